@@ -0,0 +1,251 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_BACKGROUND_WRITER_H
+#define SCRAPP_BACKGROUND_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Scrapp {
+    // Queue of values produced by any number of threads and handed in order
+    // to a single writer thread, started by the first value or flush. The
+    // first error of a handler is kept and rethrown by every later call,
+    // values queued after it are dropped. The handlers usually use the
+    // owner's members, so it must be declared after them.
+    template<typename T> class BackgroundWriter {
+      public:
+        struct Handlers {
+            // Takes every value queued since the last call.
+            std::function<void(std::deque<T>& values)> write;
+            // Called by flush(), by an idle writer after a write and, with
+            // closing set, once by close().
+            std::function<void(bool closing)> flush;
+        };
+
+        // push() blocks while max_pending values are queued. An idle writer
+        // flushes after idle_flush, 0 only flushes when asked to.
+        BackgroundWriter(
+            std::size_t max_pending, std::chrono::milliseconds idle_flush,
+            Handlers handlers)
+            : max_pending_{max_pending == 0 ? 1 : max_pending},
+              idle_flush_{idle_flush}, handlers_{std::move(handlers)} {}
+        BackgroundWriter(const BackgroundWriter&) = delete;
+        BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+        // Closes the writer, errors are lost.
+        ~BackgroundWriter() {
+            try {
+                this->close();
+            } catch (...) {
+                // Destructors must not throw, call close() to see the error.
+            }
+        }
+
+        // Thread safe. Returns false once the writer is closing.
+        bool push(T value) {
+            std::vector<T> values;
+            values.push_back(std::move(value));
+            return this->push_all(std::move(values));
+        }
+
+        // Queues values next to each other. Thread safe. Returns false once
+        // the writer is closing.
+        bool push_all(std::vector<T> values) {
+            if (this->closed_) {
+                return false;
+            }
+            std::unique_lock<std::mutex> lock{this->mutex_};
+            this->space_ready_.wait(lock, [this] {
+                return this->queue_.size() < this->max_pending_ ||
+                       this->failed_;
+            });
+            if (this->failed_) {
+                lock.unlock();
+                this->rethrow_error();
+            }
+            if (this->stopping_) {
+                return false;
+            }
+            this->start_writer();
+            for (auto& value : values) {
+                this->queue_.push_back(std::move(value));
+            }
+            lock.unlock();
+            this->work_ready_.notify_one();
+            return true;
+        }
+
+        // Waits until everything queued so far is written and flushed.
+        void flush() {
+            if (this->closed_) {
+                this->rethrow_error();
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock{this->mutex_};
+                this->start_writer();
+                auto target = ++this->flush_requested_;
+                this->work_ready_.notify_one();
+                this->flushed_ready_.wait(lock, [this, target] {
+                    return this->flushed_ >= target;
+                });
+            }
+            this->rethrow_error();
+        }
+
+        // Writes what is queued, makes the closing flush and stops the
+        // writer thread.
+        void close() {
+            if (this->closed_.exchange(true)) {
+                return;
+            }
+            bool running;
+            {
+                std::lock_guard<std::mutex> lock{this->mutex_};
+                this->stopping_ = true;
+                running = this->writer_.joinable();
+                if (running) {
+                    ++this->flush_requested_;
+                    this->work_ready_.notify_one();
+                }
+            }
+            if (running) {
+                this->writer_.join();
+            } else {
+                // Nothing was ever queued, no need for a thread.
+                this->guard([this] { this->handlers_.flush(true); });
+            }
+            this->rethrow_error();
+        }
+
+        [[nodiscard]] bool closed() const noexcept { return this->closed_; }
+        [[nodiscard]] bool failed() const noexcept { return this->failed_; }
+
+        void rethrow_error() {
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock{this->mutex_};
+                error = this->error_;
+            }
+            if (error != nullptr) {
+                std::rethrow_exception(error);
+            }
+        }
+
+      private:
+        template<typename F> void guard(F&& f) {
+            try {
+                f();
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock{this->mutex_};
+                    if (this->error_ == nullptr) {
+                        this->error_ = std::current_exception();
+                    }
+                    this->failed_ = true;
+                }
+                this->space_ready_.notify_all();
+            }
+        }
+
+        void start_writer() {
+            if (!this->writer_.joinable()) {
+                this->writer_ = std::thread{[this] { this->run(); }};
+            }
+        }
+
+        void run() {
+            bool dirty = false;
+            auto ready = [this] {
+                return !this->queue_.empty() ||
+                       this->flushed_ != this->flush_requested_;
+            };
+            std::unique_lock<std::mutex> lock{this->mutex_};
+            while (true) {
+                auto woken = true;
+                if (this->idle_flush_.count() == 0) {
+                    this->work_ready_.wait(lock, ready);
+                } else {
+                    woken = this->work_ready_.wait_for(
+                        lock, this->idle_flush_, ready);
+                }
+                if (!this->queue_.empty()) {
+                    std::deque<T> values;
+                    values.swap(this->queue_);
+                    lock.unlock();
+                    this->space_ready_.notify_all();
+                    if (!this->failed_) {
+                        this->guard(
+                            [this, &values] { this->handlers_.write(values); });
+                    }
+                    dirty = true;
+                    lock.lock();
+                    continue;
+                }
+                if (!woken && !dirty) {
+                    continue;
+                }
+
+                auto target = this->flush_requested_;
+                auto stopping = this->stopping_;
+                lock.unlock();
+                this->guard(
+                    [this, stopping] { this->handlers_.flush(stopping); });
+                dirty = false;
+                lock.lock();
+                this->flushed_ = target;
+                this->flushed_ready_.notify_all();
+                if (stopping) {
+                    return;
+                }
+            }
+        }
+
+        std::size_t max_pending_;
+        std::chrono::milliseconds idle_flush_;
+        Handlers handlers_;
+
+        std::mutex mutex_;
+        std::condition_variable work_ready_;
+        std::condition_variable space_ready_;
+        std::condition_variable flushed_ready_;
+        std::deque<T> queue_;
+        std::size_t flush_requested_{0};
+        std::size_t flushed_{0};
+        bool stopping_{false};
+        std::exception_ptr error_;
+        std::atomic<bool> failed_{false};
+        std::atomic<bool> closed_{false};
+        std::thread writer_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_BACKGROUND_WRITER_H
@@ -0,0 +1,373 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "columnar_sink.h"
+#include "exceptions.h"
+#include <algorithm>
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <boost/json.hpp>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <parquet/arrow/writer.h>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace Scrapp {
+    struct ColumnarSink::Writer {
+        std::shared_ptr<arrow::io::FileOutputStream> output;
+        std::shared_ptr<arrow::Schema> schema;
+        std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+        std::unique_ptr<parquet::arrow::FileWriter> parquet;
+        std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc;
+        std::size_t rows{0};
+        bool closed{false};
+        boost::json::serializer serializer;
+        std::string json;
+    };
+
+    namespace {
+        void check(const arrow::Status& status) {
+            if (!status.ok()) {
+                throw item_pipeline_exception(
+                    "columnar sink: " + status.ToString());
+            }
+        }
+
+        template<typename T> T check(arrow::Result<T> result) {
+            check(result.status());
+            return std::move(result).ValueUnsafe();
+        }
+
+        std::string_view view(boost::json::string_view text) {
+            return {text.data(), text.size()};
+        }
+
+        std::shared_ptr<arrow::DataType> data_type(const ColumnSpec& column) {
+            switch (column.type) {
+            case ColumnType::boolean:
+                return arrow::boolean();
+            case ColumnType::int64:
+                return arrow::int64();
+            case ColumnType::float64:
+                return arrow::float64();
+            case ColumnType::string:
+                break;
+            }
+            if (column.dictionary) {
+                return arrow::dictionary(arrow::int32(), arrow::utf8());
+            }
+            return arrow::utf8();
+        }
+
+        std::unique_ptr<arrow::ArrayBuilder>
+        make_builder(const ColumnSpec& column) {
+            auto* pool = arrow::default_memory_pool();
+            switch (column.type) {
+            case ColumnType::boolean:
+                return std::make_unique<arrow::BooleanBuilder>(pool);
+            case ColumnType::int64:
+                return std::make_unique<arrow::Int64Builder>(pool);
+            case ColumnType::float64:
+                return std::make_unique<arrow::DoubleBuilder>(pool);
+            case ColumnType::string:
+                break;
+            }
+            if (column.dictionary) {
+                return std::make_unique<arrow::StringDictionary32Builder>(
+                    pool);
+            }
+            return std::make_unique<arrow::StringBuilder>(pool);
+        }
+
+        std::optional<ColumnType> column_type(const boost::json::value& value) {
+            switch (value.kind()) {
+            case boost::json::kind::null:
+                return std::nullopt;
+            case boost::json::kind::bool_:
+                return ColumnType::boolean;
+            case boost::json::kind::int64:
+            case boost::json::kind::uint64:
+                return ColumnType::int64;
+            case boost::json::kind::double_:
+                return ColumnType::float64;
+            default:
+                return ColumnType::string;
+            }
+        }
+
+        bool is_number(ColumnType type) {
+            return type == ColumnType::int64 || type == ColumnType::float64;
+        }
+
+        void append_json(
+            boost::json::serializer& serializer,
+            const boost::json::value& value, std::string& out) {
+            out.clear();
+            serializer.reset(&value);
+            char chunk[4096];
+            while (!serializer.done()) {
+                auto part = serializer.read(chunk);
+                out.append(part.data(), part.size());
+            }
+        }
+
+        // json is scratch space for values of string columns that are not
+        // strings.
+        void append(
+            const ColumnSpec& column, arrow::ArrayBuilder& builder,
+            const boost::json::value* value,
+            boost::json::serializer& serializer, std::string& json) {
+            if (value == nullptr || value->is_null()) {
+                check(builder.AppendNull());
+                return;
+            }
+            switch (column.type) {
+            case ColumnType::boolean:
+                if (value->is_bool()) {
+                    check(static_cast<arrow::BooleanBuilder&>(builder).Append(
+                        value->get_bool()));
+                    return;
+                }
+                break;
+            case ColumnType::int64:
+                if (value->is_int64()) {
+                    check(static_cast<arrow::Int64Builder&>(builder).Append(
+                        value->get_int64()));
+                    return;
+                }
+                if (value->is_uint64() &&
+                    value->get_uint64() <= static_cast<std::uint64_t>(
+                        std::numeric_limits<std::int64_t>::max())) {
+                    check(static_cast<arrow::Int64Builder&>(builder).Append(
+                        static_cast<std::int64_t>(value->get_uint64())));
+                    return;
+                }
+                break;
+            case ColumnType::float64:
+                if (value->is_number()) {
+                    boost::json::error_code ec;
+                    auto number = value->to_number<double>(ec);
+                    if (!ec) {
+                        check(
+                            static_cast<arrow::DoubleBuilder&>(builder).Append(
+                                number));
+                        return;
+                    }
+                }
+                break;
+            case ColumnType::string: {
+                std::string_view text;
+                if (const auto* string = value->if_string()) {
+                    text = {string->data(), string->size()};
+                } else {
+                    append_json(serializer, *value, json);
+                    text = json;
+                }
+                if (column.dictionary) {
+                    check(static_cast<arrow::StringDictionary32Builder&>(
+                              builder)
+                              .Append(text));
+                } else {
+                    check(static_cast<arrow::StringBuilder&>(builder).Append(
+                        text));
+                }
+                return;
+            }
+            }
+            check(builder.AppendNull());
+        }
+    } // namespace
+
+    ColumnarSink::ColumnarSink(ColumnarSinkOptions options)
+        : options_{std::move(options)}, writer_{std::make_unique<Writer>()} {
+        this->options_.row_group_size =
+            std::max<std::size_t>(1, this->options_.row_group_size);
+        this->writer_->output =
+            check(arrow::io::FileOutputStream::Open(this->options_.path));
+        if (!this->options_.columns.empty()) {
+            this->open();
+        }
+    }
+
+    ColumnarSink::~ColumnarSink() {
+        try {
+            this->close();
+        } catch (const item_pipeline_exception&) {
+            // Destructors must not throw, close() reports the error.
+        }
+    }
+
+    void ColumnarSink::write(const std::vector<Item>& items) {
+        auto& writer = *this->writer_;
+        if (writer.closed) {
+            throw item_pipeline_exception(
+                "cannot write to closed sink " + this->options_.path);
+        }
+        if (writer.schema == nullptr) {
+            this->infer_columns(items);
+            if (this->options_.columns.empty()) {
+                return;
+            }
+            this->open();
+        }
+        for (const auto& item : items) {
+            for (std::size_t i = 0; i < this->options_.columns.size(); ++i) {
+                const auto& column = this->options_.columns[i];
+                append(
+                    column, *writer.builders[i], item.if_contains(column.name),
+                    writer.serializer, writer.json);
+            }
+            if (++writer.rows >= this->options_.row_group_size) {
+                this->write_row_group();
+            }
+        }
+    }
+
+    void ColumnarSink::flush() {}
+
+    void ColumnarSink::close() {
+        auto& writer = *this->writer_;
+        if (writer.closed) {
+            return;
+        }
+        writer.closed = true;
+        this->write_row_group();
+        if (writer.parquet != nullptr) {
+            check(writer.parquet->Close());
+        }
+        if (writer.ipc != nullptr) {
+            check(writer.ipc->Close());
+        }
+        check(writer.output->Close());
+    }
+
+    const std::vector<ColumnSpec>& ColumnarSink::columns() const noexcept {
+        return this->options_.columns;
+    }
+
+    void ColumnarSink::infer_columns(const std::vector<Item>& items) {
+        auto& columns = this->options_.columns;
+        std::unordered_map<std::string_view, std::size_t> indices;
+        std::vector<std::optional<ColumnType>> types;
+        for (const auto& item : items) {
+            for (const auto& field : item) {
+                auto name = view(field.key());
+                auto [position, added] = indices.emplace(name, columns.size());
+                if (added) {
+                    columns.push_back({std::string{name}});
+                    types.emplace_back();
+                }
+                auto type = column_type(field.value());
+                auto& current = types[position->second];
+                if (!type || current == type) {
+                    continue;
+                }
+                if (!current) {
+                    current = type;
+                } else if (is_number(*current) && is_number(*type)) {
+                    current = ColumnType::float64;
+                } else {
+                    current = ColumnType::string;
+                }
+            }
+        }
+
+        auto ratio = this->options_.dictionary_ratio;
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            auto& column = columns[i];
+            column.type = types[i].value_or(ColumnType::string);
+            if (column.type != ColumnType::string || ratio <= 0) {
+                continue;
+            }
+            std::unordered_set<std::string_view> distinct;
+            std::size_t count = 0;
+            for (const auto& item : items) {
+                const auto* value = item.if_contains(column.name);
+                if (value != nullptr && value->is_string()) {
+                    distinct.insert(view(value->get_string()));
+                    ++count;
+                }
+            }
+            column.dictionary = count > 1 &&
+                                static_cast<double>(distinct.size()) <=
+                                    ratio * static_cast<double>(count);
+        }
+    }
+
+    void ColumnarSink::open() {
+        auto& writer = *this->writer_;
+        arrow::FieldVector fields;
+        for (const auto& column : this->options_.columns) {
+            fields.push_back(arrow::field(column.name, data_type(column)));
+            writer.builders.push_back(make_builder(column));
+        }
+        writer.schema = arrow::schema(std::move(fields));
+
+        if (this->options_.format == ColumnarFormat::arrow_ipc) {
+            writer.ipc = check(
+                arrow::ipc::MakeStreamWriter(writer.output, writer.schema));
+            return;
+        }
+        parquet::WriterProperties::Builder properties;
+        properties.disable_dictionary();
+        for (const auto& column : this->options_.columns) {
+            if (column.dictionary) {
+                properties.enable_dictionary(column.name);
+            }
+        }
+        // Stores the Arrow schema too, so dictionary columns read back as
+        // dictionaries.
+        auto arrow_properties =
+            parquet::ArrowWriterProperties::Builder().store_schema()->build();
+        writer.parquet = check(parquet::arrow::FileWriter::Open(
+            *writer.schema, arrow::default_memory_pool(), writer.output,
+            properties.build(), arrow_properties));
+    }
+
+    void ColumnarSink::write_row_group() {
+        auto& writer = *this->writer_;
+        if (writer.rows == 0) {
+            return;
+        }
+        arrow::ArrayVector arrays;
+        for (auto& builder : writer.builders) {
+            std::shared_ptr<arrow::Array> array;
+            check(builder->Finish(&array));
+            arrays.push_back(std::move(array));
+        }
+        auto rows = static_cast<std::int64_t>(std::exchange(writer.rows, 0));
+        auto batch =
+            arrow::RecordBatch::Make(writer.schema, rows, std::move(arrays));
+        if (writer.ipc != nullptr) {
+            check(writer.ipc->WriteRecordBatch(*batch));
+            return;
+        }
+        auto table =
+            check(arrow::Table::FromRecordBatches(writer.schema, {batch}));
+        check(writer.parquet->WriteTable(*table, rows));
+    }
+} // namespace Scrapp
@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_COLUMNAR_SINK_H
+#define SCRAPP_COLUMNAR_SINK_H
+
+#include "pipeline.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Scrapp {
+    enum class ColumnType { boolean, int64, float64, string };
+
+    struct ColumnSpec {
+        std::string name;
+        ColumnType type{ColumnType::string};
+        // Store string columns as indices into a dictionary of their
+        // distinct values, for repetitive fields such as domains.
+        bool dictionary{false};
+    };
+
+    enum class ColumnarFormat { parquet, arrow_ipc };
+
+    struct ColumnarSinkOptions {
+        std::string path;
+        // Parquet file, or Arrow IPC stream.
+        ColumnarFormat format{ColumnarFormat::parquet};
+        // Inferred from the first batch of items when empty.
+        std::vector<ColumnSpec> columns{};
+        // Rows per Parquet row group or Arrow record batch.
+        std::size_t row_group_size{64 * 1024};
+        // Inferred string columns with at most this many distinct values
+        // per row get a dictionary, 0 never gives one.
+        double dictionary_ratio{0.5};
+    };
+
+    // Sink building the items into Arrow columns and writing them out as
+    // Parquet or Arrow IPC, one row group at a time. Fields outside the
+    // schema are ignored. Missing fields and fields of another type are
+    // null, except in string columns, which hold any other value as JSON.
+    // Only available when built with SCRAPP_WITH_ARROW. Throws
+    // item_pipeline_exception on errors.
+    class ColumnarSink : public ItemSink {
+      public:
+        explicit ColumnarSink(ColumnarSinkOptions options);
+        ColumnarSink(const ColumnarSink&) = delete;
+        ColumnarSink& operator=(const ColumnarSink&) = delete;
+        ~ColumnarSink() override;
+
+        void write(const std::vector<Item>& items) override;
+        // Does nothing, small row groups make the files slow to read. Rows
+        // are written once a row group is full and on close().
+        void flush() override;
+        void close() override;
+
+        // The declared schema, or the inferred one once items are written.
+        [[nodiscard]] const std::vector<ColumnSpec>& columns() const noexcept;
+
+      private:
+        struct Writer;
+
+        void infer_columns(const std::vector<Item>& items);
+        void open();
+        void write_row_group();
+
+        ColumnarSinkOptions options_;
+        std::unique_ptr<Writer> writer_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_COLUMNAR_SINK_H
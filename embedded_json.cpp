@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "embedded_json.h"
+#include "exceptions.h"
+#include "json.h"
+#include "utils.h"
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        // ASCII whitespace as HTML defines it.
+        constexpr std::string_view html_space = " \t\n\f\r";
+
+        // Removes one <!-- --> or <![CDATA[ ]]> wrapper, as older pages
+        // hide script bodies from ancient browsers with them.
+        std::string_view unwrap(std::string_view body) {
+            body = trim(body, html_space);
+            constexpr std::pair<std::string_view, std::string_view> wrappers[]{
+                {"<!--", "-->"}, {"<![CDATA[", "]]>"}};
+            for (const auto& [open, close] : wrappers) {
+                if (body.size() >= open.size() + close.size() &&
+                    body.substr(0, open.size()) == open &&
+                    body.substr(body.size() - close.size()) == close) {
+                    return trim(body.substr(
+                        open.size(),
+                        body.size() - open.size() - close.size()),
+                        html_space);
+                }
+            }
+            return body;
+        }
+
+        bool accepts(
+            const Html::TagScanner& scanner,
+            const EmbeddedJsonOptions& options) {
+            if (!options.id.empty() &&
+                scanner.attribute("id").value_or(std::string_view{}) !=
+                    options.id) {
+                return false;
+            }
+            if (options.types.empty()) {
+                return true;
+            }
+            auto type = scanner.attribute("type").value_or(std::string_view{});
+            type = trim(type.substr(0, type.find(';')), html_space);
+            for (const auto& accepted : options.types) {
+                if (equals_ignore_case(type, accepted)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    std::vector<std::string_view> embedded_json_scripts(
+        std::string_view html, const EmbeddedJsonOptions& options) {
+        std::vector<std::string_view> scripts;
+        Html::TagScanner scanner{html};
+        while (scanner.next()) {
+            if (scanner.is("script") && accepts(scanner, options)) {
+                scripts.push_back(unwrap(scanner.raw_text()));
+            }
+        }
+        return scripts;
+    }
+
+    std::vector<boost::json::value> embedded_json(
+        std::string_view html, const EmbeddedJsonOptions& options) {
+        std::vector<boost::json::value> values;
+        auto scripts = embedded_json_scripts(html, options);
+        if (scripts.empty()) {
+            return values;
+        }
+        auto storage = JsonArenaPool::local().acquire();
+        auto parse_options = lenient_json_options();
+        for (auto script : scripts) {
+            boost::json::error_code ec;
+            auto value = boost::json::parse(
+                boost::json::string_view{script.data(), script.size()}, ec,
+                storage, parse_options);
+            if (!ec) {
+                values.push_back(std::move(value));
+            } else if (!options.skip_invalid) {
+                throw invalid_json_exception(
+                    "invalid embedded json: " + ec.message());
+            }
+        }
+        return values;
+    }
+
+    std::vector<JsonRecord> embedded_json(
+        std::string_view html, const JsonExtractor& extractor,
+        const EmbeddedJsonOptions& options) {
+        std::vector<JsonRecord> records;
+        for (auto script : embedded_json_scripts(html, options)) {
+            try {
+                records.push_back(extractor.extract(script));
+            } catch (const invalid_json_exception&) {
+                if (!options.skip_invalid) {
+                    throw;
+                }
+            }
+        }
+        return records;
+    }
+} // namespace Scrapp
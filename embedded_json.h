@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_EMBEDDED_JSON_H
+#define SCRAPP_EMBEDDED_JSON_H
+
+#include "html/tag_scanner.h"
+#include "json_extractor.h"
+#include <boost/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp {
+    // Which <script> elements hold the JSON to extract.
+    struct EmbeddedJsonOptions {
+        // Accepted type attributes, compared case-insensitively and without
+        // parameters. Empty accepts every script.
+        std::vector<std::string> types{
+            "application/ld+json", "application/json"};
+        // Only the script with this id when set, e.g. "__NEXT_DATA__".
+        std::string id{};
+        // Skip scripts that are not valid JSON instead of throwing
+        // invalid_json_exception.
+        bool skip_invalid{true};
+    };
+
+    // Bodies of the matching scripts of html, found by a raw tag scan
+    // without building a DOM. Bodies are views into html, trimmed of
+    // whitespace and of the comment or CDATA wrappers some pages put
+    // around them.
+    std::vector<std::string_view> embedded_json_scripts(
+        std::string_view html, const EmbeddedJsonOptions& options = {});
+
+    // Parses the matching scripts of html. The values share one arena from
+    // JsonArenaPool.
+    std::vector<boost::json::value> embedded_json(
+        std::string_view html, const EmbeddedJsonOptions& options = {});
+
+    // Extracts extractor's paths from each matching script straight from
+    // the source, without materializing the documents.
+    std::vector<JsonRecord> embedded_json(
+        std::string_view html, const JsonExtractor& extractor,
+        const EmbeddedJsonOptions& options = {});
+} // namespace Scrapp
+
+#endif // SCRAPP_EMBEDDED_JSON_H
@@ -36,4 +36,20 @@ namespace Scrapp {
     invalid_content_type_exception::invalid_content_type_exception(
         std::string message)
         : exception(message) {}
+
+    invalid_json_path_exception::invalid_json_path_exception(
+        std::string message)
+        : exception(std::move(message)) {}
+
+    item_pipeline_exception::item_pipeline_exception(std::string message)
+        : exception(std::move(message)) {}
+
+    warc_exception::warc_exception(std::string message)
+        : exception(std::move(message)) {}
+
+    recrawl_exception::recrawl_exception(std::string message)
+        : exception(std::move(message)) {}
+
+    sitemap_exception::sitemap_exception(std::string message)
+        : exception(std::move(message)) {}
 } // namespace Scrapp
\ No newline at end of file
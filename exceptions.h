@@ -45,5 +45,30 @@ namespace Scrapp {
       public:
         explicit invalid_content_type_exception(std::string message);
     };
+
+    class invalid_json_path_exception : public exception {
+      public:
+        explicit invalid_json_path_exception(std::string message);
+    };
+
+    class item_pipeline_exception : public exception {
+      public:
+        explicit item_pipeline_exception(std::string message);
+    };
+
+    class warc_exception : public exception {
+      public:
+        explicit warc_exception(std::string message);
+    };
+
+    class recrawl_exception : public exception {
+      public:
+        explicit recrawl_exception(std::string message);
+    };
+
+    class sitemap_exception : public exception {
+      public:
+        explicit sitemap_exception(std::string message);
+    };
 } // namespace Scrapp
 #endif // SCRAPP_EXCEPTIONS_H
@@ -0,0 +1,202 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "frontier.h"
+#include "utils.h"
+#include <algorithm>
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        constexpr std::size_t arity = 4;
+    } // namespace
+
+    Scorer breadth_first_scorer() {
+        return [](const Request& request) {
+            return -static_cast<double>(request.depth());
+        };
+    }
+
+    Scorer best_first_scorer() {
+        return [](const Request& request) { return request.priority(); };
+    }
+
+    void PatternBoosts::set(std::string_view url, double boost) {
+        this->boosts_[url_pattern(url)] = boost;
+    }
+
+    double PatternBoosts::boost(std::string_view url) const {
+        auto found = this->boosts_.find(url_pattern(url));
+        return found == this->boosts_.end() ? 0 : found->second;
+    }
+
+    bool PatternBoosts::empty() const noexcept { return this->boosts_.empty(); }
+
+    Scorer pattern_boost_scorer(
+        std::shared_ptr<const PatternBoosts> boosts, Scorer base) {
+        return [boosts = std::move(boosts),
+                base = std::move(base)](const Request& request) {
+            auto score = base(request);
+            // url_pattern() is the costly part, skip it when it cannot
+            // matter.
+            return boosts->empty() ? score
+                                   : score + boosts->boost(request.full_url());
+        };
+    }
+
+    Scorer duplicate_penalty_scorer(
+        std::shared_ptr<const DuplicateFilter> filter, double weight,
+        Scorer base) {
+        return [filter = std::move(filter), weight,
+                base = std::move(base)](const Request& request) {
+            return base(request) -
+                   weight * filter->duplicate_ratio(request.full_url());
+        };
+    }
+
+    Frontier::Frontier(FrontierOptions options) : options_{std::move(options)} {
+        if (!this->options_.scorer) {
+            this->options_.scorer = best_first_scorer();
+        }
+    }
+
+    bool Frontier::push(Request request) {
+        if (request.depth() > this->options_.max_depth) {
+            std::lock_guard lock{this->mutex_};
+            ++this->stats_.too_deep;
+            return false;
+        }
+        auto score = this->options_.scorer(request);
+        std::lock_guard lock{this->mutex_};
+        this->insert(score, std::move(request));
+        return true;
+    }
+
+    std::size_t Frontier::push(std::vector<Request>&& requests) {
+        std::vector<double> scores;
+        scores.reserve(requests.size());
+        for (const auto& request : requests) {
+            scores.push_back(
+                request.depth() > this->options_.max_depth
+                    ? 0
+                    : this->options_.scorer(request));
+        }
+        std::size_t pushed = 0;
+        std::lock_guard lock{this->mutex_};
+        this->heap_.reserve(this->heap_.size() + requests.size());
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            if (requests[i].depth() > this->options_.max_depth) {
+                ++this->stats_.too_deep;
+                continue;
+            }
+            this->insert(scores[i], std::move(requests[i]));
+            ++pushed;
+        }
+        requests.clear();
+        return pushed;
+    }
+
+    std::optional<Request> Frontier::pop() {
+        std::lock_guard lock{this->mutex_};
+        if (this->heap_.empty()) {
+            return std::nullopt;
+        }
+        auto slot = this->heap_.front().slot;
+        this->heap_.front() = this->heap_.back();
+        this->heap_.pop_back();
+        if (!this->heap_.empty()) {
+            this->sift_down(0);
+        }
+        std::optional<Request> request{std::move(this->slots_[slot])};
+        this->free_slots_.push_back(slot);
+        ++this->stats_.popped;
+        return request;
+    }
+
+    std::size_t Frontier::size() const {
+        std::lock_guard lock{this->mutex_};
+        return this->heap_.size();
+    }
+
+    bool Frontier::empty() const { return this->size() == 0; }
+
+    FrontierStats Frontier::stats() const {
+        std::lock_guard lock{this->mutex_};
+        return this->stats_;
+    }
+
+    bool Frontier::before(const Entry& a, const Entry& b) noexcept {
+        return a.key < b.key || (a.key == b.key && a.order < b.order);
+    }
+
+    void Frontier::insert(double score, Request&& request) {
+        std::size_t slot;
+        if (this->free_slots_.empty()) {
+            slot = this->slots_.size();
+            this->slots_.push_back(std::move(request));
+        } else {
+            slot = this->free_slots_.back();
+            this->free_slots_.pop_back();
+            this->slots_[slot] = std::move(request);
+        }
+        this->heap_.push_back(Entry{-score, this->order_++, slot});
+        this->sift_up(this->heap_.size() - 1);
+        ++this->stats_.pushed;
+    }
+
+    void Frontier::sift_up(std::size_t index) noexcept {
+        auto entry = this->heap_[index];
+        while (index > 0) {
+            auto parent = (index - 1) / arity;
+            if (!before(entry, this->heap_[parent])) {
+                break;
+            }
+            this->heap_[index] = this->heap_[parent];
+            index = parent;
+        }
+        this->heap_[index] = entry;
+    }
+
+    void Frontier::sift_down(std::size_t index) noexcept {
+        auto entry = this->heap_[index];
+        auto size = this->heap_.size();
+        while (true) {
+            auto first = index * arity + 1;
+            if (first >= size) {
+                break;
+            }
+            auto last = std::min(first + arity, size);
+            auto best = first;
+            for (auto child = first + 1; child < last; ++child) {
+                if (before(this->heap_[child], this->heap_[best])) {
+                    best = child;
+                }
+            }
+            if (!before(this->heap_[best], entry)) {
+                break;
+            }
+            this->heap_[index] = this->heap_[best];
+            index = best;
+        }
+        this->heap_[index] = entry;
+    }
+} // namespace Scrapp
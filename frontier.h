@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_FRONTIER_H
+#define SCRAPP_FRONTIER_H
+
+#include "near_duplicates.h"
+#include "request.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Scrapp {
+    // Score of a request, computed once when it is queued. Higher scores
+    // are fetched first and equal scores in the order they were queued.
+    using Scorer = std::function<double(const Request&)>;
+
+    // Shallower requests first, level by level.
+    Scorer breadth_first_scorer();
+    // By Request::priority, the default.
+    Scorer best_first_scorer();
+
+    // Score boosts of URL patterns, see url_pattern. Set them before the
+    // crawl, lookups are not synchronized with set().
+    class PatternBoosts {
+      public:
+        // Boosts the URLs sharing url's pattern.
+        void set(std::string_view url, double boost);
+        // 0 for patterns without a boost.
+        [[nodiscard]] double boost(std::string_view url) const;
+        [[nodiscard]] bool empty() const noexcept;
+
+      private:
+        std::unordered_map<std::string, double> boosts_;
+    };
+
+    // base plus the boost of the request's URL pattern.
+    Scorer pattern_boost_scorer(
+        std::shared_ptr<const PatternBoosts> boosts,
+        Scorer base = best_first_scorer());
+    // base minus weight times the share of duplicates filter found among
+    // the pages of the request's URL pattern, so templates that keep
+    // producing near-duplicates sink before DuplicateFilter skips them.
+    Scorer duplicate_penalty_scorer(
+        std::shared_ptr<const DuplicateFilter> filter, double weight = 1,
+        Scorer base = best_first_scorer());
+
+    struct FrontierOptions {
+        // best_first_scorer() when empty.
+        Scorer scorer{};
+        // Requests deeper than this are dropped.
+        std::size_t max_depth{std::numeric_limits<std::size_t>::max()};
+    };
+
+    struct FrontierStats {
+        std::size_t pushed{};
+        std::size_t popped{};
+        // Dropped for exceeding max_depth.
+        std::size_t too_deep{};
+    };
+
+    // Thread safe priority queue of requests. Requests are scored once
+    // when pushed and kept in a slab, and a 4-ary min-heap of small
+    // (score, order, slot) entries orders them, so sifting never moves a
+    // Request and touches few cache lines.
+    class Frontier {
+      public:
+        explicit Frontier(FrontierOptions options = {});
+        Frontier(const Frontier&) = delete;
+        Frontier& operator=(const Frontier&) = delete;
+
+        // Whether request was queued, see FrontierOptions::max_depth.
+        bool push(Request request);
+        // Scores the batch outside the lock and queues it under one lock
+        // acquisition. Returns the number of requests queued.
+        std::size_t push(std::vector<Request>&& requests);
+        // The highest scored request, nullopt when empty.
+        std::optional<Request> pop();
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] bool empty() const;
+        [[nodiscard]] FrontierStats stats() const;
+
+      private:
+        struct Entry {
+            // Negated score, so that the smallest entry is fetched first.
+            double key;
+            std::uint64_t order;
+            std::size_t slot;
+        };
+
+        static bool before(const Entry& a, const Entry& b) noexcept;
+        void insert(double score, Request&& request);
+        void sift_up(std::size_t index) noexcept;
+        void sift_down(std::size_t index) noexcept;
+
+        FrontierOptions options_;
+        std::vector<Entry> heap_;
+        std::vector<Request> slots_;
+        std::vector<std::size_t> free_slots_;
+        std::uint64_t order_{};
+        FrontierStats stats_;
+        mutable std::mutex mutex_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_FRONTIER_H
@@ -0,0 +1,130 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "batch.h"
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/post.hpp>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Scrapp::Html {
+    namespace {
+        unsigned hardware_threads() {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        boost::asio::thread_pool& default_pool() {
+            static boost::asio::thread_pool pool{hardware_threads()};
+            return pool;
+        }
+
+        // Workers of one batch. Shared with the posted workers, which may
+        // start after run_batch returned.
+        struct Workers {
+            std::mutex mutex;
+            std::condition_variable idle;
+            std::size_t active{0};
+            bool closed{false};
+        };
+    } // namespace
+
+    namespace detail {
+        void run_batch(
+            std::size_t count, const BatchOptions& options,
+            const std::function<void(std::size_t)>& task) {
+            if (count == 0) {
+                return;
+            }
+            auto threads = options.threads;
+            if (threads == 0) {
+                threads = hardware_threads();
+            }
+            threads = std::min(threads, count);
+            auto chunk = options.chunk_size;
+            if (chunk == 0) {
+                chunk = std::max<std::size_t>(1, count / (threads * 8));
+            }
+
+            std::atomic<std::size_t> next{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            auto work = [&] {
+                while (!failed.load(std::memory_order_relaxed)) {
+                    auto begin =
+                        next.fetch_add(chunk, std::memory_order_relaxed);
+                    if (begin >= count) {
+                        return;
+                    }
+                    auto end = std::min(begin + chunk, count);
+                    try {
+                        for (auto i = begin; i < end; ++i) {
+                            task(i);
+                        }
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock{error_mutex};
+                        if (error == nullptr) {
+                            error = std::current_exception();
+                        }
+                        failed = true;
+                        return;
+                    }
+                }
+            };
+
+            // The calling thread works too instead of idling.
+            auto workers = std::make_shared<Workers>();
+            auto& pool =
+                options.pool != nullptr ? *options.pool : default_pool();
+            for (std::size_t i = 1; i < threads; ++i) {
+                boost::asio::post(pool, [workers, &work] {
+                    {
+                        std::lock_guard<std::mutex> lock{workers->mutex};
+                        if (workers->closed) {
+                            return;
+                        }
+                        ++workers->active;
+                    }
+                    work();
+                    std::lock_guard<std::mutex> lock{workers->mutex};
+                    if (--workers->active == 0) {
+                        workers->idle.notify_all();
+                    }
+                });
+            }
+            work();
+            {
+                std::unique_lock<std::mutex> lock{workers->mutex};
+                workers->closed = true;
+                workers->idle.wait(
+                    lock, [&workers] { return workers->active == 0; });
+            }
+            if (error != nullptr) {
+                std::rethrow_exception(error);
+            }
+        }
+    } // namespace detail
+} // namespace Scrapp::Html
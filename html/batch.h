@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_BATCH_H
+#define SCRAPP_BATCH_H
+
+#include "document.h"
+#include <boost/asio/thread_pool.hpp>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Scrapp::Html {
+    struct BatchOptions {
+        // Worker threads, including the calling thread. 0 uses one per
+        // hardware thread.
+        std::size_t threads{0};
+        // Documents a worker claims at a time. 0 picks a size that gives
+        // each worker several chunks, so workers that drew cheap pages take
+        // over the remaining work of slower ones.
+        std::size_t chunk_size{0};
+        // Pool the workers besides the calling thread run on. Unless set, a
+        // process-wide pool with one thread per hardware thread, created
+        // on first use. Its threads persist, so their DocumentPool and
+        // SelectorCache stay warm from one batch to the next.
+        boost::asio::thread_pool* pool{nullptr};
+    };
+
+    namespace detail {
+        // Calls task(i) for every i in [0, count) on the calling thread and
+        // workers posted to the pool, which claim chunks of indices from a
+        // shared counter. Each worker parses with its own thread's
+        // DocumentPool and SelectorCache. Workers the pool starts after the
+        // calling thread ran out of work return at once, so a busy pool
+        // only delays the batch. The first exception a task throws stops
+        // the remaining work and is rethrown once every worker has
+        // returned.
+        void run_batch(
+            std::size_t count, const BatchOptions& options,
+            const std::function<void(std::size_t)>& task);
+    } // namespace detail
+
+    // Parses every body of bodies, a random access range of strings, and
+    // returns what extract returns for each document, in input order.
+    // extract is called concurrently and must be safe to call from several
+    // threads; compiled selectors and schemas are.
+    template<class Bodies, class Extract>
+    auto parse_batch(
+        const Bodies& bodies, Extract&& extract,
+        const BatchOptions& options = {}) {
+        using Result = std::decay_t<
+            std::invoke_result_t<Extract&, const HtmlDocument&>>;
+        auto first = std::begin(bodies);
+        auto count = static_cast<std::size_t>(std::size(bodies));
+        std::vector<std::optional<Result>> slots(count);
+        detail::run_batch(count, options, [&](std::size_t i) {
+            HtmlDocument document{std::string_view{first[i]}};
+            slots[i].emplace(std::invoke(extract, std::as_const(document)));
+        });
+        std::vector<Result> results;
+        results.reserve(count);
+        for (auto& slot : slots) {
+            results.push_back(std::move(*slot));
+        }
+        return results;
+    }
+
+    // Like parse_batch, but hands each result to on_result(index, result)
+    // as soon as it is ready instead of keeping them all. Calls to
+    // on_result are serialized, in completion order.
+    template<class Bodies, class Extract, class OnResult>
+    void parse_batch_unordered(
+        const Bodies& bodies, Extract&& extract, OnResult&& on_result,
+        const BatchOptions& options = {}) {
+        auto first = std::begin(bodies);
+        auto count = static_cast<std::size_t>(std::size(bodies));
+        std::mutex mutex;
+        detail::run_batch(count, options, [&](std::size_t i) {
+            HtmlDocument document{std::string_view{first[i]}};
+            auto result = std::invoke(extract, std::as_const(document));
+            std::lock_guard<std::mutex> lock{mutex};
+            std::invoke(on_result, i, std::move(result));
+        });
+    }
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_BATCH_H
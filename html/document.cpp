@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include "document.h"
+#include "document_index.h"
+#include "document_pool.h"
 
 #include <lexbor/css/css.h>
 #include <lexbor/html/html.h>
@@ -28,62 +30,131 @@
 #include <utility>
 
 namespace Scrapp::Html {
-    HtmlDocument::HtmlDocument(std::string html)
-        : html_{std::move(html)}, document_{lxb_html_document_create()} {
-        auto lxb_html_ =
-            reinterpret_cast<const lxb_char_t*>(this->html_.c_str());
-        lxb_html_document_parse(
-            this->document_.get(), lxb_html_, html_.length());
+    HtmlDocument::HtmlDocument(std::string_view html)
+        : document_{DocumentPool::local().acquire()} {
+        auto lxb_html_ = reinterpret_cast<const lxb_char_t*>(html.data());
+        lxb_html_document_parse(this->document_.get(), lxb_html_, html.size());
+        DocumentIndex::attach(this->document_.get());
+    }
+
+    HtmlDocument::HtmlDocument(std::shared_ptr<const std::string> html)
+        : HtmlDocument(html ? std::string_view{*html} : std::string_view{}) {
+        this->source_ = std::move(html);
+    }
+
+    HtmlDocument::HtmlDocument(std::shared_ptr<lxb_html_document_t> document)
+        : document_{std::move(document)} {}
+
+    std::string_view HtmlDocument::source() const noexcept {
+        if (this->source_ == nullptr) {
+            return {};
+        }
+        return *this->source_;
     }
 
     HtmlElement HtmlDocument::head() const noexcept {
         auto head = lxb_html_document_head_element(this->document_.get());
-        return HtmlElement{lxb_dom_interface_element(head)};
+        return HtmlElement{lxb_dom_interface_element(head), this->document_};
     }
 
     HtmlElement HtmlDocument::body() const noexcept {
         auto body = lxb_html_document_body_element(this->document_.get());
-        return HtmlElement{lxb_dom_interface_element(body)};
-    }
-
-    static lxb_status_t callback(
-        lxb_dom_node_t* node, lxb_css_selector_specificity_t* spec, void* ctx) {
-        auto* pointers = static_cast<std::vector<HtmlElement>*>(ctx);
-        HtmlElement element{lxb_dom_interface_element(node)};
-        auto it = std::find_if(
-            pointers->begin(), pointers->end(),
-            [element](const HtmlElement& other) { return element == other; });
-        if (it != pointers->end()) {
-            return LXB_STATUS_OK;
-        }
-        pointers->push_back(element);
-        return LXB_STATUS_OK;
+        return HtmlElement{lxb_dom_interface_element(body), this->document_};
+    }
+
+    std::string HtmlDocument::visible_text(const TextOptions& options) const {
+        return Html::visible_text(
+            &this->document_->dom_document.node, options);
+    }
+
+    void HtmlDocument::visible_text(
+        std::string& out, const TextOptions& options) const {
+        append_visible_text(&this->document_->dom_document.node, out, options);
     }
 
+    namespace {
+        bool store_first(lxb_dom_node_t* node, void* ctx) {
+            *static_cast<lxb_dom_node_t**>(ctx) = node;
+            return false;
+        }
+    } // namespace
+
     std::vector<HtmlElement>
     HtmlDocument::css(const std::string& s) const noexcept {
-        lxb_status_t status;
-        auto selectors_string = (const lxb_char_t*)s.c_str();
-        unique_lxb_css_parser parser{lxb_css_parser_create()};
-        status = lxb_css_parser_init(parser.get(), nullptr, nullptr);
-        if (status != LXB_STATUS_OK) {
-            return {};
-        }
-        unique_lxb_selectors selectors{lxb_selectors_create()};
-        status = lxb_selectors_init(selectors.get());
-        if (status != LXB_STATUS_OK) {
-            return {};
+        if (auto compiled = detail::cached_selector(s)) {
+            return this->css(*compiled);
         }
+        return {};
+    }
 
-        unique_lxb_css_selector_list selector_list{lxb_css_selectors_parse(
-            parser.get(), selectors_string, s.length())};
-        if (parser->status != LXB_STATUS_OK) {
+    std::vector<HtmlElement>
+    HtmlDocument::css(const CompiledSelector& selector) const noexcept {
+        std::vector<HtmlElement> found;
+        try {
+            this->for_each_match(
+                selector, [&found](const HtmlElement& element) {
+                    found.push_back(element);
+                });
+        } catch (const std::bad_alloc&) {
             return {};
         }
-        std::vector<HtmlElement> found;
-        lxb_selectors_find(
-            selectors.get(), &this->document_->dom_document.node,
-            selector_list.get(), callback, &found);
         return found;
     }
+
+    std::optional<HtmlElement>
+    HtmlDocument::first(const CompiledSelector& selector) const noexcept {
+        lxb_dom_node_t* node = nullptr;
+        visit_matches(
+            &this->document_->dom_document.node, selector, store_first, &node);
+        if (node == nullptr) {
+            return std::nullopt;
+        }
+        return HtmlElement{lxb_dom_interface_element(node), this->document_};
+    }
+
+    std::optional<HtmlElement>
+    HtmlDocument::first(const std::string& selector) const noexcept {
+        if (auto compiled = detail::cached_selector(selector)) {
+            return this->first(*compiled);
+        }
+        return std::nullopt;
+    }
+
+    Matches
+    HtmlDocument::matches(const CompiledSelector& selector) const noexcept {
+        return Matches{
+            &this->document_->dom_document.node, this->document_, selector};
+    }
+
+    Matches HtmlDocument::matches(const std::string& selector) const noexcept {
+        return Matches{
+            &this->document_->dom_document.node, this->document_,
+            detail::cached_selector(selector)};
+    }
+
+    std::vector<HtmlElement>
+    HtmlDocument::xpath(const XPath& expression) const {
+        return detail::xpath_elements(
+            &this->document_->dom_document.node, this->document_, expression);
+    }
+
+    std::vector<HtmlElement>
+    HtmlDocument::xpath(const std::string& expression) const {
+        return this->xpath(XPath{expression});
+    }
+
+    std::vector<std::string>
+    HtmlDocument::xpath_strings(const XPath& expression) const {
+        return detail::xpath_strings(
+            &this->document_->dom_document.node, expression);
+    }
+
+    std::vector<std::string>
+    HtmlDocument::xpath_strings(const std::string& expression) const {
+        return this->xpath_strings(XPath{expression});
+    }
+
+    lxb_html_document_t* HtmlDocument::native_handle() const noexcept {
+        return this->document_.get();
+    }
 } // namespace Scrapp::Html
\ No newline at end of file
@@ -24,20 +24,78 @@
 #define SCRAPP_DOCUMENT_H
 
 #include "element.h"
+#include "selector.h"
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace Scrapp::Html {
     class HtmlDocument {
       private:
-        std::string html_;
-        unique_lxb_html_document document_;
+        // Only set when constructed from a shared buffer.
+        std::shared_ptr<const std::string> source_;
+        // Shared with every HtmlElement taken from this document, so elements
+        // stay valid after the HtmlDocument itself is gone.
+        std::shared_ptr<lxb_html_document_t> document_;
+
+        friend class PartialParser;
+        // Wraps a document parsed elsewhere.
+        explicit HtmlDocument(std::shared_ptr<lxb_html_document_t> document);
 
       public:
-        explicit HtmlDocument(std::string html);
+        // lexbor copies everything it keeps into the document while parsing,
+        // so html only has to stay valid until the constructor returns and
+        // is never copied.
+        explicit HtmlDocument(std::string_view html);
+        // Parses html and keeps a reference to it, for callers that want
+        // the source available through source() without copying it.
+        explicit HtmlDocument(std::shared_ptr<const std::string> html);
+        // The shared buffer the document was built from, empty otherwise.
+        [[nodiscard]] std::string_view source() const noexcept;
         [[nodiscard]] HtmlElement head() const noexcept;
         [[nodiscard]] HtmlElement body() const noexcept;
+        // Visible text of the whole page, see append_visible_text.
+        std::string visible_text(const TextOptions& options = {}) const;
+        void visible_text(
+            std::string& out, const TextOptions& options = {}) const;
         std::vector<HtmlElement>
         css(const std::string& selectors_string) const noexcept;
+        std::vector<HtmlElement>
+        css(const CompiledSelector& selector) const noexcept;
+
+        // Streaming counterparts of css(), see HtmlElement::for_each_match.
+        template<class Visitor>
+        void for_each_match(
+            const CompiledSelector& selector, Visitor&& visitor) const {
+            detail::visit_elements(
+                &this->document_->dom_document.node, this->document_,
+                selector, visitor);
+        }
+
+        template<class Visitor>
+        void
+        for_each_match(const std::string& selector, Visitor&& visitor) const {
+            if (auto compiled = detail::cached_selector(selector)) {
+                this->for_each_match(*compiled, visitor);
+            }
+        }
+
+        std::optional<HtmlElement>
+        first(const CompiledSelector& selector) const noexcept;
+        std::optional<HtmlElement>
+        first(const std::string& selector) const noexcept;
+        Matches matches(const CompiledSelector& selector) const noexcept;
+        Matches matches(const std::string& selector) const noexcept;
+
+        // XPath queries with the document node as the context node, see
+        // HtmlElement::xpath.
+        std::vector<HtmlElement> xpath(const XPath& expression) const;
+        std::vector<HtmlElement> xpath(const std::string& expression) const;
+        std::vector<std::string> xpath_strings(const XPath& expression) const;
+        std::vector<std::string>
+        xpath_strings(const std::string& expression) const;
+
+        lxb_html_document_t* native_handle() const noexcept;
     };
 } // namespace Scrapp::Html
 
@@ -0,0 +1,275 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "document_index.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace Scrapp::Html {
+    namespace {
+        struct Slot {
+            std::once_flag once;
+            std::optional<DocumentIndex> index;
+        };
+
+        bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\f' ||
+                   c == '\r';
+        }
+
+        bool has_upper(std::string_view value) {
+            return std::any_of(value.begin(), value.end(), [](char c) {
+                return c >= 'A' && c <= 'Z';
+            });
+        }
+
+        void lower_into(std::string_view value, char* out) {
+            for (auto c : value) {
+                *out++ = c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+            }
+        }
+
+        template<class Getter>
+        std::string_view view(lxb_dom_element_t* element, Getter getter) {
+            std::size_t size = 0;
+            auto data = getter(element, &size);
+            if (data == nullptr) {
+                return {};
+            }
+            return {reinterpret_cast<const char*>(data), size};
+        }
+
+        bool entry_less(
+            const DocumentIndex::Entry& a, const DocumentIndex::Entry& b) {
+            return std::tie(a.key, a.order) < std::tie(b.key, b.order);
+        }
+    } // namespace
+
+    lxb_dom_node_t* next_in_tree(lxb_dom_node_t* node, lxb_dom_node_t* root) {
+        if (node->first_child != nullptr) {
+            return node->first_child;
+        }
+        while (node != root && node->next == nullptr) {
+            node = node->parent;
+        }
+        return node == root ? nullptr : node->next;
+    }
+
+    DocumentIndex::DocumentIndex(lxb_html_document_t* document)
+        : mraw_{document->dom_document.mraw},
+          quirks_{document->dom_document.compat_mode ==
+                  LXB_DOM_DOCUMENT_CMODE_QUIRKS},
+          tags_{ArenaAllocator<Entry>{mraw_}},
+          ids_{ArenaAllocator<Entry>{mraw_}},
+          classes_{ArenaAllocator<Entry>{mraw_}} {
+        auto root = &document->dom_document.node;
+        for (auto node = root->first_child; node != nullptr;
+             node = next_in_tree(node, root)) {
+            if (node->type != LXB_DOM_NODE_TYPE_ELEMENT) {
+                continue;
+            }
+            auto element = lxb_dom_interface_element(node);
+            auto order = this->elements_++;
+            auto name = view(element, lxb_dom_element_local_name);
+            if (!name.empty()) {
+                this->tags_.push_back({this->key(name, true), element, order});
+            }
+            auto id = view(element, lxb_dom_element_id);
+            if (!id.empty()) {
+                this->ids_.push_back(
+                    {this->key(id, this->quirks_), element, order});
+            }
+            auto classes = view(element, lxb_dom_element_class);
+            auto first = this->classes_.size();
+            std::size_t i = 0;
+            while (i < classes.size()) {
+                while (i < classes.size() && is_space(classes[i])) {
+                    ++i;
+                }
+                auto start = i;
+                while (i < classes.size() && !is_space(classes[i])) {
+                    ++i;
+                }
+                if (start == i) {
+                    break;
+                }
+                auto token = this->key(
+                    classes.substr(start, i - start), this->quirks_);
+                // A class listed twice must not yield the element twice.
+                auto begin = this->classes_.begin() +
+                             static_cast<std::ptrdiff_t>(first);
+                if (std::none_of(
+                        begin, this->classes_.end(),
+                        [&](const Entry& e) { return e.key == token; })) {
+                    this->classes_.push_back({token, element, order});
+                }
+            }
+        }
+        // Entries were appended in document order, so sorting by key and
+        // order keeps each key's elements in document order.
+        std::sort(this->tags_.begin(), this->tags_.end(), entry_less);
+        std::sort(this->ids_.begin(), this->ids_.end(), entry_less);
+        std::sort(this->classes_.begin(), this->classes_.end(), entry_less);
+    }
+
+    std::string_view DocumentIndex::key(std::string_view raw, bool fold) {
+        if (!fold || !has_upper(raw)) {
+            return raw;
+        }
+        auto copy =
+            static_cast<char*>(lexbor_mraw_alloc(this->mraw_, raw.size()));
+        if (copy == nullptr) {
+            throw std::bad_alloc();
+        }
+        lower_into(raw, copy);
+        return {copy, raw.size()};
+    }
+
+    DocumentIndex::Range DocumentIndex::find(
+        const Entries& entries, std::string_view key) {
+        auto [first, last] = std::equal_range(
+            entries.begin(), entries.end(), key,
+            [](const auto& a, const auto& b) {
+                if constexpr (std::is_same_v<
+                                  std::decay_t<decltype(a)>, Entry>) {
+                    return a.key < b;
+                } else {
+                    return a < b.key;
+                }
+            });
+        return {entries.data() + (first - entries.begin()),
+                entries.data() + (last - entries.begin())};
+    }
+
+    std::string_view DocumentIndex::lookup_key(
+        std::string_view key, bool fold, std::string& scratch) const {
+        if (!fold || !has_upper(key)) {
+            return key;
+        }
+        scratch.resize(key.size());
+        lower_into(key, scratch.data());
+        return scratch;
+    }
+
+    DocumentIndex::Range DocumentIndex::tag(std::string_view name) const {
+        return find(this->tags_, name);
+    }
+
+    DocumentIndex::Range DocumentIndex::id(std::string_view id) const {
+        std::string scratch;
+        return find(this->ids_, this->lookup_key(id, this->quirks_, scratch));
+    }
+
+    DocumentIndex::Range DocumentIndex::class_name(
+        std::string_view name) const {
+        std::string scratch;
+        return find(
+            this->classes_, this->lookup_key(name, this->quirks_, scratch));
+    }
+
+    std::size_t DocumentIndex::elements() const noexcept {
+        return this->elements_;
+    }
+
+    std::optional<DocumentIndex::Range> DocumentIndex::candidates(
+        const NodeMatcher::Complex& complex) const {
+        if (complex.empty()) {
+            return std::nullopt;
+        }
+        const auto& compound = complex.back();
+        std::optional<Range> best;
+        auto consider = [&best](Range range) {
+            if (!best || range.size() < best->size()) {
+                best = range;
+            }
+        };
+        for (const auto& id : compound.ids) {
+            consider(this->id(id));
+        }
+        for (const auto& name : compound.classes) {
+            consider(this->class_name(name));
+        }
+        if (!compound.tag.empty()) {
+            consider(this->tag(compound.tag));
+        }
+        return best;
+    }
+
+    bool DocumentIndex::indexable(const NodeMatcher& matcher) noexcept {
+        const auto& selectors = matcher.selectors();
+        return !selectors.empty() &&
+               std::all_of(
+                   selectors.begin(), selectors.end(), [](const auto& c) {
+                       return !c.empty() &&
+                              (!c.back().tag.empty() ||
+                               !c.back().ids.empty() ||
+                               !c.back().classes.empty());
+                   });
+    }
+
+    void DocumentIndex::attach(lxb_html_document_t* document) {
+        auto& node = document->dom_document.node;
+        if (node.user != nullptr) {
+            return;
+        }
+        auto memory =
+            lexbor_mraw_alloc(document->dom_document.mraw, sizeof(Slot));
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        node.user = new (memory) Slot{};
+    }
+
+    const DocumentIndex* DocumentIndex::of(lxb_dom_node_t* document_node) {
+        if (document_node == nullptr ||
+            document_node->type != LXB_DOM_NODE_TYPE_DOCUMENT ||
+            document_node->user == nullptr) {
+            return nullptr;
+        }
+        auto slot = static_cast<Slot*>(document_node->user);
+        auto document = lxb_html_interface_document(document_node);
+        try {
+            std::call_once(
+                slot->once, [&] { slot->index.emplace(document); });
+        } catch (const std::bad_alloc&) {
+            // The index only speeds queries up; callers fall back to a
+            // tree search, and a later call retries the build.
+            return nullptr;
+        }
+        return slot->index ? &*slot->index : nullptr;
+    }
+
+    void DocumentIndex::detach(lxb_html_document_t* document) noexcept {
+        auto& node = document->dom_document.node;
+        if (node.user == nullptr) {
+            return;
+        }
+        auto slot = static_cast<Slot*>(node.user);
+        slot->~Slot();
+        lexbor_mraw_free(document->dom_document.mraw, slot);
+        node.user = nullptr;
+    }
+} // namespace Scrapp::Html
@@ -0,0 +1,201 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_DOCUMENT_INDEX_H
+#define SCRAPP_DOCUMENT_INDEX_H
+
+#include "matcher.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp::Html {
+    // Allocator drawing from a lexbor document's memory arena, so index
+    // memory is recycled together with the document.
+    template<class T> class ArenaAllocator {
+      public:
+        using value_type = T;
+
+        explicit ArenaAllocator(lexbor_mraw_t* mraw) noexcept : mraw{mraw} {}
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+            : mraw{other.mraw} {}
+
+        T* allocate(std::size_t n) {
+            auto* memory = lexbor_mraw_alloc(this->mraw, n * sizeof(T));
+            if (memory == nullptr) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(memory);
+        }
+
+        void deallocate(T* memory, std::size_t) noexcept {
+            lexbor_mraw_free(this->mraw, memory);
+        }
+
+        template<class U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept {
+            return this->mraw == other.mraw;
+        }
+        template<class U>
+        bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+            return this->mraw != other.mraw;
+        }
+
+        lexbor_mraw_t* mraw;
+    };
+
+    // Node after node in document order within the subtree of root, nullptr
+    // past its end.
+    lxb_dom_node_t* next_in_tree(lxb_dom_node_t* node, lxb_dom_node_t* root);
+
+    // Tag, id and class index of a parsed document, built in one walk. Each
+    // index is a flat array sorted by key and then by document order, so a
+    // lookup is a binary search yielding the matching elements in document
+    // order. Keys point into the document; in quirks mode ids and classes
+    // are folded to lowercase, as lexbor matches them case-insensitively.
+    //
+    // The index reflects the tree when it was built and must not outlive
+    // the document.
+    class DocumentIndex {
+      public:
+        struct Entry {
+            std::string_view key;
+            lxb_dom_element_t* element;
+            std::uint32_t order;
+        };
+
+        class Range {
+          public:
+            Range() = default;
+            Range(const Entry* begin, const Entry* end) noexcept
+                : begin_{begin}, end_{end} {}
+            [[nodiscard]] const Entry* begin() const noexcept {
+                return this->begin_;
+            }
+            [[nodiscard]] const Entry* end() const noexcept {
+                return this->end_;
+            }
+            [[nodiscard]] std::size_t size() const noexcept {
+                return static_cast<std::size_t>(this->end_ - this->begin_);
+            }
+            [[nodiscard]] bool empty() const noexcept {
+                return this->begin_ == this->end_;
+            }
+
+          private:
+            const Entry* begin_{};
+            const Entry* end_{};
+        };
+
+        explicit DocumentIndex(lxb_html_document_t* document);
+
+        // Elements with the given lowercase tag name.
+        [[nodiscard]] Range tag(std::string_view name) const;
+        [[nodiscard]] Range id(std::string_view id) const;
+        [[nodiscard]] Range class_name(std::string_view name) const;
+        [[nodiscard]] std::size_t elements() const noexcept;
+
+        // Smallest of the tag, id and class sets the rightmost compound of
+        // complex requires, or nullopt when it requires none of them.
+        [[nodiscard]] std::optional<Range>
+        candidates(const NodeMatcher::Complex& complex) const;
+
+        // Whether every selector of matcher has a candidate set.
+        static bool indexable(const NodeMatcher& matcher) noexcept;
+
+        // Calls visitor with each element matcher matches, in document
+        // order, until it returns false. Only candidates are tested. The
+        // matcher must be indexable.
+        template<class Visitor>
+        void visit(const NodeMatcher& matcher, Visitor&& visitor) const {
+            std::vector<Range> ranges;
+            ranges.reserve(matcher.selectors().size());
+            for (const auto& complex : matcher.selectors()) {
+                if (auto range = this->candidates(complex)) {
+                    if (!range->empty()) {
+                        ranges.push_back(*range);
+                    }
+                }
+            }
+            // Merge the candidate lists of a selector list by document
+            // order; an element found through several lists is tested once.
+            std::vector<const Entry*> heads;
+            heads.reserve(ranges.size());
+            for (const auto& range : ranges) {
+                heads.push_back(range.begin());
+            }
+            while (true) {
+                const Entry* next = nullptr;
+                for (std::size_t i = 0; i < heads.size(); ++i) {
+                    if (heads[i] != ranges[i].end() &&
+                        (next == nullptr || heads[i]->order < next->order)) {
+                        next = heads[i];
+                    }
+                }
+                if (next == nullptr) {
+                    return;
+                }
+                auto order = next->order;
+                auto* element = next->element;
+                for (std::size_t i = 0; i < heads.size(); ++i) {
+                    if (heads[i] != ranges[i].end() &&
+                        heads[i]->order == order) {
+                        ++heads[i];
+                    }
+                }
+                if (matcher.matches(element) && !visitor(element)) {
+                    return;
+                }
+            }
+        }
+
+        // Lazily built index shared by every user of a document. attach()
+        // prepares the slot, of() builds the index on first use and returns
+        // nullptr for documents without a slot, detach() frees it before
+        // the document is cleaned or destroyed.
+        static void attach(lxb_html_document_t* document);
+        static const DocumentIndex* of(lxb_dom_node_t* document_node);
+        static void detach(lxb_html_document_t* document) noexcept;
+
+      private:
+        using Entries = std::vector<Entry, ArenaAllocator<Entry>>;
+
+        std::string_view key(std::string_view raw, bool fold);
+        static Range find(const Entries& entries, std::string_view key);
+        [[nodiscard]] std::string_view lookup_key(
+            std::string_view key, bool fold, std::string& scratch) const;
+
+        lexbor_mraw_t* mraw_;
+        bool quirks_;
+        Entries tags_;
+        Entries ids_;
+        Entries classes_;
+        std::uint32_t elements_{};
+    };
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_DOCUMENT_INDEX_H
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "document_pool.h"
+#include "document_index.h"
+#include <utility>
+
+namespace Scrapp::Html {
+    namespace {
+        // Set once the calling thread's pool has been destroyed at thread
+        // exit; documents released after that are destroyed outright.
+        thread_local bool local_pool_destroyed = false;
+    } // namespace
+
+    std::atomic<std::size_t> DocumentPool::capacity_{default_capacity};
+
+    DocumentPool& DocumentPool::local() {
+        thread_local DocumentPool pool;
+        return pool;
+    }
+
+    std::shared_ptr<lxb_html_document_t> DocumentPool::acquire() {
+        unique_lxb_html_document document;
+        if (!this->idle_.empty()) {
+            document = std::move(this->idle_.back());
+            this->idle_.pop_back();
+            this->stats_.reused++;
+        } else {
+            document.reset(lxb_html_document_create());
+            this->stats_.created++;
+        }
+        return {document.release(), &DocumentPool::release};
+    }
+
+    void DocumentPool::release(lxb_html_document_t* document) noexcept {
+        if (document == nullptr) {
+            return;
+        }
+        DocumentIndex::detach(document);
+        unique_lxb_html_document owned{document};
+        if (local_pool_destroyed) {
+            return;
+        }
+        auto& pool = local();
+        if (pool.idle_.size() >= capacity()) {
+            pool.stats_.destroyed++;
+            return;
+        }
+        lxb_html_document_clean(document);
+        try {
+            pool.idle_.push_back(std::move(owned));
+        } catch (const std::bad_alloc&) {
+            pool.stats_.destroyed++;
+        }
+    }
+
+    void DocumentPool::set_capacity(std::size_t capacity) noexcept {
+        capacity_.store(capacity, std::memory_order_relaxed);
+    }
+
+    std::size_t DocumentPool::capacity() noexcept {
+        return capacity_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t DocumentPool::idle() const noexcept {
+        return this->idle_.size();
+    }
+
+    const DocumentPool::Stats& DocumentPool::stats() const noexcept {
+        return this->stats_;
+    }
+
+    void DocumentPool::clear() noexcept {
+        this->stats_.destroyed += this->idle_.size();
+        this->idle_.clear();
+    }
+
+    DocumentPool::~DocumentPool() { local_pool_destroyed = true; }
+} // namespace Scrapp::Html
@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_DOCUMENT_POOL_H
+#define SCRAPP_DOCUMENT_POOL_H
+
+#include "types.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Scrapp::Html {
+    // Per-thread pool of lexbor documents. A released document is cleaned
+    // with lxb_html_document_clean, which drops the parsed tree but keeps
+    // the document's memory arenas and hash tables, so the next page parsed
+    // into it skips most of the allocator work of a fresh document.
+    class DocumentPool {
+      public:
+        static constexpr std::size_t default_capacity = 4;
+
+        struct Stats {
+            std::size_t created{};
+            std::size_t reused{};
+            std::size_t destroyed{};
+        };
+
+        // The calling thread's pool.
+        static DocumentPool& local();
+
+        // Returns an empty document. When its last reference is dropped it
+        // is cleaned and kept by the pool of the releasing thread, unless
+        // that pool already holds capacity() documents.
+        std::shared_ptr<lxb_html_document_t> acquire();
+
+        // Maximum number of idle documents each thread keeps.
+        static void set_capacity(std::size_t capacity) noexcept;
+        static std::size_t capacity() noexcept;
+
+        [[nodiscard]] std::size_t idle() const noexcept;
+        [[nodiscard]] const Stats& stats() const noexcept;
+        void clear() noexcept;
+
+        DocumentPool(const DocumentPool&) = delete;
+        DocumentPool& operator=(const DocumentPool&) = delete;
+        ~DocumentPool();
+
+      private:
+        DocumentPool() = default;
+        static void release(lxb_html_document_t* document) noexcept;
+
+        static std::atomic<std::size_t> capacity_;
+        std::vector<unique_lxb_html_document> idle_;
+        Stats stats_;
+    };
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_DOCUMENT_POOL_H
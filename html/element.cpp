@@ -22,95 +22,192 @@
 
 #include "element.h"
 #include "html_exceptions.h"
-#include <lexbor/css/css.h>
-#include <lexbor/selectors/selectors.h>
+#include "selector.h"
+#include <utility>
 
 namespace Scrapp::Html {
-    HtmlElement::HtmlElement(lxb_dom_element_t* dom_el) : element_p{dom_el} {
+    namespace {
+        std::string_view to_string_view(const lxb_char_t* data, size_t len) {
+            if (data == nullptr) {
+                return {};
+            }
+            return {reinterpret_cast<const char*>(data), len};
+        }
+
+        bool store_first(lxb_dom_node_t* node, void* ctx) {
+            *static_cast<lxb_dom_node_t**>(ctx) = node;
+            return false;
+        }
+
+        bool collect_element(lxb_dom_node_t* node, void* ctx) {
+            try {
+                static_cast<std::vector<lxb_dom_element_t*>*>(ctx)->push_back(
+                    lxb_dom_interface_element(node));
+                return true;
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+        }
+    } // namespace
+
+    HtmlElement::HtmlElement(lxb_dom_element_t* dom_el) : element_p{dom_el} {}
+
+    HtmlElement::HtmlElement(
+        lxb_dom_element_t* dom_el,
+        std::shared_ptr<lxb_html_document_t> document)
+        : element_p{dom_el}, document_{std::move(document)} {}
+
+    std::string HtmlElement::tag() const noexcept {
+        return Scrapp::to_lower(std::string(this->tag_name()));
+    }
+
+    std::string_view HtmlElement::tag_name() const noexcept {
+        size_t len;
+        auto name = lxb_dom_element_local_name(this->element_p, &len);
+        return to_string_view(name, len);
+    }
+
+    const Attributes HtmlElement::attributes() const noexcept {
+        Attributes attributes;
         lxb_dom_attr_t* attr = this->element_p->first_attr;
         while (attr != nullptr) {
-            size_t name_len, value_len;
+            size_t name_len, value_len = 0;
             auto name = lxb_dom_attr_local_name(attr, &name_len);
+            // a flag attribute has no value, to_string_view defaults it to
+            // the empty string
             auto value = lxb_dom_attr_value(attr, &value_len);
-            if (value == nullptr) {
-                // this attr is not a key-value pair
-                // default to empty string
-                value = (const lxb_char_t*)"";
-            }
-            auto s_name = std::string(reinterpret_cast<const char*>(name));
-            auto s_value = std::string(reinterpret_cast<const char*>(value));
-            this->attributes_[s_name] = s_value;
+            attributes.insert_or_assign(
+                std::string(to_string_view(name, name_len)),
+                std::string(to_string_view(value, value_len)));
             attr = lxb_dom_element_next_attribute(attr);
         }
-
-        size_t len;
-        auto text_content =
-            lxb_dom_node_text_content(&this->element_p->node, &len);
-        this->text_ = std::string(reinterpret_cast<const char*>(text_content));
+        return attributes;
     }
 
-    std::string HtmlElement::tag() const noexcept {
-        size_t len;
-        auto lxb_tag = lxb_dom_element_tag_name(this->element_p, &len);
-        auto tag = std::string(reinterpret_cast<const char*>(lxb_tag));
-        return Scrapp::to_lower(tag);
+    std::optional<std::string_view>
+    HtmlElement::attribute(std::string_view name) const noexcept {
+        lxb_dom_attr_t* attr = this->element_p->first_attr;
+        while (attr != nullptr) {
+            size_t name_len, value_len = 0;
+            auto attr_name = lxb_dom_attr_local_name(attr, &name_len);
+            if (to_string_view(attr_name, name_len) == name) {
+                auto value = lxb_dom_attr_value(attr, &value_len);
+                return to_string_view(value, value_len);
+            }
+            attr = lxb_dom_element_next_attribute(attr);
+        }
+        return std::nullopt;
     }
 
-    const Attributes HtmlElement::attributes() const noexcept {
-        return this->attributes_;
+    bool HtmlElement::has_attribute(std::string_view name) const noexcept {
+        return this->attribute(name).has_value();
     }
 
     std::string HtmlElement::get_attribute(const std::string& attr) const {
-        auto it = this->attributes_.find(attr);
-        if (it == this->attributes_.end()) {
+        auto value = this->attribute(attr);
+        if (!value) {
             throw attribute_error("element does not have attribute: " + attr);
         }
-        return (*it).second;
+        return std::string(*value);
     }
 
-    std::string HtmlElement::text() const noexcept { return this->text_; }
-
-    static lxb_status_t callback(
-        lxb_dom_node_t* node, lxb_css_selector_specificity_t* spec, void* ctx) {
-        auto* pointers = static_cast<std::vector<HtmlElement>*>(ctx);
-        HtmlElement element{lxb_dom_interface_element(node)};
-        auto it = std::find_if(
-            pointers->begin(), pointers->end(),
-            [element](const HtmlElement& other) { return element == other; });
-        if (it != pointers->end()) {
-            return LXB_STATUS_OK;
+    std::string HtmlElement::text() const noexcept {
+        size_t len = 0;
+        auto node = &this->element_p->node;
+        auto text_content = lxb_dom_node_text_content(node, &len);
+        if (text_content == nullptr) {
+            return {};
         }
-        pointers->push_back(element);
-        return LXB_STATUS_OK;
+        std::string text{reinterpret_cast<const char*>(text_content), len};
+        lxb_dom_document_destroy_text(node->owner_document, text_content);
+        return text;
+    }
+
+    std::string HtmlElement::visible_text(const TextOptions& options) const {
+        return Html::visible_text(&this->element_p->node, options);
+    }
+
+    void HtmlElement::visible_text(
+        std::string& out, const TextOptions& options) const {
+        append_visible_text(&this->element_p->node, out, options);
     }
 
     std::vector<HtmlElement>
     HtmlElement::css(const std::string& select) const noexcept {
-        lxb_status_t status;
-        auto selectors_string = (const lxb_char_t*)select.c_str();
-        unique_lxb_css_parser parser{lxb_css_parser_create()};
-        status = lxb_css_parser_init(parser.get(), nullptr, nullptr);
-        if (status != LXB_STATUS_OK) {
-            return {};
-        }
-        unique_lxb_selectors selectors{lxb_selectors_create()};
-        status = lxb_selectors_init(selectors.get());
-        if (status != LXB_STATUS_OK) {
-            return {};
+        if (auto compiled = detail::cached_selector(select)) {
+            return this->css(*compiled);
         }
+        return {};
+    }
 
-        unique_lxb_css_selector_list selector_list{lxb_css_selectors_parse(
-            parser.get(), selectors_string, select.length())};
-        if (parser->status != LXB_STATUS_OK) {
+    std::vector<HtmlElement>
+    HtmlElement::css(const CompiledSelector& selector) const noexcept {
+        std::vector<HtmlElement> found;
+        try {
+            this->for_each_match(
+                selector, [&found](const HtmlElement& element) {
+                    found.push_back(element);
+                });
+        } catch (const std::bad_alloc&) {
             return {};
         }
-        std::vector<HtmlElement> found;
-        lxb_selectors_find(
-            selectors.get(), &this->element_p->node, selector_list.get(),
-            callback, &found);
         return found;
     }
 
+    std::optional<HtmlElement>
+    HtmlElement::first(const CompiledSelector& selector) const noexcept {
+        lxb_dom_node_t* node = nullptr;
+        visit_matches(&this->element_p->node, selector, store_first, &node);
+        if (node == nullptr) {
+            return std::nullopt;
+        }
+        return HtmlElement{lxb_dom_interface_element(node), this->document_};
+    }
+
+    std::optional<HtmlElement>
+    HtmlElement::first(const std::string& selector) const noexcept {
+        if (auto compiled = detail::cached_selector(selector)) {
+            return this->first(*compiled);
+        }
+        return std::nullopt;
+    }
+
+    Matches
+    HtmlElement::matches(const CompiledSelector& selector) const noexcept {
+        return Matches{&this->element_p->node, this->document_, selector};
+    }
+
+    Matches HtmlElement::matches(const std::string& selector) const noexcept {
+        return Matches{
+            &this->element_p->node, this->document_,
+            detail::cached_selector(selector)};
+    }
+
+    std::vector<HtmlElement>
+    HtmlElement::xpath(const XPath& expression) const {
+        return detail::xpath_elements(
+            &this->element_p->node, this->document_, expression);
+    }
+
+    std::vector<HtmlElement>
+    HtmlElement::xpath(const std::string& expression) const {
+        return this->xpath(XPath{expression});
+    }
+
+    std::vector<std::string>
+    HtmlElement::xpath_strings(const XPath& expression) const {
+        return detail::xpath_strings(&this->element_p->node, expression);
+    }
+
+    std::vector<std::string>
+    HtmlElement::xpath_strings(const std::string& expression) const {
+        return this->xpath_strings(XPath{expression});
+    }
+
+    lxb_dom_element_t* HtmlElement::native_handle() const noexcept {
+        return this->element_p;
+    }
+
     bool HtmlElement::operator==(const HtmlElement& other) const noexcept {
         // All pointers are stored in lxb_html_document and lexbor just copies
         // pointer whenever necessary, so we just check if it is the same
@@ -118,4 +215,106 @@ namespace Scrapp::Html {
         return this->element_p == other.element_p;
     }
 
+    Matches::Matches(
+        lxb_dom_node_t* root, std::shared_ptr<lxb_html_document_t> document,
+        std::optional<CompiledSelector> selector)
+        : root_{root}, document_{std::move(document)},
+          selector_{std::move(selector)} {}
+
+    void Matches::evaluate() const {
+        if (this->evaluated_) {
+            return;
+        }
+        this->evaluated_ = true;
+        if (this->selector_) {
+            visit_matches(
+                this->root_, *this->selector_, collect_element,
+                &this->elements_);
+        }
+    }
+
+    Matches::iterator Matches::begin() const {
+        this->evaluate();
+        return iterator{this, this->elements_.cbegin()};
+    }
+
+    Matches::iterator Matches::end() const {
+        this->evaluate();
+        return iterator{this, this->elements_.cend()};
+    }
+
+    bool Matches::empty() const { return this->size() == 0; }
+
+    std::size_t Matches::size() const {
+        this->evaluate();
+        return this->elements_.size();
+    }
+
+    Matches::iterator::iterator(
+        const Matches* matches,
+        std::vector<lxb_dom_element_t*>::const_iterator it)
+        : matches_{matches}, it_{it} {}
+
+    HtmlElement Matches::iterator::operator*() const {
+        return HtmlElement{*this->it_, this->matches_->document_};
+    }
+
+    Matches::iterator& Matches::iterator::operator++() {
+        ++this->it_;
+        return *this;
+    }
+
+    Matches::iterator Matches::iterator::operator++(int) {
+        auto previous = *this;
+        ++this->it_;
+        return previous;
+    }
+
+    bool Matches::iterator::operator==(const iterator& other) const noexcept {
+        return this->it_ == other.it_;
+    }
+
+    bool Matches::iterator::operator!=(const iterator& other) const noexcept {
+        return this->it_ != other.it_;
+    }
+
+    namespace detail {
+        std::optional<CompiledSelector>
+        cached_selector(const std::string& selector) noexcept {
+            try {
+                return SelectorCache::local().get(selector);
+            } catch (const std::exception&) {
+                return std::nullopt;
+            }
+        }
+
+        std::vector<HtmlElement> xpath_elements(
+            lxb_dom_node_t* context,
+            const std::shared_ptr<lxb_html_document_t>& document,
+            const XPath& expression) {
+            std::vector<HtmlElement> elements;
+            for (auto* node : expression.select(context)) {
+                if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) {
+                    elements.emplace_back(
+                        lxb_dom_interface_element(node), document);
+                }
+            }
+            return elements;
+        }
+
+        std::vector<std::string>
+        xpath_strings(lxb_dom_node_t* context, const XPath& expression) {
+            auto value = expression.evaluate(context);
+            auto* nodes = std::get_if<XPathNodeSet>(&value);
+            if (nodes == nullptr) {
+                return {expression.string(context)};
+            }
+            std::vector<std::string> strings;
+            strings.reserve(nodes->size());
+            for (auto* node : *nodes) {
+                strings.push_back(xpath_string_value(node));
+            }
+            return strings;
+        }
+    } // namespace detail
 } // namespace Scrapp::Html
@@ -23,27 +23,209 @@
 #ifndef SCRAPP_ELEMENT_H
 #define SCRAPP_ELEMENT_H
 
+#include "selector.h"
+#include "text.h"
 #include "types.h"
+#include "xpath.h"
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace Scrapp::Html {
+    class Matches;
+
     class HtmlElement {
       public:
+        // Non-owning handle; the caller keeps the lexbor document alive.
         explicit HtmlElement(lxb_dom_element_t* dom_el);
+        // Handle that shares ownership of the document dom_el belongs to.
+        HtmlElement(
+            lxb_dom_element_t* dom_el,
+            std::shared_ptr<lxb_html_document_t> document);
         std::string tag() const noexcept;
+        // Local name as stored by lexbor, valid while the document lives.
+        std::string_view tag_name() const noexcept;
         const Attributes attributes() const noexcept;
         std::string get_attribute(const std::string& attr) const;
+        // Attribute value as stored by lexbor, valid while the document
+        // lives. Flag attributes have an empty value.
+        std::optional<std::string_view>
+        attribute(std::string_view name) const noexcept;
+        bool has_attribute(std::string_view name) const noexcept;
         std::string text() const noexcept;
+        // Rendered text without script or style content and with
+        // whitespace collapsed, see append_visible_text.
+        std::string visible_text(const TextOptions& options = {}) const;
+        void visible_text(
+            std::string& out, const TextOptions& options = {}) const;
         std::vector<HtmlElement> css(const std::string& select) const noexcept;
+        std::vector<HtmlElement>
+        css(const CompiledSelector& selector) const noexcept;
+
+        // Calls visitor with each element under this one that matches the
+        // selector, in document order. A visitor returning bool stops the
+        // search by returning false. Invalid selector strings match nothing.
+        template<class Visitor>
+        void for_each_match(
+            const CompiledSelector& selector, Visitor&& visitor) const;
+        template<class Visitor>
+        void
+        for_each_match(const std::string& selector, Visitor&& visitor) const;
+        // First match in document order; the search stops there unless
+        // the selector is a list.
+        std::optional<HtmlElement>
+        first(const CompiledSelector& selector) const noexcept;
+        std::optional<HtmlElement>
+        first(const std::string& selector) const noexcept;
+        // Matches evaluated when the range is first iterated.
+        Matches matches(const CompiledSelector& selector) const noexcept;
+        Matches matches(const std::string& selector) const noexcept;
+
+        // Elements selected by an XPath expression with this element as the
+        // context node; other kinds of nodes in the result are skipped.
+        // Throws xpath_error when the result is not a node-set.
+        std::vector<HtmlElement> xpath(const XPath& expression) const;
+        // Compiles expression on every call and throws xpath_error when it
+        // is invalid; keep an XPath around for repeated queries.
+        std::vector<HtmlElement> xpath(const std::string& expression) const;
+        // String-values of the nodes an expression selects, such as the
+        // values of @href in //a/@href. Other results give one string.
+        std::vector<std::string> xpath_strings(const XPath& expression) const;
+        std::vector<std::string>
+        xpath_strings(const std::string& expression) const;
+
+        lxb_dom_element_t* native_handle() const noexcept;
         bool operator==(const HtmlElement& other) const noexcept;
 
       private:
         // Not using unique pointer here because these pointers are deleted with
         // lxb_html_document_destroy
         lxb_dom_element_t* element_p;
-        Attributes attributes_;
-        std::string text_;
+        // Keeps the owning document alive for as long as the handle exists.
+        // Empty for handles created without an owner.
+        std::shared_ptr<lxb_html_document_t> document_;
     };
+
+    // Range over the elements a selector matches under a root node. Nothing
+    // is searched until the range is first iterated, and the search result
+    // is kept as bare node pointers; HtmlElement handles are only made when
+    // an iterator is dereferenced.
+    class Matches {
+      public:
+        class iterator {
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = HtmlElement;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = HtmlElement;
+
+            iterator() = default;
+            HtmlElement operator*() const;
+            iterator& operator++();
+            iterator operator++(int);
+            bool operator==(const iterator& other) const noexcept;
+            bool operator!=(const iterator& other) const noexcept;
+
+          private:
+            friend class Matches;
+            iterator(
+                const Matches* matches,
+                std::vector<lxb_dom_element_t*>::const_iterator it);
+            const Matches* matches_{};
+            std::vector<lxb_dom_element_t*>::const_iterator it_{};
+        };
+
+        Matches(
+            lxb_dom_node_t* root,
+            std::shared_ptr<lxb_html_document_t> document,
+            std::optional<CompiledSelector> selector);
+
+        iterator begin() const;
+        iterator end() const;
+        bool empty() const;
+        std::size_t size() const;
+
+      private:
+        void evaluate() const;
+
+        lxb_dom_node_t* root_;
+        std::shared_ptr<lxb_html_document_t> document_;
+        std::optional<CompiledSelector> selector_;
+        mutable std::vector<lxb_dom_element_t*> elements_;
+        mutable bool evaluated_{false};
+    };
+
+    namespace detail {
+        template<class Visitor> struct ElementVisit {
+            Visitor* visitor;
+            const std::shared_ptr<lxb_html_document_t>* document;
+            std::exception_ptr error;
+
+            // lexbor is C, so exceptions from the visitor are caught here and
+            // rethrown once the search has unwound.
+            static bool visit(lxb_dom_node_t* node, void* ctx) {
+                auto* self = static_cast<ElementVisit*>(ctx);
+                try {
+                    HtmlElement element{
+                        lxb_dom_interface_element(node), *self->document};
+                    using Result =
+                        std::invoke_result_t<Visitor&, const HtmlElement&>;
+                    if constexpr (std::is_convertible_v<Result, bool>) {
+                        return static_cast<bool>((*self->visitor)(element));
+                    } else {
+                        (*self->visitor)(element);
+                        return true;
+                    }
+                } catch (...) {
+                    self->error = std::current_exception();
+                    return false;
+                }
+            }
+        };
+
+        template<class Visitor>
+        void visit_elements(
+            lxb_dom_node_t* root,
+            const std::shared_ptr<lxb_html_document_t>& document,
+            const CompiledSelector& selector, Visitor& visitor) {
+            ElementVisit<Visitor> state{&visitor, &document, nullptr};
+            visit_matches(
+                root, selector, &ElementVisit<Visitor>::visit, &state);
+            if (state.error) {
+                std::rethrow_exception(state.error);
+            }
+        }
+
+        std::optional<CompiledSelector>
+        cached_selector(const std::string& selector) noexcept;
+
+        std::vector<HtmlElement> xpath_elements(
+            lxb_dom_node_t* context,
+            const std::shared_ptr<lxb_html_document_t>& document,
+            const XPath& expression);
+        std::vector<std::string>
+        xpath_strings(lxb_dom_node_t* context, const XPath& expression);
+    } // namespace detail
+
+    template<class Visitor>
+    void HtmlElement::for_each_match(
+        const CompiledSelector& selector, Visitor&& visitor) const {
+        detail::visit_elements(
+            &this->element_p->node, this->document_, selector, visitor);
+    }
+
+    template<class Visitor>
+    void HtmlElement::for_each_match(
+        const std::string& selector, Visitor&& visitor) const {
+        if (auto compiled = detail::cached_selector(selector)) {
+            this->for_each_match(*compiled, visitor);
+        }
+    }
 } // namespace Scrapp::Html
 
 #endif // SCRAPP_ELEMENT_H
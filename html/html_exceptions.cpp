@@ -27,4 +27,10 @@
 namespace Scrapp::Html {
     attribute_error::attribute_error(std::string message)
         : exception(std::move(message)) {}
+
+    selector_error::selector_error(std::string message)
+        : exception(std::move(message)) {}
+
+    xpath_error::xpath_error(std::string message)
+        : exception(std::move(message)) {}
 } // namespace Scrapp::Html
\ No newline at end of file
@@ -31,6 +31,16 @@ namespace Scrapp::Html {
         explicit attribute_error(std::string message);
     };
 
+    class selector_error : public exception {
+      public:
+        explicit selector_error(std::string message);
+    };
+
+    class xpath_error : public exception {
+      public:
+        explicit xpath_error(std::string message);
+    };
+
 } // namespace Scrapp::Html
 
 #endif // SCRAPP_HTML_EXCEPTIONS_H
@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "link_extractor.h"
+#include "../utils.h"
+
+namespace Scrapp::Html {
+    LinkExtractor::LinkExtractor()
+        : LinkExtractor({{"a", "href"},
+                         {"area", "href"},
+                         {"link", "href"},
+                         {"iframe", "src"},
+                         {"frame", "src"},
+                         {"img", "src"},
+                         {"script", "src"},
+                         {"source", "src"}}) {}
+
+    LinkExtractor::LinkExtractor(std::vector<Target> targets)
+        : targets_{std::move(targets)} {}
+
+    LinkExtractor& LinkExtractor::unique(bool unique) noexcept {
+        this->unique_ = unique;
+        return *this;
+    }
+
+    const std::vector<LinkExtractor::Target>&
+    LinkExtractor::targets() const noexcept {
+        return this->targets_;
+    }
+
+    std::vector<std::string> LinkExtractor::extract(
+        std::string_view html, std::string_view page_url) const {
+        std::vector<std::string> links;
+        this->for_each_link(html, page_url, [&links](std::string url) {
+            links.push_back(std::move(url));
+        });
+        return links;
+    }
+
+    std::string LinkExtractor::base_url(
+        std::string_view html, std::string_view page_url) {
+        // <base> belongs in the head, so stop looking once the body starts
+        // instead of scanning the whole page twice.
+        TagScanner scanner{html};
+        while (scanner.next()) {
+            if (scanner.is("body")) {
+                break;
+            }
+            if (scanner.is("base")) {
+                if (auto href = scanner.attribute("href")) {
+                    return resolve_url(page_url, decode_entities(*href));
+                }
+            }
+        }
+        return std::string(page_url);
+    }
+
+    std::string LinkExtractor::resolve(
+        std::string_view base, std::string_view value) {
+        std::string url;
+        if (value.find('&') != std::string_view::npos) {
+            url = resolve_url(base, decode_entities(value));
+        } else {
+            url = resolve_url(base, value);
+        }
+        auto scheme = std::string_view{url}.substr(0, url.find(':'));
+        if (scheme.size() == 4 || scheme.size() == 5) {
+            auto lowered = to_lower(std::string(scheme));
+            if (lowered == "http" || lowered == "https") {
+                return url;
+            }
+        }
+        return {};
+    }
+} // namespace Scrapp::Html
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_LINK_EXTRACTOR_H
+#define SCRAPP_LINK_EXTRACTOR_H
+
+#include "tag_scanner.h"
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace Scrapp::Html {
+    // Collects link URLs from raw HTML with a TagScanner, without building a
+    // DOM. Values are entity-decoded and resolved against the page URL, or
+    // against the first <base href> of the document when there is one.
+    // Only http and https URLs are kept, with their fragment removed.
+    class LinkExtractor {
+      public:
+        struct Target {
+            std::string tag;
+            std::string attribute;
+        };
+
+        // a, area, link, iframe and frame href/src, plus img, script and
+        // source src.
+        LinkExtractor();
+        // Tag and attribute names must be lowercase.
+        explicit LinkExtractor(std::vector<Target> targets);
+
+        // When set, every URL is returned once, at its first occurrence.
+        // Enabled by default.
+        LinkExtractor& unique(bool unique) noexcept;
+
+        [[nodiscard]] const std::vector<Target>& targets() const noexcept;
+
+        // Links of html in document order.
+        [[nodiscard]] std::vector<std::string>
+        extract(std::string_view html, std::string_view page_url) const;
+
+        // Calls visitor with each link of html in document order.
+        template<typename Visitor>
+        void for_each_link(std::string_view html, std::string_view page_url,
+                           Visitor&& visitor) const {
+            auto base = LinkExtractor::base_url(html, page_url);
+            std::unordered_set<std::string> seen;
+            TagScanner scanner{html};
+            while (scanner.next()) {
+                for (const auto& target : this->targets_) {
+                    if (!scanner.is(target.tag)) {
+                        continue;
+                    }
+                    auto value = scanner.attribute(target.attribute);
+                    if (!value) {
+                        continue;
+                    }
+                    auto url = LinkExtractor::resolve(base, *value);
+                    if (url.empty() ||
+                        (this->unique_ && !seen.insert(url).second)) {
+                        continue;
+                    }
+                    visitor(std::move(url));
+                }
+            }
+        }
+
+      private:
+        static std::string base_url(std::string_view html,
+                                    std::string_view page_url);
+        static std::string resolve(std::string_view base,
+                                   std::string_view value);
+
+        std::vector<Target> targets_;
+        bool unique_{true};
+    };
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_LINK_EXTRACTOR_H
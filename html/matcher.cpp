@@ -0,0 +1,485 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "matcher.h"
+#include "../utils.h"
+#include <cctype>
+#include <utility>
+
+namespace Scrapp::Html {
+    namespace {
+        using Compound = NodeMatcher::Compound;
+        using Complex = NodeMatcher::Complex;
+        using AttributeTest = NodeMatcher::AttributeTest;
+        using Combinator = NodeMatcher::Combinator;
+
+        bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                   c == '\f';
+        }
+
+        bool is_ident_char(char c) {
+            auto u = static_cast<unsigned char>(c);
+            return std::isalnum(u) || c == '-' || c == '_' || u >= 0x80;
+        }
+
+        char ascii_lower(char c) {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+        }
+
+        class Parser {
+          public:
+            explicit Parser(std::string_view input) : input_{input} {}
+
+            std::optional<std::vector<Complex>> parse() {
+                std::vector<Complex> list;
+                do {
+                    auto complex = this->parse_complex();
+                    if (!complex) {
+                        return std::nullopt;
+                    }
+                    list.push_back(std::move(*complex));
+                } while (this->consume(','));
+                this->skip_space();
+                if (this->pos_ != this->input_.size()) {
+                    return std::nullopt;
+                }
+                return list;
+            }
+
+          private:
+            std::optional<Complex> parse_complex() {
+                Complex complex;
+                this->skip_space();
+                auto first = this->parse_compound();
+                if (!first) {
+                    return std::nullopt;
+                }
+                complex.push_back(std::move(*first));
+                while (true) {
+                    bool had_space = this->skip_space();
+                    if (this->at_end() || this->peek() == ',') {
+                        return complex;
+                    }
+                    Combinator combinator = Combinator::descendant;
+                    if (this->peek() == '>') {
+                        combinator = Combinator::child;
+                    } else if (this->peek() == '+') {
+                        combinator = Combinator::adjacent;
+                    } else if (this->peek() == '~') {
+                        combinator = Combinator::sibling;
+                    } else if (!had_space) {
+                        return std::nullopt;
+                    }
+                    if (combinator != Combinator::descendant) {
+                        this->pos_++;
+                        this->skip_space();
+                    }
+                    auto next = this->parse_compound();
+                    if (!next) {
+                        return std::nullopt;
+                    }
+                    next->combinator = combinator;
+                    complex.push_back(std::move(*next));
+                }
+            }
+
+            std::optional<Compound> parse_compound() {
+                Compound compound;
+                bool empty = true;
+                if (this->consume('*')) {
+                    empty = false;
+                } else if (!this->at_end() && is_ident_char(this->peek())) {
+                    compound.tag = this->parse_ident();
+                    for (auto& c : compound.tag) {
+                        c = ascii_lower(c);
+                    }
+                    empty = false;
+                }
+                while (!this->at_end()) {
+                    char c = this->peek();
+                    if (c == '#' || c == '.') {
+                        this->pos_++;
+                        auto name = this->parse_ident();
+                        if (name.empty()) {
+                            return std::nullopt;
+                        }
+                        auto& target =
+                            c == '#' ? compound.ids : compound.classes;
+                        target.push_back(std::move(name));
+                    } else if (c == '[') {
+                        auto test = this->parse_attribute();
+                        if (!test) {
+                            return std::nullopt;
+                        }
+                        compound.attributes.push_back(std::move(*test));
+                    } else if (
+                        is_space(c) || c == ',' || c == '>' || c == '+' ||
+                        c == '~') {
+                        break;
+                    } else {
+                        // pseudo-classes, namespaces, escapes, ...
+                        return std::nullopt;
+                    }
+                    empty = false;
+                }
+                if (empty) {
+                    return std::nullopt;
+                }
+                return compound;
+            }
+
+            std::optional<AttributeTest> parse_attribute() {
+                using Operator = AttributeTest::Operator;
+                AttributeTest test;
+                this->pos_++; // '['
+                this->skip_space();
+                test.name = this->parse_ident();
+                if (test.name.empty()) {
+                    return std::nullopt;
+                }
+                for (auto& c : test.name) {
+                    c = ascii_lower(c);
+                }
+                this->skip_space();
+                if (this->consume(']')) {
+                    return test;
+                }
+                if (this->consume('=')) {
+                    test.op = Operator::equals;
+                } else {
+                    if (this->pos_ + 1 >= this->input_.size() ||
+                        this->input_[this->pos_ + 1] != '=') {
+                        return std::nullopt;
+                    }
+                    switch (this->peek()) {
+                    case '~':
+                        test.op = Operator::includes;
+                        break;
+                    case '|':
+                        test.op = Operator::dash;
+                        break;
+                    case '^':
+                        test.op = Operator::prefix;
+                        break;
+                    case '$':
+                        test.op = Operator::suffix;
+                        break;
+                    case '*':
+                        test.op = Operator::substring;
+                        break;
+                    default:
+                        return std::nullopt;
+                    }
+                    this->pos_ += 2;
+                }
+                this->skip_space();
+                if (this->at_end()) {
+                    return std::nullopt;
+                }
+                char quote = this->peek();
+                if (quote == '"' || quote == '\'') {
+                    auto end = this->input_.find(quote, this->pos_ + 1);
+                    auto value = this->input_.substr(
+                        this->pos_ + 1, end - this->pos_ - 1);
+                    if (end == std::string_view::npos ||
+                        value.find('\\') != std::string_view::npos) {
+                        return std::nullopt;
+                    }
+                    test.value = std::string(value);
+                    this->pos_ = end + 1;
+                } else {
+                    test.value = this->parse_ident();
+                    if (test.value.empty()) {
+                        return std::nullopt;
+                    }
+                }
+                this->skip_space();
+                if (!this->at_end() &&
+                    (this->peek() == 'i' || this->peek() == 'I')) {
+                    test.ignore_case = true;
+                    this->pos_++;
+                    this->skip_space();
+                } else if (
+                    !this->at_end() &&
+                    (this->peek() == 's' || this->peek() == 'S')) {
+                    this->pos_++;
+                    this->skip_space();
+                }
+                if (!this->consume(']')) {
+                    return std::nullopt;
+                }
+                return test;
+            }
+
+            std::string parse_ident() {
+                auto start = this->pos_;
+                while (!this->at_end() && is_ident_char(this->peek())) {
+                    this->pos_++;
+                }
+                return std::string(
+                    this->input_.substr(start, this->pos_ - start));
+            }
+
+            bool skip_space() {
+                auto start = this->pos_;
+                while (!this->at_end() && is_space(this->peek())) {
+                    this->pos_++;
+                }
+                return this->pos_ != start;
+            }
+
+            bool consume(char c) {
+                if (!this->at_end() && this->peek() == c) {
+                    this->pos_++;
+                    return true;
+                }
+                return false;
+            }
+
+            bool at_end() const { return this->pos_ >= this->input_.size(); }
+
+            char peek() const { return this->input_[this->pos_]; }
+
+            std::string_view input_;
+            std::size_t pos_{0};
+        };
+
+        std::string_view
+        attribute_value(lxb_dom_element_t* element, std::string_view name,
+                        bool& found) {
+            for (auto attr = element->first_attr; attr != nullptr;
+                 attr = lxb_dom_element_next_attribute(attr)) {
+                size_t name_len;
+                auto attr_name = lxb_dom_attr_local_name(attr, &name_len);
+                if (attr_name != nullptr &&
+                    std::string_view(
+                        reinterpret_cast<const char*>(attr_name), name_len) ==
+                        name) {
+                    found = true;
+                    size_t value_len = 0;
+                    auto value = lxb_dom_attr_value(attr, &value_len);
+                    if (value == nullptr) {
+                        return {};
+                    }
+                    return {reinterpret_cast<const char*>(value), value_len};
+                }
+            }
+            found = false;
+            return {};
+        }
+
+        bool has_token(std::string_view list, std::string_view token,
+                       bool ignore_case) {
+            std::size_t i = 0;
+            while (i < list.size()) {
+                while (i < list.size() && is_space(list[i])) {
+                    i++;
+                }
+                auto start = i;
+                while (i < list.size() && !is_space(list[i])) {
+                    i++;
+                }
+                auto candidate = list.substr(start, i - start);
+                if (!candidate.empty() &&
+                    (ignore_case ? equals_ignore_case(candidate, token)
+                                 : candidate == token)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool test_attribute(
+            lxb_dom_element_t* element, const AttributeTest& test) {
+            using Operator = AttributeTest::Operator;
+            bool found;
+            auto value = attribute_value(element, test.name, found);
+            if (!found) {
+                return false;
+            }
+            std::string_view expected = test.value;
+            auto same = [&test](std::string_view a, std::string_view b) {
+                return test.ignore_case ? equals_ignore_case(a, b) : a == b;
+            };
+            switch (test.op) {
+            case Operator::exists:
+                return true;
+            case Operator::equals:
+                return same(value, expected);
+            case Operator::includes:
+                return has_token(value, expected, test.ignore_case);
+            case Operator::dash:
+                return same(value, expected) ||
+                       (value.size() > expected.size() &&
+                        value[expected.size()] == '-' &&
+                        same(value.substr(0, expected.size()), expected));
+            case Operator::prefix:
+                return !expected.empty() && value.size() >= expected.size() &&
+                       same(value.substr(0, expected.size()), expected);
+            case Operator::suffix:
+                return !expected.empty() && value.size() >= expected.size() &&
+                       same(value.substr(value.size() - expected.size()),
+                            expected);
+            case Operator::substring:
+                if (expected.empty() || value.size() < expected.size()) {
+                    return false;
+                }
+                for (std::size_t i = 0; i + expected.size() <= value.size();
+                     i++) {
+                    if (same(value.substr(i, expected.size()), expected)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            return false;
+        }
+
+        bool match_compound(
+            const Compound& compound, lxb_dom_element_t* element) {
+            if (!compound.tag.empty()) {
+                size_t len;
+                auto name = lxb_dom_element_local_name(element, &len);
+                if (name == nullptr ||
+                    !equals_ignore_case(
+                        {reinterpret_cast<const char*>(name), len},
+                        compound.tag)) {
+                    return false;
+                }
+            }
+            // Like lexbor, ids and classes ignore case in quirks mode.
+            auto document = element->node.owner_document;
+            bool quirks =
+                document != nullptr &&
+                document->compat_mode == LXB_DOM_DOCUMENT_CMODE_QUIRKS;
+            if (!compound.ids.empty()) {
+                bool found;
+                auto id = attribute_value(element, "id", found);
+                for (const auto& expected : compound.ids) {
+                    if (!found || !(quirks ? equals_ignore_case(id, expected)
+                                           : id == expected)) {
+                        return false;
+                    }
+                }
+            }
+            if (!compound.classes.empty()) {
+                bool found;
+                auto classes = attribute_value(element, "class", found);
+                for (const auto& expected : compound.classes) {
+                    if (!found || !has_token(classes, expected, quirks)) {
+                        return false;
+                    }
+                }
+            }
+            for (const auto& test : compound.attributes) {
+                if (!test_attribute(element, test)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        lxb_dom_element_t* parent_element(lxb_dom_element_t* element) {
+            auto parent = element->node.parent;
+            if (parent == nullptr ||
+                parent->type != LXB_DOM_NODE_TYPE_ELEMENT) {
+                return nullptr;
+            }
+            return lxb_dom_interface_element(parent);
+        }
+
+        lxb_dom_element_t* previous_element(lxb_dom_element_t* element) {
+            for (auto node = element->node.prev; node != nullptr;
+                 node = node->prev) {
+                if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) {
+                    return lxb_dom_interface_element(node);
+                }
+            }
+            return nullptr;
+        }
+
+        bool match_from(
+            const Complex& complex, std::size_t index,
+            lxb_dom_element_t* element) {
+            if (!match_compound(complex[index], element)) {
+                return false;
+            }
+            if (index == 0) {
+                return true;
+            }
+            switch (complex[index].combinator) {
+            case Combinator::child: {
+                auto parent = parent_element(element);
+                return parent != nullptr &&
+                       match_from(complex, index - 1, parent);
+            }
+            case Combinator::descendant:
+                for (auto p = parent_element(element); p != nullptr;
+                     p = parent_element(p)) {
+                    if (match_from(complex, index - 1, p)) {
+                        return true;
+                    }
+                }
+                return false;
+            case Combinator::adjacent: {
+                auto sibling = previous_element(element);
+                return sibling != nullptr &&
+                       match_from(complex, index - 1, sibling);
+            }
+            case Combinator::sibling:
+                for (auto s = previous_element(element); s != nullptr;
+                     s = previous_element(s)) {
+                    if (match_from(complex, index - 1, s)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            return false;
+        }
+    } // namespace
+
+    std::optional<NodeMatcher> NodeMatcher::parse(std::string_view selectors) {
+        auto list = Parser{selectors}.parse();
+        if (!list) {
+            return std::nullopt;
+        }
+        NodeMatcher matcher;
+        matcher.selectors_ = std::move(*list);
+        return matcher;
+    }
+
+    bool NodeMatcher::matches(lxb_dom_element_t* element) const noexcept {
+        for (const auto& complex : this->selectors_) {
+            if (match_from(complex, complex.size() - 1, element)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<NodeMatcher::Complex>&
+    NodeMatcher::selectors() const noexcept {
+        return this->selectors_;
+    }
+} // namespace Scrapp::Html
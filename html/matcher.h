@@ -0,0 +1,84 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_MATCHER_H
+#define SCRAPP_MATCHER_H
+
+#include "types.h"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp::Html {
+    // Matches single elements against the common subset of CSS selectors:
+    // type and universal selectors, #id, .class, attribute selectors with
+    // every matching operator, the four combinators and selector lists.
+    // Unlike lexbor's selector engine, which searches a whole subtree, it
+    // answers "does this element match", which is what single pass
+    // traversals and index lookups need.
+    class NodeMatcher {
+      public:
+        enum class Combinator { descendant, child, adjacent, sibling };
+
+        struct AttributeTest {
+            enum class Operator {
+                exists,
+                equals,
+                includes,
+                dash,
+                prefix,
+                suffix,
+                substring
+            };
+            std::string name;
+            Operator op{Operator::exists};
+            std::string value;
+            bool ignore_case{false};
+        };
+
+        struct Compound {
+            // Lowercase tag name, empty for the universal selector.
+            std::string tag;
+            std::vector<std::string> ids;
+            std::vector<std::string> classes;
+            std::vector<AttributeTest> attributes;
+            // How this compound relates to the one on its left.
+            Combinator combinator{Combinator::descendant};
+        };
+
+        // Compounds of one complex selector, left to right.
+        using Complex = std::vector<Compound>;
+
+        // Returns nullopt if selectors uses anything outside the supported
+        // subset, such as pseudo-classes, namespaces or escapes.
+        static std::optional<NodeMatcher> parse(std::string_view selectors);
+
+        bool matches(lxb_dom_element_t* element) const noexcept;
+        const std::vector<Complex>& selectors() const noexcept;
+
+      private:
+        std::vector<Complex> selectors_;
+    };
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_MATCHER_H
@@ -0,0 +1,197 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "partial_parser.h"
+#include "document_index.h"
+#include "document_pool.h"
+#include <algorithm>
+#include <utility>
+
+namespace Scrapp::Html {
+    namespace {
+        // The node the tree builder inserted last, which is always the last
+        // node of the document in tree order.
+        lxb_dom_node_t* last_node(lxb_dom_node_t* root) {
+            auto node = root;
+            while (node->last_child != nullptr) {
+                node = node->last_child;
+            }
+            return node;
+        }
+
+        struct CompletionCheck {
+            lxb_dom_node_t* last;
+            bool complete;
+        };
+
+        // An element is complete once the parser has inserted something
+        // after its subtree, i.e. it no longer contains the last node.
+        bool find_complete(lxb_dom_node_t* node, void* ctx) {
+            auto check = static_cast<CompletionCheck*>(ctx);
+            for (auto p = check->last; p != nullptr; p = p->parent) {
+                if (p == node) {
+                    return true;
+                }
+            }
+            check->complete = true;
+            return false;
+        }
+    } // namespace
+
+    PartialParser::PartialParser(PartialParseOptions options)
+        : options_{std::move(options)},
+          document_{DocumentPool::local().acquire()},
+          satisfied_(options_.selectors.size(), false) {
+        if (this->options_.check_interval == 0) {
+            this->options_.check_interval = 4096;
+        }
+        lxb_html_document_parse_chunk_begin(this->document_.get());
+    }
+
+    PartialParser::~PartialParser() {
+        if (this->document_ != nullptr && !this->finished_) {
+            lxb_html_document_parse_chunk_end(this->document_.get());
+        }
+    }
+
+    bool PartialParser::feed(std::string_view chunk) {
+        if (this->stopped() || this->finished_) {
+            return false;
+        }
+        const auto& options = this->options_;
+        while (!chunk.empty()) {
+            auto slice = std::min(chunk.size(), options.check_interval);
+            if (options.byte_budget != 0) {
+                slice = std::min(slice, options.byte_budget - this->consumed_);
+            }
+            lxb_html_document_parse_chunk(
+                this->document_.get(),
+                reinterpret_cast<const lxb_char_t*>(chunk.data()), slice);
+            this->consumed_ += slice;
+            chunk.remove_prefix(slice);
+
+            if (options.stop_at_head_end && this->head_ended()) {
+                this->reason_ = StopReason::head_end;
+            } else if (!options.selectors.empty() &&
+                       this->selectors_satisfied()) {
+                this->reason_ = StopReason::selectors;
+            } else if (options.byte_budget != 0 &&
+                       this->consumed_ >= options.byte_budget) {
+                this->reason_ = StopReason::byte_budget;
+            }
+            if (this->stopped()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PartialParser::stopped() const noexcept {
+        return this->reason_ != StopReason::none;
+    }
+
+    PartialParser::StopReason PartialParser::stop_reason() const noexcept {
+        return this->reason_;
+    }
+
+    std::size_t PartialParser::consumed() const noexcept {
+        return this->consumed_;
+    }
+
+    HtmlDocument PartialParser::finish() {
+        if (!this->finished_) {
+            lxb_html_document_parse_chunk_end(this->document_.get());
+            this->finished_ = true;
+            DocumentIndex::attach(this->document_.get());
+        }
+        return HtmlDocument{this->document_};
+    }
+
+    bool PartialParser::head_ended() const noexcept {
+        // After </head> the tree builder appends everything, even
+        // whitespace, after the head element, and content that implicitly
+        // closes the head starts the body.
+        auto head = lxb_html_document_head_element(this->document_.get());
+        return (head != nullptr &&
+                lxb_dom_interface_node(head)->next != nullptr) ||
+               lxb_html_document_body_element(this->document_.get()) !=
+                   nullptr;
+    }
+
+    bool PartialParser::selectors_satisfied() {
+        auto root = &this->document_->dom_document.node;
+        auto last = last_node(root);
+        std::vector<lxb_dom_node_t*> open;
+        for (auto node = last; node != root; node = node->parent) {
+            if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) {
+                open.push_back(node);
+            }
+        }
+        auto is_open = [&open](lxb_dom_node_t* node) {
+            return std::find(open.begin(), open.end(), node) != open.end();
+        };
+        // Elements completed since the previous check: those open then and
+        // closed now, and those inserted since, which follow the previous
+        // last node in tree order.
+        std::vector<lxb_dom_element_t*> completed;
+        for (auto node : this->open_) {
+            if (!is_open(node)) {
+                completed.push_back(lxb_dom_interface_element(node));
+            }
+        }
+        auto node = this->checked_ == nullptr
+                        ? root->first_child
+                        : next_in_tree(this->checked_, root);
+        for (; node != nullptr; node = next_in_tree(node, root)) {
+            if (node->type == LXB_DOM_NODE_TYPE_ELEMENT && !is_open(node)) {
+                completed.push_back(lxb_dom_interface_element(node));
+            }
+            if (node == last) {
+                break;
+            }
+        }
+        this->checked_ = last;
+        this->open_ = std::move(open);
+
+        bool all = true;
+        for (std::size_t i = 0; i < this->satisfied_.size(); ++i) {
+            if (this->satisfied_[i]) {
+                continue;
+            }
+            const auto& selector = this->options_.selectors[i];
+            if (auto matcher = selector.matcher()) {
+                this->satisfied_[i] = std::any_of(
+                    completed.begin(), completed.end(),
+                    [matcher](lxb_dom_element_t* element) {
+                        return matcher->matches(element);
+                    });
+            } else {
+                // Selectors outside NodeMatcher's subset search the tree.
+                CompletionCheck check{last, false};
+                visit_matches(root, selector, find_complete, &check);
+                this->satisfied_[i] = check.complete;
+            }
+            all = all && this->satisfied_[i];
+        }
+        return all;
+    }
+} // namespace Scrapp::Html
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_PARTIAL_PARSER_H
+#define SCRAPP_PARTIAL_PARSER_H
+
+#include "document.h"
+#include "selector.h"
+#include "types.h"
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp::Html {
+    struct PartialParseOptions {
+        // Stop once the parser has moved past </head>.
+        bool stop_at_head_end{false};
+        // Stop after this many bytes, 0 for no limit.
+        std::size_t byte_budget{0};
+        // Stop once each selector has matched an element that has been
+        // parsed completely. Each check only tests the elements completed
+        // since the previous one, except for selectors NodeMatcher cannot
+        // evaluate, which search the whole tree.
+        std::vector<CompiledSelector> selectors{};
+        // Chunks are parsed in slices of this many bytes, and the stop
+        // conditions are checked after each slice.
+        std::size_t check_interval{4096};
+    };
+
+    // Builds an HtmlDocument from a page delivered in chunks, and stops
+    // tokenizing as soon as the part of the page the caller needs has been
+    // parsed, e.g. the <head> metadata. The document is finished as if the
+    // page ended there, so elements still open are closed.
+    //
+    // feed() returns false once parsing has stopped, so it can serve as a
+    // download write callback that cancels the rest of the transfer.
+    class PartialParser {
+      public:
+        enum class StopReason { none, head_end, byte_budget, selectors };
+
+        explicit PartialParser(PartialParseOptions options = {});
+        PartialParser(PartialParser&&) noexcept = default;
+        PartialParser& operator=(PartialParser&&) = delete;
+        PartialParser(const PartialParser&) = delete;
+        PartialParser& operator=(const PartialParser&) = delete;
+        ~PartialParser();
+
+        // Parses the next chunk of the page. Returns false once a stop
+        // condition is met; later chunks are ignored.
+        bool feed(std::string_view chunk);
+        [[nodiscard]] bool stopped() const noexcept;
+        [[nodiscard]] StopReason stop_reason() const noexcept;
+        // Number of bytes handed to the tokenizer.
+        [[nodiscard]] std::size_t consumed() const noexcept;
+        // Ends parsing and returns the document. Calling it again returns
+        // the same document.
+        HtmlDocument finish();
+
+      private:
+        [[nodiscard]] bool head_ended() const noexcept;
+        bool selectors_satisfied();
+
+        PartialParseOptions options_;
+        std::shared_ptr<lxb_html_document_t> document_;
+        std::vector<bool> satisfied_;
+        // Last node at the previous selector check and the elements
+        // containing it then, still open.
+        lxb_dom_node_t* checked_{nullptr};
+        std::vector<lxb_dom_node_t*> open_;
+        std::size_t consumed_{};
+        StopReason reason_{StopReason::none};
+        bool finished_{false};
+    };
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_PARTIAL_PARSER_H
@@ -0,0 +1,195 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "schema.h"
+#include <unordered_set>
+#include <utility>
+
+namespace Scrapp::Html {
+    namespace {
+        const std::vector<std::string> no_values;
+
+        bool collect_node(lxb_dom_node_t* node, void* ctx) {
+            try {
+                static_cast<std::unordered_set<lxb_dom_node_t*>*>(ctx)->insert(
+                    node);
+                return true;
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+        }
+    } // namespace
+
+    const std::vector<std::string>&
+    Record::values(std::string_view name) const {
+        for (std::size_t i = 0; i < this->names_->size(); i++) {
+            if ((*this->names_)[i] == name) {
+                return this->values_[i];
+            }
+        }
+        return no_values;
+    }
+
+    std::optional<std::string_view>
+    Record::value(std::string_view name) const {
+        const auto& values = this->values(name);
+        if (values.empty()) {
+            return std::nullopt;
+        }
+        return values.front();
+    }
+
+    const std::vector<std::string>& Record::names() const noexcept {
+        return *this->names_;
+    }
+
+    ExtractionSchema::ExtractionSchema(std::vector<Field> fields) {
+        std::vector<std::string> names;
+        this->add_fields(fields, "", this->roots_, names);
+        this->names_ =
+            std::make_shared<const std::vector<std::string>>(std::move(names));
+    }
+
+    void ExtractionSchema::add_fields(
+        const std::vector<Field>& fields, const std::string& prefix,
+        std::vector<std::size_t>& ids, std::vector<std::string>& names) {
+        for (const auto& field : fields) {
+            auto id = this->slots_.size();
+            ids.push_back(id);
+            names.push_back(prefix + field.name);
+            this->slots_.push_back(Slot{
+                CompiledSelector{field.selector}, field.attribute,
+                field.cardinality, {}});
+            std::vector<std::size_t> children;
+            this->add_fields(
+                field.fields, prefix + field.name + ".", children, names);
+            this->slots_[id].children = std::move(children);
+        }
+    }
+
+    Record ExtractionSchema::extract(const HtmlDocument& document) const {
+        return this->run(&document.native_handle()->dom_document.node);
+    }
+
+    Record ExtractionSchema::extract(const HtmlElement& element) const {
+        return this->run(&element.native_handle()->node);
+    }
+
+    Record ExtractionSchema::run(lxb_dom_node_t* root) const {
+        Record record;
+        record.names_ = this->names_;
+        record.values_.resize(this->slots_.size());
+
+        // Selectors outside NodeMatcher's subset are answered up front by
+        // lexbor, one search each, and looked up by node during the walk.
+        std::vector<std::unordered_set<lxb_dom_node_t*>> fallback(
+            this->slots_.size());
+        for (std::size_t id = 0; id < this->slots_.size(); id++) {
+            if (this->slots_[id].selector.matcher() == nullptr) {
+                visit_matches(
+                    root, this->slots_[id].selector, collect_node,
+                    &fallback[id]);
+            }
+        }
+        auto matches = [this, &fallback](std::size_t id, lxb_dom_node_t* node) {
+            auto matcher = this->slots_[id].selector.matcher();
+            if (matcher != nullptr) {
+                return matcher->matches(lxb_dom_interface_element(node));
+            }
+            return fallback[id].count(node) != 0;
+        };
+
+        // Fields are active inside a scope: the root for top level fields,
+        // and each element a group matched for that group's sub-fields.
+        struct Scope {
+            lxb_dom_node_t* node;
+            const std::vector<std::size_t>* fields;
+            std::vector<bool> filled;
+        };
+        std::vector<Scope> scopes;
+        scopes.push_back(
+            Scope{root, &this->roots_, std::vector<bool>(this->roots_.size())});
+        std::vector<Scope> opened;
+
+        auto enter = [&](lxb_dom_node_t* node) {
+            if (node->type != LXB_DOM_NODE_TYPE_ELEMENT) {
+                return;
+            }
+            for (auto& scope : scopes) {
+                for (std::size_t i = 0; i < scope.fields->size(); i++) {
+                    auto id = (*scope.fields)[i];
+                    const auto& slot = this->slots_[id];
+                    if ((slot.cardinality == Cardinality::one &&
+                         scope.filled[i]) ||
+                        !matches(id, node)) {
+                        continue;
+                    }
+                    scope.filled[i] = true;
+                    if (!slot.children.empty()) {
+                        opened.push_back(Scope{
+                            node, &slot.children,
+                            std::vector<bool>(slot.children.size())});
+                        continue;
+                    }
+                    HtmlElement element{lxb_dom_interface_element(node)};
+                    if (slot.attribute.empty()) {
+                        record.values_[id].push_back(element.text());
+                    } else if (auto value = element.attribute(slot.attribute)) {
+                        record.values_[id].emplace_back(*value);
+                    }
+                }
+            }
+            // Sub-fields only match descendants, so the scopes a node opens
+            // become active after the node itself has been tested.
+            for (auto& scope : opened) {
+                scopes.push_back(std::move(scope));
+            }
+            opened.clear();
+        };
+        auto leave = [&scopes](lxb_dom_node_t* node) {
+            while (scopes.size() > 1 && scopes.back().node == node) {
+                scopes.pop_back();
+            }
+        };
+
+        auto node = root->first_child;
+        while (node != nullptr) {
+            enter(node);
+            if (node->first_child != nullptr) {
+                node = node->first_child;
+                continue;
+            }
+            while (node != nullptr) {
+                leave(node);
+                if (node->next != nullptr) {
+                    node = node->next;
+                    break;
+                }
+                node = node->parent;
+                if (node == root) {
+                    node = nullptr;
+                }
+            }
+        }
+        return record;
+    }
+} // namespace Scrapp::Html
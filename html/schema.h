@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_SCHEMA_H
+#define SCRAPP_SCHEMA_H
+
+#include "document.h"
+#include "element.h"
+#include "selector.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp::Html {
+    enum class Cardinality { one, many };
+
+    // One named value to extract. A field with sub-fields is a group: its
+    // selector scopes the sub-fields, which are matched inside each element
+    // the group matches, and it records no value of its own.
+    struct Field {
+        std::string name;
+        std::string selector;
+        // Attribute to read, the element text if empty.
+        std::string attribute{};
+        Cardinality cardinality{Cardinality::one};
+        std::vector<Field> fields{};
+    };
+
+    // Values produced by ExtractionSchema::extract. Sub-fields are flattened
+    // to dotted names such as "offers.price".
+    class Record {
+      public:
+        // Every value extracted for name, empty if there were none.
+        const std::vector<std::string>& values(std::string_view name) const;
+        // First value extracted for name.
+        std::optional<std::string_view> value(std::string_view name) const;
+        const std::vector<std::string>& names() const noexcept;
+
+      private:
+        friend class ExtractionSchema;
+        std::shared_ptr<const std::vector<std::string>> names_;
+        std::vector<std::vector<std::string>> values_;
+    };
+
+    // A set of fields compiled once and evaluated in a single traversal of
+    // the document, instead of one css() walk per field. Selectors
+    // NodeMatcher cannot handle are resolved with one lexbor search each
+    // before the traversal.
+    class ExtractionSchema {
+      public:
+        // Throws selector_error if any selector is invalid.
+        explicit ExtractionSchema(std::vector<Field> fields);
+
+        Record extract(const HtmlDocument& document) const;
+        // Extracts from the descendants of element.
+        Record extract(const HtmlElement& element) const;
+
+      private:
+        struct Slot {
+            CompiledSelector selector;
+            std::string attribute;
+            Cardinality cardinality;
+            std::vector<std::size_t> children;
+        };
+
+        void add_fields(
+            const std::vector<Field>& fields, const std::string& prefix,
+            std::vector<std::size_t>& ids, std::vector<std::string>& names);
+        Record run(lxb_dom_node_t* root) const;
+
+        std::vector<Slot> slots_;
+        std::vector<std::size_t> roots_;
+        std::shared_ptr<const std::vector<std::string>> names_;
+    };
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_SCHEMA_H
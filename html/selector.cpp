@@ -0,0 +1,327 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "selector.h"
+#include "document_index.h"
+#include "html_exceptions.h"
+#include <cctype>
+#include <new>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Scrapp::Html {
+    namespace {
+        // Each thread keeps one parser for compiling selectors. Parsing never
+        // calls back into user code, so it is never used re-entrantly.
+        lxb_css_parser_t* local_parser() {
+            thread_local unique_lxb_css_parser parser = [] {
+                unique_lxb_css_parser p{lxb_css_parser_create()};
+                if (lxb_css_parser_init(p.get(), nullptr, nullptr) !=
+                    LXB_STATUS_OK) {
+                    return unique_lxb_css_parser{};
+                }
+                return p;
+            }();
+            return parser.get();
+        }
+
+        // Selector engines are leased from a per-thread free list rather than
+        // shared as a single thread_local, because a match callback may run
+        // another query on the same thread while the first is in flight.
+        class EngineLease {
+          public:
+            EngineLease() {
+                auto& idle = idle_engines();
+                if (!idle.empty()) {
+                    engine_ = std::move(idle.back());
+                    idle.pop_back();
+                    return;
+                }
+                engine_.reset(lxb_selectors_create());
+                if (lxb_selectors_init(engine_.get()) != LXB_STATUS_OK) {
+                    engine_.reset();
+                }
+            }
+
+            ~EngineLease() {
+                if (engine_ != nullptr) {
+                    lxb_selectors_clean(engine_.get());
+                    idle_engines().push_back(std::move(engine_));
+                }
+            }
+
+            EngineLease(const EngineLease&) = delete;
+            EngineLease& operator=(const EngineLease&) = delete;
+
+            lxb_selectors_t* get() const noexcept { return engine_.get(); }
+
+          private:
+            static std::vector<unique_lxb_selectors>& idle_engines() {
+                thread_local std::vector<unique_lxb_selectors> idle;
+                return idle;
+            }
+
+            unique_lxb_selectors engine_;
+        };
+
+        // Whether selectors is one compound selector such as "a.link[href]",
+        // i.e. has no selector list commas and no combinators outside of
+        // brackets, parentheses and strings.
+        bool is_single_compound(std::string_view selectors) {
+            auto is_space = [](char c) {
+                return std::isspace(static_cast<unsigned char>(c)) != 0;
+            };
+            while (!selectors.empty() && is_space(selectors.front())) {
+                selectors.remove_prefix(1);
+            }
+            while (!selectors.empty() && is_space(selectors.back())) {
+                selectors.remove_suffix(1);
+            }
+            int depth = 0;
+            char quote = 0;
+            for (std::size_t i = 0; i < selectors.size(); i++) {
+                char c = selectors[i];
+                if (quote != 0) {
+                    if (c == '\\') {
+                        i++;
+                    } else if (c == quote) {
+                        quote = 0;
+                    }
+                    continue;
+                }
+                switch (c) {
+                case '\\':
+                    i++;
+                    break;
+                case '"':
+                case '\'':
+                    quote = c;
+                    break;
+                case '(':
+                case '[':
+                    depth++;
+                    break;
+                case ')':
+                case ']':
+                    depth--;
+                    break;
+                case ',':
+                case '>':
+                case '+':
+                case '~':
+                    if (depth == 0) {
+                        return false;
+                    }
+                    break;
+                default:
+                    if (depth == 0 && is_space(c)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        struct VisitState {
+            NodeVisitor visitor;
+            void* ctx;
+            std::unordered_set<lxb_dom_node_t*>* seen;
+            bool stopped;
+        };
+
+        lxb_status_t visit_callback(
+            lxb_dom_node_t* node, lxb_css_selector_specificity_t*, void* ctx) {
+            auto* state = static_cast<VisitState*>(ctx);
+            if (state->stopped) {
+                return LXB_STATUS_STOP;
+            }
+            try {
+                if (state->seen != nullptr &&
+                    !state->seen->insert(node).second) {
+                    return LXB_STATUS_OK;
+                }
+            } catch (const std::bad_alloc&) {
+                return LXB_STATUS_ERROR;
+            }
+            if (!state->visitor(node, state->ctx)) {
+                state->stopped = true;
+                return LXB_STATUS_STOP;
+            }
+            return LXB_STATUS_OK;
+        }
+
+        lxb_status_t collect_callback(
+            lxb_dom_node_t* node, lxb_css_selector_specificity_t*, void* ctx) {
+            try {
+                static_cast<std::unordered_set<lxb_dom_node_t*>*>(ctx)->insert(
+                    node);
+            } catch (const std::bad_alloc&) {
+                return LXB_STATUS_ERROR;
+            }
+            return LXB_STATUS_OK;
+        }
+    } // namespace
+
+    CompiledSelector::CompiledSelector(std::string_view selectors) {
+        auto parser = local_parser();
+        if (parser == nullptr) {
+            throw selector_error("could not initialize css parser");
+        }
+        lxb_css_parser_clean(parser);
+        unique_lxb_css_selector_list list{lxb_css_selectors_parse(
+            parser, reinterpret_cast<const lxb_char_t*>(selectors.data()),
+            selectors.size())};
+        if (parser->status != LXB_STATUS_OK || list == nullptr) {
+            throw selector_error(
+                "invalid css selector: " + std::string(selectors));
+        }
+        this->state_ = std::make_shared<const State>(State{
+            std::string(selectors), std::move(list),
+            !is_single_compound(selectors), NodeMatcher::parse(selectors)});
+    }
+
+    const std::string& CompiledSelector::source() const noexcept {
+        return this->state_->source;
+    }
+
+    lxb_css_selector_list_t* CompiledSelector::list() const noexcept {
+        return this->state_->list.get();
+    }
+
+    bool CompiledSelector::may_repeat_matches() const noexcept {
+        return this->state_->may_repeat_matches;
+    }
+
+    const NodeMatcher* CompiledSelector::matcher() const noexcept {
+        return this->state_->matcher ? &*this->state_->matcher : nullptr;
+    }
+
+    bool
+    CompiledSelector::operator==(const CompiledSelector& other) const noexcept {
+        return this->state_ == other.state_;
+    }
+
+    SelectorCache::SelectorCache(std::size_t capacity)
+        : capacity_{capacity == 0 ? 1 : capacity} {}
+
+    SelectorCache& SelectorCache::local() {
+        thread_local SelectorCache cache;
+        return cache;
+    }
+
+    CompiledSelector SelectorCache::get(std::string_view selectors) {
+        auto it = this->index_.find(selectors);
+        if (it != this->index_.end()) {
+            this->entries_.splice(
+                this->entries_.begin(), this->entries_, it->second);
+            return *it->second;
+        }
+
+        CompiledSelector compiled{selectors};
+        if (this->entries_.size() >= this->capacity_) {
+            this->index_.erase(this->entries_.back().source());
+            this->entries_.pop_back();
+        }
+        this->entries_.push_front(compiled);
+        // The key views the source string owned by the shared selector
+        // state, which lives as long as the entry.
+        this->index_.emplace(
+            this->entries_.front().source(), this->entries_.begin());
+        return compiled;
+    }
+
+    void SelectorCache::set_capacity(std::size_t capacity) {
+        this->capacity_ = capacity == 0 ? 1 : capacity;
+        while (this->entries_.size() > this->capacity_) {
+            this->index_.erase(this->entries_.back().source());
+            this->entries_.pop_back();
+        }
+    }
+
+    std::size_t SelectorCache::capacity() const noexcept {
+        return this->capacity_;
+    }
+
+    std::size_t SelectorCache::size() const noexcept {
+        return this->entries_.size();
+    }
+
+    void SelectorCache::clear() noexcept {
+        this->index_.clear();
+        this->entries_.clear();
+    }
+
+    lxb_status_t visit_matches(
+        lxb_dom_node_t* root, const CompiledSelector& selector,
+        NodeVisitor visitor, void* ctx) {
+        // Document-wide queries whose selectors each name a tag, id or class
+        // only test the indexed candidates instead of searching the tree.
+        auto matcher = selector.matcher();
+        if (matcher != nullptr && DocumentIndex::indexable(*matcher)) {
+            if (auto index = DocumentIndex::of(root)) {
+                try {
+                    index->visit(*matcher, [&](lxb_dom_element_t* element) {
+                        return visitor(&element->node, ctx);
+                    });
+                } catch (const std::bad_alloc&) {
+                    return LXB_STATUS_ERROR_MEMORY_ALLOCATION;
+                }
+                return LXB_STATUS_OK;
+            }
+        }
+        EngineLease engine;
+        if (engine.get() == nullptr) {
+            return LXB_STATUS_ERROR;
+        }
+        // Selector lists and combinators can reach the same node more than
+        // once, everything else is reported at most once and skips the set.
+        std::unordered_set<lxb_dom_node_t*> seen;
+        if (selector.list()->next != nullptr) {
+            // lexbor reports a list's matches grouped by selector; collect
+            // them and report them in document order like the index does.
+            auto status = lxb_selectors_find(
+                engine.get(), root, selector.list(), collect_callback, &seen);
+            if (status != LXB_STATUS_OK) {
+                return status;
+            }
+            auto remaining = seen.size();
+            for (auto node = root; node != nullptr && remaining > 0;
+                 node = next_in_tree(node, root)) {
+                if (seen.count(node) != 0) {
+                    --remaining;
+                    if (!visitor(node, ctx)) {
+                        break;
+                    }
+                }
+            }
+            return LXB_STATUS_OK;
+        }
+        VisitState state{
+            visitor, ctx, selector.may_repeat_matches() ? &seen : nullptr,
+            false};
+        auto status = lxb_selectors_find(
+            engine.get(), root, selector.list(), visit_callback, &state);
+        return state.stopped ? static_cast<lxb_status_t>(LXB_STATUS_OK)
+                             : status;
+    }
+} // namespace Scrapp::Html
@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_SELECTOR_H
+#define SCRAPP_SELECTOR_H
+
+#include "matcher.h"
+#include "types.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Scrapp::Html {
+    // A CSS selector list parsed once and reusable on any number of
+    // documents. Copies share the parsed list, and a CompiledSelector may be
+    // used concurrently from several threads.
+    class CompiledSelector {
+      public:
+        // Throws selector_error if selectors is not a valid selector list.
+        explicit CompiledSelector(std::string_view selectors);
+
+        [[nodiscard]] const std::string& source() const noexcept;
+        [[nodiscard]] lxb_css_selector_list_t* list() const noexcept;
+        // False when the selector is a single compound selector, which lexbor
+        // can never report twice for the same node.
+        [[nodiscard]] bool may_repeat_matches() const noexcept;
+        // Per-element matcher for the selector, or nullptr if it uses
+        // features only lexbor's engine supports.
+        [[nodiscard]] const NodeMatcher* matcher() const noexcept;
+        bool operator==(const CompiledSelector& other) const noexcept;
+
+      private:
+        struct State {
+            std::string source;
+            unique_lxb_css_selector_list list;
+            bool may_repeat_matches;
+            std::optional<NodeMatcher> matcher;
+        };
+        std::shared_ptr<const State> state_;
+    };
+
+    // Least recently used cache of compiled selectors. Each thread has its
+    // own instance, reachable through local(), so lookups take no locks.
+    class SelectorCache {
+      public:
+        static constexpr std::size_t default_capacity = 64;
+
+        explicit SelectorCache(std::size_t capacity = default_capacity);
+        static SelectorCache& local();
+
+        // Returns the cached selector for selectors, compiling it on a miss.
+        // Throws selector_error if selectors is not a valid selector list.
+        CompiledSelector get(std::string_view selectors);
+        void set_capacity(std::size_t capacity);
+        [[nodiscard]] std::size_t capacity() const noexcept;
+        [[nodiscard]] std::size_t size() const noexcept;
+        void clear() noexcept;
+
+      private:
+        std::size_t capacity_;
+        std::list<CompiledSelector> entries_;
+        std::unordered_map<
+            std::string_view, std::list<CompiledSelector>::iterator>
+            index_;
+    };
+
+    // Called for each node a selector matches; returning false stops the
+    // search.
+    using NodeVisitor = bool (*)(lxb_dom_node_t* node, void* ctx);
+
+    // Runs selector on the subtree rooted at root with one of the calling
+    // thread's selector engines and reports each matched node once, in
+    // document order. The matches of a selector list are found before the
+    // first is reported.
+    lxb_status_t visit_matches(
+        lxb_dom_node_t* root, const CompiledSelector& selector,
+        NodeVisitor visitor, void* ctx);
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_SELECTOR_H
@@ -0,0 +1,302 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "tag_scanner.h"
+#include "../utils.h"
+#include <array>
+#include <cstring>
+
+namespace Scrapp::Html {
+    namespace {
+        constexpr std::array<std::string_view, 10> raw_text_elements{
+            "script", "style",   "textarea", "title",    "xmp",
+            "iframe", "noembed", "noframes", "noscript", "plaintext"};
+
+        constexpr bool is_space(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                   c == '\f';
+        }
+
+        constexpr bool is_alpha(char c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        void append_utf8(std::string& out, unsigned long code) {
+            if (code == 0 || code > 0x10FFFF ||
+                (code >= 0xD800 && code <= 0xDFFF)) {
+                code = 0xFFFD;
+            }
+            if (code < 0x80) {
+                out += static_cast<char>(code);
+            } else if (code < 0x800) {
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+    } // namespace
+
+    TagScanner::TagScanner(std::string_view html) noexcept : html_{html} {}
+
+    bool TagScanner::next() noexcept {
+        const auto size = this->html_.size();
+        while (this->position_ < size) {
+            // memchr is vectorized by the C library, so the text between
+            // tags is skipped a register at a time.
+            const auto* found = static_cast<const char*>(std::memchr(
+                this->html_.data() + this->position_, '<',
+                size - this->position_));
+            if (found == nullptr || found + 1 >= this->html_.data() + size) {
+                break;
+            }
+            auto start = static_cast<std::size_t>(found - this->html_.data());
+            auto c = this->html_[start + 1];
+            if (c == '!') {
+                this->position_ =
+                    this->html_.compare(start, 4, "<!--") == 0
+                        ? this->skip_past("-->", start + 4)
+                        : this->skip_past(">", start + 2);
+                continue;
+            }
+            if (c == '/' || c == '?') {
+                this->position_ = this->skip_past(">", start + 2);
+                continue;
+            }
+            if (!is_alpha(c)) {
+                this->position_ = start + 1;
+                continue;
+            }
+
+            auto i = start + 1;
+            while (i < size && !is_space(this->html_[i]) &&
+                   this->html_[i] != '/' && this->html_[i] != '>') {
+                ++i;
+            }
+            this->offset_ = start;
+            this->name_ = this->html_.substr(start + 1, i - start - 1);
+
+            // Quotes only open a value right after '=', so a stray quote in
+            // an attribute name cannot swallow the rest of the page.
+            auto attributes_start = i;
+            char quote = 0;
+            char previous = 0;
+            for (; i < size; ++i) {
+                auto ch = this->html_[i];
+                if (quote != 0) {
+                    if (ch == quote) {
+                        quote = 0;
+                    }
+                } else if (ch == '>') {
+                    break;
+                } else if ((ch == '"' || ch == '\'') && previous == '=') {
+                    quote = ch;
+                }
+                if (!is_space(ch)) {
+                    previous = ch;
+                }
+            }
+            this->attributes_ = this->html_.substr(
+                attributes_start, i - attributes_start);
+            this->position_ = i < size ? i + 1 : size;
+
+            this->raw_text_ = {};
+            for (auto element : raw_text_elements) {
+                if (this->is(element)) {
+                    auto end = element == "plaintext"
+                                   ? size
+                                   : this->find_end_tag(this->position_);
+                    this->raw_text_ = this->html_.substr(
+                        this->position_, end - this->position_);
+                    this->position_ = end;
+                    break;
+                }
+            }
+            return true;
+        }
+        this->position_ = size;
+        return false;
+    }
+
+    std::string_view TagScanner::name() const noexcept { return this->name_; }
+
+    bool TagScanner::is(std::string_view lower_name) const noexcept {
+        return equals_ignore_case(this->name_, lower_name);
+    }
+
+    std::optional<std::string_view>
+    TagScanner::attribute(std::string_view lower_name) const noexcept {
+        auto attributes = this->attributes_;
+        std::size_t i = 0;
+        const auto size = attributes.size();
+        while (i < size) {
+            while (i < size &&
+                   (is_space(attributes[i]) || attributes[i] == '/')) {
+                ++i;
+            }
+            auto name_start = i;
+            // The first character of a name may be '=', per the tokenizer.
+            if (i < size) {
+                ++i;
+            }
+            while (i < size && !is_space(attributes[i]) &&
+                   attributes[i] != '/' && attributes[i] != '=') {
+                ++i;
+            }
+            auto name = attributes.substr(name_start, i - name_start);
+            while (i < size && is_space(attributes[i])) {
+                ++i;
+            }
+            std::string_view value;
+            if (i < size && attributes[i] == '=') {
+                ++i;
+                while (i < size && is_space(attributes[i])) {
+                    ++i;
+                }
+                if (i < size &&
+                    (attributes[i] == '"' || attributes[i] == '\'')) {
+                    auto quote = attributes[i++];
+                    auto end = attributes.find(quote, i);
+                    if (end == std::string_view::npos) {
+                        end = size;
+                    }
+                    value = attributes.substr(i, end - i);
+                    i = end + 1;
+                } else {
+                    auto value_start = i;
+                    while (i < size && !is_space(attributes[i])) {
+                        ++i;
+                    }
+                    value = attributes.substr(value_start, i - value_start);
+                }
+            }
+            if (!name.empty() && equals_ignore_case(name, lower_name)) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string_view TagScanner::raw_text() const noexcept {
+        return this->raw_text_;
+    }
+
+    std::size_t TagScanner::offset() const noexcept { return this->offset_; }
+
+    std::size_t TagScanner::skip_past(
+        std::string_view terminator, std::size_t from) const noexcept {
+        auto end = this->html_.find(terminator, from);
+        return end == std::string_view::npos ? this->html_.size()
+                                             : end + terminator.size();
+    }
+
+    std::size_t TagScanner::find_end_tag(std::size_t from) const noexcept {
+        const auto size = this->html_.size();
+        const auto name_size = this->name_.size();
+        while (from < size) {
+            auto end = this->html_.find("</", from);
+            if (end == std::string_view::npos) {
+                return size;
+            }
+            auto after = end + 2 + name_size;
+            if (after <= size) {
+                bool same = starts_with_ignore_case(
+                    this->html_.substr(end + 2), this->name_);
+                if (same && (after == size || is_space(this->html_[after]) ||
+                             this->html_[after] == '/' ||
+                             this->html_[after] == '>')) {
+                    return end;
+                }
+            }
+            from = end + 2;
+        }
+        return size;
+    }
+
+    std::string decode_entities(std::string_view value) {
+        std::string out;
+        out.reserve(value.size());
+        std::size_t i = 0;
+        while (i < value.size()) {
+            auto amp = value.find('&', i);
+            out.append(value.substr(i, amp - i));
+            if (amp == std::string_view::npos) {
+                break;
+            }
+            i = amp + 1;
+            auto semicolon = value.find(';', i);
+            if (semicolon == std::string_view::npos || semicolon - i > 10) {
+                out += '&';
+                continue;
+            }
+            auto entity = value.substr(i, semicolon - i);
+            if (!entity.empty() && entity[0] == '#') {
+                bool hex = entity.size() > 1 &&
+                           (entity[1] == 'x' || entity[1] == 'X');
+                auto digits = entity.substr(hex ? 2 : 1);
+                unsigned long code = 0;
+                bool valid = !digits.empty();
+                for (auto d : digits) {
+                    int v = d >= '0' && d <= '9'   ? d - '0'
+                            : hex && d >= 'a' && d <= 'f' ? d - 'a' + 10
+                            : hex && d >= 'A' && d <= 'F' ? d - 'A' + 10
+                                                          : -1;
+                    if (v < 0) {
+                        valid = false;
+                        break;
+                    }
+                    if (code <= 0x10FFFF) {
+                        code = code * (hex ? 16 : 10) +
+                               static_cast<unsigned long>(v);
+                    }
+                }
+                if (valid) {
+                    append_utf8(out, code);
+                    i = semicolon + 1;
+                } else {
+                    out += '&';
+                }
+                continue;
+            }
+            char decoded = entity == "amp"    ? '&'
+                           : entity == "lt"   ? '<'
+                           : entity == "gt"   ? '>'
+                           : entity == "quot" ? '"'
+                           : entity == "apos" ? '\''
+                                              : 0;
+            if (decoded != 0) {
+                out += decoded;
+                i = semicolon + 1;
+            } else {
+                out += '&';
+            }
+        }
+        return out;
+    }
+} // namespace Scrapp::Html
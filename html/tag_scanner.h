@@ -0,0 +1,79 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_TAG_SCANNER_H
+#define SCRAPP_TAG_SCANNER_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Scrapp::Html {
+    // Forward-only scanner over the start tags of raw HTML, for callers that
+    // only need a few attribute values and can skip building a DOM. It does
+    // not copy or allocate: names and values are views into the scanned
+    // buffer, and values are returned as written (see decode_entities).
+    // Comments, doctypes, processing instructions and end tags are skipped,
+    // and the contents of raw text elements such as script and style are
+    // never mistaken for markup.
+    class TagScanner {
+      public:
+        explicit TagScanner(std::string_view html) noexcept;
+
+        // Advances to the next start tag. Returns false at the end of input.
+        bool next() noexcept;
+
+        // Tag name as written in the source.
+        [[nodiscard]] std::string_view name() const noexcept;
+        // Case-insensitive comparison with a lowercase tag name.
+        [[nodiscard]] bool is(std::string_view lower_name) const noexcept;
+        // Raw value of the current tag's first attribute called lower_name,
+        // compared case-insensitively. Attributes without a value yield an
+        // empty view.
+        [[nodiscard]] std::optional<std::string_view>
+        attribute(std::string_view lower_name) const noexcept;
+        // Contents of the current tag when it is a raw text element (script,
+        // style, textarea, title...), up to its end tag.
+        [[nodiscard]] std::string_view raw_text() const noexcept;
+        // Offset of the current tag's '<' in the scanned buffer.
+        [[nodiscard]] std::size_t offset() const noexcept;
+
+      private:
+        std::size_t skip_past(std::string_view terminator, std::size_t from)
+            const noexcept;
+        std::size_t find_end_tag(std::size_t from) const noexcept;
+
+        std::string_view html_;
+        std::size_t position_{};
+        std::size_t offset_{};
+        std::string_view name_;
+        std::string_view attributes_;
+        std::string_view raw_text_;
+    };
+
+    // Decodes the character references that occur in attribute values in
+    // practice: the XML named entities and numeric references.
+    std::string decode_entities(std::string_view value);
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_TAG_SCANNER_H
@@ -0,0 +1,278 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "text.h"
+
+namespace Scrapp::Html {
+    namespace {
+        enum class Role { inline_, skipped, block, line_break, cell, verbatim };
+
+        Role role_of(lxb_dom_node_t* node) noexcept {
+            switch (node->local_name) {
+            case LXB_TAG_HEAD:
+            case LXB_TAG_TITLE:
+            case LXB_TAG_SCRIPT:
+            case LXB_TAG_STYLE:
+            case LXB_TAG_NOSCRIPT:
+            case LXB_TAG_TEMPLATE:
+            case LXB_TAG_IFRAME:
+            case LXB_TAG_OBJECT:
+            case LXB_TAG_EMBED:
+            case LXB_TAG_CANVAS:
+            case LXB_TAG_SVG:
+            case LXB_TAG_AUDIO:
+            case LXB_TAG_VIDEO:
+            case LXB_TAG_NOFRAMES:
+            case LXB_TAG_NOEMBED:
+            case LXB_TAG_SELECT:
+            case LXB_TAG_DATALIST:
+                return Role::skipped;
+            case LXB_TAG_ADDRESS:
+            case LXB_TAG_ARTICLE:
+            case LXB_TAG_ASIDE:
+            case LXB_TAG_BLOCKQUOTE:
+            case LXB_TAG_BODY:
+            case LXB_TAG_CAPTION:
+            case LXB_TAG_CENTER:
+            case LXB_TAG_DD:
+            case LXB_TAG_DETAILS:
+            case LXB_TAG_DIALOG:
+            case LXB_TAG_DIR:
+            case LXB_TAG_DIV:
+            case LXB_TAG_DL:
+            case LXB_TAG_DT:
+            case LXB_TAG_FIELDSET:
+            case LXB_TAG_FIGCAPTION:
+            case LXB_TAG_FIGURE:
+            case LXB_TAG_FOOTER:
+            case LXB_TAG_FORM:
+            case LXB_TAG_H1:
+            case LXB_TAG_H2:
+            case LXB_TAG_H3:
+            case LXB_TAG_H4:
+            case LXB_TAG_H5:
+            case LXB_TAG_H6:
+            case LXB_TAG_HEADER:
+            case LXB_TAG_HGROUP:
+            case LXB_TAG_HR:
+            case LXB_TAG_HTML:
+            case LXB_TAG_LEGEND:
+            case LXB_TAG_LI:
+            case LXB_TAG_MAIN:
+            case LXB_TAG_MENU:
+            case LXB_TAG_NAV:
+            case LXB_TAG_OL:
+            case LXB_TAG_P:
+            case LXB_TAG_SECTION:
+            case LXB_TAG_SUMMARY:
+            case LXB_TAG_TABLE:
+            case LXB_TAG_TBODY:
+            case LXB_TAG_TFOOT:
+            case LXB_TAG_THEAD:
+            case LXB_TAG_TR:
+            case LXB_TAG_UL:
+                return Role::block;
+            case LXB_TAG_BR:
+                return Role::line_break;
+            case LXB_TAG_TD:
+            case LXB_TAG_TH:
+                return Role::cell;
+            case LXB_TAG_PRE:
+            case LXB_TAG_TEXTAREA:
+            case LXB_TAG_LISTING:
+            case LXB_TAG_XMP:
+            case LXB_TAG_PLAINTEXT:
+                return Role::verbatim;
+            default:
+                return Role::inline_;
+            }
+        }
+
+        constexpr bool is_space(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                   c == '\f';
+        }
+
+        // Separators are only written once text follows them, so runs of
+        // empty blocks collapse and the output never starts or ends with
+        // one.
+        class TextWriter {
+          public:
+            TextWriter(std::string& out, const TextOptions& options)
+                : out_{out}, options_{options}, start_{out.size()} {}
+
+            void block() noexcept { this->pending_ = Pending::block; }
+
+            void cell() noexcept {
+                if (this->pending_ != Pending::block) {
+                    this->pending_ = Pending::cell;
+                }
+            }
+
+            void text(std::string_view text, bool verbatim) {
+                if (verbatim || !this->options_.collapse_whitespace) {
+                    if (!text.empty()) {
+                        this->flush();
+                        this->out_.append(text);
+                    }
+                    return;
+                }
+                std::size_t i = 0;
+                const auto size = text.size();
+                while (i < size) {
+                    if (is_space(text[i])) {
+                        if (this->pending_ == Pending::none) {
+                            this->pending_ = Pending::space;
+                        }
+                        while (i < size && is_space(text[i])) {
+                            ++i;
+                        }
+                        continue;
+                    }
+                    auto start = i;
+                    while (i < size && !is_space(text[i])) {
+                        ++i;
+                    }
+                    this->flush();
+                    this->out_.append(text.data() + start, i - start);
+                }
+            }
+
+          private:
+            enum class Pending { none, space, cell, block };
+
+            void flush() {
+                if (this->out_.size() > this->start_) {
+                    switch (this->pending_) {
+                    case Pending::none:
+                        break;
+                    case Pending::space:
+                        this->out_ += ' ';
+                        break;
+                    case Pending::cell:
+                        this->out_.append(this->options_.cell_separator);
+                        break;
+                    case Pending::block:
+                        this->out_.append(this->options_.block_separator);
+                        break;
+                    }
+                }
+                this->pending_ = Pending::none;
+            }
+
+            std::string& out_;
+            const TextOptions& options_;
+            std::size_t start_;
+            Pending pending_{Pending::none};
+        };
+
+        bool is_hidden(lxb_dom_node_t* node) noexcept {
+            static constexpr std::string_view hidden = "hidden";
+            return lxb_dom_element_has_attribute(
+                lxb_dom_interface_element(node),
+                reinterpret_cast<const lxb_char_t*>(hidden.data()),
+                hidden.size());
+        }
+    } // namespace
+
+    void append_visible_text(
+        lxb_dom_node_t* root, std::string& out, const TextOptions& options) {
+        TextWriter writer{out, options};
+        std::size_t verbatim_depth = 0;
+
+        auto leave = [&](lxb_dom_node_t* node) {
+            if (node->type != LXB_DOM_NODE_TYPE_ELEMENT) {
+                return;
+            }
+            switch (role_of(node)) {
+            case Role::block:
+                writer.block();
+                break;
+            case Role::verbatim:
+                --verbatim_depth;
+                writer.block();
+                break;
+            default:
+                break;
+            }
+        };
+
+        auto* node = root;
+        while (node != nullptr) {
+            bool descend = false;
+            if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) {
+                auto role = role_of(node);
+                bool hidden = role == Role::skipped ||
+                              (options.skip_hidden && is_hidden(node));
+                if (!hidden) {
+                    switch (role) {
+                    case Role::block:
+                    case Role::line_break:
+                        writer.block();
+                        break;
+                    case Role::cell:
+                        writer.cell();
+                        break;
+                    case Role::verbatim:
+                        ++verbatim_depth;
+                        writer.block();
+                        break;
+                    default:
+                        break;
+                    }
+                    descend = true;
+                }
+            } else if (node->type == LXB_DOM_NODE_TYPE_TEXT ||
+                       node->type == LXB_DOM_NODE_TYPE_CDATA_SECTION) {
+                const auto& data =
+                    lxb_dom_interface_character_data(node)->data;
+                writer.text(
+                    {reinterpret_cast<const char*>(data.data), data.length},
+                    verbatim_depth > 0);
+            } else if (node->type == LXB_DOM_NODE_TYPE_DOCUMENT ||
+                       node->type == LXB_DOM_NODE_TYPE_DOCUMENT_FRAGMENT) {
+                descend = true;
+            }
+
+            if (descend && node->first_child != nullptr) {
+                node = node->first_child;
+                continue;
+            }
+            if (descend) {
+                leave(node);
+            }
+            // Climb until a node with a next sibling, leaving every element
+            // on the way; nothing above root is visited.
+            while (node != root && node->next == nullptr) {
+                node = node->parent;
+                leave(node);
+            }
+            node = node == root ? nullptr : node->next;
+        }
+    }
+
+    std::string visible_text(lxb_dom_node_t* root, const TextOptions& options) {
+        std::string out;
+        append_visible_text(root, out, options);
+        return out;
+    }
+} // namespace Scrapp::Html
@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_TEXT_H
+#define SCRAPP_TEXT_H
+
+#include "types.h"
+#include <string>
+#include <string_view>
+
+namespace Scrapp::Html {
+    struct TextOptions {
+        // Written between block-level elements and at <br>.
+        std::string_view block_separator = "\n";
+        // Written between the cells of a table row.
+        std::string_view cell_separator = " ";
+        // Collapses runs of whitespace into one space, except inside pre,
+        // textarea, listing and xmp.
+        bool collapse_whitespace = true;
+        // Skips elements carrying the hidden attribute.
+        bool skip_hidden = true;
+    };
+
+    // Appends the text of root's subtree as a browser would render it, in a
+    // single walk: head, script, style, noscript, template and embedded
+    // content are skipped, block-level elements are separated and
+    // whitespace is collapsed. Entities were already decoded by the parser.
+    // Reusing out across calls keeps its capacity, so steady-state
+    // extraction does not allocate.
+    void append_visible_text(
+        lxb_dom_node_t* root, std::string& out,
+        const TextOptions& options = {});
+
+    std::string
+    visible_text(lxb_dom_node_t* root, const TextOptions& options = {});
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_TEXT_H
@@ -0,0 +1,2226 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "xpath.h"
+#include "html_exceptions.h"
+#include "../utils.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace Scrapp::Html {
+    namespace {
+        constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+
+        constexpr bool is_space(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        constexpr char lower(char c) noexcept {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+        }
+
+        // --- Syntax tree -----------------------------------------------
+
+        enum class Axis {
+            ancestor,
+            ancestor_or_self,
+            attribute,
+            child,
+            descendant,
+            descendant_or_self,
+            following,
+            following_sibling,
+            namespace_,
+            parent,
+            preceding,
+            preceding_sibling,
+            self
+        };
+
+        constexpr bool is_reverse(Axis axis) noexcept {
+            return axis == Axis::ancestor || axis == Axis::ancestor_or_self ||
+                   axis == Axis::preceding ||
+                   axis == Axis::preceding_sibling;
+        }
+
+        enum class NodeTest {
+            name,
+            any_name,
+            node,
+            text,
+            comment,
+            processing_instruction
+        };
+
+        enum class Function {
+            last,
+            position,
+            count,
+            id,
+            local_name,
+            namespace_uri,
+            name,
+            string,
+            concat,
+            starts_with,
+            contains,
+            substring_before,
+            substring_after,
+            substring,
+            string_length,
+            normalize_space,
+            translate,
+            boolean,
+            not_,
+            true_,
+            false_,
+            lang,
+            number,
+            sum,
+            floor,
+            ceiling,
+            round
+        };
+
+        struct FunctionInfo {
+            std::string_view name;
+            Function function;
+            std::size_t min_args;
+            std::size_t max_args;
+        };
+
+        constexpr auto unbounded = std::numeric_limits<std::size_t>::max();
+
+        constexpr std::array<FunctionInfo, 27> functions{{
+            {"last", Function::last, 0, 0},
+            {"position", Function::position, 0, 0},
+            {"count", Function::count, 1, 1},
+            {"id", Function::id, 1, 1},
+            {"local-name", Function::local_name, 0, 1},
+            {"namespace-uri", Function::namespace_uri, 0, 1},
+            {"name", Function::name, 0, 1},
+            {"string", Function::string, 0, 1},
+            {"concat", Function::concat, 2, unbounded},
+            {"starts-with", Function::starts_with, 2, 2},
+            {"contains", Function::contains, 2, 2},
+            {"substring-before", Function::substring_before, 2, 2},
+            {"substring-after", Function::substring_after, 2, 2},
+            {"substring", Function::substring, 2, 3},
+            {"string-length", Function::string_length, 0, 1},
+            {"normalize-space", Function::normalize_space, 0, 1},
+            {"translate", Function::translate, 3, 3},
+            {"boolean", Function::boolean, 1, 1},
+            {"not", Function::not_, 1, 1},
+            {"true", Function::true_, 0, 0},
+            {"false", Function::false_, 0, 0},
+            {"lang", Function::lang, 1, 1},
+            {"number", Function::number, 0, 1},
+            {"sum", Function::sum, 1, 1},
+            {"floor", Function::floor, 1, 1},
+            {"ceiling", Function::ceiling, 1, 1},
+            {"round", Function::round, 1, 1},
+        }};
+
+        enum class Type { node_set, number, string, boolean };
+
+        struct Expr;
+        using ExprPtr = std::unique_ptr<Expr>;
+
+        struct Predicate {
+            enum class Kind { general, index, has_attribute, attribute_equals };
+
+            ExprPtr expr;
+            Kind kind{Kind::general};
+            // Whether the result depends on the proximity position.
+            bool positional{true};
+            std::size_t index{};
+            std::string attribute;
+            std::string value;
+        };
+
+        struct Step {
+            Axis axis{Axis::child};
+            NodeTest test{NodeTest::node};
+            // Lowercase local name for NodeTest::name.
+            std::string name;
+            // Slot of this step's tag name memo during evaluation.
+            std::size_t memo{};
+            std::vector<Predicate> predicates;
+
+            [[nodiscard]] bool streaming() const noexcept {
+                return std::none_of(
+                    predicates.begin(), predicates.end(),
+                    [](const Predicate& p) { return p.positional; });
+            }
+        };
+
+        struct Expr {
+            enum class Kind {
+                or_,
+                and_,
+                eq,
+                ne,
+                lt,
+                le,
+                gt,
+                ge,
+                add,
+                sub,
+                mul,
+                div,
+                mod,
+                negate,
+                union_,
+                literal,
+                number,
+                function,
+                path
+            };
+
+            Kind kind;
+            ExprPtr lhs;
+            ExprPtr rhs;
+            std::string literal;
+            double number{};
+            Function function{};
+            std::vector<ExprPtr> args;
+            // Paths start from filter when it is set, from the root when
+            // absolute and from the context node otherwise.
+            ExprPtr filter;
+            std::vector<Predicate> filter_predicates;
+            bool absolute{false};
+            std::vector<Step> steps;
+
+            explicit Expr(Kind k) : kind{k} {}
+
+            [[nodiscard]] Type type() const noexcept {
+                switch (kind) {
+                case Kind::or_:
+                case Kind::and_:
+                case Kind::eq:
+                case Kind::ne:
+                case Kind::lt:
+                case Kind::le:
+                case Kind::gt:
+                case Kind::ge:
+                    return Type::boolean;
+                case Kind::add:
+                case Kind::sub:
+                case Kind::mul:
+                case Kind::div:
+                case Kind::mod:
+                case Kind::negate:
+                case Kind::number:
+                    return Type::number;
+                case Kind::literal:
+                    return Type::string;
+                case Kind::union_:
+                case Kind::path:
+                    return Type::node_set;
+                case Kind::function:
+                    break;
+                }
+                switch (function) {
+                case Function::id:
+                    return Type::node_set;
+                case Function::last:
+                case Function::position:
+                case Function::count:
+                case Function::string_length:
+                case Function::number:
+                case Function::sum:
+                case Function::floor:
+                case Function::ceiling:
+                case Function::round:
+                    return Type::number;
+                case Function::boolean:
+                case Function::not_:
+                case Function::true_:
+                case Function::false_:
+                case Function::lang:
+                case Function::starts_with:
+                case Function::contains:
+                    return Type::boolean;
+                default:
+                    return Type::string;
+                }
+            }
+
+            // Whether evaluating this expression reads the context position
+            // or size. Predicates of nested paths have their own context and
+            // are not considered.
+            [[nodiscard]] bool uses_position() const noexcept {
+                if (kind == Kind::function) {
+                    if (function == Function::last ||
+                        function == Function::position) {
+                        return true;
+                    }
+                    return std::any_of(
+                        args.begin(), args.end(), [](const ExprPtr& arg) {
+                            return arg->uses_position();
+                        });
+                }
+                if (kind == Kind::path) {
+                    return filter && filter->uses_position();
+                }
+                return (lhs && lhs->uses_position()) ||
+                       (rhs && rhs->uses_position());
+            }
+        };
+
+        // --- Lexer -----------------------------------------------------
+
+        struct Token {
+            enum class Kind {
+                end,
+                lparen,
+                rparen,
+                lbracket,
+                rbracket,
+                dot,
+                dotdot,
+                at,
+                comma,
+                colons,
+                slash,
+                slashslash,
+                pipe,
+                plus,
+                minus,
+                eq,
+                ne,
+                lt,
+                le,
+                gt,
+                ge,
+                star,
+                multiply,
+                literal,
+                number,
+                name_test,
+                operator_name,
+                function_name,
+                node_type,
+                axis_name,
+                dollar
+            };
+
+            Kind kind{Kind::end};
+            std::string text;
+            double number{};
+        };
+
+        bool is_name_start(char c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   c == '_' || static_cast<unsigned char>(c) >= 0x80;
+        }
+
+        bool is_name_char(char c) noexcept {
+            return is_name_start(c) || (c >= '0' && c <= '9') || c == '-' ||
+                   c == '.';
+        }
+
+        std::vector<Token> tokenize(std::string_view source) {
+            using Kind = Token::Kind;
+            std::vector<Token> tokens;
+            std::size_t i = 0;
+            const auto size = source.size();
+
+            // XPath 1.0 section 3.7: after these tokens '*' is a name test
+            // and a name is not an operator.
+            auto operator_context = [&tokens]() {
+                if (tokens.empty()) {
+                    return true;
+                }
+                switch (tokens.back().kind) {
+                case Kind::at:
+                case Kind::colons:
+                case Kind::lparen:
+                case Kind::lbracket:
+                case Kind::comma:
+                case Kind::operator_name:
+                case Kind::slash:
+                case Kind::slashslash:
+                case Kind::pipe:
+                case Kind::plus:
+                case Kind::minus:
+                case Kind::eq:
+                case Kind::ne:
+                case Kind::lt:
+                case Kind::le:
+                case Kind::gt:
+                case Kind::ge:
+                case Kind::multiply:
+                case Kind::dollar:
+                    return true;
+                default:
+                    return false;
+                }
+            };
+            auto skip_space = [&]() {
+                while (i < size && is_space(source[i])) {
+                    ++i;
+                }
+            };
+            auto push = [&tokens](Kind kind, std::string text = {}) {
+                Token token;
+                token.kind = kind;
+                token.text = std::move(text);
+                tokens.push_back(std::move(token));
+            };
+
+            while (true) {
+                skip_space();
+                if (i >= size) {
+                    break;
+                }
+                auto c = source[i];
+                auto next = i + 1 < size ? source[i + 1] : '\0';
+                switch (c) {
+                case '(':
+                    push(Kind::lparen);
+                    ++i;
+                    continue;
+                case ')':
+                    push(Kind::rparen);
+                    ++i;
+                    continue;
+                case '[':
+                    push(Kind::lbracket);
+                    ++i;
+                    continue;
+                case ']':
+                    push(Kind::rbracket);
+                    ++i;
+                    continue;
+                case '@':
+                    push(Kind::at);
+                    ++i;
+                    continue;
+                case ',':
+                    push(Kind::comma);
+                    ++i;
+                    continue;
+                case '|':
+                    push(Kind::pipe);
+                    ++i;
+                    continue;
+                case '+':
+                    push(Kind::plus);
+                    ++i;
+                    continue;
+                case '-':
+                    push(Kind::minus);
+                    ++i;
+                    continue;
+                case '=':
+                    push(Kind::eq);
+                    ++i;
+                    continue;
+                case '$':
+                    push(Kind::dollar);
+                    ++i;
+                    continue;
+                case '!':
+                    if (next != '=') {
+                        throw xpath_error(
+                            "unexpected '!' in XPath expression");
+                    }
+                    push(Kind::ne);
+                    i += 2;
+                    continue;
+                case '<':
+                    push(next == '=' ? Kind::le : Kind::lt);
+                    i += next == '=' ? 2 : 1;
+                    continue;
+                case '>':
+                    push(next == '=' ? Kind::ge : Kind::gt);
+                    i += next == '=' ? 2 : 1;
+                    continue;
+                case '/':
+                    push(next == '/' ? Kind::slashslash : Kind::slash);
+                    i += next == '/' ? 2 : 1;
+                    continue;
+                case ':':
+                    if (next != ':') {
+                        throw xpath_error(
+                            "unexpected ':' in XPath expression");
+                    }
+                    push(Kind::colons);
+                    i += 2;
+                    continue;
+                case '*':
+                    push(operator_context() ? Kind::star : Kind::multiply);
+                    ++i;
+                    continue;
+                case '"':
+                case '\'': {
+                    auto end = source.find(c, i + 1);
+                    if (end == std::string_view::npos) {
+                        throw xpath_error("unterminated string literal");
+                    }
+                    push(Kind::literal,
+                         std::string(source.substr(i + 1, end - i - 1)));
+                    i = end + 1;
+                    continue;
+                }
+                default:
+                    break;
+                }
+
+                if ((c >= '0' && c <= '9') ||
+                    (c == '.' && next >= '0' && next <= '9')) {
+                    auto start = i;
+                    while (i < size && source[i] >= '0' && source[i] <= '9') {
+                        ++i;
+                    }
+                    if (i < size && source[i] == '.') {
+                        ++i;
+                        while (i < size && source[i] >= '0' &&
+                               source[i] <= '9') {
+                            ++i;
+                        }
+                    }
+                    Token token;
+                    token.kind = Kind::number;
+                    token.number = std::strtod(
+                        std::string(source.substr(start, i - start)).c_str(),
+                        nullptr);
+                    tokens.push_back(std::move(token));
+                    continue;
+                }
+                if (c == '.') {
+                    push(next == '.' ? Kind::dotdot : Kind::dot);
+                    i += next == '.' ? 2 : 1;
+                    continue;
+                }
+                if (!is_name_start(c)) {
+                    throw xpath_error(
+                        std::string("unexpected character '") + c +
+                        "' in XPath expression");
+                }
+
+                auto start = i;
+                while (i < size && is_name_char(source[i])) {
+                    ++i;
+                }
+                auto name = source.substr(start, i - start);
+                if (!operator_context()) {
+                    if (name == "and" || name == "or" || name == "mod" ||
+                        name == "div") {
+                        push(Kind::operator_name, std::string(name));
+                        continue;
+                    }
+                    throw xpath_error(
+                        "expected an operator before '" + std::string(name) +
+                        "'");
+                }
+                // QName prefixes are dropped, HTML has no namespaces to
+                // match them against.
+                if (i + 1 < size && source[i] == ':' && source[i + 1] != ':') {
+                    if (source[i + 1] == '*') {
+                        i += 2;
+                        push(Kind::star);
+                        continue;
+                    }
+                    ++i;
+                    start = i;
+                    while (i < size && is_name_char(source[i])) {
+                        ++i;
+                    }
+                    name = source.substr(start, i - start);
+                    if (name.empty()) {
+                        throw xpath_error("invalid qualified name");
+                    }
+                }
+                auto lookahead = i;
+                while (lookahead < size && is_space(source[lookahead])) {
+                    ++lookahead;
+                }
+                auto following = lookahead < size ? source[lookahead] : '\0';
+                if (following == '(') {
+                    bool node_type = name == "comment" || name == "text" ||
+                                     name == "processing-instruction" ||
+                                     name == "node";
+                    push(node_type ? Kind::node_type : Kind::function_name,
+                         std::string(name));
+                } else if (following == ':' && lookahead + 1 < size &&
+                           source[lookahead + 1] == ':') {
+                    push(Kind::axis_name, std::string(name));
+                } else {
+                    push(Kind::name_test, std::string(name));
+                }
+            }
+            push(Kind::end);
+            return tokens;
+        }
+
+        // --- Parser ----------------------------------------------------
+
+        class Parser {
+          public:
+            explicit Parser(std::string_view source)
+                : tokens_{tokenize(source)} {}
+
+            ExprPtr parse() {
+                auto expr = this->parse_or();
+                if (this->peek().kind != Token::Kind::end) {
+                    throw xpath_error("unexpected token after expression");
+                }
+                return expr;
+            }
+
+            std::size_t name_tests() const noexcept {
+                return this->name_tests_;
+            }
+
+          private:
+            using Kind = Token::Kind;
+
+            const Token& peek() const { return this->tokens_[this->pos_]; }
+
+            bool accept(Kind kind) {
+                if (this->peek().kind == kind) {
+                    ++this->pos_;
+                    return true;
+                }
+                return false;
+            }
+
+            bool accept_operator(std::string_view name) {
+                if (this->peek().kind == Kind::operator_name &&
+                    this->peek().text == name) {
+                    ++this->pos_;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(Kind kind, const char* what) {
+                if (!this->accept(kind)) {
+                    throw xpath_error(std::string("expected ") + what);
+                }
+            }
+
+            static ExprPtr
+            binary(Expr::Kind kind, ExprPtr lhs, ExprPtr rhs) {
+                auto expr = std::make_unique<Expr>(kind);
+                expr->lhs = std::move(lhs);
+                expr->rhs = std::move(rhs);
+                return expr;
+            }
+
+            ExprPtr parse_or() {
+                auto lhs = this->parse_and();
+                while (this->accept_operator("or")) {
+                    lhs = binary(Expr::Kind::or_, std::move(lhs),
+                                 this->parse_and());
+                }
+                return lhs;
+            }
+
+            ExprPtr parse_and() {
+                auto lhs = this->parse_equality();
+                while (this->accept_operator("and")) {
+                    lhs = binary(Expr::Kind::and_, std::move(lhs),
+                                 this->parse_equality());
+                }
+                return lhs;
+            }
+
+            ExprPtr parse_equality() {
+                auto lhs = this->parse_relational();
+                while (true) {
+                    if (this->accept(Kind::eq)) {
+                        lhs = binary(Expr::Kind::eq, std::move(lhs),
+                                     this->parse_relational());
+                    } else if (this->accept(Kind::ne)) {
+                        lhs = binary(Expr::Kind::ne, std::move(lhs),
+                                     this->parse_relational());
+                    } else {
+                        return lhs;
+                    }
+                }
+            }
+
+            ExprPtr parse_relational() {
+                auto lhs = this->parse_additive();
+                while (true) {
+                    Expr::Kind kind;
+                    if (this->accept(Kind::lt)) {
+                        kind = Expr::Kind::lt;
+                    } else if (this->accept(Kind::le)) {
+                        kind = Expr::Kind::le;
+                    } else if (this->accept(Kind::gt)) {
+                        kind = Expr::Kind::gt;
+                    } else if (this->accept(Kind::ge)) {
+                        kind = Expr::Kind::ge;
+                    } else {
+                        return lhs;
+                    }
+                    lhs = binary(kind, std::move(lhs), this->parse_additive());
+                }
+            }
+
+            ExprPtr parse_additive() {
+                auto lhs = this->parse_multiplicative();
+                while (true) {
+                    if (this->accept(Kind::plus)) {
+                        lhs = binary(Expr::Kind::add, std::move(lhs),
+                                     this->parse_multiplicative());
+                    } else if (this->accept(Kind::minus)) {
+                        lhs = binary(Expr::Kind::sub, std::move(lhs),
+                                     this->parse_multiplicative());
+                    } else {
+                        return lhs;
+                    }
+                }
+            }
+
+            ExprPtr parse_multiplicative() {
+                auto lhs = this->parse_unary();
+                while (true) {
+                    Expr::Kind kind;
+                    if (this->accept(Kind::multiply)) {
+                        kind = Expr::Kind::mul;
+                    } else if (this->accept_operator("div")) {
+                        kind = Expr::Kind::div;
+                    } else if (this->accept_operator("mod")) {
+                        kind = Expr::Kind::mod;
+                    } else {
+                        return lhs;
+                    }
+                    lhs = binary(kind, std::move(lhs), this->parse_unary());
+                }
+            }
+
+            ExprPtr parse_unary() {
+                if (this->accept(Kind::minus)) {
+                    auto expr = std::make_unique<Expr>(Expr::Kind::negate);
+                    expr->lhs = this->parse_unary();
+                    return expr;
+                }
+                return this->parse_union();
+            }
+
+            ExprPtr parse_union() {
+                auto lhs = this->parse_path();
+                while (this->accept(Kind::pipe)) {
+                    auto rhs = this->parse_path();
+                    if (lhs->type() != Type::node_set ||
+                        rhs->type() != Type::node_set) {
+                        throw xpath_error("'|' needs node-set operands");
+                    }
+                    lhs = binary(Expr::Kind::union_, std::move(lhs),
+                                 std::move(rhs));
+                }
+                return lhs;
+            }
+
+            ExprPtr parse_path() {
+                auto kind = this->peek().kind;
+                bool filter = kind == Kind::literal || kind == Kind::number ||
+                              kind == Kind::function_name ||
+                              kind == Kind::lparen || kind == Kind::dollar;
+                if (!filter) {
+                    auto path = std::make_unique<Expr>(Expr::Kind::path);
+                    this->parse_location_path(*path);
+                    return path;
+                }
+
+                auto primary = this->parse_primary();
+                std::vector<Predicate> predicates;
+                while (this->peek().kind == Kind::lbracket) {
+                    predicates.push_back(this->parse_predicate());
+                }
+                auto next = this->peek().kind;
+                if (predicates.empty() && next != Kind::slash &&
+                    next != Kind::slashslash) {
+                    return primary;
+                }
+                if (primary->type() != Type::node_set) {
+                    throw xpath_error(
+                        "predicates and steps need a node-set");
+                }
+                auto path = std::make_unique<Expr>(Expr::Kind::path);
+                path->filter = std::move(primary);
+                path->filter_predicates = std::move(predicates);
+                if (this->accept(Kind::slashslash)) {
+                    path->steps.push_back(descendant_or_self());
+                    this->parse_relative_path(*path);
+                } else if (this->accept(Kind::slash)) {
+                    this->parse_relative_path(*path);
+                }
+                optimize(*path);
+                return path;
+            }
+
+            ExprPtr parse_primary() {
+                const auto& token = this->peek();
+                switch (token.kind) {
+                case Kind::dollar:
+                    throw xpath_error("XPath variables are not supported");
+                case Kind::lparen: {
+                    ++this->pos_;
+                    auto expr = this->parse_or();
+                    this->expect(Kind::rparen, "')'");
+                    return expr;
+                }
+                case Kind::literal: {
+                    auto expr = std::make_unique<Expr>(Expr::Kind::literal);
+                    expr->literal = token.text;
+                    ++this->pos_;
+                    return expr;
+                }
+                case Kind::number: {
+                    auto expr = std::make_unique<Expr>(Expr::Kind::number);
+                    expr->number = token.number;
+                    ++this->pos_;
+                    return expr;
+                }
+                default:
+                    return this->parse_function_call();
+                }
+            }
+
+            ExprPtr parse_function_call() {
+                auto name = this->peek().text;
+                ++this->pos_;
+                auto info = std::find_if(
+                    functions.begin(), functions.end(),
+                    [&name](const FunctionInfo& f) { return f.name == name; });
+                if (info == functions.end()) {
+                    throw xpath_error("unknown XPath function " + name);
+                }
+                auto expr = std::make_unique<Expr>(Expr::Kind::function);
+                expr->function = info->function;
+                this->expect(Kind::lparen, "'('");
+                if (!this->accept(Kind::rparen)) {
+                    do {
+                        expr->args.push_back(this->parse_or());
+                    } while (this->accept(Kind::comma));
+                    this->expect(Kind::rparen, "')'");
+                }
+                if (expr->args.size() < info->min_args ||
+                    expr->args.size() > info->max_args) {
+                    throw xpath_error(
+                        "wrong number of arguments to " + name + "()");
+                }
+                bool node_set_argument =
+                    info->function == Function::count ||
+                    info->function == Function::sum ||
+                    info->function == Function::local_name ||
+                    info->function == Function::namespace_uri ||
+                    info->function == Function::name;
+                if (node_set_argument && !expr->args.empty() &&
+                    expr->args[0]->type() != Type::node_set) {
+                    throw xpath_error(name + "() needs a node-set argument");
+                }
+                return expr;
+            }
+
+            static Step descendant_or_self() {
+                Step step;
+                step.axis = Axis::descendant_or_self;
+                step.test = NodeTest::node;
+                return step;
+            }
+
+            void parse_location_path(Expr& path) {
+                if (this->accept(Kind::slash)) {
+                    path.absolute = true;
+                    if (starts_step(this->peek().kind)) {
+                        this->parse_relative_path(path);
+                    }
+                } else if (this->accept(Kind::slashslash)) {
+                    path.absolute = true;
+                    path.steps.push_back(descendant_or_self());
+                    this->parse_relative_path(path);
+                } else {
+                    this->parse_relative_path(path);
+                }
+                optimize(path);
+            }
+
+            static bool starts_step(Kind kind) noexcept {
+                return kind == Kind::name_test || kind == Kind::star ||
+                       kind == Kind::at || kind == Kind::dot ||
+                       kind == Kind::dotdot || kind == Kind::axis_name ||
+                       kind == Kind::node_type;
+            }
+
+            void parse_relative_path(Expr& path) {
+                path.steps.push_back(this->parse_step());
+                while (true) {
+                    if (this->accept(Kind::slash)) {
+                        path.steps.push_back(this->parse_step());
+                    } else if (this->accept(Kind::slashslash)) {
+                        path.steps.push_back(descendant_or_self());
+                        path.steps.push_back(this->parse_step());
+                    } else {
+                        return;
+                    }
+                }
+            }
+
+            Step parse_step() {
+                Step step;
+                if (this->accept(Kind::dot)) {
+                    step.axis = Axis::self;
+                    return step;
+                }
+                if (this->accept(Kind::dotdot)) {
+                    step.axis = Axis::parent;
+                    return step;
+                }
+                if (this->accept(Kind::at)) {
+                    step.axis = Axis::attribute;
+                } else if (this->peek().kind == Kind::axis_name) {
+                    step.axis = axis_from_name(this->peek().text);
+                    ++this->pos_;
+                    this->expect(Kind::colons, "'::'");
+                }
+
+                const auto& token = this->peek();
+                if (token.kind == Kind::star) {
+                    step.test = NodeTest::any_name;
+                    ++this->pos_;
+                } else if (token.kind == Kind::name_test) {
+                    step.test = NodeTest::name;
+                    step.name = token.text;
+                    for (auto& c : step.name) {
+                        c = lower(c);
+                    }
+                    step.memo = this->name_tests_++;
+                    ++this->pos_;
+                } else if (token.kind == Kind::node_type) {
+                    auto type = token.text;
+                    ++this->pos_;
+                    this->expect(Kind::lparen, "'('");
+                    if (type == "processing-instruction") {
+                        step.test = NodeTest::processing_instruction;
+                        this->accept(Kind::literal);
+                    } else if (type == "comment") {
+                        step.test = NodeTest::comment;
+                    } else if (type == "text") {
+                        step.test = NodeTest::text;
+                    } else {
+                        step.test = NodeTest::node;
+                    }
+                    this->expect(Kind::rparen, "')'");
+                } else {
+                    throw xpath_error("expected a node test");
+                }
+
+                while (this->peek().kind == Kind::lbracket) {
+                    step.predicates.push_back(this->parse_predicate());
+                }
+                return step;
+            }
+
+            static Axis axis_from_name(const std::string& name) {
+                static const std::unordered_map<std::string, Axis> axes{
+                    {"ancestor", Axis::ancestor},
+                    {"ancestor-or-self", Axis::ancestor_or_self},
+                    {"attribute", Axis::attribute},
+                    {"child", Axis::child},
+                    {"descendant", Axis::descendant},
+                    {"descendant-or-self", Axis::descendant_or_self},
+                    {"following", Axis::following},
+                    {"following-sibling", Axis::following_sibling},
+                    {"namespace", Axis::namespace_},
+                    {"parent", Axis::parent},
+                    {"preceding", Axis::preceding},
+                    {"preceding-sibling", Axis::preceding_sibling},
+                    {"self", Axis::self}};
+                auto it = axes.find(name);
+                if (it == axes.end()) {
+                    throw xpath_error("unknown XPath axis " + name);
+                }
+                return it->second;
+            }
+
+            Predicate parse_predicate() {
+                this->expect(Kind::lbracket, "'['");
+                Predicate predicate;
+                predicate.expr = this->parse_or();
+                this->expect(Kind::rbracket, "']'");
+                classify(predicate);
+                return predicate;
+            }
+
+            // Name of the attribute a path like @name selects, if that is
+            // all the path does.
+            static std::optional<std::string> attribute_path(const Expr& e) {
+                if (e.kind != Expr::Kind::path || e.filter || e.absolute ||
+                    e.steps.size() != 1) {
+                    return std::nullopt;
+                }
+                const auto& step = e.steps.front();
+                if (step.axis != Axis::attribute ||
+                    step.test != NodeTest::name || !step.predicates.empty()) {
+                    return std::nullopt;
+                }
+                return step.name;
+            }
+
+            static void classify(Predicate& predicate) {
+                const auto& expr = *predicate.expr;
+                auto type = expr.type();
+                predicate.positional =
+                    type == Type::number || expr.uses_position();
+
+                if (expr.kind == Expr::Kind::number && expr.number >= 1 &&
+                    expr.number == std::floor(expr.number)) {
+                    predicate.kind = Predicate::Kind::index;
+                    predicate.index = static_cast<std::size_t>(expr.number);
+                } else if (auto name = attribute_path(expr)) {
+                    predicate.kind = Predicate::Kind::has_attribute;
+                    predicate.attribute = std::move(*name);
+                } else if (expr.kind == Expr::Kind::eq) {
+                    const Expr* path = expr.lhs.get();
+                    const Expr* literal = expr.rhs.get();
+                    if (literal->kind != Expr::Kind::literal) {
+                        std::swap(path, literal);
+                    }
+                    auto name = attribute_path(*path);
+                    if (name && literal->kind == Expr::Kind::literal) {
+                        predicate.kind = Predicate::Kind::attribute_equals;
+                        predicate.attribute = std::move(*name);
+                        predicate.value = literal->literal;
+                    }
+                }
+            }
+
+            // descendant-or-self::node()/child::x is the expansion of //x.
+            // Without positional predicates it selects the same nodes as
+            // descendant::x in a single walk.
+            static void optimize(Expr& path) {
+                auto& steps = path.steps;
+                for (std::size_t i = 0; i + 1 < steps.size(); ++i) {
+                    auto& first = steps[i];
+                    auto& second = steps[i + 1];
+                    if (first.axis != Axis::descendant_or_self ||
+                        first.test != NodeTest::node ||
+                        !first.predicates.empty() || !second.streaming()) {
+                        continue;
+                    }
+                    if (second.axis == Axis::child ||
+                        second.axis == Axis::descendant) {
+                        second.axis = Axis::descendant;
+                        steps.erase(steps.begin() +
+                                    static_cast<std::ptrdiff_t>(i));
+                    } else if (second.axis == Axis::descendant_or_self) {
+                        steps.erase(steps.begin() +
+                                    static_cast<std::ptrdiff_t>(i));
+                    }
+                }
+            }
+
+            std::vector<Token> tokens_;
+            std::size_t pos_{};
+            std::size_t name_tests_{};
+        };
+
+        // --- Node helpers ----------------------------------------------
+
+        lxb_dom_node_t* parent_of(lxb_dom_node_t* node) noexcept {
+            if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                auto* owner = lxb_dom_interface_attr(node)->owner;
+                return owner == nullptr ? nullptr : &owner->node;
+            }
+            return node->parent;
+        }
+
+        lxb_dom_node_t* root_of(lxb_dom_node_t* node) noexcept {
+            while (auto* parent = parent_of(node)) {
+                node = parent;
+            }
+            return node;
+        }
+
+        lxb_dom_attr_t* first_attribute(lxb_dom_node_t* node) noexcept {
+            if (node->type != LXB_DOM_NODE_TYPE_ELEMENT) {
+                return nullptr;
+            }
+            return lxb_dom_interface_element(node)->first_attr;
+        }
+
+        // Next node after node in document order within root's subtree,
+        // skipping node's children when skip_children is set.
+        lxb_dom_node_t* next_in_subtree(
+            lxb_dom_node_t* node, const lxb_dom_node_t* root,
+            bool skip_children = false) noexcept {
+            if (!skip_children && node->first_child != nullptr) {
+                return node->first_child;
+            }
+            while (node != root) {
+                if (node->next != nullptr) {
+                    return node->next;
+                }
+                node = node->parent;
+            }
+            return nullptr;
+        }
+
+        std::string_view attribute_name(lxb_dom_attr_t* attr) noexcept {
+            std::size_t len = 0;
+            auto* name = lxb_dom_attr_local_name(attr, &len);
+            return {reinterpret_cast<const char*>(name), len};
+        }
+
+        std::string_view attribute_value(lxb_dom_attr_t* attr) noexcept {
+            std::size_t len = 0;
+            auto* value = lxb_dom_attr_value(attr, &len);
+            if (value == nullptr) {
+                return {};
+            }
+            return {reinterpret_cast<const char*>(value), len};
+        }
+
+        lxb_dom_attr_t*
+        find_attribute(lxb_dom_node_t* node, std::string_view name) noexcept {
+            for (auto* attr = first_attribute(node); attr != nullptr;
+                 attr = lxb_dom_element_next_attribute(attr)) {
+                if (equals_ignore_case(attribute_name(attr), name)) {
+                    return attr;
+                }
+            }
+            return nullptr;
+        }
+
+        std::string_view local_name(lxb_dom_node_t* node) noexcept {
+            if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) {
+                std::size_t len = 0;
+                auto* name = lxb_dom_element_local_name(
+                    lxb_dom_interface_element(node), &len);
+                return {reinterpret_cast<const char*>(name), len};
+            }
+            if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                return attribute_name(lxb_dom_interface_attr(node));
+            }
+            return {};
+        }
+
+        std::string_view character_data(lxb_dom_node_t* node) noexcept {
+            const auto& data = lxb_dom_interface_character_data(node)->data;
+            return {reinterpret_cast<const char*>(data.data), data.length};
+        }
+
+        bool is_text(lxb_dom_node_t* node) noexcept {
+            return node->type == LXB_DOM_NODE_TYPE_TEXT ||
+                   node->type == LXB_DOM_NODE_TYPE_CDATA_SECTION;
+        }
+
+        // String-value of node. Text, attribute and comment nodes are
+        // returned as views into the document; elements are concatenated
+        // into scratch.
+        std::string_view
+        string_value(lxb_dom_node_t* node, std::string& scratch) {
+            switch (node->type) {
+            case LXB_DOM_NODE_TYPE_ATTRIBUTE:
+                return attribute_value(lxb_dom_interface_attr(node));
+            case LXB_DOM_NODE_TYPE_ELEMENT:
+            case LXB_DOM_NODE_TYPE_DOCUMENT:
+            case LXB_DOM_NODE_TYPE_DOCUMENT_FRAGMENT:
+                break;
+            case LXB_DOM_NODE_TYPE_TEXT:
+            case LXB_DOM_NODE_TYPE_CDATA_SECTION:
+            case LXB_DOM_NODE_TYPE_COMMENT:
+            case LXB_DOM_NODE_TYPE_PROCESSING_INSTRUCTION:
+                return character_data(node);
+            default:
+                return {};
+            }
+            scratch.clear();
+            for (auto* n = node->first_child; n != nullptr;
+                 n = next_in_subtree(n, node)) {
+                if (is_text(n)) {
+                    scratch.append(character_data(n));
+                }
+            }
+            return scratch;
+        }
+
+        // --- Conversions -----------------------------------------------
+
+        std::string number_to_string(double number) {
+            if (std::isnan(number)) {
+                return "NaN";
+            }
+            if (std::isinf(number)) {
+                return number > 0 ? "Infinity" : "-Infinity";
+            }
+            if (number == 0) {
+                return "0";
+            }
+            if (number == std::trunc(number) && std::fabs(number) < 1e15) {
+                return std::to_string(static_cast<long long>(number));
+            }
+            std::array<char, 400> buffer{};
+            auto result = std::to_chars(
+                buffer.data(), buffer.data() + buffer.size(), number,
+                std::chars_format::fixed);
+            return {buffer.data(), result.ptr};
+        }
+
+        double string_to_number(std::string_view text) {
+            text = trim(text);
+            std::size_t i = 0;
+            if (i < text.size() && text[i] == '-') {
+                ++i;
+            }
+            std::size_t digits = 0;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                ++i;
+                ++digits;
+            }
+            if (i < text.size() && text[i] == '.') {
+                ++i;
+                while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                    ++i;
+                    ++digits;
+                }
+            }
+            if (digits == 0 || i != text.size()) {
+                return nan;
+            }
+            return std::strtod(std::string(text).c_str(), nullptr);
+        }
+
+        double xpath_round(double number) {
+            if (std::isnan(number) || std::isinf(number) || number == 0) {
+                return number;
+            }
+            if (number < 0 && number >= -0.5) {
+                return -0.0;
+            }
+            return std::floor(number + 0.5);
+        }
+
+        // UTF-8 characters of text, as views.
+        std::vector<std::string_view> characters(std::string_view text) {
+            std::vector<std::string_view> chars;
+            chars.reserve(text.size());
+            std::size_t i = 0;
+            while (i < text.size()) {
+                auto start = i++;
+                while (i < text.size() &&
+                       (static_cast<unsigned char>(text[i]) & 0xC0) == 0x80) {
+                    ++i;
+                }
+                chars.push_back(text.substr(start, i - start));
+            }
+            return chars;
+        }
+
+        std::size_t character_count(std::string_view text) noexcept {
+            return static_cast<std::size_t>(std::count_if(
+                text.begin(), text.end(), [](char c) {
+                    return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+                }));
+        }
+
+        std::string normalize_space(std::string_view text) {
+            std::string out;
+            out.reserve(text.size());
+            bool pending = false;
+            for (auto c : text) {
+                if (is_space(c)) {
+                    pending = !out.empty();
+                    continue;
+                }
+                if (pending) {
+                    out += ' ';
+                    pending = false;
+                }
+                out += c;
+            }
+            return out;
+        }
+
+        // --- Evaluation ------------------------------------------------
+
+        struct Context {
+            lxb_dom_node_t* node;
+            std::size_t position;
+            std::size_t size;
+        };
+
+        // Per-call state: name test memos and the document order index,
+        // built only when a node-set has to be sorted.
+        class Evaluator {
+          public:
+            explicit Evaluator(std::size_t name_tests)
+                : tag_memos_(name_tests) {}
+
+            XPathValue eval(const Expr& expr, const Context& ctx) {
+                switch (expr.kind) {
+                case Expr::Kind::or_:
+                    return this->boolean(*expr.lhs, ctx) ||
+                           this->boolean(*expr.rhs, ctx);
+                case Expr::Kind::and_:
+                    return this->boolean(*expr.lhs, ctx) &&
+                           this->boolean(*expr.rhs, ctx);
+                case Expr::Kind::eq:
+                case Expr::Kind::ne:
+                case Expr::Kind::lt:
+                case Expr::Kind::le:
+                case Expr::Kind::gt:
+                case Expr::Kind::ge:
+                    return this->compare(
+                        expr.kind, this->eval(*expr.lhs, ctx),
+                        this->eval(*expr.rhs, ctx));
+                case Expr::Kind::add:
+                    return this->number(*expr.lhs, ctx) +
+                           this->number(*expr.rhs, ctx);
+                case Expr::Kind::sub:
+                    return this->number(*expr.lhs, ctx) -
+                           this->number(*expr.rhs, ctx);
+                case Expr::Kind::mul:
+                    return this->number(*expr.lhs, ctx) *
+                           this->number(*expr.rhs, ctx);
+                case Expr::Kind::div:
+                    return this->number(*expr.lhs, ctx) /
+                           this->number(*expr.rhs, ctx);
+                case Expr::Kind::mod:
+                    return std::fmod(
+                        this->number(*expr.lhs, ctx),
+                        this->number(*expr.rhs, ctx));
+                case Expr::Kind::negate:
+                    return -this->number(*expr.lhs, ctx);
+                case Expr::Kind::union_: {
+                    auto lhs = this->node_set(*expr.lhs, ctx);
+                    auto rhs = this->node_set(*expr.rhs, ctx);
+                    if (lhs.empty()) {
+                        return rhs;
+                    }
+                    lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+                    this->sort(lhs);
+                    return lhs;
+                }
+                case Expr::Kind::literal:
+                    return expr.literal;
+                case Expr::Kind::number:
+                    return expr.number;
+                case Expr::Kind::function:
+                    return this->call(expr, ctx);
+                case Expr::Kind::path:
+                    return this->path(expr, ctx);
+                }
+                return false;
+            }
+
+            XPathNodeSet node_set(const Expr& expr, const Context& ctx) {
+                auto value = this->eval(expr, ctx);
+                if (auto* nodes = std::get_if<XPathNodeSet>(&value)) {
+                    return std::move(*nodes);
+                }
+                throw xpath_error("expression does not select a node-set");
+            }
+
+            bool boolean(const Expr& expr, const Context& ctx) {
+                return to_boolean(this->eval(expr, ctx));
+            }
+
+            double number(const Expr& expr, const Context& ctx) {
+                return this->to_number(this->eval(expr, ctx));
+            }
+
+            std::string string(const Expr& expr, const Context& ctx) {
+                return this->to_string(this->eval(expr, ctx));
+            }
+
+            static bool to_boolean(const XPathValue& value) {
+                switch (value.index()) {
+                case 0:
+                    return !std::get<XPathNodeSet>(value).empty();
+                case 1: {
+                    auto n = std::get<double>(value);
+                    return n != 0 && !std::isnan(n);
+                }
+                case 2:
+                    return !std::get<std::string>(value).empty();
+                default:
+                    return std::get<bool>(value);
+                }
+            }
+
+            double to_number(const XPathValue& value) {
+                switch (value.index()) {
+                case 0:
+                    return string_to_number(this->to_string(value));
+                case 1:
+                    return std::get<double>(value);
+                case 2:
+                    return string_to_number(std::get<std::string>(value));
+                default:
+                    return std::get<bool>(value) ? 1 : 0;
+                }
+            }
+
+            std::string to_string(const XPathValue& value) {
+                switch (value.index()) {
+                case 0: {
+                    const auto& nodes = std::get<XPathNodeSet>(value);
+                    if (nodes.empty()) {
+                        return {};
+                    }
+                    return std::string(
+                        string_value(nodes.front(), this->scratch_));
+                }
+                case 1:
+                    return number_to_string(std::get<double>(value));
+                case 2:
+                    return std::get<std::string>(value);
+                default:
+                    return std::get<bool>(value) ? "true" : "false";
+                }
+            }
+
+          private:
+            // --- Comparisons -------------------------------------------
+
+            static bool compare_numbers(Expr::Kind op, double a, double b) {
+                switch (op) {
+                case Expr::Kind::eq:
+                    return a == b;
+                case Expr::Kind::ne:
+                    return a != b;
+                case Expr::Kind::lt:
+                    return a < b;
+                case Expr::Kind::le:
+                    return a <= b;
+                case Expr::Kind::gt:
+                    return a > b;
+                default:
+                    return a >= b;
+                }
+            }
+
+            static Expr::Kind mirror(Expr::Kind op) {
+                switch (op) {
+                case Expr::Kind::lt:
+                    return Expr::Kind::gt;
+                case Expr::Kind::le:
+                    return Expr::Kind::ge;
+                case Expr::Kind::gt:
+                    return Expr::Kind::lt;
+                case Expr::Kind::ge:
+                    return Expr::Kind::le;
+                default:
+                    return op;
+                }
+            }
+
+            static bool equality(Expr::Kind op) {
+                return op == Expr::Kind::eq || op == Expr::Kind::ne;
+            }
+
+            // XPath 1.0 section 3.4.
+            bool
+            compare(Expr::Kind op, const XPathValue& a, const XPathValue& b) {
+                bool a_nodes = a.index() == 0;
+                bool b_nodes = b.index() == 0;
+                if (a_nodes && b_nodes) {
+                    const auto& lhs = std::get<XPathNodeSet>(a);
+                    const auto& rhs = std::get<XPathNodeSet>(b);
+                    std::vector<std::string> values;
+                    values.reserve(rhs.size());
+                    for (auto* node : rhs) {
+                        values.emplace_back(
+                            string_value(node, this->scratch_));
+                    }
+                    for (auto* node : lhs) {
+                        auto value = std::string(
+                            string_value(node, this->scratch_));
+                        for (const auto& other : values) {
+                            if (compare_values(op, value, other)) {
+                                return true;
+                            }
+                        }
+                    }
+                    return false;
+                }
+                if (b_nodes) {
+                    return this->compare(mirror(op), b, a);
+                }
+                if (a_nodes) {
+                    const auto& nodes = std::get<XPathNodeSet>(a);
+                    if (b.index() == 3) {
+                        return compare_numbers(
+                            op, to_boolean(a) ? 1 : 0,
+                            std::get<bool>(b) ? 1 : 0);
+                    }
+                    if (b.index() == 1 || !equality(op)) {
+                        auto number = this->to_number(b);
+                        for (auto* node : nodes) {
+                            auto value = string_to_number(
+                                string_value(node, this->scratch_));
+                            if (compare_numbers(op, value, number)) {
+                                return true;
+                            }
+                        }
+                        return false;
+                    }
+                    const auto& text = std::get<std::string>(b);
+                    for (auto* node : nodes) {
+                        bool same = string_value(node, this->scratch_) == text;
+                        if (same == (op == Expr::Kind::eq)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+                if (equality(op)) {
+                    bool same;
+                    if (a.index() == 3 || b.index() == 3) {
+                        same = to_boolean(a) == to_boolean(b);
+                    } else if (a.index() == 1 || b.index() == 1) {
+                        same = this->to_number(a) == this->to_number(b);
+                    } else {
+                        same = std::get<std::string>(a) ==
+                               std::get<std::string>(b);
+                    }
+                    return same == (op == Expr::Kind::eq);
+                }
+                return compare_numbers(
+                    op, this->to_number(a), this->to_number(b));
+            }
+
+            static bool compare_values(
+                Expr::Kind op, std::string_view a, std::string_view b) {
+                if (op == Expr::Kind::eq) {
+                    return a == b;
+                }
+                if (op == Expr::Kind::ne) {
+                    return a != b;
+                }
+                return compare_numbers(
+                    op, string_to_number(a), string_to_number(b));
+            }
+
+            // --- Paths -------------------------------------------------
+
+            XPathNodeSet path(const Expr& expr, const Context& ctx) {
+                XPathNodeSet current;
+                if (expr.filter) {
+                    current = this->node_set(*expr.filter, ctx);
+                    for (const auto& predicate : expr.filter_predicates) {
+                        current = this->filter(current, predicate);
+                    }
+                } else if (expr.absolute) {
+                    current.push_back(root_of(ctx.node));
+                } else {
+                    current.push_back(ctx.node);
+                }
+                for (const auto& step : expr.steps) {
+                    if (current.empty()) {
+                        break;
+                    }
+                    current = this->step(step, current);
+                }
+                return current;
+            }
+
+            XPathNodeSet step(const Step& step, const XPathNodeSet& input) {
+                XPathNodeSet output;
+                if (input.size() == 1) {
+                    this->step_from(step, input.front(), output);
+                    return output;
+                }
+
+                bool needs_sort = false;
+                switch (step.axis) {
+                case Axis::self:
+                case Axis::attribute:
+                case Axis::namespace_:
+                    // Results follow the order of the input.
+                    break;
+                case Axis::child:
+                    needs_sort = nested(input);
+                    break;
+                case Axis::descendant:
+                case Axis::descendant_or_self:
+                    if (step.streaming()) {
+                        // The subtree of a nested context is part of its
+                        // ancestor's, so it can be skipped entirely.
+                        lxb_dom_node_t* outer = nullptr;
+                        for (auto* node : input) {
+                            if (outer != nullptr && contains(outer, node)) {
+                                continue;
+                            }
+                            outer = node;
+                            this->step_from(step, node, output);
+                        }
+                        return output;
+                    }
+                    needs_sort = true;
+                    break;
+                default:
+                    needs_sort = true;
+                    break;
+                }
+                for (auto* node : input) {
+                    this->step_from(step, node, output);
+                }
+                if (needs_sort) {
+                    this->sort(output);
+                }
+                return output;
+            }
+
+            static bool
+            contains(lxb_dom_node_t* ancestor, lxb_dom_node_t* node) {
+                for (auto* n = parent_of(node); n != nullptr;
+                     n = parent_of(n)) {
+                    if (n == ancestor) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            static bool nested(const XPathNodeSet& nodes) {
+                std::unordered_set<lxb_dom_node_t*> set(
+                    nodes.begin(), nodes.end());
+                for (auto* node : nodes) {
+                    for (auto* n = parent_of(node); n != nullptr;
+                         n = parent_of(n)) {
+                        if (set.count(n) != 0) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            // Appends the nodes step selects from node, in document order.
+            void step_from(
+                const Step& step, lxb_dom_node_t* node, XPathNodeSet& output) {
+                auto start = output.size();
+                const auto& predicates = step.predicates;
+
+                if (step.streaming()) {
+                    for_each_on_axis(
+                        step.axis, node, [&](lxb_dom_node_t* candidate) {
+                            if (this->test(step, candidate) &&
+                                this->accepts(predicates, candidate)) {
+                                output.push_back(candidate);
+                            }
+                            return true;
+                        });
+                } else if (predicates.front().kind ==
+                           Predicate::Kind::index) {
+                    // [n] stops the walk at the n-th node.
+                    auto wanted = predicates.front().index;
+                    std::size_t count = 0;
+                    lxb_dom_node_t* found = nullptr;
+                    for_each_on_axis(
+                        step.axis, node, [&](lxb_dom_node_t* candidate) {
+                            if (this->test(step, candidate) &&
+                                ++count == wanted) {
+                                found = candidate;
+                                return false;
+                            }
+                            return true;
+                        });
+                    if (found != nullptr) {
+                        XPathNodeSet nodes{found};
+                        for (std::size_t i = 1; i < predicates.size(); ++i) {
+                            nodes = this->filter(nodes, predicates[i]);
+                        }
+                        output.insert(output.end(), nodes.begin(), nodes.end());
+                    }
+                } else {
+                    XPathNodeSet nodes;
+                    for_each_on_axis(
+                        step.axis, node, [&](lxb_dom_node_t* candidate) {
+                            if (this->test(step, candidate)) {
+                                nodes.push_back(candidate);
+                            }
+                            return true;
+                        });
+                    for (const auto& predicate : predicates) {
+                        if (nodes.empty()) {
+                            break;
+                        }
+                        nodes = this->filter(nodes, predicate);
+                    }
+                    output.insert(output.end(), nodes.begin(), nodes.end());
+                }
+
+                if (is_reverse(step.axis)) {
+                    std::reverse(
+                        output.begin() + static_cast<std::ptrdiff_t>(start),
+                        output.end());
+                }
+            }
+
+            bool accepts(
+                const std::vector<Predicate>& predicates,
+                lxb_dom_node_t* node) {
+                for (const auto& predicate : predicates) {
+                    if (!this->accepts(predicate, node, 1, 1)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool accepts(
+                const Predicate& predicate, lxb_dom_node_t* node,
+                std::size_t position, std::size_t size) {
+                switch (predicate.kind) {
+                case Predicate::Kind::index:
+                    return position == predicate.index;
+                case Predicate::Kind::has_attribute:
+                    return find_attribute(node, predicate.attribute) !=
+                           nullptr;
+                case Predicate::Kind::attribute_equals: {
+                    auto* attr = find_attribute(node, predicate.attribute);
+                    return attr != nullptr &&
+                           attribute_value(attr) == predicate.value;
+                }
+                case Predicate::Kind::general:
+                    break;
+                }
+                auto value =
+                    this->eval(*predicate.expr, {node, position, size});
+                if (auto* number = std::get_if<double>(&value)) {
+                    return *number == static_cast<double>(position);
+                }
+                return to_boolean(value);
+            }
+
+            // Keeps the nodes of nodes, in axis order, that predicate
+            // accepts.
+            XPathNodeSet
+            filter(const XPathNodeSet& nodes, const Predicate& predicate) {
+                XPathNodeSet kept;
+                const auto size = nodes.size();
+                if (predicate.kind == Predicate::Kind::index) {
+                    if (predicate.index <= size) {
+                        kept.push_back(nodes[predicate.index - 1]);
+                    }
+                    return kept;
+                }
+                for (std::size_t i = 0; i < size; ++i) {
+                    if (this->accepts(predicate, nodes[i], i + 1, size)) {
+                        kept.push_back(nodes[i]);
+                    }
+                }
+                return kept;
+            }
+
+            bool test(const Step& step, lxb_dom_node_t* node) {
+                auto principal = step.axis == Axis::attribute
+                                     ? LXB_DOM_NODE_TYPE_ATTRIBUTE
+                                     : LXB_DOM_NODE_TYPE_ELEMENT;
+                switch (step.test) {
+                case NodeTest::node:
+                    return true;
+                case NodeTest::text:
+                    return is_text(node);
+                case NodeTest::comment:
+                    return node->type == LXB_DOM_NODE_TYPE_COMMENT;
+                case NodeTest::processing_instruction:
+                    return node->type ==
+                           LXB_DOM_NODE_TYPE_PROCESSING_INSTRUCTION;
+                case NodeTest::any_name:
+                    return node->type == principal;
+                case NodeTest::name:
+                    break;
+                }
+                if (node->type != principal) {
+                    return false;
+                }
+                if (principal == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                    return equals_ignore_case(
+                        attribute_name(lxb_dom_interface_attr(node)),
+                        step.name);
+                }
+                // Ids of the tags lexbor knows are the same in every
+                // document, so each is compared by name at most once.
+                auto id = node->local_name;
+                if (id < LXB_TAG__LAST_ENTRY) {
+                    auto& memo = this->tag_memos_[step.memo];
+                    if (memo.empty()) {
+                        memo.assign(LXB_TAG__LAST_ENTRY, unknown);
+                    }
+                    if (memo[id] == unknown) {
+                        memo[id] =
+                            equals_ignore_case(local_name(node), step.name)
+                                ? matched
+                                : rejected;
+                    }
+                    return memo[id] == matched;
+                }
+                return equals_ignore_case(local_name(node), step.name);
+            }
+
+            // Calls f with each node on axis from node, in axis order, until
+            // f returns false.
+            template<class F>
+            static void
+            for_each_on_axis(Axis axis, lxb_dom_node_t* node, F&& f) {
+                switch (axis) {
+                case Axis::self:
+                    f(node);
+                    return;
+                case Axis::child:
+                    for (auto* n = node->first_child; n != nullptr;
+                         n = n->next) {
+                        if (!f(n)) {
+                            return;
+                        }
+                    }
+                    return;
+                case Axis::descendant_or_self:
+                    if (!f(node)) {
+                        return;
+                    }
+                    [[fallthrough]];
+                case Axis::descendant:
+                    if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                        return;
+                    }
+                    for (auto* n = node->first_child; n != nullptr;
+                         n = next_in_subtree(n, node)) {
+                        if (!f(n)) {
+                            return;
+                        }
+                    }
+                    return;
+                case Axis::parent:
+                    if (auto* parent = parent_of(node)) {
+                        f(parent);
+                    }
+                    return;
+                case Axis::ancestor_or_self:
+                    if (!f(node)) {
+                        return;
+                    }
+                    [[fallthrough]];
+                case Axis::ancestor:
+                    for (auto* n = parent_of(node); n != nullptr;
+                         n = parent_of(n)) {
+                        if (!f(n)) {
+                            return;
+                        }
+                    }
+                    return;
+                case Axis::following_sibling:
+                    if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                        return;
+                    }
+                    for (auto* n = node->next; n != nullptr; n = n->next) {
+                        if (!f(n)) {
+                            return;
+                        }
+                    }
+                    return;
+                case Axis::preceding_sibling:
+                    if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                        return;
+                    }
+                    for (auto* n = node->prev; n != nullptr; n = n->prev) {
+                        if (!f(n)) {
+                            return;
+                        }
+                    }
+                    return;
+                case Axis::following: {
+                    lxb_dom_node_t* n;
+                    auto* root = root_of(node);
+                    if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                        auto* owner = parent_of(node);
+                        n = owner == nullptr
+                                ? nullptr
+                                : next_in_subtree(owner, root);
+                    } else {
+                        n = next_in_subtree(node, root, true);
+                    }
+                    for (; n != nullptr; n = next_in_subtree(n, root)) {
+                        if (!f(n)) {
+                            return;
+                        }
+                    }
+                    return;
+                }
+                case Axis::preceding: {
+                    if (node->type == LXB_DOM_NODE_TYPE_ATTRIBUTE) {
+                        node = parent_of(node);
+                        if (node == nullptr) {
+                            return;
+                        }
+                    }
+                    // Reverse document order, skipping ancestors.
+                    for (auto* n = node; n != nullptr; n = n->parent) {
+                        for (auto* sibling = n->prev; sibling != nullptr;
+                             sibling = sibling->prev) {
+                            if (!reverse_subtree(sibling, f)) {
+                                return;
+                            }
+                        }
+                    }
+                    return;
+                }
+                case Axis::attribute:
+                    for (auto* attr = first_attribute(node); attr != nullptr;
+                         attr = lxb_dom_element_next_attribute(attr)) {
+                        if (!f(lxb_dom_interface_node(attr))) {
+                            return;
+                        }
+                    }
+                    return;
+                case Axis::namespace_:
+                    return;
+                }
+            }
+
+            // Calls f with node's subtree in reverse document order.
+            template<class F>
+            static bool reverse_subtree(lxb_dom_node_t* node, F& f) {
+                for (auto* child = node->last_child; child != nullptr;
+                     child = child->prev) {
+                    if (!reverse_subtree(child, f)) {
+                        return false;
+                    }
+                }
+                return f(node);
+            }
+
+            // Sorts nodes into document order and removes duplicates.
+            void sort(XPathNodeSet& nodes) {
+                if (nodes.size() < 2) {
+                    return;
+                }
+                auto* root = root_of(nodes.front());
+                if (root != this->order_root_) {
+                    this->order_root_ = root;
+                    this->order_.clear();
+                    std::size_t index = 0;
+                    for (auto* n = root; n != nullptr;
+                         n = next_in_subtree(n, root)) {
+                        this->order_.emplace(n, index++);
+                        for (auto* attr = first_attribute(n); attr != nullptr;
+                             attr = lxb_dom_element_next_attribute(attr)) {
+                            this->order_.emplace(
+                                lxb_dom_interface_node(attr), index++);
+                        }
+                    }
+                }
+                auto order = [this](lxb_dom_node_t* node) {
+                    auto it = this->order_.find(node);
+                    return it == this->order_.end() ? 0 : it->second;
+                };
+                std::sort(
+                    nodes.begin(), nodes.end(),
+                    [&order](lxb_dom_node_t* a, lxb_dom_node_t* b) {
+                        return order(a) < order(b);
+                    });
+                nodes.erase(
+                    std::unique(nodes.begin(), nodes.end()), nodes.end());
+            }
+
+            // --- Functions ---------------------------------------------
+
+            // Node-set argument i, or the context node when it is omitted.
+            XPathNodeSet
+            node_argument(const Expr& expr, const Context& ctx, std::size_t i) {
+                if (expr.args.size() > i) {
+                    return this->node_set(*expr.args[i], ctx);
+                }
+                return {ctx.node};
+            }
+
+            std::string
+            string_argument(const Expr& expr, const Context& ctx,
+                            std::size_t i) {
+                if (expr.args.size() > i) {
+                    return this->string(*expr.args[i], ctx);
+                }
+                return std::string(string_value(ctx.node, this->scratch_));
+            }
+
+            XPathValue call(const Expr& expr, const Context& ctx) {
+                const auto& args = expr.args;
+                switch (expr.function) {
+                case Function::last:
+                    return static_cast<double>(ctx.size);
+                case Function::position:
+                    return static_cast<double>(ctx.position);
+                case Function::count:
+                    return static_cast<double>(
+                        this->node_set(*args[0], ctx).size());
+                case Function::id:
+                    return this->id(this->eval(*args[0], ctx), ctx);
+                case Function::local_name:
+                case Function::name: {
+                    auto nodes = this->node_argument(expr, ctx, 0);
+                    if (nodes.empty()) {
+                        return std::string{};
+                    }
+                    return std::string(local_name(nodes.front()));
+                }
+                case Function::namespace_uri:
+                    return std::string{};
+                case Function::string:
+                    return this->string_argument(expr, ctx, 0);
+                case Function::concat: {
+                    std::string out;
+                    for (const auto& arg : args) {
+                        out += this->string(*arg, ctx);
+                    }
+                    return out;
+                }
+                case Function::starts_with: {
+                    auto text = this->string(*args[0], ctx);
+                    auto prefix = this->string(*args[1], ctx);
+                    return text.compare(0, prefix.size(), prefix) == 0;
+                }
+                case Function::contains: {
+                    auto text = this->string(*args[0], ctx);
+                    auto part = this->string(*args[1], ctx);
+                    return text.find(part) != std::string::npos;
+                }
+                case Function::substring_before: {
+                    auto text = this->string(*args[0], ctx);
+                    auto part = this->string(*args[1], ctx);
+                    auto at = text.find(part);
+                    return at == std::string::npos ? std::string{}
+                                                   : text.substr(0, at);
+                }
+                case Function::substring_after: {
+                    auto text = this->string(*args[0], ctx);
+                    auto part = this->string(*args[1], ctx);
+                    auto at = text.find(part);
+                    return at == std::string::npos
+                               ? std::string{}
+                               : text.substr(at + part.size());
+                }
+                case Function::substring:
+                    return this->substring(expr, ctx);
+                case Function::string_length:
+                    return static_cast<double>(
+                        character_count(this->string_argument(expr, ctx, 0)));
+                case Function::normalize_space:
+                    return normalize_space(this->string_argument(expr, ctx, 0));
+                case Function::translate:
+                    return this->translate(expr, ctx);
+                case Function::boolean:
+                    return this->boolean(*args[0], ctx);
+                case Function::not_:
+                    return !this->boolean(*args[0], ctx);
+                case Function::true_:
+                    return true;
+                case Function::false_:
+                    return false;
+                case Function::lang:
+                    return this->lang(this->string(*args[0], ctx), ctx.node);
+                case Function::number:
+                    if (args.empty()) {
+                        return string_to_number(
+                            string_value(ctx.node, this->scratch_));
+                    }
+                    return this->number(*args[0], ctx);
+                case Function::sum: {
+                    double total = 0;
+                    for (auto* node : this->node_set(*args[0], ctx)) {
+                        total += string_to_number(
+                            string_value(node, this->scratch_));
+                    }
+                    return total;
+                }
+                case Function::floor:
+                    return std::floor(this->number(*args[0], ctx));
+                case Function::ceiling:
+                    return std::ceil(this->number(*args[0], ctx));
+                case Function::round:
+                    return xpath_round(this->number(*args[0], ctx));
+                }
+                return false;
+            }
+
+            std::string substring(const Expr& expr, const Context& ctx) {
+                auto text = this->string(*expr.args[0], ctx);
+                auto first = xpath_round(this->number(*expr.args[1], ctx));
+                auto last = std::numeric_limits<double>::infinity();
+                if (expr.args.size() == 3) {
+                    last = first +
+                           xpath_round(this->number(*expr.args[2], ctx));
+                }
+                std::string out;
+                double position = 1;
+                for (auto c : characters(text)) {
+                    if (position >= first && position < last) {
+                        out.append(c);
+                    }
+                    ++position;
+                }
+                return out;
+            }
+
+            std::string translate(const Expr& expr, const Context& ctx) {
+                auto text = this->string(*expr.args[0], ctx);
+                auto from_text = this->string(*expr.args[1], ctx);
+                auto to_text = this->string(*expr.args[2], ctx);
+                auto from = characters(from_text);
+                auto to = characters(to_text);
+                std::string out;
+                out.reserve(text.size());
+                for (auto c : characters(text)) {
+                    auto it = std::find(from.begin(), from.end(), c);
+                    if (it == from.end()) {
+                        out.append(c);
+                        continue;
+                    }
+                    auto index = static_cast<std::size_t>(it - from.begin());
+                    if (index < to.size()) {
+                        out.append(to[index]);
+                    }
+                }
+                return out;
+            }
+
+            bool lang(const std::string& wanted, lxb_dom_node_t* node) {
+                for (auto* n = node; n != nullptr; n = parent_of(n)) {
+                    auto* attr = find_attribute(n, "xml:lang");
+                    if (attr == nullptr) {
+                        attr = find_attribute(n, "lang");
+                    }
+                    if (attr == nullptr) {
+                        continue;
+                    }
+                    auto value = attribute_value(attr);
+                    if (!starts_with_ignore_case(value, wanted)) {
+                        return false;
+                    }
+                    return value.size() == wanted.size() ||
+                           value[wanted.size()] == '-';
+                }
+                return false;
+            }
+
+            XPathNodeSet id(const XPathValue& value, const Context& ctx) {
+                std::string ids;
+                if (const auto* nodes = std::get_if<XPathNodeSet>(&value)) {
+                    for (auto* node : *nodes) {
+                        ids.append(string_value(node, this->scratch_));
+                        ids += ' ';
+                    }
+                } else {
+                    ids = this->to_string(value);
+                }
+                std::unordered_set<std::string_view> wanted;
+                std::string_view rest{ids};
+                while (!rest.empty()) {
+                    auto start = rest.find_first_not_of(" \t\r\n");
+                    if (start == std::string_view::npos) {
+                        break;
+                    }
+                    rest.remove_prefix(start);
+                    auto end = rest.find_first_of(" \t\r\n");
+                    wanted.insert(rest.substr(0, end));
+                    rest.remove_prefix(
+                        end == std::string_view::npos ? rest.size() : end);
+                }
+
+                XPathNodeSet found;
+                if (wanted.empty()) {
+                    return found;
+                }
+                auto* root = root_of(ctx.node);
+                for (auto* n = root; n != nullptr;
+                     n = next_in_subtree(n, root)) {
+                    if (auto* attr = find_attribute(n, "id")) {
+                        if (wanted.erase(attribute_value(attr)) != 0) {
+                            found.push_back(n);
+                            if (wanted.empty()) {
+                                break;
+                            }
+                        }
+                    }
+                }
+                return found;
+            }
+
+            static constexpr std::int8_t unknown = 0;
+            static constexpr std::int8_t matched = 1;
+            static constexpr std::int8_t rejected = 2;
+
+            std::vector<std::vector<std::int8_t>> tag_memos_;
+            std::string scratch_;
+            lxb_dom_node_t* order_root_{};
+            std::unordered_map<lxb_dom_node_t*, std::size_t> order_;
+        };
+    } // namespace
+
+    struct XPath::Plan {
+        std::string source;
+        ExprPtr root;
+        std::size_t name_tests{};
+    };
+
+    XPath::XPath(std::string_view expression) {
+        auto plan = std::make_shared<Plan>();
+        plan->source = std::string(expression);
+        Parser parser{expression};
+        plan->root = parser.parse();
+        plan->name_tests = parser.name_tests();
+        this->plan_ = std::move(plan);
+    }
+
+    const std::string& XPath::source() const noexcept {
+        return this->plan_->source;
+    }
+
+    XPathValue XPath::evaluate(lxb_dom_node_t* context) const {
+        Evaluator evaluator{this->plan_->name_tests};
+        return evaluator.eval(*this->plan_->root, {context, 1, 1});
+    }
+
+    XPathNodeSet XPath::select(lxb_dom_node_t* context) const {
+        Evaluator evaluator{this->plan_->name_tests};
+        return evaluator.node_set(*this->plan_->root, {context, 1, 1});
+    }
+
+    std::string XPath::string(lxb_dom_node_t* context) const {
+        Evaluator evaluator{this->plan_->name_tests};
+        return evaluator.string(*this->plan_->root, {context, 1, 1});
+    }
+
+    std::string xpath_string_value(lxb_dom_node_t* node) {
+        std::string scratch;
+        return std::string(string_value(node, scratch));
+    }
+} // namespace Scrapp::Html
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_XPATH_H
+#define SCRAPP_XPATH_H
+
+#include "types.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace Scrapp::Html {
+    // Result of an XPath expression: a node-set in document order, a
+    // number, a string or a boolean. Attribute nodes in a node-set are the
+    // node of their lxb_dom_attr_t.
+    using XPathNodeSet = std::vector<lxb_dom_node_t*>;
+    using XPathValue = std::variant<XPathNodeSet, double, std::string, bool>;
+
+    // XPath 1.0 expression compiled once into an evaluation plan that runs
+    // directly on lexbor nodes. Copies share the plan and evaluation does
+    // not modify it, so one XPath can be used from several threads.
+    //
+    // Name tests compare local names case-insensitively and ignore
+    // prefixes, which is what HTML documents need. Variables are not
+    // supported, namespace-uri() is always empty and the namespace axis is
+    // always empty.
+    class XPath {
+      public:
+        // Throws xpath_error if expression is not valid XPath 1.0.
+        explicit XPath(std::string_view expression);
+
+        [[nodiscard]] const std::string& source() const noexcept;
+
+        XPathValue evaluate(lxb_dom_node_t* context) const;
+        // Throws xpath_error when the expression is not a node-set.
+        XPathNodeSet select(lxb_dom_node_t* context) const;
+        // The result converted as by the string() function.
+        std::string string(lxb_dom_node_t* context) const;
+
+        struct Plan;
+
+      private:
+        std::shared_ptr<const Plan> plan_;
+    };
+
+    // XPath string-value of node.
+    std::string xpath_string_value(lxb_dom_node_t* node);
+} // namespace Scrapp::Html
+
+#endif // SCRAPP_XPATH_H
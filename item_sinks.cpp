@@ -0,0 +1,210 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "item_sinks.h"
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        // items.jsonl -> items.00001.jsonl
+        std::string numbered(const std::string& path, std::size_t index) {
+            auto number = std::to_string(index);
+            number.insert(0, number.size() < 5 ? 5 - number.size() : 0, '0');
+            auto name = path.find_last_of('/');
+            auto dot = path.find_last_of('.');
+            if (dot == std::string::npos ||
+                (name != std::string::npos && dot < name) ||
+                dot == (name == std::string::npos ? 0 : name + 1)) {
+                return path + "." + number;
+            }
+            return path.substr(0, dot) + "." + number + path.substr(dot);
+        }
+
+        // Item or boost::json::value.
+        template<typename T>
+        void append_json(
+            boost::json::serializer& serializer, const T& value,
+            std::string& out) {
+            serializer.reset(&value);
+            char chunk[4096];
+            while (!serializer.done()) {
+                auto part = serializer.read(chunk);
+                out.append(part.data(), part.size());
+            }
+        }
+
+        void append_field(
+            std::string_view text, char delimiter, std::string& out) {
+            char special[] = {delimiter, '"', '\r', '\n'};
+            if (text.find_first_of(special, 0, sizeof(special)) ==
+                std::string_view::npos) {
+                out.append(text);
+                return;
+            }
+            out += '"';
+            for (auto c : text) {
+                if (c == '"') {
+                    out += '"';
+                }
+                out += c;
+            }
+            out += '"';
+        }
+
+        std::string
+        csv_header(const std::vector<std::string>& columns, char delimiter) {
+            std::string header;
+            for (std::size_t i = 0; i < columns.size(); ++i) {
+                if (i != 0) {
+                    header += delimiter;
+                }
+                append_field(columns[i], delimiter, header);
+            }
+            return header + "\r\n";
+        }
+    } // namespace
+
+    FileSink::FileSink(FileSinkOptions options, std::string header)
+        : options_{std::move(options)}, header_{std::move(header)} {
+        this->buffer_.reserve(this->options_.buffer_size);
+        this->open_next();
+    }
+
+    FileSink::~FileSink() {
+        if (!this->file_.is_open()) {
+            return;
+        }
+        try {
+            this->write_out();
+        } catch (const item_pipeline_exception&) {
+            // Only close() reports errors.
+        }
+    }
+
+    void FileSink::write(const std::vector<Item>& items) {
+        if (!this->file_.is_open()) {
+            throw item_pipeline_exception(
+                "cannot write to closed sink " + this->files_.back());
+        }
+        for (const auto& item : items) {
+            if (this->options_.rotate_bytes != 0 &&
+                this->file_bytes_ > this->header_.size() &&
+                this->file_bytes_ >= this->options_.rotate_bytes) {
+                this->write_out();
+                this->file_.close(
+                    this->options_.fsync != FsyncPolicy::never);
+                this->open_next();
+            }
+            auto before = this->buffer_.size();
+            this->format(item, this->buffer_);
+            this->file_bytes_ += this->buffer_.size() - before;
+            if (this->buffer_.size() >= this->options_.buffer_size) {
+                this->write_out();
+            }
+        }
+    }
+
+    void FileSink::flush() {
+        if (!this->file_.is_open()) {
+            return;
+        }
+        this->write_out();
+        if (this->options_.fsync == FsyncPolicy::on_flush) {
+            this->file_.sync();
+        }
+    }
+
+    void FileSink::close() {
+        if (!this->file_.is_open()) {
+            return;
+        }
+        this->write_out();
+        this->file_.close(this->options_.fsync != FsyncPolicy::never);
+    }
+
+    const std::vector<std::string>& FileSink::files() const noexcept {
+        return this->files_;
+    }
+
+    void FileSink::open_next() {
+        auto path = this->options_.path;
+        if (this->options_.rotate_bytes != 0) {
+            path = numbered(path, this->files_.size());
+        }
+        this->file_.open(path);
+        this->files_.push_back(std::move(path));
+        this->buffer_ += this->header_;
+        this->file_bytes_ = this->header_.size();
+    }
+
+    void FileSink::write_out() {
+        this->file_.write(this->buffer_);
+        this->buffer_.clear();
+    }
+
+    JsonLinesSink::JsonLinesSink(FileSinkOptions options)
+        : FileSink(std::move(options)) {}
+
+    void JsonLinesSink::format(const Item& item, std::string& out) {
+        append_json(this->serializer_, item, out);
+        out += '\n';
+    }
+
+    CsvSink::CsvSink(
+        FileSinkOptions options, std::vector<std::string> columns,
+        char delimiter)
+        : FileSink(std::move(options), csv_header(columns, delimiter)),
+          columns_{std::move(columns)}, delimiter_{delimiter} {}
+
+    void CsvSink::format(const Item& item, std::string& out) {
+        std::string json;
+        for (std::size_t i = 0; i < this->columns_.size(); ++i) {
+            if (i != 0) {
+                out += this->delimiter_;
+            }
+            const auto* value = item.if_contains(this->columns_[i]);
+            if (value == nullptr) {
+                continue;
+            }
+            switch (value->kind()) {
+            case boost::json::kind::null:
+                break;
+            case boost::json::kind::string: {
+                const auto& string = value->get_string();
+                append_field(
+                    {string.data(), string.size()}, this->delimiter_, out);
+                break;
+            }
+            case boost::json::kind::array:
+            case boost::json::kind::object:
+                json.clear();
+                append_json(this->serializer_, *value, json);
+                append_field(json, this->delimiter_, out);
+                break;
+            default:
+                append_json(this->serializer_, *value, out);
+                break;
+            }
+        }
+        out += "\r\n";
+    }
+} // namespace Scrapp
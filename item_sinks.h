@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_ITEM_SINKS_H
+#define SCRAPP_ITEM_SINKS_H
+
+#include "exceptions.h"
+#include "output_file.h"
+#include "pipeline.h"
+#include <boost/json.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Scrapp {
+    enum class FsyncPolicy {
+        // Leave it to the OS.
+        never,
+        // When a file is rotated or closed.
+        on_close,
+        // On every flush of the pipeline, and on close.
+        on_flush,
+    };
+
+    struct FileSinkOptions {
+        // With rotation the files are numbered before the extension, e.g.
+        // items.00000.jsonl, items.00001.jsonl.
+        std::string path;
+        // Starts a new file once this many bytes are written, 0 never does.
+        std::size_t rotate_bytes{0};
+        // Output is written in chunks of at least this size.
+        std::size_t buffer_size{1 << 20};
+        FsyncPolicy fsync{FsyncPolicy::on_close};
+    };
+
+    // Sink writing items to files with large buffered writes. Subclasses
+    // only format the items. Throws item_pipeline_exception on I/O errors.
+    class FileSink : public ItemSink {
+      public:
+        // Opens the first file right away, so that bad paths are reported
+        // before the crawl starts. header starts every file.
+        explicit FileSink(FileSinkOptions options, std::string header = {});
+        FileSink(const FileSink&) = delete;
+        FileSink& operator=(const FileSink&) = delete;
+        ~FileSink() override;
+
+        void write(const std::vector<Item>& items) final;
+        void flush() final;
+        void close() final;
+
+        // Every file opened so far, in order.
+        [[nodiscard]] const std::vector<std::string>& files() const noexcept;
+
+      protected:
+        // Appends item to out, including the record separator.
+        virtual void format(const Item& item, std::string& out) = 0;
+
+      private:
+        void open_next();
+        void write_out();
+
+        FileSinkOptions options_;
+        std::string header_;
+        std::string buffer_;
+        std::vector<std::string> files_;
+        OutputFile<item_pipeline_exception> file_;
+        std::size_t file_bytes_{0};
+    };
+
+    // One JSON document per line.
+    class JsonLinesSink : public FileSink {
+      public:
+        explicit JsonLinesSink(FileSinkOptions options);
+
+      protected:
+        void format(const Item& item, std::string& out) override;
+
+      private:
+        boost::json::serializer serializer_;
+    };
+
+    // RFC 4180 CSV with a header row. Missing and null fields are empty,
+    // arrays and objects are written as JSON.
+    class CsvSink : public FileSink {
+      public:
+        CsvSink(
+            FileSinkOptions options, std::vector<std::string> columns,
+            char delimiter = ',');
+
+      protected:
+        void format(const Item& item, std::string& out) override;
+
+      private:
+        std::vector<std::string> columns_;
+        char delimiter_;
+        boost::json::serializer serializer_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_ITEM_SINKS_H
@@ -0,0 +1,175 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json.h"
+#include "exceptions.h"
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        // Set once the calling thread's pool has been destroyed at thread
+        // exit; blocks released after that are freed outright.
+        thread_local bool local_pool_destroyed = false;
+    } // namespace
+
+    // A monotonic arena whose first block is borrowed from the pool.
+    class JsonArenaPool::Arena final : public boost::json::memory_resource {
+      public:
+        explicit Arena(Block block) noexcept
+            : block_{std::move(block)}, arena_{block_.get(), block_size} {}
+
+        ~Arena() override {
+            this->arena_.release();
+            JsonArenaPool::release(std::move(this->block_));
+        }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+      private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override {
+            return this->arena_.allocate(size, alignment);
+        }
+
+        void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+        bool do_is_equal(const boost::json::memory_resource& other)
+            const noexcept override {
+            return this == &other;
+        }
+
+        Block block_;
+        boost::json::monotonic_resource arena_;
+    };
+} // namespace Scrapp
+
+namespace boost::json {
+    // Lets containers skip deallocation calls, as the arena ignores them.
+    template<> struct is_deallocate_trivial<Scrapp::JsonArenaPool::Arena> {
+        static constexpr bool value = true;
+    };
+} // namespace boost::json
+
+namespace Scrapp {
+    std::atomic<std::size_t> JsonArenaPool::capacity_{default_capacity};
+
+    JsonArenaPool& JsonArenaPool::local() {
+        thread_local JsonArenaPool pool;
+        return pool;
+    }
+
+    boost::json::storage_ptr JsonArenaPool::acquire() {
+        Block block;
+        if (!this->idle_.empty()) {
+            block = std::move(this->idle_.back());
+            this->idle_.pop_back();
+            this->stats_.reused++;
+        } else {
+            block.reset(new unsigned char[block_size]);
+            this->stats_.created++;
+        }
+        return boost::json::make_shared_resource<Arena>(std::move(block));
+    }
+
+    void JsonArenaPool::release(Block block) noexcept {
+        if (block == nullptr || local_pool_destroyed) {
+            return;
+        }
+        auto& pool = local();
+        if (pool.idle_.size() >= capacity()) {
+            pool.stats_.destroyed++;
+            return;
+        }
+        try {
+            pool.idle_.push_back(std::move(block));
+        } catch (const std::bad_alloc&) {
+            pool.stats_.destroyed++;
+        }
+    }
+
+    void JsonArenaPool::set_capacity(std::size_t capacity) noexcept {
+        capacity_.store(capacity, std::memory_order_relaxed);
+    }
+
+    std::size_t JsonArenaPool::capacity() noexcept {
+        return capacity_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t JsonArenaPool::idle() const noexcept {
+        return this->idle_.size();
+    }
+
+    const JsonArenaPool::Stats& JsonArenaPool::stats() const noexcept {
+        return this->stats_;
+    }
+
+    void JsonArenaPool::clear() noexcept {
+        this->stats_.destroyed += this->idle_.size();
+        this->idle_.clear();
+    }
+
+    JsonArenaPool::~JsonArenaPool() { local_pool_destroyed = true; }
+
+    boost::json::parse_options lenient_json_options() noexcept {
+        boost::json::parse_options options;
+        options.allow_comments = true;
+        options.allow_trailing_commas = true;
+        return options;
+    }
+
+    JsonStream::JsonStream(const boost::json::parse_options& options)
+        : parser_{{}, options} {
+        this->parser_.reset(JsonArenaPool::local().acquire());
+    }
+
+    bool JsonStream::write(std::string_view chunk) noexcept {
+        if (this->failed()) {
+            return false;
+        }
+        try {
+            this->parser_.write(chunk.data(), chunk.size(), this->error_);
+        } catch (const std::bad_alloc&) {
+            this->error_ = boost::system::errc::make_error_code(
+                boost::system::errc::not_enough_memory);
+        }
+        return !this->failed();
+    }
+
+    bool JsonStream::failed() const noexcept {
+        return static_cast<bool>(this->error_);
+    }
+
+    const boost::json::error_code& JsonStream::error() const noexcept {
+        return this->error_;
+    }
+
+    boost::json::value JsonStream::finish() {
+        if (!this->failed()) {
+            this->parser_.finish(this->error_);
+        }
+        if (this->failed()) {
+            throw invalid_json_exception(
+                "invalid json: " + this->error_.message());
+        }
+        return this->parser_.release();
+    }
+} // namespace Scrapp
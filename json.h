@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_JSON_H
+#define SCRAPP_JSON_H
+
+#include <atomic>
+#include <boost/json.hpp>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp {
+    // Per-thread pool of the first blocks of JSON arenas. An arena takes a
+    // block from the pool of the thread that creates it and allocates from
+    // it monotonically, falling back to the heap once it is full. When the
+    // last value using the arena is gone the block goes back to the pool of
+    // the releasing thread, unless that pool already holds capacity()
+    // blocks, so steady crawls parse into the same few blocks.
+    class JsonArenaPool {
+      public:
+        static constexpr std::size_t block_size = 64 * 1024;
+        static constexpr std::size_t default_capacity = 4;
+
+        struct Stats {
+            std::size_t created{};
+            std::size_t reused{};
+            std::size_t destroyed{};
+        };
+
+        // The calling thread's pool.
+        static JsonArenaPool& local();
+
+        // Storage for a new arena. Values allocated with it share ownership
+        // of the arena, so it lives as long as the last of them. Like
+        // boost::json::monotonic_resource it must not be used from several
+        // threads at once.
+        boost::json::storage_ptr acquire();
+
+        // Maximum number of idle blocks each thread keeps.
+        static void set_capacity(std::size_t capacity) noexcept;
+        static std::size_t capacity() noexcept;
+
+        [[nodiscard]] std::size_t idle() const noexcept;
+        [[nodiscard]] const Stats& stats() const noexcept;
+        void clear() noexcept;
+
+        JsonArenaPool(const JsonArenaPool&) = delete;
+        JsonArenaPool& operator=(const JsonArenaPool&) = delete;
+        ~JsonArenaPool();
+
+      private:
+        class Arena;
+        using Block = std::unique_ptr<unsigned char[]>;
+
+        JsonArenaPool() = default;
+        static void release(Block block) noexcept;
+
+        static std::atomic<std::size_t> capacity_;
+        std::vector<Block> idle_;
+        Stats stats_;
+    };
+
+    // Comments and trailing commas are accepted, as in Response::json.
+    boost::json::parse_options lenient_json_options() noexcept;
+
+    // Parses a JSON document delivered in chunks, e.g. from a download
+    // write callback, into an arena from JsonArenaPool.
+    class JsonStream {
+      public:
+        explicit JsonStream(
+            const boost::json::parse_options& options = lenient_json_options());
+
+        // Parses the next chunk. Returns false once the input is known to
+        // be invalid; later chunks are ignored.
+        bool write(std::string_view chunk) noexcept;
+        [[nodiscard]] bool failed() const noexcept;
+        [[nodiscard]] const boost::json::error_code& error() const noexcept;
+        // Returns the parsed document, which owns its arena. Throws
+        // invalid_json_exception if the input was invalid or incomplete.
+        boost::json::value finish();
+
+      private:
+        boost::json::stream_parser parser_;
+        boost::json::error_code error_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_JSON_H
@@ -0,0 +1,572 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_extractor.h"
+#include "exceptions.h"
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        const std::vector<boost::json::value> no_values;
+
+        bool parse_index(std::string_view text, std::size_t& index) {
+            // Leading zeros are not array indexes in JSON Pointer.
+            if (text.empty() || text.size() > 18 ||
+                (text.size() > 1 && text[0] == '0')) {
+                return false;
+            }
+            index = 0;
+            for (auto c : text) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                index = index * 10 + static_cast<std::size_t>(c - '0');
+            }
+            return true;
+        }
+    } // namespace
+
+    const std::vector<boost::json::value>&
+    JsonRecord::values(std::string_view name) const {
+        for (std::size_t i = 0; i < this->names_->size(); i++) {
+            if ((*this->names_)[i] == name) {
+                return this->values_[i];
+            }
+        }
+        return no_values;
+    }
+
+    const boost::json::value* JsonRecord::value(std::string_view name) const {
+        const auto& values = this->values(name);
+        return values.empty() ? nullptr : &values.front();
+    }
+
+    const std::vector<std::string>& JsonRecord::names() const noexcept {
+        return *this->names_;
+    }
+
+    // Tracks the path of the value being parsed and which fields can still
+    // match below it. Matched scalars are copied out when they are parsed,
+    // matched containers are rebuilt with a value_stack fed by the events
+    // of their subtree. Containers no field can reach are skipped by
+    // counting their depth only.
+    class JsonExtractor::Handler {
+      public:
+        static constexpr std::size_t max_object_size =
+            std::numeric_limits<std::size_t>::max();
+        static constexpr std::size_t max_array_size =
+            std::numeric_limits<std::size_t>::max();
+        static constexpr std::size_t max_key_size =
+            std::numeric_limits<std::size_t>::max();
+        static constexpr std::size_t max_string_size =
+            std::numeric_limits<std::size_t>::max();
+
+        Handler(const JsonExtractor& extractor, JsonRecord& record)
+            : paths_{extractor.paths_}, record_{record} {}
+
+        bool on_document_begin(boost::json::error_code&) { return true; }
+        bool on_document_end(boost::json::error_code&) { return true; }
+
+        bool on_object_begin(boost::json::error_code&) {
+            this->begin_container(false);
+            return true;
+        }
+
+        bool on_object_end(std::size_t size, boost::json::error_code&) {
+            this->end_container(false, size);
+            return true;
+        }
+
+        bool on_array_begin(boost::json::error_code&) {
+            this->begin_container(true);
+            return true;
+        }
+
+        bool on_array_end(std::size_t size, boost::json::error_code&) {
+            this->end_container(true, size);
+            return true;
+        }
+
+        bool on_key_part(
+            boost::json::string_view part, std::size_t,
+            boost::json::error_code&) {
+            if (this->skip_depth_ == 0) {
+                for (auto& capture : this->captures_) {
+                    capture->stack.push_chars(part);
+                }
+                if (this->needs_key()) {
+                    this->key_.append(part.data(), part.size());
+                }
+            }
+            return true;
+        }
+
+        bool on_key(
+            boost::json::string_view key, std::size_t,
+            boost::json::error_code&) {
+            if (this->skip_depth_ == 0) {
+                for (auto& capture : this->captures_) {
+                    capture->stack.push_key(key);
+                }
+                if (this->needs_key()) {
+                    this->key_.append(key.data(), key.size());
+                }
+            }
+            return true;
+        }
+
+        bool on_string_part(
+            boost::json::string_view part, std::size_t,
+            boost::json::error_code&) {
+            if (this->skip_depth_ == 0) {
+                if (!this->in_string_) {
+                    this->in_string_ = true;
+                    this->begin_scalar();
+                }
+                for (auto& capture : this->captures_) {
+                    capture->stack.push_chars(part);
+                }
+                if (!this->matched_.empty()) {
+                    this->string_.append(part.data(), part.size());
+                }
+            }
+            return true;
+        }
+
+        bool on_string(
+            boost::json::string_view last, std::size_t,
+            boost::json::error_code&) {
+            if (this->skip_depth_ == 0) {
+                if (!this->in_string_) {
+                    this->begin_scalar();
+                }
+                this->in_string_ = false;
+                for (auto& capture : this->captures_) {
+                    capture->stack.push_string(last);
+                }
+                if (!this->matched_.empty()) {
+                    this->string_.append(last.data(), last.size());
+                    this->emit(boost::json::value(
+                        boost::json::string_view{
+                            this->string_.data(), this->string_.size()}));
+                }
+                this->end_scalar();
+            }
+            return true;
+        }
+
+        bool on_number_part(
+            boost::json::string_view, boost::json::error_code&) {
+            return true;
+        }
+
+        bool on_int64(
+            std::int64_t number, boost::json::string_view,
+            boost::json::error_code&) {
+            return this->scalar(number, [number](auto& stack) {
+                stack.push_int64(number);
+            });
+        }
+
+        bool on_uint64(
+            std::uint64_t number, boost::json::string_view,
+            boost::json::error_code&) {
+            return this->scalar(number, [number](auto& stack) {
+                stack.push_uint64(number);
+            });
+        }
+
+        bool on_double(
+            double number, boost::json::string_view,
+            boost::json::error_code&) {
+            return this->scalar(number, [number](auto& stack) {
+                stack.push_double(number);
+            });
+        }
+
+        bool on_bool(bool value, boost::json::error_code&) {
+            return this->scalar(
+                value, [value](auto& stack) { stack.push_bool(value); });
+        }
+
+        bool on_null(boost::json::error_code&) {
+            return this->scalar(
+                nullptr, [](auto& stack) { stack.push_null(); });
+        }
+
+        bool on_comment_part(
+            boost::json::string_view, boost::json::error_code&) {
+            return true;
+        }
+
+        bool on_comment(boost::json::string_view, boost::json::error_code&) {
+            return true;
+        }
+
+      private:
+        struct Level {
+            bool array;
+            std::size_t index;
+            // Range of alive_ holding the fields that can match below.
+            std::size_t alive_begin;
+            std::size_t alive_end;
+        };
+
+        struct Capture {
+            Capture(std::size_t field, std::size_t depth)
+                : field{field}, depth{depth} {
+                this->stack.reset();
+            }
+
+            std::size_t field;
+            std::size_t depth;
+            boost::json::value_stack stack;
+        };
+
+        static bool matches(
+            const Segment& segment, const Level& parent,
+            std::string_view key) {
+            switch (segment.kind) {
+            case Segment::Kind::any:
+                return true;
+            case Segment::Kind::key:
+                return !parent.array && segment.key == key;
+            case Segment::Kind::index:
+                return parent.array && segment.index == parent.index;
+            case Segment::Kind::key_or_index:
+                return parent.array ? segment.index == parent.index
+                                    : segment.key == key;
+            }
+            return false;
+        }
+
+        [[nodiscard]] bool needs_key() const noexcept {
+            if (this->levels_.empty()) {
+                return false;
+            }
+            const auto& top = this->levels_.back();
+            return !top.array && top.alive_begin != top.alive_end;
+        }
+
+        // Fills matched_ with the fields whose path ends at the value that
+        // starts now and, for containers, appends the fields that continue
+        // below it to alive_.
+        void select(bool container) {
+            this->matched_.clear();
+            auto depth = this->levels_.size();
+            if (depth == 0) {
+                for (std::size_t field = 0; field < this->paths_.size();
+                     field++) {
+                    if (this->paths_[field].empty()) {
+                        this->matched_.push_back(field);
+                    } else if (container) {
+                        this->alive_.push_back(field);
+                    }
+                }
+                return;
+            }
+            auto parent = this->levels_.back();
+            for (auto i = parent.alive_begin; i < parent.alive_end; i++) {
+                auto field = this->alive_[i];
+                const auto& path = this->paths_[field];
+                if (!matches(path[depth - 1], parent, this->key_)) {
+                    continue;
+                }
+                if (path.size() == depth) {
+                    this->matched_.push_back(field);
+                } else if (container) {
+                    this->alive_.push_back(field);
+                }
+            }
+            this->key_.clear();
+        }
+
+        void advance() {
+            if (!this->levels_.empty() && this->levels_.back().array) {
+                this->levels_.back().index++;
+            }
+        }
+
+        void begin_scalar() {
+            this->select(false);
+            this->string_.clear();
+        }
+
+        void end_scalar() {
+            this->matched_.clear();
+            this->advance();
+        }
+
+        void emit(const boost::json::value& value) {
+            for (auto field : this->matched_) {
+                this->record_.values_[field].push_back(value);
+            }
+        }
+
+        template<class Value, class Push>
+        bool scalar(Value value, Push push) {
+            if (this->skip_depth_ != 0) {
+                return true;
+            }
+            this->begin_scalar();
+            for (auto& capture : this->captures_) {
+                push(capture->stack);
+            }
+            if (!this->matched_.empty()) {
+                this->emit(boost::json::value(value));
+            }
+            this->end_scalar();
+            return true;
+        }
+
+        void begin_container(bool array) {
+            if (this->skip_depth_ != 0) {
+                this->skip_depth_++;
+                return;
+            }
+            auto alive_begin = this->alive_.size();
+            this->select(true);
+            auto alive_end = this->alive_.size();
+            if (alive_begin == alive_end && this->matched_.empty() &&
+                this->captures_.empty()) {
+                this->skip_depth_ = 1;
+                return;
+            }
+            this->levels_.push_back({array, 0, alive_begin, alive_end});
+            for (auto field : this->matched_) {
+                this->captures_.push_back(
+                    std::make_unique<Capture>(field, this->levels_.size()));
+            }
+            this->matched_.clear();
+        }
+
+        void end_container(bool array, std::size_t size) {
+            if (this->skip_depth_ != 0) {
+                if (--this->skip_depth_ == 0) {
+                    this->advance();
+                }
+                return;
+            }
+            auto depth = this->levels_.size();
+            for (auto& capture : this->captures_) {
+                if (array) {
+                    capture->stack.push_array(size);
+                } else {
+                    capture->stack.push_object(size);
+                }
+            }
+            // Captures nest, so the ones ending here are the innermost.
+            while (!this->captures_.empty() &&
+                   this->captures_.back()->depth == depth) {
+                auto& capture = *this->captures_.back();
+                this->record_.values_[capture.field].push_back(
+                    capture.stack.release());
+                this->captures_.pop_back();
+            }
+            this->alive_.resize(this->levels_.back().alive_begin);
+            this->levels_.pop_back();
+            this->advance();
+        }
+
+        const std::vector<std::vector<Segment>>& paths_;
+        JsonRecord& record_;
+        std::vector<Level> levels_;
+        std::vector<std::size_t> alive_;
+        std::vector<std::size_t> matched_;
+        std::vector<std::unique_ptr<Capture>> captures_;
+        std::string key_;
+        std::string string_;
+        std::size_t skip_depth_{};
+        bool in_string_{false};
+    };
+
+    JsonExtractor::JsonExtractor(std::vector<JsonField> fields) {
+        std::vector<std::string> names;
+        names.reserve(fields.size());
+        for (auto& field : fields) {
+            this->paths_.push_back(compile(field.path));
+            names.push_back(std::move(field.name));
+        }
+        this->names_ =
+            std::make_shared<const std::vector<std::string>>(std::move(names));
+    }
+
+    std::vector<JsonExtractor::Segment>
+    JsonExtractor::compile(const std::string& path) {
+        auto invalid = [&path](const char* reason) {
+            return invalid_json_path_exception(
+                "invalid json path \"" + path + "\": " + reason);
+        };
+        auto segment = [](std::string token) {
+            Segment segment;
+            if (token == "*") {
+                segment.kind = Segment::Kind::any;
+            } else if (parse_index(token, segment.index)) {
+                segment.kind = Segment::Kind::key_or_index;
+            }
+            segment.key = std::move(token);
+            return segment;
+        };
+
+        std::vector<Segment> segments;
+        if (path.empty()) {
+            return segments;
+        }
+        if (path[0] == '/') {
+            // JSON Pointer, RFC 6901.
+            std::size_t start = 1;
+            while (true) {
+                auto end = std::min(path.find('/', start), path.size());
+                std::string token;
+                for (auto i = start; i < end; i++) {
+                    if (path[i] != '~') {
+                        token += path[i];
+                    } else if (i + 1 < end && path[i + 1] == '0') {
+                        token += '~';
+                        i++;
+                    } else if (i + 1 < end && path[i + 1] == '1') {
+                        token += '/';
+                        i++;
+                    } else {
+                        throw invalid("'~' must be followed by 0 or 1");
+                    }
+                }
+                segments.push_back(segment(std::move(token)));
+                if (end == path.size()) {
+                    return segments;
+                }
+                start = end + 1;
+            }
+        }
+
+        std::string_view rest = path;
+        if (rest[0] == '$') {
+            rest.remove_prefix(1);
+            if (!rest.empty() && rest[0] == '.') {
+                rest.remove_prefix(1);
+            }
+        }
+        std::size_t i = 0;
+        while (i < rest.size()) {
+            if (rest[i] == '[') {
+                auto close = rest.find(']', i);
+                if (close == std::string_view::npos) {
+                    throw invalid("unclosed '['");
+                }
+                auto inner = rest.substr(i + 1, close - i - 1);
+                Segment bracket;
+                if (inner == "*") {
+                    bracket.kind = Segment::Kind::any;
+                } else if (parse_index(inner, bracket.index)) {
+                    bracket.kind = Segment::Kind::index;
+                } else if (inner.size() >= 2 &&
+                           (inner[0] == '\'' || inner[0] == '"') &&
+                           inner.back() == inner[0]) {
+                    bracket.key = inner.substr(1, inner.size() - 2);
+                } else {
+                    throw invalid("expected an index, '*' or a quoted key");
+                }
+                segments.push_back(std::move(bracket));
+                i = close + 1;
+            } else {
+                auto end = std::min(rest.find_first_of(".[", i), rest.size());
+                if (end == i) {
+                    throw invalid("empty segment");
+                }
+                segments.push_back(
+                    segment(std::string{rest.substr(i, end - i)}));
+                i = end;
+            }
+            if (i < rest.size() && rest[i] == '.') {
+                if (++i == rest.size()) {
+                    throw invalid("empty segment");
+                }
+            } else if (i < rest.size() && rest[i] != '[') {
+                throw invalid("expected '.' or '['");
+            }
+        }
+        return segments;
+    }
+
+    JsonRecord JsonExtractor::extract(
+        std::string_view json,
+        const boost::json::parse_options& options) const {
+        JsonRecord record;
+        record.names_ = this->names_;
+        record.values_.resize(this->paths_.size());
+        boost::json::basic_parser<Handler> parser{options, *this, record};
+        boost::json::error_code ec;
+        auto consumed = parser.write_some(false, json.data(), json.size(), ec);
+        if (!ec && consumed < json.size()) {
+            ec = boost::json::error::extra_data;
+        }
+        if (ec) {
+            throw invalid_json_exception("invalid json: " + ec.message());
+        }
+        return record;
+    }
+
+    JsonRecord
+    JsonExtractor::extract_value(const boost::json::value& document) const {
+        JsonRecord record;
+        record.names_ = this->names_;
+        record.values_.resize(this->paths_.size());
+        for (std::size_t i = 0; i < this->paths_.size(); i++) {
+            collect(document, this->paths_[i], 0, record.values_[i]);
+        }
+        return record;
+    }
+
+    void JsonExtractor::collect(
+        const boost::json::value& value, const std::vector<Segment>& path,
+        std::size_t depth, std::vector<boost::json::value>& out) {
+        if (depth == path.size()) {
+            // Copies allocate from the source's storage unless told
+            // otherwise, and documents may live in a shared arena.
+            out.emplace_back(value, boost::json::storage_ptr{});
+            return;
+        }
+        const auto& segment = path[depth];
+        if (const auto* array = value.if_array()) {
+            if (segment.kind == Segment::Kind::any) {
+                for (const auto& element : *array) {
+                    collect(element, path, depth + 1, out);
+                }
+            } else if (segment.kind != Segment::Kind::key &&
+                       segment.index < array->size()) {
+                collect((*array)[segment.index], path, depth + 1, out);
+            }
+        } else if (const auto* object = value.if_object()) {
+            if (segment.kind == Segment::Kind::any) {
+                for (const auto& member : *object) {
+                    collect(member.value(), path, depth + 1, out);
+                }
+            } else if (segment.kind != Segment::Kind::index) {
+                if (const auto* child = object->if_contains(segment.key)) {
+                    collect(*child, path, depth + 1, out);
+                }
+            }
+        }
+    }
+} // namespace Scrapp
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_JSON_EXTRACTOR_H
+#define SCRAPP_JSON_EXTRACTOR_H
+
+#include "json.h"
+#include <boost/json.hpp>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Scrapp {
+    // One named value to extract. path is either a JSON Pointer such as
+    // "/items/0/id", or a dotted pattern such as "items[*].id". "*" as a
+    // pointer segment, "[*]" or ".*" matches every element of an array or
+    // member of an object.
+    struct JsonField {
+        std::string name;
+        std::string path;
+    };
+
+    // Values produced by JsonExtractor::extract, in document order.
+    class JsonRecord {
+      public:
+        // Every value matched for name, empty if there were none.
+        const std::vector<boost::json::value>&
+        values(std::string_view name) const;
+        // First value matched for name, nullptr if there was none.
+        const boost::json::value* value(std::string_view name) const;
+        const std::vector<std::string>& names() const noexcept;
+
+      private:
+        friend class JsonExtractor;
+        std::shared_ptr<const std::vector<std::string>> names_;
+        std::vector<std::vector<boost::json::value>> values_;
+    };
+
+    // A set of JSON paths compiled once and matched in one pass of
+    // boost::json::basic_parser over the input. No document tree is built:
+    // only matched values are materialized, and subtrees no path can reach
+    // are skipped without allocating.
+    class JsonExtractor {
+      public:
+        // Throws invalid_json_path_exception if a path is malformed.
+        explicit JsonExtractor(std::vector<JsonField> fields);
+
+        // Throws invalid_json_exception if json is not a valid document.
+        JsonRecord extract(
+            std::string_view json,
+            const boost::json::parse_options& options =
+                lenient_json_options()) const;
+        // Matches the paths against an already parsed document.
+        JsonRecord extract_value(const boost::json::value& document) const;
+
+      private:
+        class Handler;
+
+        struct Segment {
+            enum class Kind { key, index, key_or_index, any };
+            Kind kind{Kind::key};
+            std::string key;
+            std::size_t index{};
+        };
+
+        static std::vector<Segment> compile(const std::string& path);
+        static void collect(
+            const boost::json::value& value, const std::vector<Segment>& path,
+            std::size_t depth, std::vector<boost::json::value>& out);
+
+        std::vector<std::vector<Segment>> paths_;
+        std::shared_ptr<const std::vector<std::string>> names_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_JSON_EXTRACTOR_H
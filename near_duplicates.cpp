@@ -0,0 +1,420 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "near_duplicates.h"
+#include "utils.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+
+namespace Scrapp {
+    namespace {
+        constexpr std::uint64_t fnv_offset = 0xcbf29ce484222325ULL;
+        constexpr std::uint64_t fnv_prime = 0x100000001b3ULL;
+        // Odd multiplier of the rolling shingle hash.
+        constexpr std::uint64_t shingle_base = 0x9e3779b97f4a7c15ULL;
+        constexpr std::size_t max_shingle_size = 16;
+
+        // splitmix64's finalizer, so every bit of a shingle hash depends on
+        // every word of the shingle.
+        std::uint64_t mix(std::uint64_t hash) noexcept {
+            hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+            return hash ^ (hash >> 31);
+        }
+
+        bool is_word_char(char c) noexcept {
+            auto byte = static_cast<unsigned char>(c);
+            return byte >= 0x80 || (byte >= '0' && byte <= '9') ||
+                   ((byte | 0x20) >= 'a' && (byte | 0x20) <= 'z');
+        }
+
+        std::uint64_t hash_word(std::string_view word) noexcept {
+            auto hash = fnv_offset;
+            for (char c : word) {
+                auto byte = static_cast<unsigned char>(c);
+                if (byte >= 'A' && byte <= 'Z') {
+                    byte |= 0x20;
+                }
+                hash = (hash ^ byte) * fnv_prime;
+            }
+            return hash;
+        }
+
+        // Hashes every window of shingle_size consecutive words in O(1) per
+        // word with a polynomial rolling hash, and sums the bits of the
+        // windows' hashes.
+        class Shingler {
+          public:
+            explicit Shingler(std::size_t shingle_size) noexcept
+                : size_{std::clamp<std::size_t>(
+                      shingle_size, 1, max_shingle_size)} {
+                for (std::size_t i = 0; i < this->size_; ++i) {
+                    this->power_ *= shingle_base;
+                }
+            }
+
+            void add(std::uint64_t word) noexcept {
+                auto slot = this->words_ % this->size_;
+                this->hash_ = this->hash_ * shingle_base + word;
+                if (this->words_ >= this->size_) {
+                    this->hash_ -= this->window_[slot] * this->power_;
+                }
+                this->window_[slot] = word;
+                if (++this->words_ >= this->size_) {
+                    this->accumulate(mix(this->hash_));
+                }
+            }
+
+            // Texts shorter than a shingle are one shingle.
+            std::uint64_t finish() noexcept {
+                if (this->words_ > 0 && this->words_ < this->size_) {
+                    this->accumulate(mix(this->hash_));
+                }
+                std::uint64_t fingerprint = 0;
+                for (std::size_t bit = 0; bit < 64; ++bit) {
+                    if (2 * this->ones_[bit] > this->shingles_) {
+                        fingerprint |= std::uint64_t{1} << bit;
+                    }
+                }
+                return fingerprint;
+            }
+
+          private:
+            void accumulate(std::uint64_t hash) noexcept {
+                for (std::size_t bit = 0; bit < 64; ++bit) {
+                    this->ones_[bit] += (hash >> bit) & 1;
+                }
+                ++this->shingles_;
+            }
+
+            std::size_t size_;
+            std::uint64_t power_{1};
+            std::uint64_t hash_{};
+            std::size_t words_{};
+            std::array<std::uint64_t, max_shingle_size> window_{};
+            std::array<std::uint32_t, 64> ones_{};
+            std::uint32_t shingles_{};
+        };
+
+        template<typename F>
+        void for_each_word(std::string_view text, F&& f) {
+            std::size_t i = 0;
+            while (i < text.size()) {
+                while (i < text.size() && !is_word_char(text[i])) {
+                    ++i;
+                }
+                auto start = i;
+                while (i < text.size() && is_word_char(text[i])) {
+                    ++i;
+                }
+                if (i > start) {
+                    f(text.substr(start, i - start));
+                }
+            }
+        }
+
+        // Position after the '>' closing the tag starting at from, skipping
+        // quoted attribute values.
+        std::size_t skip_tag(std::string_view html, std::size_t from) noexcept {
+            char quote = 0;
+            for (auto i = from; i < html.size(); ++i) {
+                if (quote != 0) {
+                    quote = html[i] == quote ? 0 : quote;
+                } else if (html[i] == '"' || html[i] == '\'') {
+                    quote = html[i];
+                } else if (html[i] == '>') {
+                    return i + 1;
+                }
+            }
+            return html.size();
+        }
+
+        // Position after the end tag of the raw text element name whose
+        // contents start at from.
+        std::size_t skip_raw_text(
+            std::string_view html, std::size_t from,
+            std::string_view name) noexcept {
+            for (auto i = html.find("</", from); i != std::string_view::npos;
+                 i = html.find("</", i + 2)) {
+                if (starts_with_ignore_case(html.substr(i + 2), name)) {
+                    return skip_tag(html, i + 2);
+                }
+            }
+            return html.size();
+        }
+
+        // Visible words of html, split at markup and character references.
+        template<typename F>
+        void for_each_html_word(std::string_view html, F&& f) {
+            std::size_t text = 0;
+            std::size_t i = 0;
+            auto flush = [&](std::size_t end) {
+                for_each_word(html.substr(text, end - text), f);
+            };
+            while (i < html.size()) {
+                auto c = html[i];
+                if (c == '&') {
+                    auto end = i + 1;
+                    while (end < html.size() && end - i <= 32 &&
+                           (is_word_char(html[end]) || html[end] == '#')) {
+                        ++end;
+                    }
+                    if (end < html.size() && html[end] == ';') {
+                        flush(i);
+                        text = i = end + 1;
+                        continue;
+                    }
+                    ++i;
+                    continue;
+                }
+                if (c != '<' || i + 1 == html.size()) {
+                    ++i;
+                    continue;
+                }
+                auto next = html[i + 1];
+                auto is_tag = [&](std::string_view name) {
+                    auto after = i + 1 + name.size();
+                    return starts_with_ignore_case(html.substr(i + 1), name) &&
+                           (after == html.size() ||
+                            !is_word_char(html[after]));
+                };
+                std::size_t end;
+                if (starts_with_ignore_case(html.substr(i + 1), "!--")) {
+                    auto close = html.find("-->", i + 4);
+                    end = close == std::string_view::npos ? html.size()
+                                                          : close + 3;
+                } else if (is_tag("script")) {
+                    end = skip_raw_text(html, skip_tag(html, i), "script");
+                } else if (is_tag("style")) {
+                    end = skip_raw_text(html, skip_tag(html, i), "style");
+                } else if (
+                    is_word_char(next) || next == '/' || next == '!' ||
+                    next == '?') {
+                    end = skip_tag(html, i);
+                } else {
+                    ++i;
+                    continue;
+                }
+                flush(i);
+                text = i = end;
+            }
+            flush(html.size());
+        }
+    } // namespace
+
+    std::uint64_t
+    simhash(std::string_view text, const SimHashOptions& options) {
+        Shingler shingler{options.shingle_size};
+        for_each_word(text, [&shingler](std::string_view word) {
+            shingler.add(hash_word(word));
+        });
+        return shingler.finish();
+    }
+
+    std::uint64_t simhash(
+        const std::vector<std::string_view>& tokens,
+        const SimHashOptions& options) {
+        Shingler shingler{options.shingle_size};
+        for (auto token : tokens) {
+            shingler.add(hash_word(token));
+        }
+        return shingler.finish();
+    }
+
+    std::uint64_t
+    html_simhash(std::string_view html, const SimHashOptions& options) {
+        Shingler shingler{options.shingle_size};
+        for_each_html_word(html, [&shingler](std::string_view word) {
+            shingler.add(hash_word(word));
+        });
+        return shingler.finish();
+    }
+
+    unsigned hamming_distance(std::uint64_t a, std::uint64_t b) noexcept {
+        return static_cast<unsigned>(std::bitset<64>{a ^ b}.count());
+    }
+
+    NearDuplicateIndex::NearDuplicateIndex(unsigned max_distance)
+        : max_distance_{std::min(max_distance, 15U)},
+          band_bits_{64 / (this->max_distance_ + 1)},
+          bands_(this->max_distance_ + 1) {}
+
+    std::optional<NearDuplicate>
+    NearDuplicateIndex::find(std::uint64_t fingerprint) const {
+        std::lock_guard lock{this->mutex_};
+        return this->find_locked(fingerprint);
+    }
+
+    std::optional<NearDuplicate>
+    NearDuplicateIndex::insert(std::uint64_t fingerprint, std::string url) {
+        auto key = url_fingerprint(url);
+        std::lock_guard lock{this->mutex_};
+        auto known = this->ids_.find(key);
+        std::optional<std::uint32_t> own;
+        if (known != this->ids_.end()) {
+            own = known->second;
+        }
+        if (auto duplicate = this->find_locked(fingerprint, own)) {
+            return duplicate;
+        }
+        if (own) {
+            this->replace(*own, fingerprint, std::move(url));
+            return std::nullopt;
+        }
+        auto id = static_cast<std::uint32_t>(this->fingerprints_.size());
+        this->fingerprints_.push_back(fingerprint);
+        this->urls_.push_back(std::move(url));
+        this->ids_.emplace(std::move(key), id);
+        for (std::size_t i = 0; i < this->bands_.size(); ++i) {
+            this->bands_[i][this->band(fingerprint, i)].push_back(id);
+        }
+        return std::nullopt;
+    }
+
+    std::size_t NearDuplicateIndex::size() const {
+        std::lock_guard lock{this->mutex_};
+        return this->fingerprints_.size();
+    }
+
+    std::optional<NearDuplicate> NearDuplicateIndex::find_locked(
+        std::uint64_t fingerprint, std::optional<std::uint32_t> skip) const {
+        std::optional<std::uint32_t> nearest;
+        auto nearest_distance = this->max_distance_ + 1;
+        for (std::size_t i = 0; i < this->bands_.size(); ++i) {
+            auto found = this->bands_[i].find(this->band(fingerprint, i));
+            if (found == this->bands_[i].end()) {
+                continue;
+            }
+            for (auto id : found->second) {
+                if (id == skip) {
+                    continue;
+                }
+                auto distance =
+                    hamming_distance(fingerprint, this->fingerprints_[id]);
+                if (distance < nearest_distance) {
+                    nearest = id;
+                    nearest_distance = distance;
+                }
+            }
+            if (nearest_distance == 0) {
+                break;
+            }
+        }
+        if (!nearest) {
+            return std::nullopt;
+        }
+        return NearDuplicate{
+            this->urls_[*nearest], this->fingerprints_[*nearest],
+            nearest_distance};
+    }
+
+    void NearDuplicateIndex::replace(
+        std::uint32_t id, std::uint64_t fingerprint, std::string url) {
+        auto previous = this->fingerprints_[id];
+        this->urls_[id] = std::move(url);
+        if (previous == fingerprint) {
+            return;
+        }
+        for (std::size_t i = 0; i < this->bands_.size(); ++i) {
+            auto& band = this->bands_[i];
+            auto found = band.find(this->band(previous, i));
+            auto& ids = found->second;
+            ids.erase(std::find(ids.begin(), ids.end(), id));
+            if (ids.empty()) {
+                band.erase(found);
+            }
+            band[this->band(fingerprint, i)].push_back(id);
+        }
+        this->fingerprints_[id] = fingerprint;
+    }
+
+    std::uint64_t NearDuplicateIndex::band(
+        std::uint64_t fingerprint, std::size_t index) const noexcept {
+        auto shift = index * this->band_bits_;
+        // The last band takes the bits left over.
+        auto bits = index + 1 == this->bands_.size() ? 64 - shift
+                                                     : this->band_bits_;
+        auto mask = bits == 64 ? ~std::uint64_t{0}
+                               : (std::uint64_t{1} << bits) - 1;
+        return (fingerprint >> shift) & mask;
+    }
+
+    DuplicateFilter::DuplicateFilter(DuplicateFilterOptions options)
+        : options_{options}, index_{options.max_distance} {}
+
+    std::optional<NearDuplicate>
+    DuplicateFilter::check(const Response& response) {
+        return this->check(
+            response.url.str(),
+            html_simhash(response.text, this->options_.simhash));
+    }
+
+    std::optional<NearDuplicate>
+    DuplicateFilter::check(std::string_view url, std::uint64_t fingerprint) {
+        auto duplicate = this->index_.insert(fingerprint, std::string{url});
+        auto pattern = url_pattern(url);
+        std::lock_guard lock{this->mutex_};
+        auto& stats = this->patterns_[std::move(pattern)];
+        ++stats.pages;
+        ++this->stats_.pages;
+        if (duplicate) {
+            ++stats.duplicates;
+            ++this->stats_.duplicates;
+        }
+        return duplicate;
+    }
+
+    bool DuplicateFilter::skip(std::string_view url) {
+        if (this->options_.skip_duplicate_ratio > 1) {
+            return false;
+        }
+        auto pattern = url_pattern(url);
+        std::lock_guard lock{this->mutex_};
+        auto found = this->patterns_.find(pattern);
+        if (found == this->patterns_.end() ||
+            found->second.pages < this->options_.min_pattern_pages ||
+            static_cast<double>(found->second.duplicates) <
+                this->options_.skip_duplicate_ratio *
+                    static_cast<double>(found->second.pages)) {
+            return false;
+        }
+        ++this->stats_.skipped_requests;
+        return true;
+    }
+
+    double DuplicateFilter::duplicate_ratio(std::string_view url) const {
+        auto pattern = url_pattern(url);
+        std::lock_guard lock{this->mutex_};
+        auto found = this->patterns_.find(pattern);
+        if (found == this->patterns_.end() || found->second.pages == 0) {
+            return 0;
+        }
+        return static_cast<double>(found->second.duplicates) /
+               static_cast<double>(found->second.pages);
+    }
+
+    DuplicateFilterStats DuplicateFilter::stats() const {
+        std::lock_guard lock{this->mutex_};
+        return this->stats_;
+    }
+} // namespace Scrapp
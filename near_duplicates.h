@@ -0,0 +1,159 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_NEAR_DUPLICATES_H
+#define SCRAPP_NEAR_DUPLICATES_H
+
+#include "response.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Scrapp {
+    struct SimHashOptions {
+        // Consecutive words hashed together, 1 to 16. Longer shingles tell
+        // apart pages that share vocabulary but not sentences.
+        std::size_t shingle_size{3};
+    };
+
+    // 64-bit SimHash of the words of text, ASCII case-insensitive. Texts
+    // differing in a few words differ in a few bits.
+    std::uint64_t
+    simhash(std::string_view text, const SimHashOptions& options = {});
+    // SimHash of already extracted tokens.
+    std::uint64_t simhash(
+        const std::vector<std::string_view>& tokens,
+        const SimHashOptions& options = {});
+    // SimHash of the words of html outside of tags, comments, script and
+    // style elements and character references, without building a DOM.
+    std::uint64_t
+    html_simhash(std::string_view html, const SimHashOptions& options = {});
+
+    // Number of bits a and b differ in.
+    unsigned hamming_distance(std::uint64_t a, std::uint64_t b) noexcept;
+
+    struct NearDuplicate {
+        std::string url;
+        std::uint64_t fingerprint{};
+        unsigned distance{};
+    };
+
+    // SimHash fingerprints searchable by Hamming distance. Fingerprints are
+    // split into max_distance + 1 bands: two fingerprints within
+    // max_distance bits agree on at least one band, so only the fingerprints
+    // sharing a band are compared. Thread safe.
+    class NearDuplicateIndex {
+      public:
+        // max_distance is clamped to 0 to 15.
+        explicit NearDuplicateIndex(unsigned max_distance = 3);
+
+        // The nearest indexed fingerprint within max_distance.
+        [[nodiscard]] std::optional<NearDuplicate>
+        find(std::uint64_t fingerprint) const;
+        // Indexes fingerprint unless it has a near duplicate, which is
+        // returned instead. An earlier fingerprint of the same URL (see
+        // url_fingerprint) is not a duplicate but replaced, so revisited
+        // pages do not match their own previous versions.
+        std::optional<NearDuplicate>
+        insert(std::uint64_t fingerprint, std::string url);
+        [[nodiscard]] std::size_t size() const;
+
+      private:
+        // Ignores the fingerprint indexed as skip.
+        std::optional<NearDuplicate> find_locked(
+            std::uint64_t fingerprint,
+            std::optional<std::uint32_t> skip = std::nullopt) const;
+        void replace(
+            std::uint32_t id, std::uint64_t fingerprint, std::string url);
+        [[nodiscard]] std::uint64_t
+        band(std::uint64_t fingerprint, std::size_t index) const noexcept;
+
+        unsigned max_distance_;
+        std::size_t band_bits_;
+        std::vector<std::uint64_t> fingerprints_;
+        std::vector<std::string> urls_;
+        // By url_fingerprint of the URLs.
+        std::unordered_map<std::string, std::uint32_t> ids_;
+        // Per band, the fingerprints with each value of the band.
+        using Band =
+            std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>;
+        std::vector<Band> bands_;
+        mutable std::mutex mutex_;
+    };
+
+    struct DuplicateFilterOptions {
+        // See NearDuplicateIndex.
+        unsigned max_distance{3};
+        SimHashOptions simhash{};
+        // Requests to a URL pattern (see url_pattern) are skipped once at
+        // least min_pattern_pages of its pages were checked and this share
+        // of them were duplicates. Above 1 nothing is skipped.
+        double skip_duplicate_ratio{0.9};
+        std::size_t min_pattern_pages{20};
+    };
+
+    struct DuplicateFilterStats {
+        std::size_t pages{};
+        std::size_t duplicates{};
+        std::size_t skipped_requests{};
+    };
+
+    // Drops pages whose visible text nearly duplicates an earlier page, and
+    // requests to URL patterns that keep producing duplicates, such as
+    // session ids, tracking parameters or print views. Thread safe.
+    class DuplicateFilter {
+      public:
+        explicit DuplicateFilter(DuplicateFilterOptions options = {});
+
+        // Fingerprints the response body and indexes it unless it nearly
+        // duplicates an earlier page, which is returned instead. Earlier
+        // visits of the same URL do not count, so recrawled pages pass.
+        std::optional<NearDuplicate> check(const Response& response);
+        std::optional<NearDuplicate>
+        check(std::string_view url, std::uint64_t fingerprint);
+        // Whether url's pattern produces duplicates too often to be worth
+        // fetching. Counts the request as skipped when it does.
+        bool skip(std::string_view url);
+        // Share of the checked pages of url's pattern that were duplicates.
+        [[nodiscard]] double duplicate_ratio(std::string_view url) const;
+        [[nodiscard]] DuplicateFilterStats stats() const;
+
+      private:
+        struct PatternStats {
+            std::size_t pages{};
+            std::size_t duplicates{};
+        };
+
+        DuplicateFilterOptions options_;
+        NearDuplicateIndex index_;
+        std::unordered_map<std::string, PatternStats> patterns_;
+        DuplicateFilterStats stats_;
+        mutable std::mutex mutex_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_NEAR_DUPLICATES_H
@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_OUTPUT_FILE_H
+#define SCRAPP_OUTPUT_FILE_H
+
+#include <cerrno>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace Scrapp {
+    // File opened for writing, for outputs that do their own buffering and
+    // hand over large chunks. Errors are thrown as Exception, naming the
+    // path and the reason.
+    template<typename Exception> class OutputFile {
+      public:
+        OutputFile() = default;
+        OutputFile(const OutputFile&) = delete;
+        OutputFile& operator=(const OutputFile&) = delete;
+        // Closes without syncing, errors are lost.
+        ~OutputFile() {
+            if (this->fd_ != -1) {
+                ::close(this->fd_);
+            }
+        }
+
+        // Creates or truncates path. The file must be closed.
+        void open(std::string path) {
+            this->fd_ = ::open(
+                path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            this->path_ = std::move(path);
+            if (this->fd_ == -1) {
+                this->fail("open");
+            }
+        }
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return this->fd_ != -1;
+        }
+
+        // Writes all of data, retrying short and interrupted writes.
+        void write(std::string_view data) {
+            while (!data.empty()) {
+                auto written = ::write(this->fd_, data.data(), data.size());
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    this->fail("write");
+                }
+                data.remove_prefix(static_cast<std::size_t>(written));
+            }
+        }
+
+        void sync() {
+            if (::fsync(this->fd_) != 0) {
+                this->fail("sync");
+            }
+        }
+
+        // Syncs first if sync is set. The file is closed even if that
+        // fails.
+        void close(bool sync) {
+            auto fd = std::exchange(this->fd_, -1);
+            auto synced = !sync || ::fsync(fd) == 0;
+            auto closed = ::close(fd) == 0;
+            if (!synced || !closed) {
+                this->fail(synced ? "close" : "sync");
+            }
+        }
+
+      private:
+        [[noreturn]] void fail(std::string_view action) const {
+            auto error = errno;
+            throw Exception(
+                "cannot " + std::string{action} + " " + this->path_ + ": " +
+                std::system_category().message(error));
+        }
+
+        std::string path_;
+        int fd_{-1};
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_OUTPUT_FILE_H
@@ -0,0 +1,177 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pipeline.h"
+#include "exceptions.h"
+#include <algorithm>
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        // Threads get consecutive slots so that up to buffers() emitting
+        // threads never share a buffer.
+        std::size_t thread_slot() noexcept {
+            static std::atomic<std::size_t> next{0};
+            thread_local const std::size_t slot =
+                next.fetch_add(1, std::memory_order_relaxed);
+            return slot;
+        }
+    } // namespace
+
+    ItemPipeline::ItemPipeline(PipelineOptions options)
+        : options_{options},
+          writer_{
+              options.max_pending_batches,
+              options.flush_interval,
+              {[this](std::deque<std::vector<Item>>& batches) {
+                   for (const auto& batch : batches) {
+                       this->write(batch);
+                   }
+               },
+               [this](bool closing) { this->flush_sinks(closing); }}} {
+        this->options_.batch_size = std::max<std::size_t>(
+            1, this->options_.batch_size);
+        auto count = this->options_.buffers;
+        if (count == 0) {
+            count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        this->buffers_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            this->buffers_.push_back(std::make_unique<Buffer>());
+        }
+    }
+
+    ItemPipeline::~ItemPipeline() {
+        try {
+            this->close();
+        } catch (...) {
+            // Errors are lost here, callers that care call close().
+        }
+    }
+
+    void ItemPipeline::add_stage(ItemStage stage) {
+        this->stages_.push_back(std::move(stage));
+    }
+
+    void ItemPipeline::add_sink(std::unique_ptr<ItemSink> sink) {
+        this->sinks_.push_back(std::move(sink));
+    }
+
+    void ItemPipeline::emit(Item item) {
+        if (this->closed_) {
+            throw item_pipeline_exception("item pipeline is closed");
+        }
+        if (this->writer_.failed()) {
+            this->writer_.rethrow_error();
+        }
+        for (const auto& stage : this->stages_) {
+            if (!stage(item)) {
+                this->dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        this->emitted_.fetch_add(1, std::memory_order_relaxed);
+
+        auto& buffer = this->buffer();
+        std::vector<Item> batch;
+        {
+            std::lock_guard<std::mutex> lock{buffer.mutex};
+            buffer.items.push_back(std::move(item));
+            if (buffer.items.size() < this->options_.batch_size) {
+                return;
+            }
+            batch.swap(buffer.items);
+            buffer.items.reserve(this->options_.batch_size);
+        }
+        this->submit(std::move(batch));
+    }
+
+    void ItemPipeline::flush() {
+        if (this->closed_) {
+            this->writer_.rethrow_error();
+            return;
+        }
+        this->drain();
+        this->writer_.flush();
+    }
+
+    void ItemPipeline::close() {
+        if (this->closed_.exchange(true)) {
+            return;
+        }
+        try {
+            this->drain();
+        } catch (...) {
+            // A failed sink, rethrown by the writer.
+        }
+        this->writer_.close();
+    }
+
+    PipelineStats ItemPipeline::stats() const noexcept {
+        return {
+            this->emitted_.load(std::memory_order_relaxed),
+            this->dropped_.load(std::memory_order_relaxed),
+            this->written_.load(std::memory_order_relaxed),
+            this->batches_.load(std::memory_order_relaxed)};
+    }
+
+    ItemPipeline::Buffer& ItemPipeline::buffer() noexcept {
+        return *this->buffers_[thread_slot() % this->buffers_.size()];
+    }
+
+    void ItemPipeline::drain() {
+        for (auto& buffer : this->buffers_) {
+            std::vector<Item> batch;
+            {
+                std::lock_guard<std::mutex> lock{buffer->mutex};
+                batch.swap(buffer->items);
+            }
+            if (!batch.empty()) {
+                this->submit(std::move(batch));
+            }
+        }
+    }
+
+    void ItemPipeline::submit(std::vector<Item> batch) {
+        if (!this->writer_.push(std::move(batch))) {
+            throw item_pipeline_exception("item pipeline is closed");
+        }
+    }
+
+    void ItemPipeline::write(const std::vector<Item>& batch) {
+        for (auto& sink : this->sinks_) {
+            sink->write(batch);
+        }
+        this->written_.fetch_add(batch.size(), std::memory_order_relaxed);
+        this->batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ItemPipeline::flush_sinks(bool closing) {
+        for (auto& sink : this->sinks_) {
+            if (closing) {
+                sink->close();
+            } else {
+                sink->flush();
+            }
+        }
+    }
+} // namespace Scrapp
@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_PIPELINE_H
+#define SCRAPP_PIPELINE_H
+
+#include "background_writer.h"
+#include <atomic>
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Scrapp {
+    // Items are JSON objects, like the bodies Response::json parses.
+    using Item = boost::json::object;
+
+    // Output stage of an ItemPipeline. Sinks are only called from the
+    // pipeline's writer thread, one call at a time.
+    class ItemSink {
+      public:
+        virtual ~ItemSink() = default;
+
+        virtual void write(const std::vector<Item>& items) = 0;
+        // Hands buffered output over, called when the pipeline is flushed
+        // and periodically while it is idle.
+        virtual void flush() = 0;
+        // Called once when the pipeline is closed, after the last write.
+        virtual void close() { this->flush(); }
+    };
+
+    // Runs on the emitting thread before the item is buffered. Returning
+    // false drops the item.
+    using ItemStage = std::function<bool(Item&)>;
+
+    struct PipelineOptions {
+        // Items buffered per emitting thread before they go to the writer.
+        std::size_t batch_size{512};
+        // Batches waiting for the writer before emit() blocks.
+        std::size_t max_pending_batches{64};
+        // How often an idle writer flushes the sinks, 0 leaves it to
+        // flush() and close().
+        std::chrono::milliseconds flush_interval{1000};
+        // Buffers the emitting threads are spread over, 0 for one per
+        // hardware thread.
+        std::size_t buffers{0};
+    };
+
+    struct PipelineStats {
+        std::size_t emitted{};
+        std::size_t dropped{};
+        std::size_t written{};
+        std::size_t batches{};
+    };
+
+    // Moves items emitted from any number of threads through the stages
+    // and hands them in batches to the sinks on a dedicated writer thread,
+    // so emitting threads only contend on their own buffer.
+    class ItemPipeline {
+      public:
+        explicit ItemPipeline(PipelineOptions options = {});
+        ItemPipeline(const ItemPipeline&) = delete;
+        ItemPipeline& operator=(const ItemPipeline&) = delete;
+        // Closes the pipeline, errors of the sinks are lost.
+        ~ItemPipeline();
+
+        // Stages and sinks must be added before the first item is emitted.
+        void add_stage(ItemStage stage);
+        void add_sink(std::unique_ptr<ItemSink> sink);
+
+        // Thread safe. Blocks while the writer is max_pending_batches
+        // behind. Throws the first error of a sink, or
+        // item_pipeline_exception once the pipeline is closed.
+        void emit(Item item);
+        // Writes every item emitted so far and flushes the sinks. Throws the
+        // first error of a sink.
+        void flush();
+        // Flushes, closes the sinks and stops the writer thread. Throws the
+        // first error of a sink.
+        void close();
+
+        [[nodiscard]] PipelineStats stats() const noexcept;
+
+      private:
+        struct alignas(64) Buffer {
+            std::mutex mutex;
+            std::vector<Item> items;
+        };
+
+        Buffer& buffer() noexcept;
+        void drain();
+        void submit(std::vector<Item> batch);
+        void write(const std::vector<Item>& batch);
+        void flush_sinks(bool closing);
+
+        PipelineOptions options_;
+        std::vector<ItemStage> stages_;
+        std::vector<std::unique_ptr<ItemSink>> sinks_;
+        std::vector<std::unique_ptr<Buffer>> buffers_;
+        std::atomic<bool> closed_{false};
+
+        std::atomic<std::size_t> emitted_{0};
+        std::atomic<std::size_t> dropped_{0};
+        std::atomic<std::size_t> written_{0};
+        std::atomic<std::size_t> batches_{0};
+
+        // Last, its thread uses the sinks until it is joined.
+        BackgroundWriter<std::vector<Item>> writer_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_PIPELINE_H
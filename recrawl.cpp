@@ -0,0 +1,368 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "recrawl.h"
+#include "exceptions.h"
+#include "utils.h"
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+
+namespace Scrapp {
+    namespace {
+        constexpr char table_magic[8] = {
+            'S', 'C', 'R', 'A', 'P', 'P', 'R', 'C'};
+        constexpr std::uint32_t table_version = 1;
+
+        using Clock = std::chrono::system_clock;
+
+        std::int64_t to_seconds(Clock::time_point time) noexcept {
+            return std::chrono::duration_cast<std::chrono::seconds>(
+                       time.time_since_epoch())
+                .count();
+        }
+
+        Clock::time_point from_seconds(std::int64_t seconds) noexcept {
+            return Clock::time_point{std::chrono::seconds{seconds}};
+        }
+
+        template<typename T>
+        void put(std::string& buffer, T value) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            buffer.append(bytes, sizeof(T));
+        }
+
+        // Reads the table, in native byte order, with bounds checks.
+        class TableReader {
+          public:
+            TableReader(std::string_view data, const std::string& path)
+                : data_{data}, path_{path} {}
+
+            template<typename T>
+            T get() {
+                T value;
+                std::memcpy(&value, this->take(sizeof(T)).data(), sizeof(T));
+                return value;
+            }
+
+            std::string_view take(std::size_t size) {
+                if (this->data_.size() < size) {
+                    throw recrawl_exception(
+                        "truncated recrawl table " + this->path_);
+                }
+                auto bytes = this->data_.substr(0, size);
+                this->data_.remove_prefix(size);
+                return bytes;
+            }
+
+          private:
+            std::string_view data_;
+            const std::string& path_;
+        };
+
+        // RFC 7231 IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT".
+        std::string http_date(Clock::time_point time) {
+            auto seconds = Clock::to_time_t(time);
+            std::tm parts{};
+            gmtime_r(&seconds, &parts);
+            char date[32];
+            std::strftime(
+                date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &parts);
+            return date;
+        }
+
+        std::optional<Clock::time_point>
+        parse_http_date(std::string_view text) {
+            static constexpr std::string_view months[] = {
+                "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+            std::string date{text};
+            std::tm parts{};
+            char month[4] = {};
+            if (std::sscanf(
+                    date.c_str(), "%*3s, %2d %3s %4d %2d:%2d:%2d",
+                    &parts.tm_mday, month, &parts.tm_year, &parts.tm_hour,
+                    &parts.tm_min, &parts.tm_sec) != 6) {
+                return std::nullopt;
+            }
+            auto found = std::find(std::begin(months), std::end(months), month);
+            if (found == std::end(months)) {
+                return std::nullopt;
+            }
+            parts.tm_mon = static_cast<int>(found - std::begin(months));
+            parts.tm_year -= 1900;
+            return Clock::from_time_t(timegm(&parts));
+        }
+
+        std::optional<std::string_view>
+        find_header(const Headers& headers, std::string_view name) {
+            for (const auto& [key, value] : headers) {
+                if (boost::algorithm::iequals(key, name)) {
+                    return std::string_view{value};
+                }
+            }
+            return std::nullopt;
+        }
+    } // namespace
+
+    RecrawlScheduler::RecrawlScheduler(RecrawlOptions options)
+        : options_{std::move(options)} {
+        this->options_.revisit_probability =
+            std::clamp(this->options_.revisit_probability, 0.01, 0.99);
+        if (!this->options_.path.empty()) {
+            this->load();
+        }
+    }
+
+    bool RecrawlScheduler::observe(
+        const Response& response, Clock::time_point now) {
+        auto url = response.url.str();
+        Clock::time_point last_modified;
+        if (auto header = find_header(response.headers, "Last-Modified")) {
+            last_modified = parse_http_date(*header).value_or(last_modified);
+        }
+        if (response.status_code == 304) {
+            std::lock_guard lock{this->mutex_};
+            auto found = this->pages_.find(url_fingerprint(url));
+            if (found != this->pages_.end()) {
+                auto& history = found->second.history;
+                history.last_visit = now;
+                ++history.visits;
+                found->second.pending_until = {};
+                this->schedule(found->second);
+                return false;
+            }
+        }
+        return this->observe(
+            url, html_simhash(response.text, this->options_.simhash), now,
+            last_modified);
+    }
+
+    bool RecrawlScheduler::observe(
+        std::string_view url, std::uint64_t fingerprint, Clock::time_point now,
+        Clock::time_point last_modified) {
+        auto key = url_fingerprint(url);
+        std::lock_guard lock{this->mutex_};
+        auto [found, added] = this->pages_.try_emplace(std::move(key));
+        auto& page = found->second;
+        auto& history = page.history;
+        auto changed = false;
+        if (added) {
+            history.url = std::string{url};
+            history.first_visit = now;
+        } else {
+            changed = hamming_distance(history.fingerprint, fingerprint) >
+                      this->options_.change_distance;
+            history.changes += changed;
+        }
+        history.fingerprint = fingerprint;
+        history.last_visit = now;
+        history.last_modified = last_modified;
+        ++history.visits;
+        page.pending_until = {};
+        this->schedule(page);
+        return changed;
+    }
+
+    double RecrawlScheduler::change_rate(std::string_view url) const {
+        std::lock_guard lock{this->mutex_};
+        auto found = this->pages_.find(url_fingerprint(url));
+        return found == this->pages_.end() ? 0
+                                           : this->rate(found->second.history);
+    }
+
+    Clock::time_point
+    RecrawlScheduler::next_visit(std::string_view url) const {
+        std::lock_guard lock{this->mutex_};
+        auto found = this->pages_.find(url_fingerprint(url));
+        return found == this->pages_.end() ? Clock::time_point{}
+                                           : found->second.next_visit;
+    }
+
+    std::optional<PageHistory>
+    RecrawlScheduler::history(std::string_view url) const {
+        std::lock_guard lock{this->mutex_};
+        auto found = this->pages_.find(url_fingerprint(url));
+        if (found == this->pages_.end()) {
+            return std::nullopt;
+        }
+        return found->second.history;
+    }
+
+    std::vector<Request>
+    RecrawlScheduler::due(Clock::time_point now, std::size_t limit) {
+        std::lock_guard lock{this->mutex_};
+        std::vector<std::pair<double, Page*>> due;
+        for (auto& [key, page] : this->pages_) {
+            if (page.next_visit <= now && page.pending_until <= now) {
+                auto elapsed = std::chrono::duration<double>(
+                                   now - page.history.last_visit)
+                                   .count();
+                auto changed =
+                    1 - std::exp(-this->rate(page.history) * elapsed);
+                due.emplace_back(changed, &page);
+            }
+        }
+        auto count = std::min(limit, due.size());
+        std::partial_sort(
+            due.begin(), due.begin() + static_cast<std::ptrdiff_t>(count),
+            due.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        std::vector<Request> requests;
+        requests.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto& page = *due[i].second;
+            page.pending_until = now + this->options_.min_interval;
+            Request request{Url{page.history.url}};
+            if (page.history.last_modified != Clock::time_point{}) {
+                request.add_header(
+                    {"If-Modified-Since",
+                     http_date(page.history.last_modified)});
+            }
+            requests.push_back(std::move(request));
+        }
+        return requests;
+    }
+
+    std::size_t RecrawlScheduler::size() const {
+        std::lock_guard lock{this->mutex_};
+        return this->pages_.size();
+    }
+
+    void RecrawlScheduler::save() const {
+        if (this->options_.path.empty()) {
+            return;
+        }
+        std::string table;
+        {
+            std::lock_guard lock{this->mutex_};
+            table.append(table_magic, sizeof(table_magic));
+            put(table, table_version);
+            put(table, static_cast<std::uint64_t>(this->pages_.size()));
+            for (const auto& [key, page] : this->pages_) {
+                const auto& history = page.history;
+                put(table, static_cast<std::uint32_t>(history.url.size()));
+                table += history.url;
+                put(table, history.fingerprint);
+                put(table, to_seconds(history.first_visit));
+                put(table, to_seconds(history.last_visit));
+                put(table, to_seconds(history.last_modified));
+                put(table, history.visits);
+                put(table, history.changes);
+            }
+        }
+
+        auto temporary = this->options_.path + ".tmp";
+        {
+            std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+            file.write(
+                table.data(), static_cast<std::streamsize>(table.size()));
+            if (!file.flush()) {
+                throw recrawl_exception("cannot write " + temporary);
+            }
+        }
+        if (std::rename(temporary.c_str(), this->options_.path.c_str()) != 0) {
+            throw recrawl_exception(
+                "cannot replace " + this->options_.path + ": " +
+                std::system_category().message(errno));
+        }
+    }
+
+    void RecrawlScheduler::load() {
+        std::ifstream file{this->options_.path, std::ios::binary};
+        if (!file) {
+            // Nothing was saved yet.
+            return;
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        auto data = content.str();
+        TableReader reader{data, this->options_.path};
+        if (reader.take(sizeof(table_magic)) !=
+                std::string_view{table_magic, sizeof(table_magic)} ||
+            reader.get<std::uint32_t>() != table_version) {
+            throw recrawl_exception(
+                this->options_.path + " is not a recrawl table");
+        }
+        auto count = reader.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            Page page;
+            auto& history = page.history;
+            auto url_size = reader.get<std::uint32_t>();
+            history.url = std::string{reader.take(url_size)};
+            history.fingerprint = reader.get<std::uint64_t>();
+            history.first_visit = from_seconds(reader.get<std::int64_t>());
+            history.last_visit = from_seconds(reader.get<std::int64_t>());
+            history.last_modified = from_seconds(reader.get<std::int64_t>());
+            history.visits = reader.get<std::uint32_t>();
+            history.changes = reader.get<std::uint32_t>();
+            this->schedule(page);
+            this->pages_[url_fingerprint(history.url)] = std::move(page);
+        }
+    }
+
+    double RecrawlScheduler::rate(const PageHistory& history) const noexcept {
+        auto probability = this->options_.revisit_probability;
+        auto observed = std::chrono::duration<double>(
+                            history.last_visit - history.first_visit)
+                            .count();
+        if (history.visits < 2 || observed <= 0) {
+            // The rate at which the page is due after initial_interval.
+            auto initial =
+                static_cast<double>(this->options_.initial_interval.count());
+            return -std::log(1 - probability) / initial;
+        }
+        auto intervals = static_cast<double>(history.visits - 1);
+        auto changes =
+            std::min(static_cast<double>(history.changes), intervals);
+        // Changes per visit interval, corrected for changes missed between
+        // visits, over the mean interval.
+        return -std::log((intervals - changes + 0.5) / (intervals + 0.5)) *
+               intervals / observed;
+    }
+
+    void RecrawlScheduler::schedule(Page& page) const noexcept {
+        auto rate = this->rate(page.history);
+        auto max = static_cast<double>(this->options_.max_interval.count());
+        auto interval =
+            rate > 0
+                ? -std::log(1 - this->options_.revisit_probability) / rate
+                : max;
+        interval = std::clamp(
+            interval,
+            static_cast<double>(this->options_.min_interval.count()), max);
+        page.next_visit =
+            page.history.last_visit +
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(interval));
+    }
+} // namespace Scrapp
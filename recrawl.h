@@ -0,0 +1,135 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_RECRAWL_H
+#define SCRAPP_RECRAWL_H
+
+#include "near_duplicates.h"
+#include "request.h"
+#include "response.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Scrapp {
+    struct RecrawlOptions {
+        // Table the page histories are loaded from and saved to, in memory
+        // only if empty.
+        std::string path{};
+        std::chrono::seconds min_interval{std::chrono::hours{1}};
+        std::chrono::seconds max_interval{std::chrono::hours{24 * 30}};
+        // Interval after the first visit, before any change was observed.
+        std::chrono::seconds initial_interval{std::chrono::hours{24}};
+        // A page is revisited once it has changed with this probability.
+        // Lower values keep pages fresher with more requests.
+        double revisit_probability{0.5};
+        // Pages whose fingerprints differ in more bits changed, so dates or
+        // counters in footers do not count. See html_simhash.
+        unsigned change_distance{3};
+        SimHashOptions simhash{};
+    };
+
+    struct PageHistory {
+        std::string url;
+        std::uint64_t fingerprint{};
+        std::chrono::system_clock::time_point first_visit;
+        std::chrono::system_clock::time_point last_visit;
+        // From the Last-Modified header, the epoch if the server sent none.
+        std::chrono::system_clock::time_point last_modified;
+        std::uint32_t visits{};
+        std::uint32_t changes{};
+    };
+
+    // Schedules revisits of crawled pages by how often they change. Every
+    // visit is compared with the previous one, and each page's changes are
+    // modeled as a Poisson process whose rate is estimated from its
+    // history (Cho and Garcia-Molina's estimator for regular visits, which
+    // stays unbiased when changes are missed between visits). A page is
+    // due once it has changed with revisit_probability, within
+    // min_interval and max_interval, so pages that never change are
+    // rarely refetched. Thread safe.
+    class RecrawlScheduler {
+      public:
+        // Loads the table at options.path if it exists. Throws
+        // recrawl_exception if it cannot be read.
+        explicit RecrawlScheduler(RecrawlOptions options = {});
+
+        // Records a visit to the response's URL. 304 Not Modified responses
+        // are visits without changes. Returns whether the page changed
+        // since the previous visit, false on the first one.
+        bool observe(
+            const Response& response,
+            std::chrono::system_clock::time_point now =
+                std::chrono::system_clock::now());
+        bool observe(
+            std::string_view url, std::uint64_t fingerprint,
+            std::chrono::system_clock::time_point now,
+            std::chrono::system_clock::time_point last_modified = {});
+
+        // Estimated changes per second, 0 for unknown pages.
+        [[nodiscard]] double change_rate(std::string_view url) const;
+        // When url is due, the epoch for unknown pages.
+        [[nodiscard]] std::chrono::system_clock::time_point
+        next_visit(std::string_view url) const;
+        [[nodiscard]] std::optional<PageHistory>
+        history(std::string_view url) const;
+
+        // Up to limit pages due by now, the most likely to have changed
+        // first, as conditional GET requests. They are not due again until
+        // observed or min_interval passes.
+        std::vector<Request> due(
+            std::chrono::system_clock::time_point now =
+                std::chrono::system_clock::now(),
+            std::size_t limit = std::numeric_limits<std::size_t>::max());
+
+        [[nodiscard]] std::size_t size() const;
+        // Atomically replaces the table at options.path. Throws
+        // recrawl_exception.
+        void save() const;
+
+      private:
+        struct Page {
+            PageHistory history;
+            std::chrono::system_clock::time_point next_visit;
+            // When a request handed out by due() is given up on.
+            std::chrono::system_clock::time_point pending_until;
+        };
+
+        void load();
+        [[nodiscard]] double rate(const PageHistory& history) const noexcept;
+        void schedule(Page& page) const noexcept;
+
+        RecrawlOptions options_;
+        // By url_fingerprint.
+        std::unordered_map<std::string, Page> pages_;
+        mutable std::mutex mutex_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_RECRAWL_H
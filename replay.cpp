@@ -0,0 +1,507 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "replay.h"
+#include "exceptions.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <zlib.h>
+#ifdef SCRAPP_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Scrapp {
+    namespace {
+        // Enough for the header of any record.
+        constexpr std::size_t header_limit = 64 * 1024;
+
+        struct RecordHeader {
+            std::string_view type;
+            std::string_view record_id;
+            std::string_view target_uri;
+            std::string_view date;
+            std::string_view concurrent_to;
+            std::uint64_t content_length{};
+            // Up to the empty line ending the header.
+            std::size_t size{};
+        };
+
+        std::optional<RecordHeader> parse_header(std::string_view record) {
+            auto end = record.find("\r\n\r\n");
+            if (end == std::string_view::npos ||
+                record.substr(0, 5) != "WARC/") {
+                return std::nullopt;
+            }
+            RecordHeader header;
+            header.size = end + 4;
+            auto lines = record.substr(0, end);
+            bool has_length = false;
+            while (!lines.empty()) {
+                auto line_end = lines.find("\r\n");
+                auto line = lines.substr(0, line_end);
+                lines = line_end == std::string_view::npos
+                            ? std::string_view{}
+                            : lines.substr(line_end + 2);
+                auto colon = line.find(':');
+                if (colon == std::string_view::npos) {
+                    continue;
+                }
+                auto name = line.substr(0, colon);
+                auto value = trim(line.substr(colon + 1));
+                if (equals_ignore_case(name, "WARC-Type")) {
+                    header.type = value;
+                } else if (equals_ignore_case(name, "WARC-Record-ID")) {
+                    header.record_id = value;
+                } else if (equals_ignore_case(name, "WARC-Target-URI")) {
+                    header.target_uri = value;
+                } else if (equals_ignore_case(name, "WARC-Date")) {
+                    header.date = value;
+                } else if (equals_ignore_case(name, "WARC-Concurrent-To")) {
+                    header.concurrent_to = value;
+                } else if (equals_ignore_case(name, "Content-Length")) {
+                    std::string digits{value};
+                    char* digits_end = nullptr;
+                    header.content_length =
+                        std::strtoull(digits.c_str(), &digits_end, 10);
+                    has_length = !digits.empty() && *digits_end == '\0';
+                }
+            }
+            if (!has_length) {
+                return std::nullopt;
+            }
+            return header;
+        }
+
+        // 2000-01-01T00:00:00Z, with optional fractions of a second.
+        std::chrono::system_clock::time_point
+        parse_date(std::string_view date) {
+            std::string text{date};
+            std::tm time{};
+            int consumed = 0;
+            if (std::sscanf(
+                    text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%n", &time.tm_year,
+                    &time.tm_mon, &time.tm_mday, &time.tm_hour, &time.tm_min,
+                    &time.tm_sec, &consumed) != 6) {
+                return {};
+            }
+            time.tm_year -= 1900;
+            time.tm_mon -= 1;
+            auto point =
+                std::chrono::system_clock::from_time_t(timegm(&time));
+            std::chrono::microseconds fraction{0};
+            if (text[static_cast<std::size_t>(consumed)] == '.') {
+                auto scale = 100000;
+                for (auto i = static_cast<std::size_t>(consumed) + 1;
+                     i < text.size() && scale > 0 && text[i] >= '0' &&
+                     text[i] <= '9';
+                     ++i, scale /= 10) {
+                    fraction +=
+                        std::chrono::microseconds{(text[i] - '0') * scale};
+                }
+            }
+            return point + std::chrono::duration_cast<
+                               std::chrono::system_clock::duration>(fraction);
+        }
+
+        // Inflates the gzip member at the start of data, appending at most
+        // keep bytes of it to out. Returns the size of the member.
+        std::size_t gunzip(
+            std::string_view data, std::string& out, std::size_t keep,
+            const std::string& path) {
+            struct Inflater {
+                z_stream stream{};
+                bool ready{false};
+
+                ~Inflater() {
+                    if (this->ready) {
+                        inflateEnd(&this->stream);
+                    }
+                }
+            };
+            thread_local Inflater inflater;
+            if (!inflater.ready) {
+                if (inflateInit2(&inflater.stream, 15 + 16) != Z_OK) {
+                    throw warc_exception("cannot initialize zlib");
+                }
+                inflater.ready = true;
+            } else {
+                inflateReset(&inflater.stream);
+            }
+
+            auto& stream = inflater.stream;
+            std::size_t consumed = 0;
+            char chunk[64 * 1024];
+            while (true) {
+                if (stream.avail_in == 0) {
+                    auto size = std::min<std::size_t>(
+                        data.size() - consumed, UINT_MAX);
+                    stream.next_in = reinterpret_cast<Bytef*>(
+                        const_cast<char*>(data.data() + consumed));
+                    stream.avail_in = static_cast<uInt>(size);
+                    consumed += size;
+                }
+                stream.next_out = reinterpret_cast<Bytef*>(chunk);
+                stream.avail_out = sizeof(chunk);
+                auto status = inflate(&stream, Z_NO_FLUSH);
+                auto produced = sizeof(chunk) - stream.avail_out;
+                auto kept = std::min(produced, keep);
+                out.append(chunk, kept);
+                keep -= kept;
+                if (status == Z_STREAM_END) {
+                    auto size = consumed - stream.avail_in;
+                    stream.avail_in = 0;
+                    return size;
+                }
+                if (status != Z_OK &&
+                    !(status == Z_BUF_ERROR && consumed < data.size())) {
+                    stream.avail_in = 0;
+                    throw warc_exception("corrupt gzip member in " + path);
+                }
+            }
+        }
+
+#ifdef SCRAPP_WITH_ZSTD
+        // Decompresses the zstd frame at the start of data, appending at
+        // most keep bytes of it to out. Returns the size of the frame.
+        std::size_t unzstd(
+            std::string_view data, std::string& out, std::size_t keep,
+            const std::string& path) {
+            thread_local unique_ptr_with_deleter<ZSTD_DCtx, ZSTD_freeDCtx>
+                context{ZSTD_createDCtx()};
+            thread_local std::string scratch;
+            auto frame = ZSTD_findFrameCompressedSize(data.data(), data.size());
+            auto content = ZSTD_getFrameContentSize(data.data(), frame);
+            if (context == nullptr || ZSTD_isError(frame) ||
+                content == ZSTD_CONTENTSIZE_ERROR ||
+                content == ZSTD_CONTENTSIZE_UNKNOWN) {
+                throw warc_exception("corrupt zstd frame in " + path);
+            }
+            auto& target = keep >= content ? out : scratch;
+            auto offset = keep >= content ? out.size() : 0;
+            target.resize(offset + content);
+            auto size = ZSTD_decompressDCtx(
+                context.get(), target.data() + offset, content, data.data(),
+                frame);
+            if (ZSTD_isError(size)) {
+                throw warc_exception("corrupt zstd frame in " + path);
+            }
+            if (&target == &scratch) {
+                out.append(scratch, 0, keep);
+            }
+            return frame;
+        }
+#endif
+
+        Response make_response(std::string_view uri, std::string_view block) {
+            Response response;
+            response.url = Url{std::string{uri}};
+            auto header_end = block.find("\r\n\r\n");
+            auto header = block.substr(0, header_end);
+            response.raw_header = std::string{header} + "\r\n\r\n";
+            response.text = header_end == std::string_view::npos
+                                ? std::string{}
+                                : std::string{block.substr(header_end + 4)};
+            response.downloaded_bytes =
+                static_cast<cpr::cpr_off_t>(response.text.size());
+
+            auto line_end = header.find("\r\n");
+            response.status_line = std::string{header.substr(0, line_end)};
+            std::string_view status = response.status_line;
+            auto code = status.find(' ');
+            if (code != std::string_view::npos) {
+                auto reason = status.find(' ', code + 1);
+                response.status_code = std::strtol(
+                    std::string{status.substr(code + 1, reason - code - 1)}
+                        .c_str(),
+                    nullptr, 10);
+                if (reason != std::string_view::npos) {
+                    response.reason = std::string{status.substr(reason + 1)};
+                }
+            }
+            header = line_end == std::string_view::npos
+                         ? std::string_view{}
+                         : header.substr(line_end + 2);
+            while (!header.empty()) {
+                line_end = header.find("\r\n");
+                auto line = header.substr(0, line_end);
+                header = line_end == std::string_view::npos
+                             ? std::string_view{}
+                             : header.substr(line_end + 2);
+                auto colon = line.find(':');
+                if (colon != std::string_view::npos) {
+                    response.headers[std::string{line.substr(0, colon)}] =
+                        std::string{trim(line.substr(colon + 1))};
+                }
+            }
+            return response;
+        }
+    } // namespace
+
+    WarcArchive::WarcArchive(const std::vector<std::string>& segments) {
+        try {
+            for (const auto& path : segments) {
+                this->map(path);
+            }
+            for (std::size_t i = 0; i < this->segments_.size(); ++i) {
+                this->scan(i);
+            }
+        } catch (...) {
+            for (auto& segment : this->segments_) {
+                ::munmap(const_cast<char*>(segment.data), segment.size);
+            }
+            throw;
+        }
+    }
+
+    WarcArchive::~WarcArchive() {
+        for (auto& segment : this->segments_) {
+            ::munmap(const_cast<char*>(segment.data), segment.size);
+        }
+    }
+
+    std::size_t WarcArchive::size() const noexcept {
+        return this->responses_.size();
+    }
+
+    std::optional<WarcCapture>
+    WarcArchive::find(const Request& request) const {
+        auto found = this->responses_.find(request.fingerprint());
+        if (found == this->responses_.end()) {
+            return std::nullopt;
+        }
+        std::string scratch;
+        auto record = this->read(found->second, scratch);
+        auto header = parse_header(record);
+        if (!header) {
+            throw warc_exception(
+                "malformed record in " +
+                this->segments_[found->second.segment].path);
+        }
+        return WarcCapture{
+            make_response(
+                header->target_uri,
+                record.substr(header->size, header->content_length)),
+            found->second.date};
+    }
+
+    std::chrono::system_clock::time_point
+    WarcArchive::first_capture() const noexcept {
+        return this->first_capture_;
+    }
+
+    void WarcArchive::map(const std::string& path) {
+        auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            throw warc_exception(
+                "cannot open " + path + ": " +
+                std::system_category().message(errno));
+        }
+        struct stat status {};
+        if (::fstat(fd, &status) != 0) {
+            auto error = errno;
+            ::close(fd);
+            throw warc_exception(
+                "cannot stat " + path + ": " +
+                std::system_category().message(error));
+        }
+        auto size = static_cast<std::size_t>(status.st_size);
+        if (size == 0) {
+            ::close(fd);
+            return;
+        }
+        auto* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        auto error = errno;
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw warc_exception(
+                "cannot map " + path + ": " +
+                std::system_category().message(error));
+        }
+
+        Segment segment{path, static_cast<const char*>(data), size};
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+            segment.compression = Compression::gzip;
+        } else if (
+            size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 &&
+            bytes[2] == 0x2f && bytes[3] == 0xfd) {
+#ifndef SCRAPP_WITH_ZSTD
+            ::munmap(data, size);
+            throw warc_exception(
+                path + " is zstd compressed, which requires building with "
+                       "SCRAPP_WITH_ZSTD");
+#endif
+            segment.compression = Compression::zstd;
+        }
+        this->segments_.push_back(std::move(segment));
+    }
+
+    void WarcArchive::scan(std::size_t index) {
+        const auto& segment = this->segments_[index];
+        std::string_view data{segment.data, segment.size};
+        // Responses by record id, and the requests pointing to them as
+        // their fingerprint and the id of their response.
+        std::unordered_map<std::string, Location> responses;
+        std::vector<std::pair<std::string, std::string>> requests;
+        std::string scratch;
+        std::uint64_t offset = 0;
+        while (offset < data.size()) {
+            auto rest = data.substr(offset);
+            std::string_view record;
+            std::uint64_t length = 0;
+            scratch.clear();
+            switch (segment.compression) {
+            case Compression::none:
+                record = rest;
+                break;
+            case Compression::gzip:
+                length = gunzip(rest, scratch, header_limit, segment.path);
+                record = scratch;
+                break;
+            case Compression::zstd:
+#ifdef SCRAPP_WITH_ZSTD
+                length = unzstd(rest, scratch, header_limit, segment.path);
+                record = scratch;
+#endif
+                break;
+            }
+            auto header = parse_header(record);
+            if (!header) {
+                throw warc_exception(
+                    "malformed record in " + segment.path + " at offset " +
+                    std::to_string(offset));
+            }
+            if (segment.compression == Compression::none) {
+                length = header->size + header->content_length;
+                if (length > rest.size()) {
+                    throw warc_exception(
+                        "truncated record in " + segment.path +
+                        " at offset " + std::to_string(offset));
+                }
+                // Skip the empty lines ending the record.
+                while (length < rest.size() &&
+                       (rest[length] == '\r' || rest[length] == '\n')) {
+                    ++length;
+                }
+            }
+
+            Location location{index, offset, length, parse_date(header->date)};
+            if (header->type == "response") {
+                if ((this->responses_.empty() && responses.empty()) ||
+                    location.date < this->first_capture_) {
+                    this->first_capture_ = location.date;
+                }
+                this->responses_[url_fingerprint(header->target_uri)] =
+                    location;
+                responses[std::string{header->record_id}] = location;
+            } else if (header->type == "request") {
+                requests.emplace_back(
+                    url_fingerprint(header->target_uri),
+                    std::string{header->concurrent_to});
+            }
+            offset += length;
+        }
+        // Requests are archived by the URL they asked for, which differs
+        // from the response's after redirects.
+        for (auto& [fingerprint, response] : requests) {
+            auto found = responses.find(response);
+            if (found != responses.end()) {
+                this->responses_[std::move(fingerprint)] = found->second;
+            }
+        }
+    }
+
+    std::string_view
+    WarcArchive::read(const Location& location, std::string& scratch) const {
+        const auto& segment = this->segments_[location.segment];
+        std::string_view record{
+            segment.data + location.offset,
+            static_cast<std::size_t>(location.length)};
+        switch (segment.compression) {
+        case Compression::none:
+            return record;
+        case Compression::gzip:
+            gunzip(record, scratch, SIZE_MAX, segment.path);
+            return scratch;
+        case Compression::zstd:
+#ifdef SCRAPP_WITH_ZSTD
+            unzstd(record, scratch, SIZE_MAX, segment.path);
+#endif
+            return scratch;
+        }
+        return record;
+    }
+
+    ReplayTransport::ReplayTransport(
+        std::shared_ptr<const WarcArchive> archive, ReplayOptions options)
+        : archive_(std::move(archive)), options_(options) {
+        if (!(this->options_.speed > 0)) {
+            this->options_.speed = 1.0;
+        }
+    }
+
+    Response ReplayTransport::fetch(
+        const Request& request, const FetchOptions& /*options*/) {
+        std::optional<WarcCapture> capture;
+        std::string error;
+        try {
+            capture = this->archive_->find(request);
+            if (!capture) {
+                error = "no response archived for " + request.full_url();
+            }
+        } catch (const warc_exception& exception) {
+            error = exception.what();
+        }
+        if (!capture) {
+            Response response;
+            response.url = Url{request.full_url()};
+            response.error.code = cpr::ErrorCode::UNKNOWN_ERROR;
+            response.error.message = std::move(error);
+            return response;
+        }
+        if (this->options_.timing == ReplayTiming::original) {
+            std::call_once(this->started_, [this] {
+                this->start_ = std::chrono::steady_clock::now();
+            });
+            auto delay = std::chrono::duration<double>(
+                             capture->date - this->archive_->first_capture()) /
+                         this->options_.speed;
+            std::this_thread::sleep_until(
+                this->start_ +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    delay));
+        }
+        return std::move(capture->response);
+    }
+} // namespace Scrapp
@@ -0,0 +1,131 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_REPLAY_H
+#define SCRAPP_REPLAY_H
+
+#include "transport.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Scrapp {
+    struct WarcCapture {
+        Response response;
+        std::chrono::system_clock::time_point date;
+    };
+
+    // Responses of WARC archives, such as the segments WarcWriter writes,
+    // memory-mapped and indexed by request fingerprint. Records are only
+    // decompressed when they are looked up. Thread safe.
+    class WarcArchive {
+      public:
+        // Maps and indexes segments, uncompressed or compressed per record
+        // with gzip, or with zstd when built with SCRAPP_WITH_ZSTD. Throws
+        // warc_exception.
+        explicit WarcArchive(const std::vector<std::string>& segments);
+        WarcArchive(const WarcArchive&) = delete;
+        WarcArchive& operator=(const WarcArchive&) = delete;
+        ~WarcArchive();
+
+        // Number of requests with a recorded response.
+        [[nodiscard]] std::size_t size() const noexcept;
+        // The last response recorded for a request with the same
+        // fingerprint. Responses are found through the request records
+        // pointing to them, or by their own target URI.
+        [[nodiscard]] std::optional<WarcCapture>
+        find(const Request& request) const;
+        // Capture date of the first response.
+        [[nodiscard]] std::chrono::system_clock::time_point
+        first_capture() const noexcept;
+
+      private:
+        enum class Compression { none, gzip, zstd };
+
+        struct Segment {
+            std::string path;
+            const char* data{};
+            std::size_t size{};
+            Compression compression{};
+        };
+
+        struct Location {
+            std::size_t segment{};
+            std::uint64_t offset{};
+            std::uint64_t length{};
+            std::chrono::system_clock::time_point date;
+        };
+
+        void map(const std::string& path);
+        void scan(std::size_t segment);
+        // The decompressed record at location, in scratch if it had to be
+        // decompressed.
+        std::string_view
+        read(const Location& location, std::string& scratch) const;
+
+        std::vector<Segment> segments_;
+        std::unordered_map<std::string, Location> responses_;
+        std::chrono::system_clock::time_point first_capture_;
+    };
+
+    enum class ReplayTiming {
+        // Serve responses as fast as they are asked for.
+        fastest,
+        // Serve every response no earlier than it was captured, counting
+        // from the first capture and the first fetch.
+        original,
+    };
+
+    struct ReplayOptions {
+        ReplayTiming timing{ReplayTiming::fastest};
+        // Speeds up original timing, 2 halves the recorded delays.
+        double speed{1.0};
+    };
+
+    // Serves a Spider the responses of an archive instead of fetching
+    // them. Requests missing from the archive, or whose records cannot be
+    // read, get a response without a status code and with error set.
+    class ReplayTransport : public Transport {
+      public:
+        explicit ReplayTransport(
+            std::shared_ptr<const WarcArchive> archive,
+            ReplayOptions options = {});
+
+        Response
+        fetch(const Request& request, const FetchOptions& options) override;
+
+      private:
+        std::shared_ptr<const WarcArchive> archive_;
+        ReplayOptions options_;
+        std::once_flag started_;
+        std::chrono::steady_clock::time_point start_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_REPLAY_H
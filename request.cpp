@@ -57,21 +57,46 @@ namespace Scrapp {
 
     void Request::set_render(bool render) noexcept { this->_render = render; }
 
+    void Request::set_stream_json(bool stream_json) noexcept {
+        this->_stream_json = stream_json;
+    }
+
+    bool Request::stream_json() const noexcept { return this->_stream_json; }
+
+    void Request::set_priority(double priority) noexcept {
+        this->_priority = priority;
+    }
+
+    double Request::priority() const noexcept { return this->_priority; }
+
+    void Request::set_depth(std::size_t depth) noexcept {
+        this->_depth = depth;
+    }
+
+    std::size_t Request::depth() const noexcept { return this->_depth; }
+
     std::string Request::full_url() const noexcept {
         std::string total = this->_url.str();
-        total = total + "?";
+        auto separator = total.find('?') == std::string::npos ? '?' : '&';
         for (const auto& [key, value] : this->_parameters) {
+            total += separator;
             total += Scrapp::url_encode(key) + "=" + Scrapp::url_encode(value);
+            separator = '&';
         }
         return total;
     }
 
+    std::string Request::fingerprint() const noexcept {
+        return Scrapp::url_fingerprint(this->full_url());
+    }
+
     std::string Request::url() const noexcept { return this->_url.str(); }
 
     bool Request::operator==(const Request& other) const noexcept {
         return this->_url == other._url &&
                this->_parameters == other._parameters &&
                this->_headers == other._headers &&
-               this->_render == other._render;
+               this->_render == other._render &&
+               this->_stream_json == other._stream_json;
     }
 } // namespace Scrapp
@@ -63,7 +63,21 @@ namespace Scrapp {
         add_header(const std::pair<std::string, std::string>& header) noexcept;
         Headers headers() const noexcept;
         void set_render(bool render) noexcept;
+        // Parse the body as JSON while it downloads instead of buffering it
+        // in Response::text, see Response::json.
+        void set_stream_json(bool stream_json) noexcept;
+        bool stream_json() const noexcept;
+        // Scheduling metadata, not part of the request's identity: the
+        // Frontier fetches higher priorities first (see best_first_scorer),
+        // and follow_links() queues links one level deeper than the page.
+        void set_priority(double priority) noexcept;
+        double priority() const noexcept;
+        void set_depth(std::size_t depth) noexcept;
+        std::size_t depth() const noexcept;
         std::string full_url() const noexcept;
+        // Equal for requests that fetch the same resource, whatever the
+        // order of their parameters. See url_fingerprint.
+        std::string fingerprint() const noexcept;
         std::string url() const noexcept;
         bool operator==(const Request& other) const noexcept;
 
@@ -72,6 +86,9 @@ namespace Scrapp {
         RequestParameters _parameters;
         Headers _headers;
         bool _render{};
+        bool _stream_json{};
+        double _priority{};
+        std::size_t _depth{};
     };
 } // namespace Scrapp
 
@@ -23,8 +23,8 @@
 
 #include "response.h"
 #include "exceptions.h"
+#include "json.h"
 #include <boost/algorithm/string.hpp>
-#include <boost/json/string_view.hpp>
 #include <iostream>
 
 namespace Scrapp {
@@ -36,10 +36,18 @@ namespace Scrapp {
           downloaded_bytes{res.downloaded_bytes},
           redirect_count{res.redirect_count}, status_code{res.status_code} {}
 
+    Response::Response(
+        cpr::Response& res, std::shared_ptr<const boost::json::value> json,
+        boost::json::error_code json_error)
+        : Response(res) {
+        this->json_ = std::move(json);
+        this->json_error_ = json_error;
+    }
+
     Response::Response() = default;
     Response::~Response() = default;
 
-    boost::json::value Response::json() {
+    void Response::check_json_content_type() const {
         // covers both application/json and application/ld+json
         if (!boost::algorithm::contains(
                 this->headers.at("Content-Type"), "json")) {
@@ -47,15 +55,34 @@ namespace Scrapp {
                 "response to " + this->url.str() +
                 " is not a valid json: " + this->text);
         }
-        boost::json::parse_options opts;
-        opts.allow_comments = true;
-        opts.allow_trailing_commas = true;
-        boost::json::error_code ec;
-
-        unsigned char buf[4096];
-        boost::json::static_resource res(buf);
-        boost::json::string_view sw = this->text;
-        auto j = boost::json::parse(sw, ec, &res, opts);
-        return j;
+    }
+
+    void Response::check_json_error() const {
+        if (this->json_error_) {
+            throw invalid_json_exception(
+                "response to " + this->url.str() +
+                " is not a valid json: " + this->json_error_.message());
+        }
+    }
+
+    const boost::json::value& Response::json() {
+        this->check_json_content_type();
+        if (this->json_ == nullptr) {
+            this->check_json_error();
+            JsonStream stream;
+            stream.write(this->text);
+            this->json_ =
+                std::make_shared<const boost::json::value>(stream.finish());
+        }
+        return *this->json_;
+    }
+
+    JsonRecord Response::json(const JsonExtractor& extractor) const {
+        this->check_json_content_type();
+        if (this->json_ != nullptr) {
+            return extractor.extract_value(*this->json_);
+        }
+        this->check_json_error();
+        return extractor.extract(this->text);
     }
 }; // namespace Scrapp
@@ -23,17 +23,27 @@
 #ifndef SCRAPP_RESPONSE_H
 #define SCRAPP_RESPONSE_H
 
+#include "embedded_json.h"
 #include "exceptions.h"
 #include "html/document.h"
+#include "html/link_extractor.h"
+#include "json_extractor.h"
 #include "request.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/json.hpp>
 #include <cpr/cpr.h>
+#include <memory>
 
 namespace Scrapp {
     class Response {
       public:
         explicit Response(cpr::Response& res);
+        // For bodies parsed while downloading, see Request::set_stream_json.
+        // json is null and json_error says why if the body was invalid or
+        // its download failed.
+        Response(
+            cpr::Response& res, std::shared_ptr<const boost::json::value> json,
+            boost::json::error_code json_error = {});
 
         explicit Response();
         ~Response();
@@ -51,9 +61,42 @@ namespace Scrapp {
         cpr::cpr_off_t uploaded_bytes{};
         cpr::cpr_off_t downloaded_bytes{};
         long redirect_count{};
+        // Depth of the request this responds to, see Request::depth.
+        std::size_t depth{};
 
-        boost::json::value json();
+        // The document parsed while downloading, or text parsed into an
+        // arena from JsonArenaPool on the first call. The document is shared
+        // by the copies of the response made after that, never copied. The
+        // arena is not thread safe, so copies of the document or its parts
+        // must pass their own storage: boost::json::value{v, {}}.
+        // Throws invalid_json_exception if the content type is not JSON or
+        // the body is invalid, with the error of the download's parser for
+        // bodies parsed while downloading.
+        const boost::json::value& json();
+        // Extracts only the values extractor's paths match, without
+        // building the document. Throws like json().
+        JsonRecord json(const JsonExtractor& extractor) const;
 
+        // JSON embedded in the body's <script> elements, such as JSON-LD or
+        // __NEXT_DATA__, found by a raw tag scan without building a DOM.
+        std::vector<boost::json::value>
+        embedded_json(const EmbeddedJsonOptions& options = {}) const {
+            return Scrapp::embedded_json(this->text, options);
+        }
+        std::vector<JsonRecord> embedded_json(
+            const JsonExtractor& extractor,
+            const EmbeddedJsonOptions& options = {}) const {
+            return Scrapp::embedded_json(this->text, extractor, options);
+        }
+
+        // Links of the body found by a raw tag scan, resolved against url.
+        // Much cheaper than html() when only the links are needed.
+        std::vector<std::string>
+        links(const Html::LinkExtractor& extractor = {}) const {
+            return extractor.extract(this->text, this->url.str());
+        }
+
+        // Parses text in place, the body is never copied.
         template<bool check_content_type = true>
         Html::HtmlDocument html() const {
             if constexpr (check_content_type) {
@@ -69,13 +112,20 @@ namespace Scrapp {
                         "Content-Type: " +
                         content_type);
                 }
-                return Html::HtmlDocument{this->text};
+                return Html::HtmlDocument{std::string_view{this->text}};
             } else {
-                return Html::HtmlDocument{this->text};
+                return Html::HtmlDocument{std::string_view{this->text}};
             }
         }
 
       private:
+        void check_json_content_type() const;
+        // Throws the error of the parser that read the body while
+        // downloading, if it failed.
+        void check_json_error() const;
+
+        std::shared_ptr<const boost::json::value> json_;
+        boost::json::error_code json_error_;
     };
 } // namespace Scrapp
 
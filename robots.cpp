@@ -0,0 +1,414 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "robots.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <mutex>
+
+namespace Scrapp {
+    namespace {
+        bool is_hex(char c) noexcept {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+                   (c >= 'A' && c <= 'F');
+        }
+
+        // Percent-encoded octets compare equal whatever the case of their
+        // hex digits. Returns target itself when it is already normalized.
+        std::string_view
+        normalize_escapes(std::string_view target, std::string& buffer) {
+            for (std::size_t i = 0; i + 2 < target.size(); ++i) {
+                if (target[i] == '%' && is_hex(target[i + 1]) &&
+                    is_hex(target[i + 2]) &&
+                    (std::islower(static_cast<unsigned char>(target[i + 1])) ||
+                     std::islower(static_cast<unsigned char>(target[i + 2])))) {
+                    buffer.assign(target);
+                    for (auto j = i; j + 2 < buffer.size(); ++j) {
+                        if (buffer[j] == '%' && is_hex(buffer[j + 1]) &&
+                            is_hex(buffer[j + 2])) {
+                            buffer[j + 1] = static_cast<char>(std::toupper(
+                                static_cast<unsigned char>(buffer[j + 1])));
+                            buffer[j + 2] = static_cast<char>(std::toupper(
+                                static_cast<unsigned char>(buffer[j + 2])));
+                        }
+                    }
+                    return buffer;
+                }
+            }
+            return target;
+        }
+
+        // Whether pattern, starting at a '*', matches a prefix of text, or
+        // all of it when it ends with '$'.
+        bool matches_wildcard(
+            std::string_view pattern, std::string_view text) noexcept {
+            auto anchored = !pattern.empty() && pattern.back() == '$';
+            if (anchored) {
+                pattern.remove_suffix(1);
+            }
+            std::size_t p = 0;
+            std::size_t t = 0;
+            auto star = std::string_view::npos;
+            std::size_t mark = 0;
+            while (true) {
+                if (!anchored && p == pattern.size()) {
+                    return true;
+                }
+                if (t == text.size()) {
+                    break;
+                }
+                if (p < pattern.size() && pattern[p] == '*') {
+                    star = p++;
+                    mark = t;
+                } else if (p < pattern.size() && pattern[p] == text[t]) {
+                    ++p;
+                    ++t;
+                } else if (star != std::string_view::npos) {
+                    p = star + 1;
+                    t = ++mark;
+                } else {
+                    return false;
+                }
+            }
+            while (p < pattern.size() && pattern[p] == '*') {
+                ++p;
+            }
+            return p == pattern.size();
+        }
+
+        struct Group {
+            std::vector<std::string> agents;
+            std::vector<std::pair<std::string, bool>> rules;
+            std::optional<std::chrono::milliseconds> crawl_delay;
+            bool has_rules{};
+        };
+    } // namespace
+
+    RobotsRules::RobotsRules() = default;
+
+    RobotsRules::RobotsRules(
+        std::string_view robots_txt, std::string_view user_agent) {
+        std::vector<Group> groups;
+        while (!robots_txt.empty()) {
+            auto end = robots_txt.find('\n');
+            auto line = robots_txt.substr(0, end);
+            robots_txt = end == std::string_view::npos
+                             ? std::string_view{}
+                             : robots_txt.substr(end + 1);
+            line = trim(line.substr(0, line.find('#')));
+            auto colon = line.find(':');
+            if (colon == std::string_view::npos) {
+                continue;
+            }
+            auto key = to_lower(std::string{trim(line.substr(0, colon))});
+            auto value = trim(line.substr(colon + 1));
+            if (key == "user-agent") {
+                if (groups.empty() || groups.back().has_rules) {
+                    groups.emplace_back();
+                }
+                groups.back().agents.push_back(to_lower(std::string{value}));
+            } else if (key == "allow" || key == "disallow") {
+                if (groups.empty()) {
+                    continue;
+                }
+                groups.back().has_rules = true;
+                // An empty Disallow allows everything, like no rule.
+                if (!value.empty()) {
+                    groups.back().rules.emplace_back(value, key == "allow");
+                }
+            } else if (key == "crawl-delay") {
+                if (groups.empty()) {
+                    continue;
+                }
+                groups.back().has_rules = true;
+                std::string number{value};
+                char* number_end = nullptr;
+                auto seconds = std::strtod(number.c_str(), &number_end);
+                if (number_end != number.c_str() && seconds >= 0 &&
+                    seconds < 86400) {
+                    groups.back().crawl_delay =
+                        std::chrono::milliseconds{
+                            static_cast<std::int64_t>(seconds * 1000)};
+                }
+            } else if (key == "sitemap" && !value.empty()) {
+                this->sitemaps_.emplace_back(value);
+            }
+        }
+
+        // The product token, "Scrapp" of "Scrapp/1.0 (+https://...)".
+        auto token = to_lower(std::string{
+            user_agent.substr(0, user_agent.find_first_of("/ "))});
+        auto selected = [&groups](std::string_view agent) {
+            std::vector<const Group*> matches;
+            for (const auto& group : groups) {
+                if (std::find(
+                        group.agents.begin(), group.agents.end(), agent) !=
+                    group.agents.end()) {
+                    matches.push_back(&group);
+                }
+            }
+            return matches;
+        };
+        auto matches = selected(token);
+        if (matches.empty()) {
+            matches = selected("*");
+        }
+        std::vector<std::pair<std::string, bool>> rules;
+        for (const auto* group : matches) {
+            rules.insert(rules.end(), group->rules.begin(), group->rules.end());
+            if (!this->crawl_delay_) {
+                this->crawl_delay_ = group->crawl_delay;
+            }
+        }
+        this->compile(rules);
+    }
+
+    RobotsRules RobotsRules::allow_all() {
+        RobotsRules rules;
+        rules.compile({});
+        return rules;
+    }
+
+    RobotsRules RobotsRules::disallow_all() {
+        RobotsRules rules;
+        rules.compile({{"/", false}});
+        return rules;
+    }
+
+    bool RobotsRules::allowed(std::string_view target) const noexcept {
+        if (target == "/robots.txt") {
+            return true;
+        }
+        std::string buffer;
+        target = normalize_escapes(target, buffer);
+        std::optional<Rule> best;
+        auto consider = [&best](const Rule& rule) {
+            if (!best || rule.length > best->length ||
+                (rule.length == best->length && rule.allow)) {
+                best = rule;
+            }
+        };
+        std::uint32_t node = 0;
+        for (std::size_t depth = 0;; ++depth) {
+            const auto& current = this->nodes_[node];
+            if (current.prefix) {
+                consider(*current.prefix);
+            }
+            if (current.exact && depth == target.size()) {
+                consider(*current.exact);
+            }
+            for (auto i = current.first_wildcard;
+                 i < current.first_wildcard + current.wildcard_count; ++i) {
+                const auto& wildcard = this->wildcards_[i];
+                if (matches_wildcard(wildcard.rest, target.substr(depth))) {
+                    consider(wildcard.rule);
+                }
+            }
+            if (depth == target.size()) {
+                break;
+            }
+            const auto* labels = this->edge_labels_.data() + current.first_edge;
+            const auto* found =
+                std::find(labels, labels + current.edge_count, target[depth]);
+            if (found == labels + current.edge_count) {
+                break;
+            }
+            auto edge = current.first_edge +
+                        static_cast<std::uint32_t>(found - labels);
+            node = this->edge_targets_[edge];
+        }
+        return !best || best->allow;
+    }
+
+    std::optional<std::chrono::milliseconds>
+    RobotsRules::crawl_delay() const noexcept {
+        return this->crawl_delay_;
+    }
+
+    const std::vector<std::string>& RobotsRules::sitemaps() const noexcept {
+        return this->sitemaps_;
+    }
+
+    void RobotsRules::compile(
+        const std::vector<std::pair<std::string, bool>>& rules) {
+        struct Building {
+            std::map<char, std::uint32_t> children;
+            std::optional<Rule> prefix;
+            std::optional<Rule> exact;
+            std::vector<WildcardRule> wildcards;
+        };
+        std::vector<Building> building(1);
+        // Rules of equal length on one node tie, and Allow wins ties.
+        auto merge = [](std::optional<Rule>& slot, Rule rule) {
+            if (slot) {
+                slot->allow = slot->allow || rule.allow;
+            } else {
+                slot = rule;
+            }
+        };
+        std::string buffer;
+        for (const auto& [raw, allow] : rules) {
+            auto pattern = normalize_escapes(raw, buffer);
+            Rule rule{static_cast<std::uint32_t>(pattern.size()), allow};
+            auto star = pattern.find('*');
+            auto exact = star == std::string_view::npos &&
+                         pattern.back() == '$';
+            auto literal = pattern.substr(
+                0, star != std::string_view::npos
+                       ? star
+                       : pattern.size() - (exact ? 1 : 0));
+            std::uint32_t node = 0;
+            for (char c : literal) {
+                auto [child, added] = building[node].children.try_emplace(
+                    c, static_cast<std::uint32_t>(building.size()));
+                if (added) {
+                    building.emplace_back();
+                }
+                node = child->second;
+            }
+            if (star != std::string_view::npos) {
+                building[node].wildcards.push_back(
+                    WildcardRule{rule, std::string{pattern.substr(star)}});
+            } else if (exact) {
+                merge(building[node].exact, rule);
+            } else {
+                merge(building[node].prefix, rule);
+            }
+        }
+
+        // Lay the trie out in flat arrays, each node's edges contiguous.
+        this->nodes_.resize(building.size());
+        for (std::size_t i = 0; i < building.size(); ++i) {
+            auto& node = this->nodes_[i];
+            node.first_edge =
+                static_cast<std::uint32_t>(this->edge_labels_.size());
+            node.edge_count =
+                static_cast<std::uint32_t>(building[i].children.size());
+            for (const auto& [label, target] : building[i].children) {
+                this->edge_labels_.push_back(label);
+                this->edge_targets_.push_back(target);
+            }
+            node.first_wildcard =
+                static_cast<std::uint32_t>(this->wildcards_.size());
+            node.wildcard_count =
+                static_cast<std::uint32_t>(building[i].wildcards.size());
+            for (auto& wildcard : building[i].wildcards) {
+                this->wildcards_.push_back(std::move(wildcard));
+            }
+            node.prefix = building[i].prefix;
+            node.exact = building[i].exact;
+        }
+    }
+
+    RobotsCache::RobotsCache(
+        std::shared_ptr<Transport> transport, RobotsOptions options)
+        : transport_{std::move(transport)}, options_{std::move(options)} {}
+
+    std::shared_ptr<const RobotsRules>
+    RobotsCache::rules(std::string_view url) {
+        auto origin = url_origin(url);
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::shared_lock lock{this->mutex_};
+            auto found = this->hosts_.find(origin);
+            if (found != this->hosts_.end() && found->second.expires > now) {
+                auto rules = found->second.rules;
+                lock.unlock();
+                return rules.get();
+            }
+        }
+
+        std::promise<std::shared_ptr<const RobotsRules>> fetched;
+        {
+            std::unique_lock lock{this->mutex_};
+            auto& entry = this->hosts_[origin];
+            if (entry.rules.valid() && entry.expires > now) {
+                // Another thread fetched or is fetching the file.
+                auto rules = entry.rules;
+                lock.unlock();
+                return rules.get();
+            }
+            entry.rules = fetched.get_future().share();
+            // Until the fetch completes, callers wait for it.
+            entry.expires = std::chrono::steady_clock::time_point::max();
+        }
+
+        auto rules = this->fetch(origin);
+        auto ttl = rules ? this->options_.ttl : this->options_.error_ttl;
+        auto shared = std::make_shared<const RobotsRules>(
+            rules ? std::move(*rules) : RobotsRules::disallow_all());
+        fetched.set_value(shared);
+        {
+            std::unique_lock lock{this->mutex_};
+            this->hosts_[origin].expires =
+                std::chrono::steady_clock::now() + ttl;
+        }
+        return shared;
+    }
+
+    bool RobotsCache::allowed(std::string_view url) {
+        return this->rules(url)->allowed(url_target(url));
+    }
+
+    void
+    RobotsCache::insert(std::string_view url, std::string_view robots_txt) {
+        std::promise<std::shared_ptr<const RobotsRules>> rules;
+        rules.set_value(std::make_shared<const RobotsRules>(
+            robots_txt.substr(0, this->options_.max_size),
+            this->options_.user_agent));
+        std::unique_lock lock{this->mutex_};
+        this->hosts_[url_origin(url)] = Entry{
+            rules.get_future().share(),
+            std::chrono::steady_clock::now() + this->options_.ttl};
+    }
+
+    std::size_t RobotsCache::size() const {
+        std::shared_lock lock{this->mutex_};
+        return this->hosts_.size();
+    }
+
+    std::optional<RobotsRules> RobotsCache::fetch(const std::string& origin) {
+        Response response;
+        try {
+            Request request{Url{origin + "/robots.txt"}};
+            request.add_header({"User-Agent", this->options_.user_agent});
+            response = this->transport_->fetch(request, FetchOptions{});
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+        if (response.error.code != cpr::ErrorCode::OK ||
+            response.status_code >= 500 || response.status_code < 200) {
+            return std::nullopt;
+        }
+        if (response.status_code >= 300) {
+            // Unavailable, including redirects that were not followed.
+            return RobotsRules::allow_all();
+        }
+        return RobotsRules{
+            std::string_view{response.text}.substr(0, this->options_.max_size),
+            this->options_.user_agent};
+    }
+} // namespace Scrapp
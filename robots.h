@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_ROBOTS_H
+#define SCRAPP_ROBOTS_H
+
+#include "transport.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Scrapp {
+    // The rules of a robots.txt file (RFC 9309) for one user agent,
+    // compiled into a trie of their literal prefixes. A check walks the
+    // trie along the path once, so it costs O(path length) plus the rules
+    // with wildcards whose prefix the path reaches.
+    class RobotsRules {
+      public:
+        // Parses robots_txt and keeps the groups of user_agent's product
+        // token, case-insensitive, or the "*" groups if there are none.
+        RobotsRules(std::string_view robots_txt, std::string_view user_agent);
+
+        static RobotsRules allow_all();
+        static RobotsRules disallow_all();
+
+        // Whether target, the path and query of a URL, may be fetched. The
+        // longest matching rule wins, Allow on ties.
+        [[nodiscard]] bool allowed(std::string_view target) const noexcept;
+        [[nodiscard]] std::optional<std::chrono::milliseconds>
+        crawl_delay() const noexcept;
+        // Sitemap URLs listed in the file, whatever the group.
+        [[nodiscard]] const std::vector<std::string>&
+        sitemaps() const noexcept;
+
+      private:
+        RobotsRules();
+
+        struct Rule {
+            // Pattern length, the rule's priority.
+            std::uint32_t length{};
+            bool allow{};
+        };
+
+        struct WildcardRule {
+            Rule rule;
+            // Pattern after the literal prefix, from its first '*'.
+            std::string rest;
+        };
+
+        struct Node {
+            std::uint32_t first_edge{};
+            std::uint32_t edge_count{};
+            std::uint32_t first_wildcard{};
+            std::uint32_t wildcard_count{};
+            // Literal patterns ending here, matching any continuation or
+            // only the end of the path ('$').
+            std::optional<Rule> prefix;
+            std::optional<Rule> exact;
+        };
+
+        // Builds the trie of patterns, Allow if true.
+        void compile(const std::vector<std::pair<std::string, bool>>& rules);
+
+        std::vector<Node> nodes_;
+        std::vector<char> edge_labels_;
+        std::vector<std::uint32_t> edge_targets_;
+        std::vector<WildcardRule> wildcards_;
+        std::optional<std::chrono::milliseconds> crawl_delay_;
+        std::vector<std::string> sitemaps_;
+    };
+
+    struct RobotsOptions {
+        // Product token matched against the groups' user agents.
+        std::string user_agent{"Scrapp"};
+        std::chrono::seconds ttl{std::chrono::hours{24}};
+        // How long server errors and unreachable hosts disallow the whole
+        // host before robots.txt is fetched again.
+        std::chrono::seconds error_ttl{std::chrono::minutes{10}};
+        // Bytes of robots.txt parsed, RFC 9309 requires at least 500 KiB.
+        std::size_t max_size{500 * 1024};
+    };
+
+    // robots.txt of every host, fetched once through a Transport and
+    // cached for ttl. Missing files (4xx) allow everything, server errors
+    // and network failures disallow everything for error_ttl. Checks of
+    // cached hosts only take a shared lock. Thread safe.
+    class RobotsCache {
+      public:
+        explicit RobotsCache(
+            std::shared_ptr<Transport> transport =
+                std::make_shared<HttpTransport>(),
+            RobotsOptions options = {});
+
+        // Rules of url's host, fetching them if they are not cached or
+        // expired. Concurrent callers for one host share a single fetch.
+        std::shared_ptr<const RobotsRules> rules(std::string_view url);
+        bool allowed(std::string_view url);
+        // Caches robots_txt as the file of url's host without fetching it.
+        void insert(std::string_view url, std::string_view robots_txt);
+        [[nodiscard]] std::size_t size() const;
+
+      private:
+        struct Entry {
+            std::shared_future<std::shared_ptr<const RobotsRules>> rules;
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        // The host's rules, nullopt on server errors and network failures.
+        std::optional<RobotsRules> fetch(const std::string& origin);
+
+        std::shared_ptr<Transport> transport_;
+        RobotsOptions options_;
+        std::unordered_map<std::string, Entry> hosts_;
+        mutable std::shared_mutex mutex_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_ROBOTS_H
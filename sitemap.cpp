@@ -0,0 +1,462 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "sitemap.h"
+#include "exceptions.h"
+#include "html/tag_scanner.h"
+#include "utils.h"
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <exception>
+#include <unordered_set>
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        // Longest construct or value buffered; sitemaps.org limits URLs to
+        // 2048 characters.
+        constexpr std::size_t max_pending = 1024 * 1024;
+        constexpr std::size_t max_value = 64 * 1024;
+
+        std::string_view local_name(std::string_view name) {
+            auto end = name.find_first_of(" \t\r\n/");
+            name = name.substr(0, end);
+            auto colon = name.find(':');
+            return colon == std::string_view::npos ? name
+                                                   : name.substr(colon + 1);
+        }
+
+        bool starts_with(
+            std::string_view text, std::size_t at, std::string_view prefix) {
+            return text.compare(at, prefix.size(), prefix) == 0;
+        }
+
+        // Reads count digits at text[at], advancing at.
+        std::optional<int>
+        digits(std::string_view text, std::size_t& at, std::size_t count) {
+            if (text.size() - at < count) {
+                return std::nullopt;
+            }
+            int value = 0;
+            for (std::size_t i = 0; i < count; ++i, ++at) {
+                if (text[at] < '0' || text[at] > '9') {
+                    return std::nullopt;
+                }
+                value = value * 10 + (text[at] - '0');
+            }
+            return value;
+        }
+
+        // Days since 1970-01-01 of a proleptic Gregorian date.
+        std::int64_t days_from_civil(int year, int month, int day) noexcept {
+            year -= month <= 2;
+            auto era = (year >= 0 ? year : year - 399) / 400;
+            auto year_of_era = year - era * 400;
+            auto day_of_year =
+                (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            auto day_of_era = year_of_era * 365 + year_of_era / 4 -
+                              year_of_era / 100 + day_of_year;
+            return static_cast<std::int64_t>(era) * 146097 + day_of_era -
+                   719468;
+        }
+    } // namespace
+
+    std::optional<std::chrono::system_clock::time_point>
+    parse_w3c_datetime(std::string_view text) {
+        text = trim(text);
+        std::size_t at = 0;
+        auto year = digits(text, at, 4);
+        if (!year) {
+            return std::nullopt;
+        }
+        int month = 1;
+        int day = 1;
+        std::int64_t seconds = 0;
+        std::chrono::microseconds fraction{0};
+        if (at < text.size()) {
+            auto parsed =
+                text[at++] == '-' ? digits(text, at, 2) : std::nullopt;
+            if (!parsed || *parsed < 1 || *parsed > 12) {
+                return std::nullopt;
+            }
+            month = *parsed;
+        }
+        if (at < text.size()) {
+            auto parsed =
+                text[at++] == '-' ? digits(text, at, 2) : std::nullopt;
+            if (!parsed || *parsed < 1 || *parsed > 31) {
+                return std::nullopt;
+            }
+            day = *parsed;
+        }
+        if (at < text.size()) {
+            if (text[at++] != 'T') {
+                return std::nullopt;
+            }
+            auto hours = digits(text, at, 2);
+            auto minutes = at < text.size() && text[at++] == ':'
+                               ? digits(text, at, 2)
+                               : std::nullopt;
+            if (!hours || !minutes || *hours > 23 || *minutes > 59) {
+                return std::nullopt;
+            }
+            seconds = *hours * 3600 + *minutes * 60;
+            if (at < text.size() && text[at] == ':') {
+                ++at;
+                auto parsed = digits(text, at, 2);
+                if (!parsed || *parsed > 60) {
+                    return std::nullopt;
+                }
+                seconds += *parsed;
+                if (at < text.size() && text[at] == '.') {
+                    auto scale = 100000;
+                    for (++at; at < text.size() && text[at] >= '0' &&
+                               text[at] <= '9';
+                         ++at, scale /= 10) {
+                        fraction += std::chrono::microseconds{
+                            (text[at] - '0') * scale};
+                    }
+                }
+            }
+            // The time zone designator is required with a time.
+            if (at == text.size()) {
+                return std::nullopt;
+            }
+            auto sign = text[at++];
+            if (sign == '+' || sign == '-') {
+                auto zone_hours = digits(text, at, 2);
+                auto zone_minutes = at < text.size() && text[at++] == ':'
+                                        ? digits(text, at, 2)
+                                        : std::nullopt;
+                if (!zone_hours || !zone_minutes) {
+                    return std::nullopt;
+                }
+                auto offset = *zone_hours * 3600 + *zone_minutes * 60;
+                seconds -= sign == '+' ? offset : -offset;
+            } else if (sign != 'Z') {
+                return std::nullopt;
+            }
+            if (at != text.size()) {
+                return std::nullopt;
+            }
+        }
+        seconds += days_from_civil(*year, month, day) * 86400;
+        return std::chrono::system_clock::time_point{
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::seconds{seconds} + fraction)};
+    }
+
+    SitemapParser::SitemapParser(Callback on_url, Callback on_sitemap)
+        : on_url_{std::move(on_url)}, on_sitemap_{std::move(on_sitemap)} {}
+
+    void SitemapParser::write(std::string_view chunk) {
+        this->pending_.append(chunk);
+        this->parse();
+    }
+
+    void SitemapParser::finish() {
+        if (this->in_entry_ ||
+            this->pending_.find('<') != std::string::npos) {
+            throw sitemap_exception("incomplete sitemap");
+        }
+        this->pending_.clear();
+    }
+
+    void SitemapParser::parse() {
+        std::string_view pending = this->pending_;
+        std::size_t i = 0;
+        while (i < pending.size()) {
+            auto open = pending.find('<', i);
+            if (open == std::string_view::npos) {
+                // Hold back a character reference split across chunks.
+                auto end = pending.size();
+                auto amp = pending.rfind('&');
+                if (amp != std::string_view::npos && amp >= i &&
+                    pending.find(';', amp) == std::string_view::npos &&
+                    pending.size() - amp < 16) {
+                    end = amp;
+                }
+                this->text(Html::decode_entities(pending.substr(i, end - i)));
+                i = end;
+                break;
+            }
+            this->text(Html::decode_entities(pending.substr(i, open - i)));
+            i = open;
+
+            // Every construct ends with '>', so a prefix without one may
+            // still become a comment or a CDATA section.
+            auto end = pending.find('>', i);
+            if (end == std::string_view::npos) {
+                break;
+            }
+            if (starts_with(pending, i, "<!--")) {
+                end = pending.find("-->", i + 4);
+                if (end == std::string_view::npos) {
+                    break;
+                }
+                end += 3;
+            } else if (starts_with(pending, i, "<![CDATA[")) {
+                end = pending.find("]]>", i + 9);
+                if (end == std::string_view::npos) {
+                    break;
+                }
+                this->text(pending.substr(i + 9, end - i - 9));
+                end += 3;
+            } else {
+                auto tag = pending.substr(i + 1, end - i - 1);
+                ++end;
+                if (tag.empty() || tag[0] == '?' || tag[0] == '!') {
+                    // Declarations, doctypes and processing instructions.
+                } else if (tag[0] == '/') {
+                    this->end_tag(local_name(tag.substr(1)));
+                } else {
+                    auto name = local_name(tag);
+                    this->start_tag(name);
+                    if (tag.back() == '/') {
+                        this->end_tag(name);
+                    }
+                }
+            }
+            i = end;
+        }
+        this->pending_.erase(0, i);
+        if (this->pending_.size() > max_pending) {
+            throw sitemap_exception("unterminated markup in sitemap");
+        }
+    }
+
+    void SitemapParser::start_tag(std::string_view name) {
+        if (name == "url" || name == "sitemap") {
+            this->in_entry_ = true;
+            this->in_url_ = name == "url";
+            this->entry_ = SitemapEntry{};
+        } else if (this->in_entry_ && name == "loc") {
+            this->field_ = Field::loc;
+            this->value_.clear();
+        } else if (this->in_entry_ && name == "lastmod") {
+            this->field_ = Field::lastmod;
+            this->value_.clear();
+        }
+    }
+
+    void SitemapParser::end_tag(std::string_view name) {
+        if (this->field_ == Field::loc && name == "loc") {
+            this->entry_.loc = std::string{trim(this->value_)};
+            this->field_ = Field::none;
+        } else if (this->field_ == Field::lastmod && name == "lastmod") {
+            this->entry_.lastmod = parse_w3c_datetime(this->value_);
+            this->field_ = Field::none;
+        } else if (
+            this->in_entry_ &&
+            (name == "url" || name == "sitemap")) {
+            this->in_entry_ = false;
+            this->field_ = Field::none;
+            if (!this->entry_.loc.empty()) {
+                auto& callback =
+                    this->in_url_ ? this->on_url_ : this->on_sitemap_;
+                callback(std::move(this->entry_));
+            }
+        }
+    }
+
+    void SitemapParser::text(std::string_view text) {
+        if (this->field_ == Field::none || text.empty()) {
+            return;
+        }
+        if (this->value_.size() + text.size() > max_value) {
+            throw sitemap_exception("sitemap value too long");
+        }
+        this->value_.append(text);
+    }
+
+    GzipStream::GzipStream(Callback on_data) : on_data_{std::move(on_data)} {}
+
+    GzipStream::~GzipStream() {
+        if (this->inflating_) {
+            inflateEnd(&this->stream_);
+        }
+    }
+
+    void GzipStream::write(std::string_view chunk) {
+        if (this->format_ == Format::unknown) {
+            this->header_.append(chunk);
+            if (this->header_.size() < 2) {
+                return;
+            }
+            auto gzip = static_cast<unsigned char>(this->header_[0]) == 0x1f &&
+                        static_cast<unsigned char>(this->header_[1]) == 0x8b;
+            this->format_ = gzip ? Format::gzip : Format::plain;
+            if (gzip) {
+                if (inflateInit2(&this->stream_, 15 + 16) != Z_OK) {
+                    throw sitemap_exception("cannot initialize zlib");
+                }
+                this->inflating_ = true;
+            }
+            auto header = std::move(this->header_);
+            this->header_.clear();
+            this->write(header);
+            return;
+        }
+        if (this->format_ == Format::plain) {
+            this->on_data_(chunk);
+        } else {
+            this->inflate(chunk);
+        }
+    }
+
+    void GzipStream::finish() {
+        if (this->format_ == Format::unknown && !this->header_.empty()) {
+            this->format_ = Format::plain;
+            this->on_data_(this->header_);
+        }
+        if (this->format_ == Format::gzip && !this->ended_) {
+            throw sitemap_exception("truncated gzip stream");
+        }
+    }
+
+    void GzipStream::inflate(std::string_view chunk) {
+        char buffer[64 * 1024];
+        while (!chunk.empty()) {
+            if (this->ended_) {
+                // Concatenated gzip members form one stream.
+                if (static_cast<unsigned char>(chunk[0]) != 0x1f) {
+                    return;
+                }
+                inflateReset(&this->stream_);
+                this->ended_ = false;
+            }
+            auto size = std::min<std::size_t>(chunk.size(), UINT_MAX);
+            this->stream_.next_in =
+                reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+            this->stream_.avail_in = static_cast<uInt>(size);
+            int status;
+            do {
+                this->stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+                this->stream_.avail_out = sizeof(buffer);
+                status = ::inflate(&this->stream_, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END &&
+                    status != Z_BUF_ERROR) {
+                    throw sitemap_exception("corrupt gzip stream");
+                }
+                auto produced = sizeof(buffer) - this->stream_.avail_out;
+                if (produced > 0) {
+                    this->on_data_(std::string_view{buffer, produced});
+                }
+            } while (status == Z_OK && this->stream_.avail_out == 0);
+            chunk.remove_prefix(size - this->stream_.avail_in);
+            if (status == Z_STREAM_END) {
+                this->ended_ = true;
+            } else if (this->stream_.avail_in != 0) {
+                throw sitemap_exception("corrupt gzip stream");
+            }
+        }
+    }
+
+    SitemapLoader::SitemapLoader(
+        std::shared_ptr<Transport> transport, SitemapOptions options)
+        : transport_{std::move(transport)}, options_{options} {
+        this->options_.batch_size = std::max<std::size_t>(
+            this->options_.batch_size, 1);
+    }
+
+    SitemapStats
+    SitemapLoader::load(const std::string& url, const Enqueue& enqueue) {
+        SitemapStats stats;
+        std::vector<Request> batch;
+        auto flush = [&batch, &enqueue] {
+            if (!batch.empty()) {
+                enqueue(std::move(batch));
+                batch = {};
+            }
+        };
+        const auto& since = this->options_.modified_since;
+        auto on_url = [&](SitemapEntry&& entry) {
+            if (since && (entry.lastmod ? *entry.lastmod < *since
+                                        : !this->options_.keep_undated)) {
+                ++stats.skipped_urls;
+                return;
+            }
+            batch.emplace_back(Url{std::move(entry.loc)});
+            ++stats.urls;
+            if (batch.size() >= this->options_.batch_size) {
+                flush();
+            }
+        };
+
+        std::deque<std::pair<std::string, std::size_t>> queue{{url, 0}};
+        std::unordered_set<std::string> seen{url_fingerprint(url)};
+        while (!queue.empty()) {
+            auto [current, depth] = std::move(queue.front());
+            queue.pop_front();
+            ++stats.sitemaps;
+            // An index's lastmod is its sitemaps' latest change.
+            auto on_sitemap = [&, depth = depth](SitemapEntry&& entry) {
+                if (depth >= this->options_.max_depth ||
+                    seen.size() >= this->options_.max_sitemaps ||
+                    (since && entry.lastmod && *entry.lastmod < *since)) {
+                    return;
+                }
+                if (seen.insert(url_fingerprint(entry.loc)).second) {
+                    queue.emplace_back(std::move(entry.loc), depth + 1);
+                }
+            };
+            SitemapParser parser{on_url, on_sitemap};
+            GzipStream gzip{
+                [&parser](std::string_view data) { parser.write(data); }};
+
+            // Exceptions must not unwind through the transport, the body
+            // callback aborts the transfer instead.
+            auto failed = false;
+            std::exception_ptr error;
+            auto response = this->transport_->fetch_stream(
+                Request{Url{current}}, [&](std::string_view chunk) {
+                    try {
+                        gzip.write(chunk);
+                        return true;
+                    } catch (const sitemap_exception&) {
+                        failed = true;
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    return false;
+                });
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            if (!failed && response.error.code == cpr::ErrorCode::OK &&
+                response.status_code >= 200 && response.status_code < 300) {
+                try {
+                    gzip.finish();
+                    parser.finish();
+                } catch (const sitemap_exception&) {
+                    failed = true;
+                }
+            } else {
+                failed = true;
+            }
+            stats.failed_sitemaps += failed;
+        }
+        flush();
+        return stats;
+    }
+} // namespace Scrapp
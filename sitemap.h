@@ -0,0 +1,157 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_SITEMAP_H
+#define SCRAPP_SITEMAP_H
+
+#include "request.h"
+#include "transport.h"
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+
+namespace Scrapp {
+    struct SitemapEntry {
+        std::string loc;
+        std::optional<std::chrono::system_clock::time_point> lastmod;
+    };
+
+    // Push parser of sitemaps and sitemap indexes (sitemaps.org), fed the
+    // document in chunks of any size. Only the construct being parsed is
+    // buffered, so memory does not grow with the document. Namespace
+    // prefixes are ignored and entities and CDATA sections in values are
+    // decoded.
+    class SitemapParser {
+      public:
+        using Callback = std::function<void(SitemapEntry&&)>;
+
+        // on_url gets the <url> entries of sitemaps, on_sitemap the
+        // <sitemap> entries of indexes.
+        SitemapParser(Callback on_url, Callback on_sitemap);
+
+        // Throws sitemap_exception on malformed documents.
+        void write(std::string_view chunk);
+        // Throws sitemap_exception if the document is incomplete.
+        void finish();
+
+      private:
+        enum class Field { none, loc, lastmod };
+
+        // Consumes pending_ up to the last complete construct.
+        void parse();
+        void start_tag(std::string_view name);
+        void end_tag(std::string_view name);
+        void text(std::string_view text);
+
+        Callback on_url_;
+        Callback on_sitemap_;
+        std::string pending_;
+        // Inside <url> or <sitemap>.
+        bool in_entry_{false};
+        bool in_url_{false};
+        Field field_{Field::none};
+        std::string value_;
+        SitemapEntry entry_;
+    };
+
+    // Decompresses gzip streams chunk by chunk and passes anything else
+    // through, telling them apart by their first bytes.
+    class GzipStream {
+      public:
+        using Callback = std::function<void(std::string_view)>;
+
+        explicit GzipStream(Callback on_data);
+        GzipStream(const GzipStream&) = delete;
+        GzipStream& operator=(const GzipStream&) = delete;
+        ~GzipStream();
+
+        // Throws sitemap_exception on corrupt data.
+        void write(std::string_view chunk);
+        // Throws sitemap_exception if a gzip stream is truncated.
+        void finish();
+
+      private:
+        void inflate(std::string_view chunk);
+
+        Callback on_data_;
+        // Bytes held until the format is known.
+        std::string header_;
+        enum class Format { unknown, plain, gzip } format_{Format::unknown};
+        z_stream stream_{};
+        bool inflating_{false};
+        bool ended_{false};
+    };
+
+    // Parses "2004", "2004-12", "2004-12-23" and "2004-12-23T18:00:15+01:00"
+    // W3C datetimes, with optional fractions of a second.
+    std::optional<std::chrono::system_clock::time_point>
+    parse_w3c_datetime(std::string_view text);
+
+    struct SitemapOptions {
+        // Only URLs modified at or after this time are enqueued.
+        std::optional<std::chrono::system_clock::time_point> modified_since;
+        // Whether URLs without lastmod pass modified_since.
+        bool keep_undated{true};
+        // URLs per enqueued batch.
+        std::size_t batch_size{10000};
+        // Levels of sitemap indexes followed.
+        std::size_t max_depth{3};
+        std::size_t max_sitemaps{100000};
+    };
+
+    struct SitemapStats {
+        std::size_t sitemaps{};
+        std::size_t failed_sitemaps{};
+        std::size_t urls{};
+        // URLs left out by modified_since.
+        std::size_t skipped_urls{};
+    };
+
+    // Streams sitemaps, gzipped or not, from a Transport and following
+    // sitemap indexes, and hands their URLs over in batches.
+    class SitemapLoader {
+      public:
+        using Enqueue = std::function<void(std::vector<Request>&&)>;
+
+        explicit SitemapLoader(
+            std::shared_ptr<Transport> transport =
+                std::make_shared<HttpTransport>(),
+            SitemapOptions options = {});
+
+        // Loads url and the sitemaps it indexes, calling enqueue with every
+        // batch. Sitemaps that fail to download or parse are counted and
+        // skipped.
+        SitemapStats load(const std::string& url, const Enqueue& enqueue);
+
+      private:
+        std::shared_ptr<Transport> transport_;
+        SitemapOptions options_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_SITEMAP_H
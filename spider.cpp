@@ -22,24 +22,25 @@
 // SOFTWARE.
 
 #include "spider.h"
-#include <cpr/cpr.h>
+#include "utils.h"
+#include <algorithm>
 #include <future>
+#include <iterator>
+#include <optional>
 
 void Scrapp::Spider::start() {
     if (!this->running()) {
         this->running_ = true;
-        this->request_added_.connect([this](const Request& request) {
-            this->on_request_added_(request);
-        });
         this->request_finished_.connect(
             [this](const Request& request, const Response& response) {
                 this->on_request_finished_(request, response);
             });
     }
-    for (; !this->request_queue_.empty(); this->request_queue_.pop_front()) {
-        auto front = this->request_queue_.front();
-        this->request_added_(front);
-    }
+    this->frontier_->push(std::vector<Request>(
+        std::make_move_iterator(this->request_queue_.begin()),
+        std::make_move_iterator(this->request_queue_.end())));
+    this->request_queue_.clear();
+    this->dispatch_();
 }
 
 void Scrapp::Spider::add_request(const std::string& url) {
@@ -48,10 +49,49 @@ void Scrapp::Spider::add_request(const std::string& url) {
 }
 
 void Scrapp::Spider::add_request(const Scrapp::Request& request) {
-    this->request_queue_.push_back(request);
-    if (this->running()) {
-        this->request_added_(request);
+    if (!this->running()) {
+        this->request_queue_.push_back(request);
+        return;
+    }
+    this->frontier_->push(request);
+    this->dispatch_();
+}
+
+void Scrapp::Spider::add_requests(const std::vector<Request>& requests) {
+    this->add_requests(std::vector<Request>(requests));
+}
+
+void Scrapp::Spider::add_requests(std::vector<Request>&& requests) {
+    if (!this->running()) {
+        this->request_queue_.insert(
+            this->request_queue_.end(),
+            std::make_move_iterator(requests.begin()),
+            std::make_move_iterator(requests.end()));
+        return;
     }
+    this->frontier_->push(std::move(requests));
+    this->dispatch_();
+}
+
+Scrapp::SitemapStats Scrapp::Spider::add_sitemap(
+    const std::string& url, const SitemapOptions& options) {
+    SitemapLoader loader{this->transport_, options};
+    return loader.load(url, [this](std::vector<Request>&& requests) {
+        this->add_requests(std::move(requests));
+    });
+}
+
+void Scrapp::Spider::follow_links(
+    const Scrapp::Response& response,
+    const Scrapp::Html::LinkExtractor& extractor) {
+    std::vector<Request> requests;
+    extractor.for_each_link(
+        response.text, response.url.str(),
+        [&requests, &response](std::string url) {
+            requests.emplace_back(Scrapp::Url(std::move(url)))
+                .set_depth(response.depth + 1);
+        });
+    this->add_requests(std::move(requests));
 }
 
 const std::deque<Scrapp::Request>&
@@ -59,32 +99,201 @@ Scrapp::Spider::request_queue() const noexcept {
     return this->request_queue_;
 }
 
-void Scrapp::Spider::on_request_added_(const Scrapp::Request& request) {
-    asio::post(this->thread_pool_, [this, request]() {
-        auto params = cpr::Parameters{};
-        for (const auto& [key, value] : request.parameters()) {
-            params.Add({key, value});
+void Scrapp::Spider::dispatch_() {
+    std::lock_guard lock{this->dispatch_mutex_};
+    while (this->in_flight_ < this->max_in_flight_) {
+        auto request = this->frontier_->pop();
+        if (!request) {
+            break;
         }
-        auto headers = cpr::Header{};
-        for (const auto& [key, value] : request.headers()) {
-            headers[key] = value;
+        ++this->in_flight_;
+        asio::post(
+            this->thread_pool_, [this, request = std::move(*request)]() {
+                this->schedule_(request);
+            });
+    }
+}
+
+void Scrapp::Spider::release_() {
+    {
+        std::lock_guard lock{this->dispatch_mutex_};
+        --this->in_flight_;
+    }
+    this->dispatch_();
+}
+
+void Scrapp::Spider::schedule_(const Scrapp::Request& request) {
+    if (this->duplicate_filter_ != nullptr &&
+        this->duplicate_filter_->skip(request.full_url())) {
+        this->release_();
+        return;
+    }
+    if (this->robots_ == nullptr) {
+        this->fetch_(request);
+        this->release_();
+        return;
+    }
+    auto url = request.full_url();
+    auto rules = this->robots_->rules(url);
+    if (!rules->allowed(url_target(url))) {
+        this->release_();
+        return;
+    }
+    auto delay = rules->crawl_delay();
+    if (!delay || delay->count() == 0) {
+        this->fetch_(request);
+        this->release_();
+        return;
+    }
+    // Requests wait in their origin's queue for its next slot, and the
+    // origin's timer fetches them in turn.
+    auto origin = url_origin(url);
+    auto now = std::chrono::steady_clock::now();
+    bool ready = false;
+    {
+        std::lock_guard lock{this->delayed_hosts_mutex_};
+        auto& host = this->delayed_hosts_[origin];
+        host.delay = *delay;
+        if (host.waiting.empty() && host.next <= now) {
+            host.next = now + *delay;
+            ready = true;
+        } else {
+            host.waiting.push_back(request);
+            if (host.waiting.size() == 1) {
+                this->arm_(origin, host);
+            }
+        }
+    }
+    if (ready) {
+        this->fetch_(request);
+    }
+    this->release_();
+}
+
+void Scrapp::Spider::arm_(const std::string& origin, const DelayedHost& host) {
+    auto timer = std::make_shared<asio::steady_timer>(this->thread_pool_);
+    timer->expires_at(host.next);
+    timer->async_wait([this, origin, timer](const auto& error) {
+        if (!error) {
+            this->fetch_delayed_(origin);
         }
-        auto c_res = cpr::Get(cpr::Url{request.url()}, params, headers);
-        this->request_finished_(request, Scrapp::Response(c_res));
     });
 }
 
+void Scrapp::Spider::fetch_delayed_(const std::string& origin) {
+    std::optional<Request> request;
+    {
+        std::lock_guard lock{this->delayed_hosts_mutex_};
+        auto& host = this->delayed_hosts_[origin];
+        request = std::move(host.waiting.front());
+        host.waiting.pop_front();
+        host.next = std::chrono::steady_clock::now() + host.delay;
+        if (!host.waiting.empty()) {
+            this->arm_(origin, host);
+        }
+    }
+    this->fetch_(*request);
+}
+
+void Scrapp::Spider::fetch_(const Scrapp::Request& request) {
+    FetchOptions options;
+    options.keep_body = this->warc_writer_ != nullptr;
+    auto response = this->transport_->fetch(request, options);
+    response.depth = request.depth();
+    this->archive_(request, response);
+    this->request_finished_(request, response);
+}
+
+void Scrapp::Spider::archive_(
+    const Scrapp::Request& request, const Scrapp::Response& response) {
+    if (this->warc_writer_ == nullptr) {
+        return;
+    }
+    try {
+        this->warc_writer_->write(request, response);
+    } catch (const warc_exception&) {
+        // The writer keeps the error, wait() reports it.
+    }
+}
+
 void Scrapp::Spider::on_request_finished_(
     const Scrapp::Request& request, const Scrapp::Response& response) {
     asio::post(this->thread_pool_, [this, request, response]() {
+        if (this->recrawl_scheduler_ != nullptr &&
+            response.error.code == cpr::ErrorCode::OK) {
+            this->recrawl_scheduler_->observe(response);
+            if (response.status_code == 304) {
+                return;
+            }
+        }
+        if (this->duplicate_filter_ != nullptr &&
+            response.error.code == cpr::ErrorCode::OK &&
+            !response.text.empty() &&
+            this->duplicate_filter_->check(response)) {
+            return;
+        }
         this->parse(response);
     });
 }
 
+Scrapp::ItemPipeline& Scrapp::Spider::pipeline() noexcept {
+    return this->pipeline_;
+}
+
+void Scrapp::Spider::emit(Scrapp::Item item) {
+    try {
+        this->pipeline_.emit(std::move(item));
+    } catch (const item_pipeline_exception&) {
+        // The pipeline keeps the error, wait() reports it.
+    }
+}
+
+void Scrapp::Spider::set_transport(
+    std::shared_ptr<Transport> transport) noexcept {
+    this->transport_ = std::move(transport);
+}
+
+void Scrapp::Spider::set_warc_writer(
+    std::shared_ptr<WarcWriter> writer) noexcept {
+    this->warc_writer_ = std::move(writer);
+}
+
+void Scrapp::Spider::set_duplicate_filter(
+    std::shared_ptr<DuplicateFilter> filter) noexcept {
+    this->duplicate_filter_ = std::move(filter);
+}
+
+void Scrapp::Spider::set_recrawl_scheduler(
+    std::shared_ptr<RecrawlScheduler> scheduler) noexcept {
+    this->recrawl_scheduler_ = std::move(scheduler);
+}
+
+void Scrapp::Spider::set_robots(
+    std::shared_ptr<RobotsCache> robots) noexcept {
+    this->robots_ = std::move(robots);
+}
+
+void Scrapp::Spider::set_frontier(
+    std::shared_ptr<Frontier> frontier) noexcept {
+    this->frontier_ = std::move(frontier);
+}
+
+void Scrapp::Spider::enqueue_recrawls(std::size_t limit) {
+    if (this->recrawl_scheduler_ != nullptr) {
+        this->add_requests(
+            this->recrawl_scheduler_->due(
+                std::chrono::system_clock::now(), limit));
+    }
+}
+
 void Scrapp::Spider::wait() {
     this->work_guard_.reset();
     this->thread_pool_.join();
     this->running_ = false;
+    this->pipeline_.flush();
+    if (this->warc_writer_ != nullptr) {
+        this->warc_writer_->flush();
+    }
 }
 
 void Scrapp::Spider::stop() {
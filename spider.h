@@ -23,12 +23,24 @@
 #ifndef SCRAPP_SPIDER_H
 #define SCRAPP_SPIDER_H
 
+#include "frontier.h"
+#include "near_duplicates.h"
+#include "pipeline.h"
+#include "recrawl.h"
 #include "request.h"
 #include "response.h"
+#include "robots.h"
+#include "sitemap.h"
+#include "transport.h"
+#include "warc.h"
 #include <boost/asio.hpp>
 #include <boost/signals2.hpp>
+#include <chrono>
 #include <deque>
+#include <limits>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace asio = boost::asio;
@@ -39,30 +51,112 @@ namespace Scrapp {
       private:
         bool running_ = false;
         std::vector<Request> _requests;
+        // Requests added before start(), moved to frontier_ by it.
         std::deque<Request> request_queue_;
-        signals::signal<void(const Request&)> request_added_;
-        void on_request_added_(const Request& request);
+        std::shared_ptr<Frontier> frontier_{std::make_shared<Frontier>()};
+        // Requests popped from frontier_ and not fetched yet, at most
+        // max_in_flight_. The rest wait in frontier_ in order of score.
+        std::size_t in_flight_{};
+        std::size_t max_in_flight_;
+        std::mutex dispatch_mutex_;
+        void dispatch_();
+        void release_();
+        void schedule_(const Request& request);
         signals::signal<void(const Request&, const Response&)>
             request_finished_;
         void
         on_request_finished_(const Request& request, const Response& response);
         std::size_t thread_count_;
+        ItemPipeline pipeline_;
+        std::shared_ptr<Transport> transport_{
+            std::make_shared<HttpTransport>()};
+        std::shared_ptr<WarcWriter> warc_writer_;
+        std::shared_ptr<DuplicateFilter> duplicate_filter_;
+        std::shared_ptr<RecrawlScheduler> recrawl_scheduler_;
+        std::shared_ptr<RobotsCache> robots_;
+        // An origin with a Crawl-delay. Its requests wait here, holding no
+        // slot of max_in_flight_, and are fetched one at a time by a single
+        // timer, so a slow host only ever holds up its own requests.
+        struct DelayedHost {
+            std::deque<Request> waiting;
+            // Earliest time of the next fetch.
+            std::chrono::steady_clock::time_point next;
+            std::chrono::milliseconds delay{};
+        };
+        std::unordered_map<std::string, DelayedHost> delayed_hosts_;
+        std::mutex delayed_hosts_mutex_;
+        void arm_(const std::string& origin, const DelayedHost& host);
+        void fetch_delayed_(const std::string& origin);
+        void fetch_(const Request& request);
+        void archive_(const Request& request, const Response& response);
+        // Declared last so that the pool is joined before the members its
+        // handlers use are destroyed.
         asio::thread_pool thread_pool_;
         asio::executor_work_guard<asio::thread_pool::executor_type> work_guard_;
 
       public:
         explicit Spider(std::size_t thread_count = 8)
-            : thread_count_{thread_count}, thread_pool_{thread_count_},
+            : max_in_flight_{2 * thread_count}, thread_count_{thread_count},
+              thread_pool_{thread_count_},
               work_guard_{asio::make_work_guard(thread_pool_)} {}
 
         virtual ~Spider() = default;
 
         void add_request(const std::string& url);
         void add_request(const Request& request); // TODO Maybe change const ref
+        void add_requests(const std::vector<Request>& requests);
+        void add_requests(std::vector<Request>&& requests);
+        // Adds [first, last), pass move iterators to move the requests.
+        template<class Iterator>
+        void add_requests(Iterator first, Iterator last) {
+            this->add_requests(std::vector<Request>(first, last));
+        }
+        // Streams the sitemap or sitemap index at url into the queue in
+        // batches, fetching through the transport. Blocks until loaded.
+        SitemapStats
+        add_sitemap(const std::string& url, const SitemapOptions& options = {});
+        // Queues a GET request for every link of response, one level
+        // deeper than it.
+        void follow_links(
+            const Response& response,
+            const Html::LinkExtractor& extractor = Html::LinkExtractor{});
+        // Requests added and not started yet, empty after start().
         const std::deque<Request>& request_queue() const noexcept;
 
         virtual void parse(Scrapp::Response result) = 0;
 
+        // Stages and sinks the items emitted from parse() go through. Add
+        // them before start().
+        ItemPipeline& pipeline() noexcept;
+        // Thread safe, see ItemPipeline::emit. Once a sink failed, items
+        // are dropped and wait() rethrows the error.
+        void emit(Item item);
+        // Where responses come from, HttpTransport unless set. Set before
+        // start().
+        void set_transport(std::shared_ptr<Transport> transport) noexcept;
+        // Records every exchange before it is parsed. Set before start().
+        void set_warc_writer(std::shared_ptr<WarcWriter> writer) noexcept;
+        // Pages nearly duplicating an earlier page are not parsed, and
+        // requests to URL patterns that keep producing them are not
+        // fetched. Set before start().
+        void
+        set_duplicate_filter(std::shared_ptr<DuplicateFilter> filter) noexcept;
+        // Observes every response, and skips parsing the 304 responses to
+        // the conditional requests of enqueue_recrawls(). Set before
+        // start().
+        void set_recrawl_scheduler(
+            std::shared_ptr<RecrawlScheduler> scheduler) noexcept;
+        // Requests robots.txt disallows are dropped, and fetches from a
+        // host with a Crawl-delay are spaced by it without blocking a
+        // thread. Set before start().
+        void set_robots(std::shared_ptr<RobotsCache> robots) noexcept;
+        // Orders the requests after start(), a best-first Frontier on
+        // Request::priority unless set. Set before start().
+        void set_frontier(std::shared_ptr<Frontier> frontier) noexcept;
+        // Queues up to limit pages the recrawl scheduler says are due.
+        void enqueue_recrawls(
+            std::size_t limit = std::numeric_limits<std::size_t>::max());
+
         void start();
         void wait();
         void stop();
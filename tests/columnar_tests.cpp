@@ -0,0 +1,153 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "columnar_sink.h"
+#include "exceptions.h"
+#include "test_utils.h"
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <parquet/arrow/reader.h>
+#include <string>
+#include <utility>
+
+namespace {
+    std::shared_ptr<arrow::Table> read_parquet(const std::string& path) {
+        auto file = arrow::io::ReadableFile::Open(path).ValueOrDie();
+        std::unique_ptr<parquet::arrow::FileReader> reader;
+        REQUIRE(parquet::arrow::OpenFile(
+                    file, arrow::default_memory_pool(), &reader)
+                    .ok());
+        std::shared_ptr<arrow::Table> table;
+        REQUIRE(reader->ReadTable(&table).ok());
+        return table;
+    }
+
+    std::shared_ptr<arrow::Table> read_ipc(const std::string& path) {
+        auto file = arrow::io::ReadableFile::Open(path).ValueOrDie();
+        auto reader =
+            arrow::ipc::RecordBatchStreamReader::Open(file).ValueOrDie();
+        return reader->ToTable().ValueOrDie();
+    }
+
+    // The chunk holding row of the column, and the row's index in it.
+    template<typename T>
+    std::pair<std::shared_ptr<T>, std::int64_t>
+    cell(const arrow::Table& table, const std::string& name, std::int64_t row) {
+        auto column = table.GetColumnByName(name);
+        for (int i = 0; i < column->num_chunks(); ++i) {
+            auto chunk = column->chunk(i);
+            if (row < chunk->length()) {
+                return {std::static_pointer_cast<T>(chunk), row};
+            }
+            row -= chunk->length();
+        }
+        FAIL("row out of range");
+        return {};
+    }
+} // namespace
+
+TEST_CASE("ColumnarSink") {
+    auto directory = Scrapp::Tests::temp_directory("scrapp_columnar_sink");
+    Scrapp::ColumnarSinkOptions options;
+    options.row_group_size = 3;
+
+    auto write = [&options] {
+        Scrapp::ItemPipeline pipeline;
+        auto sink = std::make_unique<Scrapp::ColumnarSink>(options);
+        auto* columnar = sink.get();
+        pipeline.add_sink(std::move(sink));
+        for (int i = 0; i < 10; ++i) {
+            pipeline.emit(
+                {{"domain", i % 2 == 0 ? "a.com" : "b.com"},
+                 {"id", i},
+                 {"price", i % 3 == 0 ? boost::json::value(i) : 1.5},
+                 {"tags", {"x"}},
+                 {"sold", i == 4 ? boost::json::value(nullptr) : true}});
+        }
+        auto columns = columnar->columns();
+        pipeline.close();
+        return columns;
+    };
+
+    SECTION("the schema is inferred from the first batch") {
+        options.path = (directory / "items.parquet").string();
+        auto columns = write();
+        REQUIRE(columns.size() == 5);
+        REQUIRE(columns[0].name == "domain");
+        REQUIRE(columns[0].type == Scrapp::ColumnType::string);
+        REQUIRE(columns[0].dictionary);
+        REQUIRE(columns[1].type == Scrapp::ColumnType::int64);
+        REQUIRE(columns[2].type == Scrapp::ColumnType::float64);
+        REQUIRE(columns[3].type == Scrapp::ColumnType::string);
+        REQUIRE(columns[4].type == Scrapp::ColumnType::boolean);
+
+        auto table = read_parquet(options.path);
+        REQUIRE(table->num_rows() == 10);
+        REQUIRE(
+            table->GetColumnByName("domain")->type()->id() ==
+            arrow::Type::DICTIONARY);
+        REQUIRE(table->GetColumnByName("id")->num_chunks() == 4);
+        auto [ids, id] = cell<arrow::Int64Array>(*table, "id", 9);
+        REQUIRE(ids->Value(id) == 9);
+        auto [prices, price] = cell<arrow::DoubleArray>(*table, "price", 3);
+        REQUIRE(prices->Value(price) == 3);
+        auto [tags, tag] = cell<arrow::StringArray>(*table, "tags", 0);
+        REQUIRE(tags->GetString(tag) == "[\"x\"]");
+        auto [sold, sale] = cell<arrow::BooleanArray>(*table, "sold", 4);
+        REQUIRE(sold->IsNull(sale));
+    }
+
+    SECTION("declared schemas ignore other fields") {
+        options.path = (directory / "items.arrows").string();
+        options.format = Scrapp::ColumnarFormat::arrow_ipc;
+        options.columns = {
+            {"id", Scrapp::ColumnType::int64},
+            {"domain", Scrapp::ColumnType::string, true},
+            {"price", Scrapp::ColumnType::int64}};
+        write();
+
+        auto table = read_ipc(options.path);
+        REQUIRE(table->num_rows() == 10);
+        REQUIRE(table->schema()->num_fields() == 3);
+        auto [prices, price] = cell<arrow::Int64Array>(*table, "price", 3);
+        REQUIRE(prices->Value(price) == 3);
+        auto [others, other] = cell<arrow::Int64Array>(*table, "price", 1);
+        REQUIRE(others->IsNull(other));
+        auto [domains, domain] =
+            cell<arrow::DictionaryArray>(*table, "domain", 7);
+        auto dictionary = std::static_pointer_cast<arrow::StringArray>(
+            domains->dictionary());
+        REQUIRE(
+            dictionary->GetString(domains->GetValueIndex(domain)) == "b.com");
+    }
+
+    SECTION("unwritable paths throw right away") {
+        options.path = (directory / "missing" / "items.parquet").string();
+        REQUIRE_THROWS_AS(
+            Scrapp::ColumnarSink{options}, Scrapp::item_pipeline_exception);
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,229 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "frontier.h"
+#include "spider.h"
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    Scrapp::Request request(
+        const std::string& url, double priority = 0, std::size_t depth = 0) {
+        Scrapp::Request request{Scrapp::Url{url}};
+        request.set_priority(priority);
+        request.set_depth(depth);
+        return request;
+    }
+
+    std::vector<std::string> drain(Scrapp::Frontier& frontier) {
+        std::vector<std::string> urls;
+        while (auto request = frontier.pop()) {
+            urls.push_back(request->url());
+        }
+        return urls;
+    }
+
+    // Records the order of fetches.
+    class RecordingTransport : public Scrapp::Transport {
+      public:
+        Scrapp::Response fetch(
+            const Scrapp::Request& request,
+            const Scrapp::FetchOptions& /*options*/) override {
+            std::lock_guard lock{this->mutex};
+            this->fetched.push_back(request.full_url());
+            Scrapp::Response response;
+            response.url = Scrapp::Url{request.full_url()};
+            response.status_code = 200;
+            response.text = R"(<a href="/child">child</a>)";
+            return response;
+        }
+
+        std::mutex mutex;
+        std::vector<std::string> fetched;
+    };
+
+    class FollowingSpider : public Scrapp::Spider {
+      public:
+        FollowingSpider() : Scrapp::Spider{1} {}
+
+        void parse(Scrapp::Response response) override {
+            this->follow_links(response);
+        }
+    };
+} // namespace
+
+TEST_CASE("Frontier") {
+    SECTION("pops by descending priority, ties in push order") {
+        Scrapp::Frontier frontier;
+        REQUIRE(frontier.push(request("http://a/low", -1)));
+        REQUIRE(frontier.push(request("http://a/first", 5)));
+        REQUIRE(frontier.push(request("http://a/mid", 2)));
+        REQUIRE(frontier.push(request("http://a/second", 5)));
+        REQUIRE(frontier.size() == 4);
+        REQUIRE(
+            drain(frontier) ==
+            std::vector<std::string>{
+                "http://a/first", "http://a/second", "http://a/mid",
+                "http://a/low"});
+        REQUIRE(frontier.empty());
+        REQUIRE_FALSE(frontier.pop().has_value());
+    }
+
+    SECTION("matches a sorted order on random scores") {
+        std::mt19937 random{42};
+        std::uniform_int_distribution<int> scores{0, 50};
+        Scrapp::Frontier frontier;
+        std::vector<std::pair<int, std::size_t>> expected;
+        for (std::size_t i = 0; i < 2000; ++i) {
+            auto score = scores(random);
+            expected.emplace_back(-score, i);
+            frontier.push(request("http://a/" + std::to_string(i), score));
+            // Interleave pops to exercise slot reuse.
+            if (i % 7 == 6) {
+                auto popped = frontier.pop();
+                auto best =
+                    std::min_element(expected.begin(), expected.end());
+                REQUIRE(
+                    popped->url() ==
+                    "http://a/" + std::to_string(best->second));
+                expected.erase(best);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        std::vector<std::string> urls;
+        for (const auto& [score, i] : expected) {
+            urls.push_back("http://a/" + std::to_string(i));
+        }
+        REQUIRE(drain(frontier) == urls);
+    }
+
+    SECTION("breadth first and depth limit") {
+        Scrapp::FrontierOptions options;
+        options.scorer = Scrapp::breadth_first_scorer();
+        options.max_depth = 2;
+        Scrapp::Frontier frontier{options};
+        std::vector<Scrapp::Request> requests{
+            request("http://a/2", 100, 2), request("http://a/0", 0, 0),
+            request("http://a/3", 0, 3), request("http://a/1", 0, 1)};
+        REQUIRE(frontier.push(std::move(requests)) == 3);
+        REQUIRE(
+            drain(frontier) ==
+            std::vector<std::string>{"http://a/0", "http://a/1", "http://a/2"});
+        auto stats = frontier.stats();
+        REQUIRE(stats.pushed == 3);
+        REQUIRE(stats.popped == 3);
+        REQUIRE(stats.too_deep == 1);
+    }
+
+    SECTION("pattern boosts and duplicate penalties") {
+        auto boosts = std::make_shared<Scrapp::PatternBoosts>();
+        boosts->set("http://a/products/1", 10);
+        REQUIRE(boosts->boost("http://a/products/977") == 10);
+        REQUIRE(boosts->boost("http://a/about") == 0);
+
+        auto filter = std::make_shared<Scrapp::DuplicateFilter>();
+        filter->check("http://a/tags/1", 0xFFFF);
+        filter->check("http://a/tags/2", 0xFFFF);
+        REQUIRE(filter->duplicate_ratio("http://a/tags/3") == 0.5);
+
+        Scrapp::FrontierOptions options;
+        options.scorer = Scrapp::duplicate_penalty_scorer(
+            filter, 4, Scrapp::pattern_boost_scorer(boosts));
+        Scrapp::Frontier frontier{options};
+        frontier.push(request("http://a/about", 1));
+        frontier.push(request("http://a/tags/3", 0));
+        frontier.push(request("http://a/products/5", 0));
+        REQUIRE(
+            drain(frontier) ==
+            std::vector<std::string>{
+                "http://a/products/5", "http://a/about", "http://a/tags/3"});
+    }
+}
+
+TEST_CASE("Spider frontier") {
+    auto transport = std::make_shared<RecordingTransport>();
+    FollowingSpider spider;
+    spider.set_transport(transport);
+    Scrapp::FrontierOptions options;
+    options.max_depth = 1;
+    spider.set_frontier(std::make_shared<Scrapp::Frontier>(options));
+
+    std::vector<Scrapp::Request> requests;
+    for (int i = 0; i < 6; ++i) {
+        requests.push_back(request("http://a/" + std::to_string(i), i));
+    }
+    spider.add_requests(
+        std::make_move_iterator(requests.begin()),
+        std::make_move_iterator(requests.end()));
+    REQUIRE(spider.request_queue().size() == 6);
+    spider.start();
+    REQUIRE(spider.request_queue().empty());
+    spider.wait();
+
+    // Higher priorities first, then the links found one level deeper, which
+    // the depth limit keeps from being followed again.
+    REQUIRE(transport->fetched.size() == 12);
+    REQUIRE(
+        std::vector<std::string>(
+            transport->fetched.begin(), transport->fetched.begin() + 2) ==
+        std::vector<std::string>{"http://a/5", "http://a/4"});
+    REQUIRE(std::is_sorted(
+        transport->fetched.begin(), transport->fetched.begin() + 6,
+        std::greater<>{}));
+    REQUIRE(std::all_of(
+        transport->fetched.begin() + 6, transport->fetched.end(),
+        [](const std::string& url) { return url == "http://a/child"; }));
+}
+
+TEST_CASE("Frontier benchmarks", "[.][benchmark]") {
+    std::vector<Scrapp::Request> requests;
+    std::mt19937 random{7};
+    std::uniform_real_distribution<double> priorities{0, 1};
+    for (int i = 0; i < 100000; ++i) {
+        requests.push_back(request(
+            "http://example.com/" + std::to_string(i), priorities(random)));
+    }
+
+    BENCHMARK("push 100000 requests in bulk and pop them") {
+        Scrapp::Frontier frontier;
+        frontier.push(std::vector<Scrapp::Request>(requests));
+        std::size_t popped = 0;
+        while (frontier.pop()) {
+            ++popped;
+        }
+        return popped;
+    };
+
+    BENCHMARK("push 100000 requests one by one") {
+        Scrapp::Frontier frontier;
+        for (const auto& request : requests) {
+            frontier.push(request);
+        }
+        return frontier.size();
+    };
+}
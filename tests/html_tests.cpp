@@ -20,11 +20,28 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "html/batch.h"
 #include "html/document.h"
+#include "html/document_index.h"
+#include "html/document_pool.h"
 #include "html/element.h"
 #include "html/html_exceptions.h"
+#include "html/link_extractor.h"
+#include "html/matcher.h"
+#include "html/partial_parser.h"
+#include "html/schema.h"
+#include "html/selector.h"
+#include "html/tag_scanner.h"
+#include "html/text.h"
 #include "html/types.h"
+#include "html/xpath.h"
+#include "utils.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
 
 using namespace Scrapp;
 using namespace Scrapp::Html;
@@ -265,4 +282,816 @@ TEST_CASE("HtmlDocument") {
         REQUIRE(!found.empty());
         REQUIRE(found.size() == 1);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("HtmlDocument sources") {
+    SECTION("accepts a string_view that only lives during construction") {
+        std::optional<HtmlDocument> document;
+        {
+            std::string html = "<p>temporary</p>";
+            document.emplace(std::string_view{html});
+        }
+        REQUIRE(document->first("p")->text() == "temporary");
+        REQUIRE(document->source().empty());
+    }
+
+    SECTION("keeps a shared buffer alive and exposes it") {
+        auto html = std::make_shared<const std::string>("<p>shared</p>");
+        HtmlDocument document{html};
+        REQUIRE(document.source() == "<p>shared</p>");
+        REQUIRE(document.source().data() == html->data());
+    }
+}
+
+TEST_CASE("HtmlElement lifetime") {
+    SECTION("elements keep their document alive") {
+        std::vector<HtmlElement> links;
+        {
+            HtmlDocument document{
+                R"(<a href="/one" class="x">one</a><a href="/two">two</a>)"};
+            links = document.css("a");
+        }
+        REQUIRE(links.size() == 2);
+        REQUIRE(links[0].attribute("href") == "/one");
+        REQUIRE(links[1].text() == "two");
+        REQUIRE(links[1].tag_name() == "a");
+    }
+
+    SECTION("::attribute returns nullopt for missing attributes") {
+        HtmlDocument document{R"(<div id="42" hidden>hey</div>)"};
+        auto div = document.css("div")[0];
+        REQUIRE(div.attribute("id") == "42");
+        REQUIRE(div.attribute("hidden") == "");
+        REQUIRE_FALSE(div.attribute("class").has_value());
+        REQUIRE(div.has_attribute("hidden"));
+    }
+}
+
+TEST_CASE("Streaming matches") {
+    std::string html = R"(<ul><li id="a">1</li><li id="b">2</li>)"
+                       R"(<li id="c">3</li></ul>)";
+    HtmlDocument document{html};
+
+    SECTION("::for_each_match visits every match") {
+        std::vector<std::string> ids;
+        document.for_each_match("li", [&ids](const HtmlElement& element) {
+            ids.emplace_back(*element.attribute("id"));
+        });
+        REQUIRE(ids == std::vector<std::string>{"a", "b", "c"});
+    }
+
+    SECTION("::for_each_match stops when the visitor returns false") {
+        int visited = 0;
+        document.for_each_match("li", [&visited](const HtmlElement&) {
+            visited++;
+            return false;
+        });
+        REQUIRE(visited == 1);
+    }
+
+    SECTION("::for_each_match reports each element once for selector lists") {
+        int visited = 0;
+        document.for_each_match(
+            "li, #b, ul li", [&visited](const HtmlElement&) { visited++; });
+        REQUIRE(visited == 3);
+    }
+
+    SECTION("::for_each_match rethrows visitor exceptions") {
+        REQUIRE_THROWS_AS(
+            document.for_each_match(
+                "li",
+                [](const HtmlElement&) { throw attribute_error("stop"); }),
+            attribute_error);
+    }
+
+    SECTION("::first returns the first match or nothing") {
+        REQUIRE(document.first("li")->attribute("id") == "a");
+        REQUIRE_FALSE(document.first("table").has_value());
+        REQUIRE(document.body().first("#c")->text() == "3");
+    }
+
+    SECTION("::matches is an iterable range of elements") {
+        auto matches = document.matches("li");
+        REQUIRE(matches.size() == 3);
+        std::string text;
+        for (const auto& element : matches) {
+            text += element.text();
+        }
+        REQUIRE(text == "123");
+    }
+}
+
+TEST_CASE("CompiledSelector") {
+    SECTION("can be reused across documents") {
+        CompiledSelector selector{"div.price"};
+        HtmlDocument first{"<div class=\"price\">10</div>"};
+        HtmlDocument second{"<p><div class=\"price\">20</div></p>"};
+        REQUIRE(first.css(selector)[0].text() == "10");
+        REQUIRE(second.css(selector)[0].text() == "20");
+        REQUIRE(second.body().css(selector).size() == 1);
+    }
+
+    SECTION("throws selector_error on invalid selectors") {
+        REQUIRE_THROWS_AS(CompiledSelector{"div["}, selector_error);
+    }
+
+    SECTION("string overloads of ::css return empty list on invalid "
+            "selectors") {
+        HtmlDocument document{"<div></div>"};
+        REQUIRE(document.css("div[").empty());
+    }
+}
+
+TEST_CASE("SelectorCache") {
+    SECTION("returns the same compiled selector for repeated lookups") {
+        SelectorCache cache{4};
+        auto first = cache.get("a[href]");
+        auto second = cache.get("a[href]");
+        REQUIRE(first == second);
+        REQUIRE(cache.size() == 1);
+    }
+
+    SECTION("evicts the least recently used selector") {
+        SelectorCache cache{2};
+        auto a = cache.get("a");
+        cache.get("p");
+        cache.get("a");
+        cache.get("div");
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.get("a") == a);
+        REQUIRE(cache.size() == 2);
+    }
+}
+
+TEST_CASE("NodeMatcher") {
+    HtmlDocument document{
+        R"(<div id="main" class="product card"><h1 lang="en-US">T</h1>)"
+        R"(<span class="price" data-x>1</span><a href="/p?q=1">a</a></div>)"};
+    auto matches = [&document](const char* selector, const char* target) {
+        auto matcher = NodeMatcher::parse(selector);
+        REQUIRE(matcher.has_value());
+        return matcher->matches(document.first(target)->native_handle());
+    };
+
+    SECTION("matches compound selectors") {
+        REQUIRE(matches("div#main.card.product", "div"));
+        REQUIRE_FALSE(matches("div.missing", "div"));
+        REQUIRE(matches("[data-x]", "span"));
+        REQUIRE(matches("a[href^='/p'][href$=\"q=1\"]", "a"));
+        REQUIRE(matches("h1[lang|=en]", "h1"));
+    }
+
+    SECTION("matches combinators") {
+        REQUIRE(matches("body .price", "span"));
+        REQUIRE(matches("div > span", "span"));
+        REQUIRE_FALSE(matches("body > span", "span"));
+        REQUIRE(matches("h1 + span", "span"));
+        REQUIRE(matches("h1 ~ a", "a"));
+        REQUIRE_FALSE(matches("h1 + a", "a"));
+    }
+
+    SECTION("rejects selectors outside its subset") {
+        REQUIRE_FALSE(NodeMatcher::parse("li:first-child").has_value());
+        REQUIRE_FALSE(NodeMatcher::parse("div[").has_value());
+    }
+}
+
+TEST_CASE("DocumentIndex") {
+    HtmlDocument document{
+        R"(<!DOCTYPE html><ul id="list"><li class="a">1</li>)"
+        R"(<li class="b a a">2</li><li class="B">3</li></ul>)"};
+    auto root = &document.native_handle()->dom_document.node;
+    auto texts = [](const std::vector<HtmlElement>& elements) {
+        std::string joined;
+        for (const auto& element : elements) {
+            joined += element.text();
+        }
+        return joined;
+    };
+
+    SECTION("lookups return elements in document order") {
+        auto index = DocumentIndex::of(root);
+        REQUIRE(index != nullptr);
+        REQUIRE(index->tag("li").size() == 3);
+        REQUIRE(index->id("list").size() == 1);
+        REQUIRE(index->id("LIST").empty());
+        auto a = index->class_name("a");
+        REQUIRE(a.size() == 2);
+        REQUIRE(a.begin()->order < (a.begin() + 1)->order);
+        REQUIRE(DocumentIndex::of(root) == index);
+    }
+
+    SECTION("indexed queries match the tree search") {
+        for (std::string selector :
+             {"li", ".a", "#list > li.a", "li.b, .a, ul li", "li[class='B']",
+              "ul .B"}) {
+            REQUIRE(texts(document.css(selector)) ==
+                    texts(document.first("html")->css(selector)));
+        }
+        REQUIRE(texts(document.css("li.b, .a")) == "12");
+        REQUIRE(document.first(".b")->text() == "2");
+    }
+
+    SECTION("selector lists match in document order on both paths") {
+        auto list = document.first("ul");
+        REQUIRE(texts(document.css(".B, .a")) == "123");
+        REQUIRE(texts(list->css(".B, .a")) == "123");
+        REQUIRE(texts(list->css("li.B, li:first-child")) == "13");
+        REQUIRE(list->first(".B, .b")->text() == "2");
+    }
+
+    SECTION("ids and classes ignore case in quirks mode") {
+        HtmlDocument quirks{R"(<p id="Intro" class="Lead">x</p>)"};
+        REQUIRE(quirks.css("#intro.LEAD").size() == 1);
+        REQUIRE(document.css(".b").size() == 1);
+        REQUIRE(document.css(".A").empty());
+    }
+}
+
+TEST_CASE("DocumentIndex benchmarks", "[.][benchmark]") {
+    std::string page = "<html><head><title>t</title></head><body>";
+    for (int i = 0; i < 2000; i++) {
+        page += R"(<div class="row"><span class="name">n</span>)"
+                R"(<span class="price">)" +
+                std::to_string(i) + "</span></div>";
+    }
+    page += R"(<div id="footer">f</div></body></html>)";
+    HtmlDocument document{page};
+    auto html = *document.first("html");
+    CompiledSelector price{".row > .price"};
+    CompiledSelector footer{"#footer"};
+    REQUIRE(document.css(price).size() == html.css(price).size());
+
+    BENCHMARK("indexed .row > .price") { return document.css(price).size(); };
+    BENCHMARK("tree search .row > .price") { return html.css(price).size(); };
+    BENCHMARK("indexed #footer") { return document.first(footer); };
+    BENCHMARK("tree search #footer") { return html.first(footer); };
+}
+
+TEST_CASE("ExtractionSchema") {
+    std::string html = R"(<h1>Shoes</h1>)"
+                       R"(<div class="item"><a href="/1">One</a>)"
+                       R"(<span class="price">10</span></div>)"
+                       R"(<div class="item"><a href="/2">Two</a>)"
+                       R"(<span class="price">20</span></div>)";
+    HtmlDocument document{html};
+    ExtractionSchema schema{{
+        {"title", "h1"},
+        {"links", "a", "href", Cardinality::many},
+        {"items",
+         "div.item",
+         "",
+         Cardinality::many,
+         {{"name", "a"}, {"price", ".price"}}},
+        {"first", "li:first-child"},
+    }};
+    auto record = schema.extract(document);
+
+    SECTION("extracts text and attributes") {
+        REQUIRE(record.value("title") == "Shoes");
+        REQUIRE(
+            record.values("links") == std::vector<std::string>{"/1", "/2"});
+    }
+
+    SECTION("flattens sub-fields, one value per group match") {
+        REQUIRE(
+            record.values("items.name") ==
+            std::vector<std::string>{"One", "Two"});
+        REQUIRE(
+            record.values("items.price") ==
+            std::vector<std::string>{"10", "20"});
+    }
+
+    SECTION("fields without matches have no values") {
+        REQUIRE_FALSE(record.value("first").has_value());
+        REQUIRE(record.values("unknown").empty());
+    }
+
+    SECTION("throws selector_error on invalid selectors") {
+        REQUIRE_THROWS_AS(
+            ExtractionSchema(std::vector<Field>{{"bad", "div["}}),
+            selector_error);
+    }
+}
+
+TEST_CASE("DocumentPool") {
+    auto& pool = DocumentPool::local();
+    pool.clear();
+
+    SECTION("released documents are reused") {
+        auto reused = pool.stats().reused;
+        { HtmlDocument first{"<p>first</p>"}; }
+        REQUIRE(pool.idle() == 1);
+        HtmlDocument second{"<p>second</p>"};
+        REQUIRE(pool.stats().reused == reused + 1);
+        REQUIRE(second.css("p").size() == 1);
+        REQUIRE(second.first("p")->text() == "second");
+    }
+
+    SECTION("documents stay out of the pool while elements use them") {
+        std::optional<HtmlElement> paragraph;
+        {
+            HtmlDocument document{"<p>text</p>"};
+            paragraph = document.first("p");
+        }
+        REQUIRE(pool.idle() == 0);
+        REQUIRE(paragraph->text() == "text");
+        paragraph.reset();
+        REQUIRE(pool.idle() == 1);
+    }
+
+    SECTION("idle documents are capped by capacity") {
+        DocumentPool::set_capacity(1);
+        {
+            HtmlDocument first{"<p>1</p>"};
+            HtmlDocument second{"<p>2</p>"};
+        }
+        REQUIRE(pool.idle() == 1);
+        DocumentPool::set_capacity(DocumentPool::default_capacity);
+    }
+}
+
+TEST_CASE("DocumentPool benchmarks", "[.][benchmark]") {
+    std::string page = "<html><head><title>t</title></head><body>";
+    for (int i = 0; i < 500; i++) {
+        page += R"(<div class="item"><a href="/p)" + std::to_string(i) +
+                R"(">product</a><span class="price">10</span></div>)";
+    }
+    page += "</body></html>";
+
+    BENCHMARK("parse into a fresh document") {
+        unique_lxb_html_document document{lxb_html_document_create()};
+        return lxb_html_document_parse(
+            document.get(), (const lxb_char_t*)page.c_str(), page.size());
+    };
+    BENCHMARK("parse into a pooled document") {
+        HtmlDocument document{page};
+        return document.native_handle() != nullptr;
+    };
+}
+
+TEST_CASE("PartialParser") {
+    std::string page =
+        R"(<!DOCTYPE html><html><head><title>Shop</title>)"
+        R"(<link rel="canonical" href="https://example.com/p">)"
+        R"(</head><body><h1>Heading</h1><p class="later">rest</p>)";
+    for (int i = 0; i < 200; i++) {
+        page += "<p>filler</p>";
+    }
+    page += "</body></html>";
+    auto feed = [&page](PartialParser& parser, std::size_t chunk) {
+        for (std::size_t i = 0; i < page.size(); i += chunk) {
+            if (!parser.feed(std::string_view{page}.substr(i, chunk))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    SECTION("stops after the head") {
+        PartialParseOptions options;
+        options.stop_at_head_end = true;
+        options.check_interval = 16;
+        PartialParser parser{options};
+        REQUIRE_FALSE(feed(parser, 7));
+        REQUIRE(parser.stop_reason() == PartialParser::StopReason::head_end);
+        REQUIRE(parser.consumed() < 200);
+        auto document = parser.finish();
+        REQUIRE(document.first("title")->text() == "Shop");
+        REQUIRE(document.first("link[rel=canonical]").has_value());
+        REQUIRE(document.css("p").empty());
+        REQUIRE_FALSE(parser.feed("<p>late</p>"));
+    }
+
+    SECTION("stops at the byte budget") {
+        PartialParseOptions options;
+        options.byte_budget = 50;
+        PartialParser parser{options};
+        REQUIRE_FALSE(feed(parser, 1024));
+        REQUIRE(parser.stop_reason() ==
+                PartialParser::StopReason::byte_budget);
+        REQUIRE(parser.consumed() == 50);
+        REQUIRE(parser.finish().first("title")->text() == "Shop");
+    }
+
+    SECTION("stops once every selector matched a complete element") {
+        PartialParseOptions options;
+        options.selectors = {
+            CompiledSelector{"link[rel=canonical]"}, CompiledSelector{"h1"}};
+        options.check_interval = 8;
+        PartialParser parser{options};
+        REQUIRE_FALSE(feed(parser, 64));
+        REQUIRE(parser.stop_reason() == PartialParser::StopReason::selectors);
+        auto document = parser.finish();
+        REQUIRE(document.first("h1")->text() == "Heading");
+        REQUIRE(document.css("p").size() < 3);
+    }
+
+    SECTION("elements are complete once something follows them") {
+        std::string items = R"(<div class="x">)";
+        for (int i = 0; i < 50; i++) {
+            items += "<span>a</span>";
+        }
+        auto end = items.size();
+        items += "</div><p>after</p><p>more</p>";
+        PartialParseOptions options;
+        options.selectors = {CompiledSelector{"div.x"}};
+        options.check_interval = 4;
+        PartialParser parser{options};
+        REQUIRE(parser.feed(std::string_view{items}.substr(0, end)));
+        REQUIRE_FALSE(parser.feed(std::string_view{items}.substr(end)));
+        auto document = parser.finish();
+        REQUIRE(document.first("div.x")->css("span").size() == 50);
+        REQUIRE(document.css("p").size() < 2);
+    }
+
+    SECTION("selectors NodeMatcher cannot evaluate search the tree") {
+        PartialParseOptions options;
+        options.selectors = {CompiledSelector{"p:first-of-type"}};
+        options.check_interval = 8;
+        PartialParser parser{options};
+        REQUIRE_FALSE(feed(parser, 64));
+        REQUIRE(parser.stop_reason() == PartialParser::StopReason::selectors);
+        REQUIRE(parser.finish().css("p").size() < 3);
+    }
+
+    SECTION("parses the whole page without stop conditions") {
+        PartialParser parser;
+        REQUIRE(feed(parser, 100));
+        REQUIRE_FALSE(parser.stopped());
+        auto document = parser.finish();
+        REQUIRE(document.css("p").size() == 201);
+        REQUIRE(parser.finish().native_handle() == document.native_handle());
+    }
+}
+
+TEST_CASE("PartialParser benchmarks", "[.][benchmark]") {
+    std::string page = "<html><head><title>t</title>"
+                       R"(<meta name="description" content="d"></head>)"
+                       "<body>";
+    for (int i = 0; i < 2000; i++) {
+        page += R"(<div class="item"><a href="/p">product</a></div>)";
+    }
+    page += "</body></html>";
+    PartialParseOptions options;
+    options.stop_at_head_end = true;
+
+    BENCHMARK("full parse") { return HtmlDocument{page}.first("title"); };
+    BENCHMARK("parse until </head>") {
+        PartialParser parser{options};
+        parser.feed(page);
+        return parser.finish().first("title");
+    };
+
+    // Checked after every slice of the page, never satisfied.
+    PartialParseOptions missing;
+    missing.selectors = {CompiledSelector{"div.missing a"}};
+    BENCHMARK("parse checking a selector that never matches") {
+        PartialParser parser{missing};
+        parser.feed(page);
+        return parser.finish().first("title");
+    };
+}
+
+TEST_CASE("Batch parsing") {
+    std::vector<std::string> pages;
+    for (int i = 0; i < 100; i++) {
+        pages.push_back(
+            "<p class=\"n\">" + std::to_string(i) + "</p><p>" +
+            std::string(static_cast<std::size_t>(i % 7), 'x') + "</p>");
+    }
+    CompiledSelector number{"p.n"};
+    auto extract = [&number](const HtmlDocument& document) {
+        return document.first(number)->text();
+    };
+
+    SECTION("results come back in input order") {
+        BatchOptions options;
+        options.threads = 4;
+        options.chunk_size = 3;
+        auto results = parse_batch(pages, extract, options);
+        REQUIRE(results.size() == pages.size());
+        for (std::size_t i = 0; i < results.size(); i++) {
+            REQUIRE(results[i] == std::to_string(i));
+        }
+        REQUIRE(parse_batch(std::vector<std::string>{}, extract).empty());
+    }
+
+    SECTION("results are handed over as they complete") {
+        std::vector<std::string> texts(pages.size());
+        std::size_t calls = 0;
+        parse_batch_unordered(
+            pages, extract, [&](std::size_t i, std::string text) {
+                texts[i] = std::move(text);
+                calls++;
+            });
+        REQUIRE(calls == pages.size());
+        for (std::size_t i = 0; i < texts.size(); i++) {
+            REQUIRE(texts[i] == std::to_string(i));
+        }
+    }
+
+    SECTION("the first exception is rethrown") {
+        auto failing = [](const HtmlDocument& document) {
+            if (document.first("p.n")->text() == "42") {
+                throw std::runtime_error("bad page");
+            }
+            return 0;
+        };
+        REQUIRE_THROWS_AS(parse_batch(pages, failing), std::runtime_error);
+    }
+
+    SECTION("batches reuse the threads of the pool") {
+        boost::asio::thread_pool pool{2};
+        BatchOptions options;
+        options.threads = 3;
+        options.chunk_size = 1;
+        options.pool = &pool;
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        auto record = [&](const HtmlDocument& document) {
+            std::lock_guard<std::mutex> lock{mutex};
+            threads.insert(std::this_thread::get_id());
+            return extract(document);
+        };
+        for (int batch = 0; batch < 5; batch++) {
+            REQUIRE(parse_batch(pages, record, options).size() == 100);
+        }
+        // The calling thread and the pool's two.
+        REQUIRE(threads.size() <= 3);
+    }
+}
+
+TEST_CASE("Batch parsing benchmarks", "[.][benchmark]") {
+    std::string page = "<html><body>";
+    for (int i = 0; i < 200; i++) {
+        page += R"(<div class="item"><a href="/p">product</a></div>)";
+    }
+    page += "</body></html>";
+    std::vector<std::string> pages(256, page);
+    CompiledSelector links{"div.item > a"};
+    auto extract = [&links](const HtmlDocument& document) {
+        return document.css(links).size();
+    };
+
+    BENCHMARK("sequential") {
+        std::size_t total = 0;
+        for (const auto& body : pages) {
+            total += extract(HtmlDocument{body});
+        }
+        return total;
+    };
+    BENCHMARK("parse_batch") { return parse_batch(pages, extract).size(); };
+}
+
+TEST_CASE("TagScanner") {
+    SECTION("start tags and attributes are found") {
+        TagScanner scanner{
+            R"(<DIV Class="a b" id=main data-x='1'><br/><input disabled>)"};
+        REQUIRE(scanner.next());
+        REQUIRE(scanner.name() == "DIV");
+        REQUIRE(scanner.is("div"));
+        REQUIRE(scanner.attribute("class") == "a b");
+        REQUIRE(scanner.attribute("id") == "main");
+        REQUIRE(scanner.attribute("data-x") == "1");
+        REQUIRE_FALSE(scanner.attribute("href"));
+        REQUIRE(scanner.next());
+        REQUIRE(scanner.is("br"));
+        REQUIRE(scanner.next());
+        REQUIRE(scanner.attribute("disabled") == "");
+        REQUIRE_FALSE(scanner.next());
+    }
+
+    SECTION("comments, end tags and raw text are skipped") {
+        TagScanner scanner{"<!doctype html><!-- <a> --><script>"
+                           "if (a<b) document.write('<a href=x>')"
+                           "</SCRIPT ><p>"};
+        REQUIRE(scanner.next());
+        REQUIRE(scanner.is("script"));
+        REQUIRE(scanner.raw_text() ==
+                "if (a<b) document.write('<a href=x>')");
+        REQUIRE(scanner.next());
+        REQUIRE(scanner.is("p"));
+        REQUIRE_FALSE(scanner.next());
+    }
+
+    SECTION("decode_entities") {
+        REQUIRE(decode_entities("a=1&amp;b=2") == "a=1&b=2");
+        REQUIRE(decode_entities("&#65;&#x42;&lt;") == "AB<");
+        REQUIRE(decode_entities("&#233;") == "\xC3\xA9");
+        REQUIRE(decode_entities("AT&T &unknown;") == "AT&T &unknown;");
+    }
+}
+
+TEST_CASE("LinkExtractor") {
+    std::string page = R"(<html><head><base href="https://example.com/dir/">
+        </head><body>
+        <a href="page.html">relative</a>
+        <a href="/root?a=1&amp;b=2#top">absolute path</a>
+        <a href="page.html">duplicate</a>
+        <a href="mailto:someone@example.com">mail</a>
+        <img src="//cdn.example.com/image.png">
+        <a name="anchor">no href</a>
+        </body></html>)";
+
+    SECTION("links are resolved against the base element") {
+        auto links = LinkExtractor{}.extract(page, "http://other.org/");
+        REQUIRE(links == std::vector<std::string>{
+                             "https://example.com/dir/page.html",
+                             "https://example.com/root?a=1&b=2",
+                             "https://cdn.example.com/image.png"});
+    }
+
+    SECTION("targets and uniqueness are configurable") {
+        LinkExtractor anchors{{{"a", "href"}}};
+        anchors.unique(false);
+        auto links = anchors.extract(page, "http://other.org/");
+        REQUIRE(links.size() == 3);
+        REQUIRE(links[2] == "https://example.com/dir/page.html");
+    }
+
+    SECTION("the page URL is used without a base element") {
+        auto links = LinkExtractor{}.extract(
+            R"(<a href="../b">b</a>)", "https://example.com/x/y/z");
+        REQUIRE(links == std::vector<std::string>{"https://example.com/x/b"});
+    }
+}
+
+TEST_CASE("LinkExtractor benchmarks", "[.][benchmark]") {
+    std::string page = "<html><head><title>t</title></head><body>";
+    for (int i = 0; i < 500; i++) {
+        page += R"(<div class="item"><a href="/p)" + std::to_string(i) +
+                R"(">product</a><span class="price">10</span>)"
+                R"(<p>Some description of the product.</p></div>)";
+    }
+    page += "</body></html>";
+
+    BENCHMARK("links through the DOM") {
+        HtmlDocument document{page};
+        std::vector<std::string> links;
+        for (const auto& anchor : document.css("a")) {
+            if (auto href = anchor.attribute("href")) {
+                links.push_back(
+                    resolve_url("https://example.com/", *href));
+            }
+        }
+        return links;
+    };
+    BENCHMARK("links through LinkExtractor") {
+        return LinkExtractor{}.extract(page, "https://example.com/");
+    };
+}
+
+TEST_CASE("XPath") {
+    HtmlDocument document{R"(<html><body>
+        <div id="products" class="list">
+            <div class="product"><a href="/p1">One</a>
+                <span class="price">10</span></div>
+            <div class="product sale"><a href="/p2">Two</a>
+                <span class="price">20</span></div>
+            <div class="product"><a href="/p3">Three</a>
+                <span class="price">30</span></div>
+        </div>
+        <p>first <b>bold</b></p><p>second</p>
+        </body></html>)"};
+
+    SECTION("location paths select elements in document order") {
+        REQUIRE(document.xpath("//a").size() == 3);
+        REQUIRE(document.xpath("/html/body/p").size() == 2);
+        REQUIRE(document.xpath("//div[@id='products']/div").size() == 3);
+        auto sale = document.xpath("//div[contains(@class, 'sale')]/a");
+        REQUIRE(sale.size() == 1);
+        REQUIRE(sale[0].text() == "Two");
+    }
+
+    SECTION("positional predicates") {
+        REQUIRE(document.xpath("(//a)[last()]")[0].text() == "Three");
+        REQUIRE(document.xpath("//div[@class='product'][2]/a")[0].text() ==
+                "Three");
+        REQUIRE(document.xpath("//p[1]")[0].text() == "first bold");
+        REQUIRE(document.xpath("//span[. > 15]").size() == 2);
+    }
+
+    SECTION("axes") {
+        auto b = document.xpath("//b")[0];
+        REQUIRE(b.xpath("ancestor::*[1]")[0].tag() == "p");
+        REQUIRE(b.xpath("following::p")[0].text() == "second");
+        REQUIRE(b.xpath("preceding::a").size() == 3);
+        REQUIRE(document.xpath("//a[.='Two']/../following-sibling::div")
+                    .size() == 1);
+    }
+
+    SECTION("attribute and text nodes are read with xpath_strings") {
+        REQUIRE(document.xpath_strings("//a/@href") ==
+                std::vector<std::string>{"/p1", "/p2", "/p3"});
+        REQUIRE(document.xpath_strings("//p[2]/text()") ==
+                std::vector<std::string>{"second"});
+        REQUIRE(document.xpath_strings("sum(//span[@class='price'])") ==
+                std::vector<std::string>{"60"});
+        REQUIRE(document.xpath_strings("normalize-space(//p[1])") ==
+                std::vector<std::string>{"first bold"});
+    }
+
+    SECTION("compiled expressions are reusable") {
+        XPath price{"span[@class='price']"};
+        std::vector<std::string> prices;
+        for (const auto& product : document.xpath("//div[@class]/div")) {
+            for (const auto& value : product.xpath_strings(price)) {
+                prices.push_back(value);
+            }
+        }
+        REQUIRE(prices == std::vector<std::string>{"10", "20", "30"});
+        REQUIRE(price.source() == "span[@class='price']");
+    }
+
+    SECTION("invalid expressions throw xpath_error") {
+        REQUIRE_THROWS_AS(XPath("//a["), xpath_error);
+        REQUIRE_THROWS_AS(XPath("unknown()"), xpath_error);
+        REQUIRE_THROWS_AS(XPath("$variable"), xpath_error);
+        REQUIRE_THROWS_AS(document.xpath("count(//a)"), xpath_error);
+    }
+}
+
+TEST_CASE("XPath benchmarks", "[.][benchmark]") {
+    std::string page = "<html><head><title>t</title></head><body>";
+    for (int i = 0; i < 500; i++) {
+        page += R"(<div class="item"><a href="/p)" + std::to_string(i) +
+                R"(">product</a><span class="price">10</span></div>)";
+    }
+    page += "</body></html>";
+    HtmlDocument document{page};
+    CompiledSelector css{"div[class='item']"};
+    XPath xpath{"//div[@class='item']"};
+    REQUIRE(document.css(css).size() == document.xpath(xpath).size());
+
+    BENCHMARK("css div[class='item']") { return document.css(css).size(); };
+    BENCHMARK("xpath //div[@class='item']") {
+        return document.xpath(xpath).size();
+    };
+    BENCHMARK("xpath (//a)[1]") {
+        return XPath{"(//a)[1]"}.select(
+            &document.native_handle()->dom_document.node);
+    };
+}
+
+TEST_CASE("Visible text") {
+    HtmlDocument document{R"(<html><head><title>Title</title>
+        <style>p { color: red; }</style></head><body>
+        <h1>  Hello,
+            world </h1>
+        <p>Some <b>bold</b> text &amp; more.<br>Next line</p>
+        <script>var hidden = "<p>not text</p>";</script>
+        <div hidden>secret</div>
+        <table><tr><td>a</td><td>b</td></tr><tr><td>c</td><td>d</td></tr>
+        </table>
+        <pre>keep   this
+ layout</pre>
+        <div></div><div></div>
+        </body></html>)"};
+
+    SECTION("the document is rendered in one pass") {
+        REQUIRE(document.visible_text() ==
+                "Hello, world\n"
+                "Some bold text & more.\n"
+                "Next line\n"
+                "a b\n"
+                "c d\n"
+                "keep   this\n layout");
+    }
+
+    SECTION("separators and hidden elements are configurable") {
+        TextOptions options;
+        options.block_separator = " | ";
+        options.cell_separator = "\t";
+        options.skip_hidden = false;
+        auto text = document.body().visible_text(options);
+        REQUIRE(text.find("secret") != std::string::npos);
+        REQUIRE(text.find("a\tb | c\td") != std::string::npos);
+    }
+
+    SECTION("text is appended to a reusable buffer") {
+        std::string buffer = "h1: ";
+        document.first("h1")->visible_text(buffer);
+        REQUIRE(buffer == "h1: Hello, world");
+    }
+}
+
+TEST_CASE("Visible text benchmarks", "[.][benchmark]") {
+    std::string page = "<html><head><style>.a{}</style></head><body>";
+    for (int i = 0; i < 500; i++) {
+        page += "<div class=\"item\"><h2>Product " + std::to_string(i) +
+                "</h2><p>Some   description\n of the product.</p>"
+                "<script>track(" +
+                std::to_string(i) + ");</script></div>";
+    }
+    page += "</body></html>";
+    HtmlDocument document{page};
+    auto body = document.body();
+    std::string buffer;
+
+    BENCHMARK("text() of the body") { return body.text(); };
+    BENCHMARK("visible_text() into a reused buffer") {
+        buffer.clear();
+        body.visible_text(buffer);
+        return buffer.size();
+    };
+}
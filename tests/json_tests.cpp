@@ -0,0 +1,355 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "embedded_json.h"
+#include "json.h"
+#include "json_extractor.h"
+#include "response.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <optional>
+#include <string>
+
+namespace {
+    std::string large_payload(std::size_t items) {
+        std::string payload = R"({"items": [)";
+        for (std::size_t i = 0; i < items; i++) {
+            if (i != 0) {
+                payload += ",";
+            }
+            payload += R"({"id": )" + std::to_string(i) +
+                       R"(, "name": "product )" + std::to_string(i) +
+                       R"(", "tags": ["a", "b"], "price": 9.5})";
+        }
+        payload += R"(], "total": )" + std::to_string(items) + "}";
+        return payload;
+    }
+
+    std::string product_page(std::size_t paragraphs) {
+        std::string html = "<html><head><title>Product</title>"
+                           R"(<script type="application/ld+json">)" +
+                           large_payload(10) + "</script></head><body>";
+        for (std::size_t i = 0; i < paragraphs; i++) {
+            html += "<p class=\"text\">paragraph <a href=\"/p/" +
+                    std::to_string(i) + "\">" + std::to_string(i) +
+                    "</a></p>";
+        }
+        return html + "</body></html>";
+    }
+} // namespace
+
+TEST_CASE("JsonStream") {
+    SECTION("chunks parse to the same document as a single buffer") {
+        auto payload = large_payload(200);
+        Scrapp::JsonStream stream;
+        for (std::size_t i = 0; i < payload.size(); i += 100) {
+            REQUIRE(stream.write(std::string_view{payload}.substr(i, 100)));
+        }
+        auto value = stream.finish();
+        REQUIRE(value == boost::json::parse(payload));
+        REQUIRE(value.at("items").as_array().at(199).at("id") == 199);
+    }
+
+    SECTION("comments and trailing commas are accepted") {
+        Scrapp::JsonStream stream;
+        REQUIRE(stream.write("{\"a\": [1, 2,], // note\n}"));
+        REQUIRE(stream.finish().at("a").as_array().at(1) == 2);
+    }
+
+    SECTION("invalid and incomplete input throw invalid_json_exception") {
+        Scrapp::JsonStream invalid;
+        REQUIRE_FALSE(invalid.write("{\"a\": ]"));
+        REQUIRE(invalid.failed());
+        REQUIRE_FALSE(invalid.write("}"));
+        REQUIRE_THROWS_AS(invalid.finish(), Scrapp::invalid_json_exception);
+
+        Scrapp::JsonStream incomplete;
+        REQUIRE(incomplete.write("{\"a\": [1"));
+        REQUIRE_THROWS_AS(
+            incomplete.finish(), Scrapp::invalid_json_exception);
+    }
+}
+
+TEST_CASE("JsonArenaPool") {
+    auto& pool = Scrapp::JsonArenaPool::local();
+    pool.clear();
+    auto created = pool.stats().created;
+
+    SECTION("values own their arena and return its block when gone") {
+        std::optional<boost::json::value> value;
+        {
+            Scrapp::JsonStream stream;
+            stream.write(large_payload(50));
+            value.emplace(stream.finish());
+        }
+        REQUIRE(value->at("total") == 50);
+        REQUIRE(pool.idle() == 0);
+        value.reset();
+        REQUIRE(pool.idle() == 1);
+
+        Scrapp::JsonStream reused;
+        REQUIRE(pool.idle() == 0);
+        REQUIRE(pool.stats().created == created + 1);
+    }
+
+    SECTION("idle blocks are capped by capacity") {
+        Scrapp::JsonArenaPool::set_capacity(1);
+        {
+            auto first = pool.acquire();
+            auto second = pool.acquire();
+        }
+        REQUIRE(pool.idle() == 1);
+        Scrapp::JsonArenaPool::set_capacity(
+            Scrapp::JsonArenaPool::default_capacity);
+    }
+}
+
+TEST_CASE("JsonExtractor") {
+    std::string payload =
+        R"({"items": [{"id": 1, "name": "a\"b", "tags": ["x"]},)"
+        R"( {"id": 2, "name": "c", "skip": {"deep": [1, {"id": 9}]}}],)"
+        R"( "total": 2, "a/b": {"~c": null}, "odd key": true})";
+    Scrapp::JsonExtractor extractor{std::vector<Scrapp::JsonField>{
+        {"ids", "items[*].id"},
+        {"first", "/items/0"},
+        {"names", "$.items.*.name"},
+        {"total", "total"},
+        {"pointer", "/a~1b/~0c"},
+        {"quoted", "['odd key']"},
+        {"missing", "items[5].id"}}};
+
+    SECTION("only matched values are extracted, in document order") {
+        auto record = extractor.extract(payload);
+        const auto& ids = record.values("ids");
+        REQUIRE(ids.size() == 2);
+        REQUIRE(ids[0] == 1);
+        REQUIRE(ids[1] == 2);
+        REQUIRE(*record.value("first") ==
+                boost::json::parse(payload).at("items").as_array().at(0));
+        REQUIRE(record.values("names").size() == 2);
+        REQUIRE(*record.value("names") == "a\"b");
+        REQUIRE(*record.value("total") == 2);
+        REQUIRE(record.value("pointer")->is_null());
+        REQUIRE(*record.value("quoted") == true);
+        REQUIRE(record.value("missing") == nullptr);
+        REQUIRE(record.names().size() == 7);
+    }
+
+    SECTION("a parsed document gives the same record") {
+        auto streamed = extractor.extract(payload);
+        auto parsed = extractor.extract_value(boost::json::parse(payload));
+        for (const auto& name : streamed.names()) {
+            REQUIRE(streamed.values(name) == parsed.values(name));
+        }
+    }
+
+    SECTION("errors are reported") {
+        REQUIRE_THROWS_AS(
+            extractor.extract(R"({"items": [)"),
+            Scrapp::invalid_json_exception);
+        REQUIRE_THROWS_AS(
+            extractor.extract("{} []"), Scrapp::invalid_json_exception);
+        for (auto path : {"a..b", "a[", "a[x]", "/a~2", "a."}) {
+            REQUIRE_THROWS_AS(
+                Scrapp::JsonExtractor(
+                    std::vector<Scrapp::JsonField>{{"bad", path}}),
+                Scrapp::invalid_json_path_exception);
+        }
+    }
+
+    SECTION("responses extract without building the document") {
+        Scrapp::Response response;
+        response.headers["Content-Type"] = "application/json";
+        response.text = payload;
+        REQUIRE(*response.json(extractor).value("total") == 2);
+    }
+}
+
+TEST_CASE("JsonExtractor benchmarks", "[.][benchmark]") {
+    auto payload = large_payload(20000);
+    Scrapp::JsonExtractor extractor{std::vector<Scrapp::JsonField>{
+        {"total", "/total"}, {"first", "items[0].name"}}};
+    REQUIRE(*extractor.extract(payload).value("total") == 20000);
+
+    BENCHMARK("boost::json::parse and look up") {
+        auto value = boost::json::parse(payload);
+        return value.at("total").as_int64() +
+               static_cast<std::int64_t>(
+                   value.at("items").as_array().at(0).at("name").as_string()
+                       .size());
+    };
+    BENCHMARK("JsonExtractor::extract") {
+        return extractor.extract(payload).values("first").size();
+    };
+}
+
+TEST_CASE("Response::json") {
+    Scrapp::Response response;
+    response.headers["Content-Type"] = "application/json";
+
+    SECTION("payloads larger than a stack buffer stay valid") {
+        response.text = large_payload(1000);
+        const auto& value = response.json();
+        const auto& items = value.at("items").as_array();
+        REQUIRE(items.size() == 1000);
+        REQUIRE(items.at(999).at("name") == "product 999");
+    }
+
+    SECTION("invalid bodies throw invalid_json_exception") {
+        response.text = "{\"a\": ";
+        REQUIRE_THROWS_AS(response.json(), Scrapp::invalid_json_exception);
+    }
+
+    SECTION("the document is parsed once and shared by copies") {
+        response.text = large_payload(10);
+        const auto& value = response.json();
+        auto copy = response;
+        REQUIRE(&copy.json() == &value);
+        REQUIRE(&response.json() == &value);
+    }
+
+    SECTION("extracted values do not allocate from the shared document") {
+        response.text = large_payload(10);
+        const auto& document = response.json();
+        Scrapp::JsonExtractor extractor{
+            std::vector<Scrapp::JsonField>{{"name", "items[*].name"}}};
+        auto copy = response;
+        auto record = copy.json(extractor);
+        REQUIRE(record.values("name").size() == 10);
+        for (const auto& name : record.values("name")) {
+            REQUIRE(name.storage().get() != document.storage().get());
+        }
+    }
+
+    SECTION("bodies that failed to stream throw the parser's error") {
+        cpr::Response streamed;
+        streamed.header["Content-Type"] = "application/json";
+        auto error = boost::json::make_error_code(boost::json::error::syntax);
+        Scrapp::Response failed{streamed, nullptr, error};
+        std::string message;
+        try {
+            failed.json();
+        } catch (const Scrapp::invalid_json_exception& e) {
+            message = e.what();
+        }
+        REQUIRE(message.find(error.message()) != std::string::npos);
+        Scrapp::JsonExtractor extractor{
+            std::vector<Scrapp::JsonField>{{"total", "total"}}};
+        REQUIRE_THROWS_AS(
+            failed.json(extractor), Scrapp::invalid_json_exception);
+    }
+}
+
+TEST_CASE("Response::json benchmarks", "[.][benchmark]") {
+    Scrapp::Response response;
+    response.headers["Content-Type"] = "application/json";
+    response.text = large_payload(20000);
+
+    BENCHMARK("boost::json::parse with the default resource") {
+        return boost::json::parse(response.text).at("total");
+    };
+    BENCHMARK("JsonStream with a pooled arena") {
+        Scrapp::JsonStream stream;
+        stream.write(response.text);
+        return stream.finish().at("total");
+    };
+}
+
+TEST_CASE("embedded_json") {
+    std::string html =
+        "<html><head>"
+        R"(<script type="Application/LD+JSON; charset=utf-8">)"
+        R"(  {"@type": "Product", "name": "a"}  </script>)"
+        R"(<script type="application/ld+json"><!-- {"n": 2} --></script>)"
+        R"(<script type="text/javascript">var a = {"n": 3};</script>)"
+        R"(<!-- <script type="application/ld+json">{"n": 4}</script> -->)"
+        "</head><body>"
+        R"(<script id="__NEXT_DATA__" type="application/json">)"
+        R"(<![CDATA[{"props": {"page": "/x"}}]]></script>)"
+        R"(<script type="application/ld+json">{"n": </script>)"
+        "</body></html>";
+
+    SECTION("matching scripts are parsed in document order") {
+        auto values = Scrapp::embedded_json(html);
+        REQUIRE(values.size() == 3);
+        REQUIRE(values[0].at("name") == "a");
+        REQUIRE(values[1].at("n") == 2);
+        REQUIRE(values[2].at("props").at("page") == "/x");
+    }
+
+    SECTION("scripts are selected by id and type") {
+        Scrapp::EmbeddedJsonOptions options;
+        options.id = "__NEXT_DATA__";
+        auto values = Scrapp::embedded_json(html, options);
+        REQUIRE(values.size() == 1);
+        REQUIRE(values[0].at("props").at("page") == "/x");
+
+        options.id.clear();
+        options.types = {"text/javascript"};
+        auto scripts = Scrapp::embedded_json_scripts(html, options);
+        REQUIRE(scripts.size() == 1);
+        REQUIRE(scripts[0] == R"(var a = {"n": 3};)");
+        REQUIRE(Scrapp::embedded_json(html, options).empty());
+    }
+
+    SECTION("invalid scripts throw when not skipped") {
+        Scrapp::EmbeddedJsonOptions options;
+        options.skip_invalid = false;
+        REQUIRE_THROWS_AS(
+            Scrapp::embedded_json(html, options),
+            Scrapp::invalid_json_exception);
+    }
+
+    SECTION("extractors run on each script") {
+        Scrapp::JsonExtractor extractor{std::vector<Scrapp::JsonField>{
+            {"name", "name"}, {"page", "/props/page"}}};
+        auto records = Scrapp::embedded_json(html, extractor);
+        REQUIRE(records.size() == 3);
+        REQUIRE(*records[0].value("name") == "a");
+        REQUIRE(records[1].value("name") == nullptr);
+        REQUIRE(*records[2].value("page") == "/x");
+    }
+
+    SECTION("responses scan their body") {
+        Scrapp::Response response;
+        response.text = html;
+        REQUIRE(response.embedded_json().size() == 3);
+    }
+}
+
+TEST_CASE("embedded_json benchmarks", "[.][benchmark]") {
+    auto html = product_page(5000);
+    REQUIRE(Scrapp::embedded_json(html).size() == 1);
+
+    BENCHMARK("HtmlDocument::css and parse") {
+        Scrapp::Html::HtmlDocument document{std::string_view{html}};
+        std::size_t count = 0;
+        auto scripts = document.css("script[type='application/ld+json']");
+        for (auto& script : scripts) {
+            count += boost::json::parse(script.text()).is_object();
+        }
+        return count;
+    };
+    BENCHMARK("embedded_json") {
+        return Scrapp::embedded_json(html).size();
+    };
+}
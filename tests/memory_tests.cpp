@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "html/document.h"
+#include "response.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <new>
+
+// Counts bytes requested through operator new on the current thread. lexbor
+// allocates with malloc and is not counted, which is what these tests want:
+// anything the library copies on the C++ side shows up here.
+namespace {
+    thread_local std::size_t allocated_bytes = 0;
+
+    class AllocationScope {
+      public:
+        AllocationScope() : start_{allocated_bytes} {}
+        std::size_t bytes() const { return allocated_bytes - this->start_; }
+
+      private:
+        std::size_t start_;
+    };
+
+    std::string large_page(std::size_t min_size) {
+        std::string page = "<html><body>";
+        while (page.size() < min_size) {
+            page += R"(<div class="item"><a href="/product">A product)"
+                    R"( with a long enough description</a></div>)";
+        }
+        page += "</body></html>";
+        return page;
+    }
+} // namespace
+
+void* operator new(std::size_t size) {
+    allocated_bytes += size;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+TEST_CASE("HtmlDocument memory profile") {
+    constexpr std::size_t page_size = 4 * 1024 * 1024;
+    auto page = large_page(page_size);
+
+    SECTION("parsing a string_view does not copy the source") {
+        AllocationScope scope;
+        Scrapp::Html::HtmlDocument document{std::string_view{page}};
+        REQUIRE(scope.bytes() < page_size / 4);
+    }
+
+    SECTION("parsing a shared buffer keeps it without copying") {
+        auto buffer = std::make_shared<const std::string>(page);
+        AllocationScope scope;
+        Scrapp::Html::HtmlDocument document{buffer};
+        REQUIRE(scope.bytes() < page_size / 4);
+        REQUIRE(document.source().data() == buffer->data());
+        REQUIRE(buffer.use_count() == 2);
+    }
+
+    SECTION("Response::html() does not copy the body") {
+        Scrapp::Response response;
+        response.text = page;
+        AllocationScope scope;
+        auto document = response.html<false>();
+        REQUIRE(scope.bytes() < page_size / 4);
+        REQUIRE(document.first("a").has_value());
+    }
+}
@@ -0,0 +1,243 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "near_duplicates.h"
+#include "recrawl.h"
+#include "spider.h"
+#include <atomic>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Deterministic filler text of count words from a vocabulary of 1000.
+    std::string words(std::size_t count, std::uint64_t seed) {
+        std::string text;
+        for (std::size_t i = 0; i < count; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            text += "w" + std::to_string((seed >> 33) % 1000) + " ";
+        }
+        return text;
+    }
+
+    std::string page(const std::string& body, const std::string& extra) {
+        return "<html><head><title>Shop</title><style>p { color: red }"
+               "</style><script>var session = \"" +
+               extra +
+               "\";</script></head><body><p class=\"lead\">" + body +
+               "</p><!-- rendered " + extra + " --></body></html>";
+    }
+
+    // Serves the same page, ignoring conditional requests.
+    class UnchangedTransport : public Scrapp::Transport {
+      public:
+        explicit UnchangedTransport(std::string text)
+            : text_{std::move(text)} {}
+
+        Scrapp::Response fetch(
+            const Scrapp::Request& request,
+            const Scrapp::FetchOptions& /*options*/) override {
+            ++this->fetches;
+            Scrapp::Response response;
+            response.url = Scrapp::Url{request.full_url()};
+            response.status_code = 200;
+            response.text = this->text_;
+            return response;
+        }
+
+        std::atomic<int> fetches{0};
+
+      private:
+        std::string text_;
+    };
+
+    // Asks for the due recrawls after the first page.
+    class RecrawlingSpider : public Scrapp::Spider {
+      public:
+        void parse(Scrapp::Response /*response*/) override {
+            if (++this->parsed == 1) {
+                this->enqueue_recrawls();
+            }
+        }
+
+        std::atomic<int> parsed{0};
+    };
+} // namespace
+
+TEST_CASE("simhash") {
+    SECTION("similar texts are near, unrelated texts are far") {
+        auto text = words(500, 1);
+        auto fingerprint = Scrapp::simhash(text);
+        REQUIRE(
+            Scrapp::hamming_distance(
+                fingerprint, Scrapp::simhash(text + "printed 2024")) <= 3);
+        REQUIRE(
+            Scrapp::hamming_distance(
+                fingerprint, Scrapp::simhash(words(500, 2))) > 10);
+    }
+
+    SECTION("words ignore case and punctuation") {
+        REQUIRE(
+            Scrapp::simhash("Hello, WORLD!") ==
+            Scrapp::simhash(std::vector<std::string_view>{"hello", "world"}));
+        REQUIRE(Scrapp::simhash("") == 0);
+    }
+
+    SECTION("html markup, scripts and styles are ignored") {
+        auto body = words(300, 3);
+        REQUIRE(
+            Scrapp::html_simhash(page(body, "a1b2c3")) ==
+            Scrapp::simhash("Shop " + body));
+        REQUIRE(
+            Scrapp::html_simhash("<p title=\"a > b\">Fish &amp; chips</p>") ==
+            Scrapp::simhash("Fish chips"));
+    }
+}
+
+TEST_CASE("NearDuplicateIndex") {
+    Scrapp::NearDuplicateIndex index{3};
+    std::uint64_t fingerprint = 0x0123456789abcdefULL;
+    REQUIRE_FALSE(index.insert(fingerprint, "https://a.com/1").has_value());
+
+    SECTION("fingerprints within the distance are duplicates") {
+        auto near = fingerprint ^ 0b101 ^ (std::uint64_t{1} << 63);
+        auto duplicate = index.insert(near, "https://a.com/2");
+        REQUIRE(duplicate.has_value());
+        REQUIRE(duplicate->url == "https://a.com/1");
+        REQUIRE(duplicate->distance == 3);
+        REQUIRE(index.size() == 1);
+    }
+
+    SECTION("farther fingerprints are indexed") {
+        REQUIRE_FALSE(index.insert(fingerprint ^ 0xf, "https://a.com/3"));
+        REQUIRE(index.size() == 2);
+        REQUIRE(index.find(fingerprint ^ 0xf)->url == "https://a.com/3");
+    }
+
+    SECTION("revisits of a URL replace its fingerprint") {
+        REQUIRE_FALSE(index.insert(fingerprint, "https://A.com/1#top"));
+        auto changed = fingerprint ^ 0xff;
+        REQUIRE_FALSE(index.insert(changed, "https://a.com/1"));
+        REQUIRE(index.size() == 1);
+        REQUIRE_FALSE(index.find(fingerprint).has_value());
+        auto duplicate = index.insert(changed ^ 1, "https://a.com/2");
+        REQUIRE(duplicate.has_value());
+        REQUIRE(duplicate->url == "https://a.com/1");
+    }
+
+    SECTION("concurrent inserts") {
+        std::vector<std::thread> threads;
+        for (std::uint64_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&index, t] {
+                for (std::uint64_t i = 0; i < 1000; ++i) {
+                    index.insert(
+                        (t << 62) | (i << 32) | (i * 0x9e3779b9ULL),
+                        "https://b.com/" + std::to_string(i));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(index.size() > 1);
+    }
+}
+
+TEST_CASE("DuplicateFilter") {
+    Scrapp::DuplicateFilterOptions options;
+    options.min_pattern_pages = 4;
+    options.skip_duplicate_ratio = 0.7;
+    Scrapp::DuplicateFilter filter{options};
+    auto body = words(300, 4);
+
+    SECTION("pages differing in session ids are duplicates") {
+        Scrapp::Response first;
+        first.url = Scrapp::Url{"https://shop.com/item/1"};
+        first.text = page(body, "f00d");
+        Scrapp::Response second;
+        second.url = Scrapp::Url{"https://shop.com/item/1?sid=beef"};
+        second.text = page(body, "beef");
+        REQUIRE_FALSE(filter.check(first).has_value());
+        auto duplicate = filter.check(second);
+        REQUIRE(duplicate.has_value());
+        REQUIRE(duplicate->url == "https://shop.com/item/1");
+    }
+
+    SECTION("patterns producing duplicates are skipped") {
+        auto fingerprint = Scrapp::simhash(words(300, 6));
+        for (int i = 0; i < 4; ++i) {
+            filter.check(
+                "https://shop.com/print/" + std::to_string(i), fingerprint);
+        }
+        REQUIRE(filter.duplicate_ratio("https://shop.com/print/9") == 0.75);
+        REQUIRE(filter.skip("https://shop.com/print/10"));
+        REQUIRE_FALSE(filter.skip("https://shop.com/item/10"));
+        auto stats = filter.stats();
+        REQUIRE(stats.pages == 4);
+        REQUIRE(stats.duplicates == 3);
+        REQUIRE(stats.skipped_requests == 1);
+    }
+}
+
+TEST_CASE("Spider duplicate filter with recrawls") {
+    auto transport =
+        std::make_shared<UnchangedTransport>(page(words(300, 7), "f00d"));
+    Scrapp::RecrawlOptions recrawl_options;
+    recrawl_options.min_interval = std::chrono::seconds{0};
+    recrawl_options.initial_interval = std::chrono::seconds{0};
+    auto filter = std::make_shared<Scrapp::DuplicateFilter>();
+    RecrawlingSpider spider;
+    spider.set_transport(transport);
+    spider.set_recrawl_scheduler(
+        std::make_shared<Scrapp::RecrawlScheduler>(recrawl_options));
+    spider.set_duplicate_filter(filter);
+    spider.add_request("https://shop.com/item/1");
+    spider.start();
+    spider.wait();
+
+    REQUIRE(transport->fetches == 2);
+    REQUIRE(spider.parsed == 2);
+    REQUIRE(filter->stats().duplicates == 0);
+}
+
+TEST_CASE("near duplicate benchmarks", "[.][benchmark]") {
+    auto html = page(words(5000, 5), "abc");
+    BENCHMARK("html_simhash of 5000 words") {
+        return Scrapp::html_simhash(html);
+    };
+
+    Scrapp::NearDuplicateIndex index{3};
+    std::uint64_t state = 7;
+    for (int i = 0; i < 1000000; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        index.insert(state, "");
+    }
+    BENCHMARK("find among 1000000 fingerprints") {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return index.find(state).has_value();
+    };
+}
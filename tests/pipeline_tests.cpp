@@ -0,0 +1,284 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "exceptions.h"
+#include "item_sinks.h"
+#include "pipeline.h"
+#include "spider.h"
+#include "test_utils.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Scrapp::Tests::read_file;
+    using Scrapp::Tests::temp_directory;
+
+    std::size_t count_lines(const std::string& text) {
+        return static_cast<std::size_t>(
+            std::count(text.begin(), text.end(), '\n'));
+    }
+
+    class MemorySink : public Scrapp::ItemSink {
+      public:
+        explicit MemorySink(std::vector<Scrapp::Item>& items)
+            : items_{items} {}
+
+        void write(const std::vector<Scrapp::Item>& items) override {
+            this->items_.insert(this->items_.end(), items.begin(), items.end());
+        }
+        void flush() override {}
+
+      private:
+        std::vector<Scrapp::Item>& items_;
+    };
+
+    class FailingSink : public Scrapp::ItemSink {
+      public:
+        void write(const std::vector<Scrapp::Item>&) override {
+            this->failed = true;
+            throw Scrapp::item_pipeline_exception("disk full");
+        }
+        void flush() override {}
+
+        std::atomic<bool> failed{false};
+    };
+
+    class PageTransport : public Scrapp::Transport {
+      public:
+        Scrapp::Response fetch(
+            const Scrapp::Request& request,
+            const Scrapp::FetchOptions& /*options*/) override {
+            Scrapp::Response response;
+            response.url = Scrapp::Url{request.full_url()};
+            response.status_code = 200;
+            response.text = "<html></html>";
+            return response;
+        }
+    };
+
+    // Emits a full batch, then keeps emitting after the sink failed.
+    class EmittingSpider : public Scrapp::Spider {
+      public:
+        explicit EmittingSpider(const FailingSink& sink) : sink_{sink} {}
+
+        void parse(Scrapp::Response /*response*/) override {
+            for (int i = 0; i < 512; ++i) {
+                this->emit({{"i", i}});
+            }
+            while (!this->sink_.failed) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            this->emit({{"i", 512}});
+            ++this->parsed;
+        }
+
+        std::atomic<int> parsed{0};
+
+      private:
+        const FailingSink& sink_;
+    };
+} // namespace
+
+TEST_CASE("ItemPipeline") {
+    Scrapp::PipelineOptions options;
+    options.batch_size = 16;
+    options.max_pending_batches = 2;
+
+    SECTION("items from every thread reach the sinks") {
+        std::vector<Scrapp::Item> items;
+        Scrapp::ItemPipeline pipeline{options};
+        pipeline.add_sink(std::make_unique<MemorySink>(items));
+        pipeline.add_stage([](Scrapp::Item& item) {
+            return item.at("i").as_int64() % 10 != 0;
+        });
+        pipeline.add_stage([](Scrapp::Item& item) {
+            item["seen"] = true;
+            return true;
+        });
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&pipeline] {
+                for (int i = 0; i < 1000; ++i) {
+                    pipeline.emit({{"i", i}});
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        pipeline.flush();
+
+        REQUIRE(items.size() == 3600);
+        REQUIRE(items.front().at("seen") == true);
+        auto stats = pipeline.stats();
+        REQUIRE(stats.emitted == 3600);
+        REQUIRE(stats.dropped == 400);
+        REQUIRE(stats.written == 3600);
+    }
+
+    SECTION("sink errors reach the emitting side") {
+        Scrapp::ItemPipeline pipeline{options};
+        pipeline.add_sink(std::make_unique<FailingSink>());
+        pipeline.emit({{"i", 1}});
+        REQUIRE_THROWS_AS(pipeline.flush(), Scrapp::item_pipeline_exception);
+        REQUIRE_THROWS_AS(
+            pipeline.emit({{"i", 2}}), Scrapp::item_pipeline_exception);
+    }
+
+    SECTION("closed pipelines reject items") {
+        Scrapp::ItemPipeline pipeline{options};
+        pipeline.close();
+        REQUIRE_THROWS_AS(
+            pipeline.emit({{"i", 1}}), Scrapp::item_pipeline_exception);
+    }
+}
+
+TEST_CASE("Spider item errors") {
+    auto sink = std::make_unique<FailingSink>();
+    EmittingSpider spider{*sink};
+    spider.pipeline().add_sink(std::move(sink));
+    spider.set_transport(std::make_shared<PageTransport>());
+    spider.add_request("https://example.com/1");
+    spider.start();
+
+    REQUIRE_THROWS_AS(spider.wait(), Scrapp::item_pipeline_exception);
+    REQUIRE(spider.parsed == 1);
+}
+
+TEST_CASE("Item sinks") {
+    auto directory = temp_directory("scrapp_item_sinks");
+    Scrapp::FileSinkOptions options;
+
+    SECTION("JSON lines") {
+        options.path = (directory / "items.jsonl").string();
+        Scrapp::ItemPipeline pipeline;
+        pipeline.add_sink(std::make_unique<Scrapp::JsonLinesSink>(options));
+        pipeline.emit({{"name", "a"}, {"price", 1}});
+        pipeline.emit({{"name", "b"}, {"tags", {"x", "y"}}});
+        pipeline.close();
+        REQUIRE(
+            read_file(options.path) ==
+            "{\"name\":\"a\",\"price\":1}\n"
+            "{\"name\":\"b\",\"tags\":[\"x\",\"y\"]}\n");
+    }
+
+    SECTION("CSV quotes fields and writes JSON for nested values") {
+        options.path = (directory / "items.csv").string();
+        Scrapp::ItemPipeline pipeline;
+        pipeline.add_sink(std::make_unique<Scrapp::CsvSink>(
+            options, std::vector<std::string>{"name", "price", "tags"}));
+        pipeline.emit({{"name", "a \"b\", c"}, {"price", 1.5}});
+        pipeline.emit({{"tags", {"x"}}, {"price", nullptr}});
+        pipeline.close();
+        REQUIRE(
+            read_file(options.path) ==
+            "name,price,tags\r\n"
+            "\"a \"\"b\"\", c\",1.5E0,\r\n"
+            ",,\"[\"\"x\"\"]\"\r\n");
+    }
+
+    SECTION("files rotate once they reach rotate_bytes") {
+        options.path = (directory / "items.csv").string();
+        options.rotate_bytes = 64;
+        options.buffer_size = 16;
+        options.fsync = Scrapp::FsyncPolicy::on_flush;
+        auto sink = std::make_unique<Scrapp::CsvSink>(
+            options, std::vector<std::string>{"i"});
+        const auto& files = sink->files();
+        Scrapp::ItemPipeline pipeline;
+        pipeline.add_sink(std::move(sink));
+        for (int i = 0; i < 100; ++i) {
+            pipeline.emit({{"i", i}});
+        }
+        pipeline.close();
+
+        REQUIRE(files.size() > 1);
+        REQUIRE(files[0] == (directory / "items.00000.csv").string());
+        std::size_t rows = 0;
+        for (const auto& file : files) {
+            auto content = read_file(file);
+            REQUIRE(content.rfind("i\r\n", 0) == 0);
+            rows += count_lines(content) - 1;
+        }
+        REQUIRE(rows == 100);
+    }
+
+    SECTION("unwritable paths throw right away") {
+        options.path = (directory / "missing" / "items.jsonl").string();
+        REQUIRE_THROWS_AS(
+            Scrapp::JsonLinesSink{options}, Scrapp::item_pipeline_exception);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("ItemPipeline benchmarks", "[.][benchmark]") {
+    auto directory = temp_directory("scrapp_pipeline_benchmarks");
+    auto path = (directory / "items.jsonl").string();
+    constexpr int threads = 4;
+    constexpr int items = 25000;
+    auto run = [](auto&& emit) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&emit, t] {
+                for (int i = 0; i < items; ++i) {
+                    emit(Scrapp::Item{
+                        {"thread", t}, {"i", i}, {"name", "product"}});
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    BENCHMARK("mutex guarded ofstream") {
+        std::ofstream file{path};
+        std::mutex mutex;
+        run([&](const Scrapp::Item& item) {
+            std::lock_guard<std::mutex> lock{mutex};
+            file << boost::json::serialize(item) << '\n';
+        });
+    };
+    BENCHMARK("ItemPipeline with JsonLinesSink") {
+        Scrapp::FileSinkOptions options;
+        options.path = path;
+        Scrapp::ItemPipeline pipeline;
+        pipeline.add_sink(std::make_unique<Scrapp::JsonLinesSink>(options));
+        run([&](Scrapp::Item item) { pipeline.emit(std::move(item)); });
+        pipeline.close();
+    };
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,178 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "exceptions.h"
+#include "recrawl.h"
+#include "test_utils.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+    using Clock = std::chrono::system_clock;
+    using std::chrono::hours;
+
+    const Clock::time_point start{std::chrono::seconds{1700000000}};
+
+    // Visits url every interval for count visits, changing its content on
+    // every visit if changing.
+    Clock::time_point visit(
+        Scrapp::RecrawlScheduler& scheduler, const std::string& url,
+        int count, hours interval, bool changing) {
+        auto now = start;
+        for (int i = 0; i < count; ++i, now += interval) {
+            scheduler.observe(
+                url, changing ? ~std::uint64_t{0} * (i % 2) : 0, now);
+        }
+        return now - interval;
+    }
+
+    Scrapp::Response not_modified(const std::string& url) {
+        Scrapp::Response response;
+        response.url = Scrapp::Url{url};
+        response.status_code = 304;
+        return response;
+    }
+} // namespace
+
+TEST_CASE("RecrawlScheduler") {
+    Scrapp::RecrawlOptions options;
+    options.min_interval = hours{1};
+    options.max_interval = hours{24 * 30};
+    options.initial_interval = hours{24};
+    Scrapp::RecrawlScheduler scheduler{options};
+
+    SECTION("first visits are due after the initial interval") {
+        REQUIRE_FALSE(scheduler.observe("https://a.com/", 1, start));
+        REQUIRE(scheduler.next_visit("https://a.com/") == start + hours{24});
+        REQUIRE(scheduler.due(start + hours{23}).empty());
+        REQUIRE(scheduler.due(start + hours{24}).size() == 1);
+    }
+
+    SECTION("pages that change often are revisited sooner") {
+        auto last = visit(scheduler, "https://a.com/news", 10, hours{6}, true);
+        visit(scheduler, "https://a.com/about", 10, hours{6}, false);
+        auto news = scheduler.history("https://a.com/news");
+        REQUIRE(news->visits == 10);
+        REQUIRE(news->changes == 9);
+        REQUIRE(
+            scheduler.change_rate("https://a.com/news") >
+            scheduler.change_rate("https://a.com/about"));
+        REQUIRE(scheduler.next_visit("https://a.com/news") < last + hours{6});
+        REQUIRE(
+            scheduler.next_visit("https://a.com/about") ==
+            last + options.max_interval);
+    }
+
+    SECTION("small differences are not changes") {
+        REQUIRE_FALSE(scheduler.observe("https://a.com/", 0, start));
+        REQUIRE_FALSE(scheduler.observe("https://a.com/", 0b11, start));
+        REQUIRE(scheduler.observe("https://a.com/", 0xff, start));
+    }
+
+    SECTION("due pages are most likely changed first and handed out once") {
+        visit(scheduler, "https://a.com/news", 10, hours{6}, true);
+        visit(scheduler, "https://a.com/about", 10, hours{6}, false);
+        scheduler.observe(
+            "https://a.com/new", 1, start, start - hours{24 * 365});
+        auto later = start + hours{24 * 365};
+        auto due = scheduler.due(later, 2);
+        REQUIRE(due.size() == 2);
+        REQUIRE(due[0].url() == "https://a.com/news");
+        REQUIRE(due[1].url() == "https://a.com/new");
+        REQUIRE(
+            due[1].headers().at("If-Modified-Since") ==
+            "Mon, 14 Nov 2022 22:13:20 GMT");
+        auto rest = scheduler.due(later);
+        REQUIRE(rest.size() == 1);
+        REQUIRE(rest[0].url() == "https://a.com/about");
+        REQUIRE(scheduler.due(later).empty());
+    }
+
+    SECTION("not modified responses are visits without changes") {
+        scheduler.observe("https://a.com/", 1, start);
+        REQUIRE_FALSE(scheduler.observe(not_modified("https://a.com/")));
+        auto history = scheduler.history("https://a.com/");
+        REQUIRE(history->visits == 2);
+        REQUIRE(history->fingerprint == 1);
+    }
+
+    SECTION("URLs are matched by fingerprint") {
+        scheduler.observe("https://a.com/p?b=1&a=2", 1, start);
+        REQUIRE(scheduler.history("https://A.com/p?a=2&b=1#x").has_value());
+        REQUIRE(scheduler.size() == 1);
+    }
+}
+
+TEST_CASE("RecrawlScheduler table") {
+    auto directory = Scrapp::Tests::temp_directory("scrapp_recrawl");
+    Scrapp::RecrawlOptions options;
+    options.path = (directory / "pages.bin").string();
+
+    SECTION("histories survive a restart") {
+        {
+            Scrapp::RecrawlScheduler scheduler{options};
+            visit(scheduler, "https://a.com/news", 5, hours{6}, true);
+            scheduler.observe("https://a.com/about", 7, start, start);
+            scheduler.save();
+        }
+        Scrapp::RecrawlScheduler scheduler{options};
+        REQUIRE(scheduler.size() == 2);
+        auto news = scheduler.history("https://a.com/news");
+        REQUIRE(news->visits == 5);
+        REQUIRE(news->changes == 4);
+        REQUIRE(news->first_visit == start);
+        auto about = scheduler.history("https://a.com/about");
+        REQUIRE(about->fingerprint == 7);
+        REQUIRE(about->last_modified == start);
+        REQUIRE(
+            scheduler.next_visit("https://a.com/about") ==
+            start + options.initial_interval);
+    }
+
+    SECTION("other files are rejected") {
+        std::ofstream{options.path} << "not a table";
+        REQUIRE_THROWS_AS(
+            Scrapp::RecrawlScheduler{options}, Scrapp::recrawl_exception);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("RecrawlScheduler benchmarks", "[.][benchmark]") {
+    Scrapp::RecrawlScheduler scheduler;
+    for (std::uint64_t i = 0; i < 1000000; ++i) {
+        scheduler.observe(
+            "https://example.com/item/" + std::to_string(i), i,
+            start + std::chrono::seconds{i});
+    }
+    BENCHMARK("observe") {
+        return scheduler.observe("https://example.com/item/42", 43, start);
+    };
+    BENCHMARK("due 1000 of 1000000") {
+        return scheduler.due(start + hours{24 * 365}, 1000).size();
+    };
+}
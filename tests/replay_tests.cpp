@@ -0,0 +1,254 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "exceptions.h"
+#include "replay.h"
+#include "spider.h"
+#include "test_utils.h"
+#include "warc.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+    using Scrapp::Tests::read_file;
+    using Scrapp::Tests::temp_directory;
+
+    Scrapp::Response make_response(const std::string& url, int page) {
+        Scrapp::Response response;
+        response.url = Scrapp::Url{url};
+        response.status_code = 200;
+        response.raw_header = "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: text/html\r\n\r\n";
+        response.text = "<html>page " + std::to_string(page) + "</html>";
+        return response;
+    }
+
+    // Records a redirected request and pages 1 to count of a listing.
+    std::vector<std::string> record(
+        const std::filesystem::path& directory,
+        Scrapp::WarcCompression compression, int count) {
+        Scrapp::WarcOptions options;
+        options.path = (directory / "capture").string();
+        options.compression = compression;
+        Scrapp::WarcWriter writer{options};
+        Scrapp::Request moved{Scrapp::Url{"https://example.com/old"}};
+        auto response = make_response("https://example.com/new", 0);
+        response.raw_header = "HTTP/1.1 301 Moved Permanently\r\n"
+                              "Location: /new\r\n\r\n" +
+                              response.raw_header;
+        writer.write(moved, response);
+        for (int page = 1; page <= count; ++page) {
+            Scrapp::Request request{Scrapp::Url{"https://example.com/list"}};
+            request.add_parameter({"sort", "asc"});
+            request.add_parameter({"page", std::to_string(page)});
+            writer.write(request, make_response(request.full_url(), page));
+        }
+        writer.close();
+        return writer.segments();
+    }
+
+    class ReplaySpider : public Scrapp::Spider {
+      public:
+        void parse(Scrapp::Response response) override {
+            std::lock_guard lock{this->mutex_};
+            this->bodies_.push_back(response.text);
+        }
+
+        std::vector<std::string> bodies() {
+            std::lock_guard lock{this->mutex_};
+            return this->bodies_;
+        }
+
+      private:
+        std::mutex mutex_;
+        std::vector<std::string> bodies_;
+    };
+} // namespace
+
+TEST_CASE("WarcArchive") {
+    auto directory = temp_directory("scrapp_replay");
+    Scrapp::WarcArchive archive{
+        record(directory, Scrapp::WarcCompression::gzip, 3)};
+
+    SECTION("requests find their response regardless of parameter order") {
+        REQUIRE(archive.size() == 5);
+        Scrapp::Request request{
+            Scrapp::Url{"https://EXAMPLE.com/list?page=2&sort=asc#top"}};
+        auto capture = archive.find(request);
+        REQUIRE(capture.has_value());
+        REQUIRE(capture->response.status_code == 200);
+        REQUIRE(capture->response.reason == "OK");
+        REQUIRE(capture->response.headers["Content-Type"] == "text/html");
+        REQUIRE(capture->response.text == "<html>page 2</html>");
+        REQUIRE(capture->date >= archive.first_capture());
+    }
+
+    SECTION("redirected requests find the final response") {
+        auto capture = archive.find(
+            Scrapp::Request{Scrapp::Url{"https://example.com/old"}});
+        REQUIRE(capture.has_value());
+        REQUIRE(capture->response.url.str() == "https://example.com/new");
+        REQUIRE(capture->response.text == "<html>page 0</html>");
+    }
+
+    SECTION("uncompressed archives are read in place") {
+        auto uncompressed = directory / "uncompressed";
+        std::filesystem::create_directories(uncompressed);
+        Scrapp::WarcArchive plain{
+            record(uncompressed, Scrapp::WarcCompression::none, 3)};
+        REQUIRE(plain.size() == 5);
+        auto capture = plain.find(Scrapp::Request{
+            Scrapp::Url{"https://example.com/list?sort=asc&page=3"}});
+        REQUIRE(capture.has_value());
+        REQUIRE(capture->response.text == "<html>page 3</html>");
+    }
+
+    SECTION("unknown requests are not found") {
+        REQUIRE_FALSE(
+            archive
+                .find(Scrapp::Request{Scrapp::Url{"https://example.com/list"}})
+                .has_value());
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("WarcArchive errors") {
+    auto directory = temp_directory("scrapp_replay_errors");
+
+    SECTION("missing segments throw") {
+        REQUIRE_THROWS_AS(
+            Scrapp::WarcArchive{{(directory / "missing.warc").string()}},
+            Scrapp::warc_exception);
+    }
+
+    SECTION("files that are not WARC throw") {
+        auto path = (directory / "notes.txt").string();
+        std::ofstream{path} << "not an archive\r\n\r\n";
+        REQUIRE_THROWS_AS(Scrapp::WarcArchive{{path}}, Scrapp::warc_exception);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("ReplayTransport") {
+    auto directory = temp_directory("scrapp_replay_transport");
+    auto archive = std::make_shared<Scrapp::WarcArchive>(
+        record(directory, Scrapp::WarcCompression::gzip, 5));
+
+    SECTION("missing requests get an error") {
+        Scrapp::ReplayTransport transport{archive};
+        auto response = transport.fetch(
+            Scrapp::Request{Scrapp::Url{"https://example.com/missing"}}, {});
+        REQUIRE(response.status_code == 0);
+        REQUIRE(response.error.code != cpr::ErrorCode::OK);
+    }
+
+    SECTION("unreadable records get an error") {
+        auto corrupt = directory / "corrupt";
+        std::filesystem::create_directories(corrupt);
+        auto segments = record(corrupt, Scrapp::WarcCompression::none, 2);
+        Scrapp::ReplayTransport transport{
+            std::make_shared<Scrapp::WarcArchive>(segments)};
+        // The archive maps the segment, so damage done after indexing is
+        // only seen when the record is read.
+        auto data = read_file(segments.front());
+        auto target =
+            data.find("WARC-Target-URI: https://example.com/list?page=2");
+        REQUIRE(target != std::string::npos);
+        auto record_start = data.rfind("WARC/1.1", target);
+        {
+            std::fstream file{segments.front(), std::ios::in | std::ios::out};
+            file.seekp(static_cast<std::streamoff>(record_start));
+            file << "XXXX";
+        }
+
+        Scrapp::Request request{Scrapp::Url{"https://example.com/list"}};
+        request.add_parameter({"page", "2"});
+        request.add_parameter({"sort", "asc"});
+        auto response = transport.fetch(request, {});
+        REQUIRE(response.status_code == 0);
+        REQUIRE(response.error.code != cpr::ErrorCode::OK);
+        REQUIRE(response.error.message.find("malformed record") !=
+                std::string::npos);
+    }
+
+    SECTION("original timing never serves a response early") {
+        Scrapp::ReplayTransport transport{
+            archive, {Scrapp::ReplayTiming::original, 1.0}};
+        Scrapp::Request last{Scrapp::Url{"https://example.com/list"}};
+        last.add_parameter({"page", "5"});
+        last.add_parameter({"sort", "asc"});
+        auto recorded = archive->find(last)->date - archive->first_capture();
+        auto start = std::chrono::steady_clock::now();
+        transport.fetch(
+            Scrapp::Request{Scrapp::Url{"https://example.com/old"}}, {});
+        transport.fetch(last, {});
+        REQUIRE(std::chrono::steady_clock::now() - start >= recorded);
+    }
+
+    SECTION("spiders crawl the archive") {
+        ReplaySpider spider;
+        spider.set_transport(
+            std::make_shared<Scrapp::ReplayTransport>(archive));
+        for (int page = 1; page <= 5; ++page) {
+            spider.add_request(
+                "https://example.com/list?page=" + std::to_string(page) +
+                "&sort=asc");
+        }
+        spider.start();
+        spider.wait();
+        auto bodies = spider.bodies();
+        REQUIRE(bodies.size() == 5);
+        for (const auto& body : bodies) {
+            REQUIRE(body.rfind("<html>page ", 0) == 0);
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("WarcArchive benchmarks", "[.][benchmark]") {
+    auto directory = temp_directory("scrapp_replay_benchmarks");
+    auto segments = record(directory, Scrapp::WarcCompression::gzip, 10000);
+
+    BENCHMARK("index 10000 exchanges") {
+        return Scrapp::WarcArchive{segments}.size();
+    };
+
+    Scrapp::WarcArchive archive{segments};
+    Scrapp::Request request{Scrapp::Url{"https://example.com/list"}};
+    request.add_parameter({"page", "5000"});
+    request.add_parameter({"sort", "asc"});
+    BENCHMARK("find") {
+        return archive.find(request)->response.text.size();
+    };
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,282 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "frontier.h"
+#include "robots.h"
+#include "spider.h"
+#include <algorithm>
+#include <atomic>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Serves robots.txt with a fixed status and body, and records every
+    // other fetch.
+    class FakeTransport : public Scrapp::Transport {
+      public:
+        FakeTransport(long status, std::string robots_txt)
+            : status_{status}, robots_txt_{std::move(robots_txt)} {}
+
+        Scrapp::Response fetch(
+            const Scrapp::Request& request,
+            const Scrapp::FetchOptions& /*options*/) override {
+            Scrapp::Response response;
+            response.url = Scrapp::Url{request.full_url()};
+            if (request.full_url().find("/robots.txt") != std::string::npos) {
+                ++this->robots_fetches;
+                std::this_thread::sleep_for(std::chrono::milliseconds{20});
+                response.status_code = this->status_;
+                response.text = this->robots_txt_;
+                return response;
+            }
+            std::lock_guard lock{this->mutex};
+            this->fetched.push_back(request.full_url());
+            this->fetch_times.push_back(std::chrono::steady_clock::now());
+            response.status_code = 200;
+            return response;
+        }
+
+        std::atomic<int> robots_fetches{0};
+        std::mutex mutex;
+        std::vector<std::string> fetched;
+        std::vector<std::chrono::steady_clock::time_point> fetch_times;
+
+      private:
+        long status_;
+        std::string robots_txt_;
+    };
+
+    class NullSpider : public Scrapp::Spider {
+      public:
+        using Scrapp::Spider::Spider;
+
+        void parse(Scrapp::Response /*response*/) override {}
+    };
+} // namespace
+
+TEST_CASE("RobotsRules") {
+    SECTION("the longest matching rule wins, Allow on ties") {
+        Scrapp::RobotsRules rules{
+            "User-agent: *\n"
+            "Disallow: /shop\n"
+            "Allow: /shop/public\n"
+            "Disallow: /shop/public/drafts\n"
+            "Allow: /page\n"
+            "Disallow: /page\n",
+            "Scrapp"};
+        REQUIRE(rules.allowed("/"));
+        REQUIRE_FALSE(rules.allowed("/shop"));
+        REQUIRE_FALSE(rules.allowed("/shopping?q=1"));
+        REQUIRE(rules.allowed("/shop/public/item"));
+        REQUIRE_FALSE(rules.allowed("/shop/public/drafts/1"));
+        REQUIRE(rules.allowed("/page"));
+        REQUIRE(rules.allowed("/robots.txt"));
+    }
+
+    SECTION("wildcards and end anchors") {
+        Scrapp::RobotsRules rules{
+            "User-agent: *\n"
+            "Disallow: /*.pdf$\n"
+            "Disallow: /*?sessionid=\n"
+            "Disallow: /exact$\n"
+            "Allow: /docs/*/public$\n"
+            "Disallow: /docs/\n",
+            "Scrapp"};
+        REQUIRE_FALSE(rules.allowed("/files/report.pdf"));
+        REQUIRE(rules.allowed("/files/report.pdf?download=1"));
+        REQUIRE_FALSE(rules.allowed("/a?sessionid=42"));
+        REQUIRE(rules.allowed("/a?id=42"));
+        REQUIRE_FALSE(rules.allowed("/exact"));
+        REQUIRE(rules.allowed("/exact/child"));
+        REQUIRE(rules.allowed("/docs/v2/public"));
+        REQUIRE_FALSE(rules.allowed("/docs/v2/private"));
+    }
+
+    SECTION("percent escapes match whatever their case") {
+        Scrapp::RobotsRules rules{
+            "User-agent: *\nDisallow: /caf%c3%a9\n", "Scrapp"};
+        REQUIRE_FALSE(rules.allowed("/caf%C3%A9/menu"));
+        REQUIRE_FALSE(rules.allowed("/caf%c3%a9"));
+    }
+
+    SECTION("the user agent's groups replace the * groups") {
+        std::string robots_txt = "# comment\n"
+                                 "User-agent: *\n"
+                                 "Disallow: /\n"
+                                 "\n"
+                                 "User-agent: other\n"
+                                 "User-agent: scrapp\n"
+                                 "Disallow: /private # inline comment\n"
+                                 "Crawl-delay: 1.5\n"
+                                 "\n"
+                                 "Sitemap: https://example.com/sitemap.xml\n"
+                                 "User-agent: SCRAPP\n"
+                                 "Disallow: /tmp\n"
+                                 "Disallow:\n";
+        Scrapp::RobotsRules rules{robots_txt, "Scrapp/1.0 (+https://x)"};
+        REQUIRE(rules.allowed("/public"));
+        REQUIRE_FALSE(rules.allowed("/private/1"));
+        REQUIRE_FALSE(rules.allowed("/tmp"));
+        REQUIRE(rules.crawl_delay() == std::chrono::milliseconds{1500});
+        REQUIRE(
+            rules.sitemaps() ==
+            std::vector<std::string>{"https://example.com/sitemap.xml"});
+
+        Scrapp::RobotsRules others{robots_txt, "OtherBot"};
+        REQUIRE_FALSE(others.allowed("/public"));
+        REQUIRE_FALSE(others.crawl_delay().has_value());
+    }
+}
+
+TEST_CASE("RobotsCache") {
+    SECTION("each host's file is fetched once") {
+        auto transport = std::make_shared<FakeTransport>(
+            200, "User-agent: *\nDisallow: /private\n");
+        Scrapp::RobotsCache cache{transport};
+        std::vector<std::thread> threads;
+        std::atomic<int> allowed{0};
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&cache, &allowed] {
+                allowed += cache.allowed("https://example.com/public");
+                allowed += cache.allowed("https://EXAMPLE.com/private/a");
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(allowed == 8);
+        REQUIRE(transport->robots_fetches == 1);
+        REQUIRE(cache.allowed("https://other.com/public"));
+        REQUIRE(transport->robots_fetches == 2);
+        REQUIRE(cache.size() == 2);
+    }
+
+    SECTION("missing files allow everything") {
+        auto transport = std::make_shared<FakeTransport>(404, "");
+        Scrapp::RobotsCache cache{transport};
+        REQUIRE(cache.allowed("https://example.com/private"));
+    }
+
+    SECTION("server errors disallow everything until error_ttl") {
+        auto transport = std::make_shared<FakeTransport>(503, "");
+        Scrapp::RobotsOptions options;
+        options.error_ttl = std::chrono::seconds{0};
+        Scrapp::RobotsCache cache{transport, options};
+        REQUIRE_FALSE(cache.allowed("https://example.com/"));
+        REQUIRE_FALSE(cache.allowed("https://example.com/"));
+        REQUIRE(transport->robots_fetches == 2);
+    }
+
+    SECTION("inserted files are not fetched") {
+        auto transport = std::make_shared<FakeTransport>(200, "");
+        Scrapp::RobotsCache cache{transport};
+        cache.insert("https://example.com/a", "User-agent: *\nDisallow: /");
+        REQUIRE_FALSE(cache.allowed("https://example.com/b"));
+        REQUIRE(transport->robots_fetches == 0);
+    }
+}
+
+TEST_CASE("Spider robots") {
+    auto transport = std::make_shared<FakeTransport>(
+        200, "User-agent: *\nDisallow: /private\nCrawl-delay: 0.05\n");
+    NullSpider spider;
+    spider.set_transport(transport);
+    spider.set_robots(std::make_shared<Scrapp::RobotsCache>(transport));
+    spider.add_request("https://example.com/1");
+    spider.add_request("https://example.com/private/2");
+    spider.add_request("https://example.com/3");
+    spider.add_request("https://example.com/4");
+    spider.start();
+    spider.wait();
+
+    REQUIRE(transport->fetched.size() == 3);
+    std::sort(transport->fetch_times.begin(), transport->fetch_times.end());
+    for (std::size_t i = 1; i < transport->fetch_times.size(); ++i) {
+        REQUIRE(
+            transport->fetch_times[i] - transport->fetch_times[i - 1] >=
+            std::chrono::milliseconds{45});
+    }
+}
+
+TEST_CASE("Spider crawl delay") {
+    auto transport = std::make_shared<FakeTransport>(404, "");
+    auto robots = std::make_shared<Scrapp::RobotsCache>(transport);
+    robots->insert("https://slow.com/", "User-agent: *\nCrawl-delay: 0.3\n");
+    NullSpider spider{1};
+    spider.set_transport(transport);
+    spider.set_robots(robots);
+    // The slow host comes first and has more requests than there are
+    // slots.
+    for (int i = 0; i < 3; ++i) {
+        Scrapp::Request request{
+            Scrapp::Url{"https://slow.com/" + std::to_string(i)}};
+        request.set_priority(1);
+        spider.add_request(request);
+    }
+    for (int i = 0; i < 3; ++i) {
+        spider.add_request("https://fast.com/" + std::to_string(i));
+    }
+    spider.start();
+    spider.wait();
+
+    REQUIRE(transport->fetched.size() == 6);
+    std::vector<std::chrono::steady_clock::time_point> slow;
+    std::vector<std::chrono::steady_clock::time_point> fast;
+    for (std::size_t i = 0; i < transport->fetched.size(); ++i) {
+        auto& times =
+            transport->fetched[i].find("slow.com") != std::string::npos
+                ? slow
+                : fast;
+        times.push_back(transport->fetch_times[i]);
+    }
+    std::sort(slow.begin(), slow.end());
+    for (std::size_t i = 1; i < slow.size(); ++i) {
+        REQUIRE(slow[i] - slow[i - 1] >= std::chrono::milliseconds{295});
+    }
+    // The fast host is not held up by the slow host's waits.
+    REQUIRE(*std::max_element(fast.begin(), fast.end()) < slow[1]);
+}
+
+TEST_CASE("RobotsRules benchmarks", "[.][benchmark]") {
+    std::string robots_txt = "User-agent: *\n";
+    for (int i = 0; i < 200; ++i) {
+        robots_txt += "Disallow: /section" + std::to_string(i) + "/private\n";
+        robots_txt += "Allow: /section" + std::to_string(i) + "/private/ok\n";
+    }
+    robots_txt += "Disallow: /*?sessionid=\nDisallow: /*.pdf$\n";
+    Scrapp::RobotsRules rules{robots_txt, "Scrapp"};
+    BENCHMARK("allowed with 400 rules") {
+        return rules.allowed("/section150/private/ok/products?page=3");
+    };
+
+    Scrapp::RobotsCache cache{std::make_shared<FakeTransport>(404, "")};
+    cache.insert("https://example.com/", robots_txt);
+    BENCHMARK("cached allowed") {
+        return cache.allowed("https://example.com/section7/private/x");
+    };
+}
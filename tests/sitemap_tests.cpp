@@ -0,0 +1,376 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "exceptions.h"
+#include "sitemap.h"
+#include "spider.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+    std::string gzip(const std::string& text) {
+        z_stream stream{};
+        REQUIRE(
+            deflateInit2(
+                &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                Z_DEFAULT_STRATEGY) == Z_OK);
+        std::string out(deflateBound(&stream, text.size()), '\0');
+        stream.next_in =
+            reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+        stream.avail_in = static_cast<uInt>(text.size());
+        stream.next_out = reinterpret_cast<Bytef*>(out.data());
+        stream.avail_out = static_cast<uInt>(out.size());
+        REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+
+    std::string urlset(const std::vector<std::string>& urls) {
+        std::string xml = R"(<?xml version="1.0" encoding="UTF-8"?>)"
+                          R"(<urlset xmlns="http://www.sitemaps.org/)"
+                          R"(schemas/sitemap/0.9">)";
+        for (const auto& url : urls) {
+            xml += "<url><loc>" + url + "</loc></url>";
+        }
+        return xml + "</urlset>";
+    }
+
+    // Serves fixed bodies in chunks of chunk_size, 404 for anything else.
+    class FakeTransport : public Scrapp::Transport {
+      public:
+        explicit FakeTransport(std::size_t chunk_size = 7)
+            : chunk_size_{chunk_size} {}
+
+        Scrapp::Response fetch(
+            const Scrapp::Request& request,
+            const Scrapp::FetchOptions& /*options*/) override {
+            Scrapp::Response response;
+            response.url = Scrapp::Url{request.full_url()};
+            this->fetched.push_back(request.full_url());
+            auto body = this->bodies.find(request.full_url());
+            if (body == this->bodies.end()) {
+                response.status_code = 404;
+            } else {
+                response.status_code = 200;
+                response.text = body->second;
+            }
+            return response;
+        }
+
+        Scrapp::Response fetch_stream(
+            const Scrapp::Request& request,
+            const Scrapp::BodyCallback& on_body) override {
+            auto response = this->fetch(request, {});
+            std::string_view text = response.text;
+            for (std::size_t i = 0; i < text.size(); i += this->chunk_size_) {
+                if (!on_body(text.substr(i, this->chunk_size_))) {
+                    break;
+                }
+            }
+            response.text.clear();
+            return response;
+        }
+
+        std::map<std::string, std::string> bodies;
+        std::vector<std::string> fetched;
+
+      private:
+        std::size_t chunk_size_;
+    };
+
+    class NullSpider : public Scrapp::Spider {
+      public:
+        void parse(Scrapp::Response /*response*/) override {}
+    };
+
+    std::vector<Scrapp::SitemapEntry> parse_in_chunks(
+        const std::string& xml, std::size_t chunk_size,
+        std::vector<Scrapp::SitemapEntry>* sitemaps = nullptr) {
+        std::vector<Scrapp::SitemapEntry> urls;
+        Scrapp::SitemapParser parser{
+            [&urls](Scrapp::SitemapEntry&& entry) {
+                urls.push_back(std::move(entry));
+            },
+            [sitemaps](Scrapp::SitemapEntry&& entry) {
+                if (sitemaps != nullptr) {
+                    sitemaps->push_back(std::move(entry));
+                }
+            }};
+        for (std::size_t i = 0; i < xml.size(); i += chunk_size) {
+            parser.write(std::string_view{xml}.substr(i, chunk_size));
+        }
+        parser.finish();
+        return urls;
+    }
+} // namespace
+
+TEST_CASE("SitemapParser") {
+    SECTION("parses the same at any chunk size") {
+        std::string xml =
+            R"(<?xml version="1.0" encoding="UTF-8"?>)"
+            "<!-- generated <url><loc>http://no/</loc></url> -->"
+            R"(<urlset xmlns="http://www.sitemaps.org/schemas/sitemap/0.9">)"
+            "<url>\n  <loc> http://example.com/?a=1&amp;b=2 </loc>\n"
+            "  <lastmod>2005-01-01</lastmod>\n  <priority>0.8</priority>"
+            "</url>"
+            "<url><loc><![CDATA[http://example.com/a&b]]></loc></url>"
+            "<url><lastmod>2005-01-01</lastmod></url>"
+            "<url><loc>http://example.com/&#233;t&#xE9;</loc>"
+            "<lastmod>2004-12-23T18:00:15+01:00</lastmod></url>"
+            "</urlset>";
+        for (std::size_t chunk_size : {1, 2, 3, 5, 64, 4096}) {
+            auto urls = parse_in_chunks(xml, chunk_size);
+            REQUIRE(urls.size() == 3);
+            REQUIRE(urls[0].loc == "http://example.com/?a=1&b=2");
+            REQUIRE(
+                urls[0].lastmod ==
+                Scrapp::parse_w3c_datetime("2005-01-01"));
+            REQUIRE(urls[1].loc == "http://example.com/a&b");
+            REQUIRE_FALSE(urls[1].lastmod.has_value());
+            REQUIRE(urls[2].loc == "http://example.com/\xC3\xA9t\xC3\xA9");
+            REQUIRE(urls[2].lastmod.has_value());
+        }
+    }
+
+    SECTION("reports index entries and ignores namespace prefixes") {
+        std::vector<Scrapp::SitemapEntry> sitemaps;
+        auto urls = parse_in_chunks(
+            "<sm:sitemapindex xmlns:sm=\"x\"><sm:sitemap>"
+            "<sm:loc>http://example.com/a.xml.gz</sm:loc>"
+            "<sm:lastmod>2020-05-01T00:00:00Z</sm:lastmod>"
+            "</sm:sitemap><sitemap><loc>http://example.com/b.xml</loc>"
+            "</sitemap><sitemap/></sm:sitemapindex>",
+            4, &sitemaps);
+        REQUIRE(urls.empty());
+        REQUIRE(sitemaps.size() == 2);
+        REQUIRE(sitemaps[0].loc == "http://example.com/a.xml.gz");
+        REQUIRE(sitemaps[0].lastmod.has_value());
+        REQUIRE(sitemaps[1].loc == "http://example.com/b.xml");
+    }
+
+    SECTION("rejects truncated and oversized documents") {
+        REQUIRE_THROWS_AS(
+            parse_in_chunks("<urlset><url><loc>http://a/</lo", 4),
+            Scrapp::sitemap_exception);
+        REQUIRE_THROWS_AS(
+            parse_in_chunks(
+                "<urlset><url><loc>" + std::string(100000, 'a') + "</loc>",
+                4096),
+            Scrapp::sitemap_exception);
+        REQUIRE_THROWS_AS(
+            parse_in_chunks("<!-- " + std::string(2 << 20, 'a'), 4096),
+            Scrapp::sitemap_exception);
+    }
+}
+
+TEST_CASE("parse_w3c_datetime") {
+    using namespace std::chrono;
+    auto epoch = system_clock::time_point{};
+    REQUIRE(Scrapp::parse_w3c_datetime("1970") == epoch);
+    REQUIRE(Scrapp::parse_w3c_datetime("1970-01-02") == epoch + hours{24});
+    REQUIRE(
+        Scrapp::parse_w3c_datetime("1970-01-01T01:00+01:00") == epoch);
+    REQUIRE(
+        Scrapp::parse_w3c_datetime("1969-12-31T23:00:00-01:00") == epoch);
+    REQUIRE(
+        Scrapp::parse_w3c_datetime("1970-01-01T00:00:01.5Z") ==
+        epoch + milliseconds{1500});
+    REQUIRE(
+        Scrapp::parse_w3c_datetime("2004-12-23T18:00:15+01:00") ==
+        system_clock::time_point{seconds{1103821215}});
+    REQUIRE_FALSE(Scrapp::parse_w3c_datetime("").has_value());
+    REQUIRE_FALSE(Scrapp::parse_w3c_datetime("2004-13-01").has_value());
+    REQUIRE_FALSE(Scrapp::parse_w3c_datetime("2004-12-23T18:00").has_value());
+    REQUIRE_FALSE(Scrapp::parse_w3c_datetime("yesterday").has_value());
+}
+
+TEST_CASE("GzipStream") {
+    auto text = urlset({"http://example.com/1", "http://example.com/2"});
+    std::string out;
+    auto collect = [&out](std::string_view data) { out.append(data); };
+
+    SECTION("inflates gzip in any chunks, including concatenated members") {
+        auto compressed = gzip(text) + gzip(text);
+        Scrapp::GzipStream stream{collect};
+        for (std::size_t i = 0; i < compressed.size(); i += 3) {
+            stream.write(std::string_view{compressed}.substr(i, 3));
+        }
+        stream.finish();
+        REQUIRE(out == text + text);
+    }
+
+    SECTION("passes plain text through") {
+        Scrapp::GzipStream stream{collect};
+        stream.write("<");
+        stream.write(text.substr(1));
+        stream.finish();
+        REQUIRE(out == text);
+    }
+
+    SECTION("rejects corrupt and truncated streams") {
+        auto compressed = gzip(text);
+        Scrapp::GzipStream truncated{collect};
+        truncated.write(compressed.substr(0, compressed.size() / 2));
+        REQUIRE_THROWS_AS(truncated.finish(), Scrapp::sitemap_exception);
+
+        compressed[12] = static_cast<char>(~compressed[12]);
+        compressed[13] = static_cast<char>(~compressed[13]);
+        Scrapp::GzipStream corrupt{collect};
+        REQUIRE_THROWS_AS(
+            [&] {
+                corrupt.write(compressed);
+                corrupt.finish();
+            }(),
+            Scrapp::sitemap_exception);
+    }
+}
+
+TEST_CASE("SitemapLoader") {
+    auto transport = std::make_shared<FakeTransport>();
+    transport->bodies["http://example.com/sitemap.xml"] =
+        "<sitemapindex>"
+        "<sitemap><loc>http://example.com/a.xml.gz</loc>"
+        "<lastmod>2021-01-01</lastmod></sitemap>"
+        "<sitemap><loc>http://example.com/b.xml</loc>"
+        "<lastmod>2019-01-01</lastmod></sitemap>"
+        "<sitemap><loc>http://example.com/missing.xml</loc></sitemap>"
+        "<sitemap><loc>http://example.com/sitemap.xml</loc></sitemap>"
+        "</sitemapindex>";
+    transport->bodies["http://example.com/a.xml.gz"] = gzip(
+        "<urlset>"
+        "<url><loc>http://example.com/new</loc>"
+        "<lastmod>2021-01-01</lastmod></url>"
+        "<url><loc>http://example.com/old</loc>"
+        "<lastmod>2019-01-01</lastmod></url>"
+        "<url><loc>http://example.com/undated</loc></url>"
+        "</urlset>");
+    transport->bodies["http://example.com/b.xml"] =
+        urlset({"http://example.com/b1", "http://example.com/b2"});
+
+    std::vector<std::vector<std::string>> batches;
+    auto enqueue = [&batches](std::vector<Scrapp::Request>&& requests) {
+        auto& batch = batches.emplace_back();
+        for (const auto& request : requests) {
+            batch.push_back(request.full_url());
+        }
+    };
+
+    SECTION("follows indexes once and counts failed sitemaps") {
+        Scrapp::SitemapOptions options;
+        options.batch_size = 2;
+        Scrapp::SitemapLoader loader{transport, options};
+        auto stats = loader.load("http://example.com/sitemap.xml", enqueue);
+        REQUIRE(stats.sitemaps == 4);
+        REQUIRE(stats.failed_sitemaps == 1);
+        REQUIRE(stats.urls == 5);
+        REQUIRE(stats.skipped_urls == 0);
+        REQUIRE(
+            batches == std::vector<std::vector<std::string>>{
+                           {"http://example.com/new", "http://example.com/old"},
+                           {"http://example.com/undated",
+                            "http://example.com/b1"},
+                           {"http://example.com/b2"}});
+    }
+
+    SECTION("filters by lastmod") {
+        Scrapp::SitemapOptions options;
+        options.modified_since = Scrapp::parse_w3c_datetime("2020-01-01");
+        options.keep_undated = false;
+        Scrapp::SitemapLoader loader{transport, options};
+        auto stats = loader.load("http://example.com/sitemap.xml", enqueue);
+        // b.xml is older than modified_since and not fetched.
+        REQUIRE(stats.sitemaps == 3);
+        REQUIRE(stats.urls == 1);
+        REQUIRE(stats.skipped_urls == 2);
+        REQUIRE(
+            batches ==
+            std::vector<std::vector<std::string>>{{"http://example.com/new"}});
+        REQUIRE(
+            std::count(
+                transport->fetched.begin(), transport->fetched.end(),
+                "http://example.com/b.xml") == 0);
+    }
+
+    SECTION("stops at max_depth") {
+        Scrapp::SitemapOptions options;
+        options.max_depth = 0;
+        Scrapp::SitemapLoader loader{transport, options};
+        auto stats = loader.load("http://example.com/sitemap.xml", enqueue);
+        REQUIRE(stats.sitemaps == 1);
+        REQUIRE(batches.empty());
+    }
+
+    SECTION("counts malformed sitemaps as failed") {
+        transport->bodies["http://example.com/b.xml"] = "<urlset><url><loc>";
+        Scrapp::SitemapLoader loader{transport};
+        auto stats = loader.load("http://example.com/sitemap.xml", enqueue);
+        REQUIRE(stats.failed_sitemaps == 2);
+        REQUIRE(stats.urls == 3);
+    }
+
+    SECTION("Spider::add_sitemap queues the URLs") {
+        NullSpider spider;
+        spider.set_transport(transport);
+        auto stats = spider.add_sitemap("http://example.com/sitemap.xml");
+        REQUIRE(stats.urls == 5);
+        REQUIRE(spider.request_queue().size() == 5);
+        REQUIRE(spider.request_queue().front().full_url() ==
+              "http://example.com/new");
+        REQUIRE(spider.request_queue().back().full_url() ==
+              "http://example.com/b2");
+    }
+}
+
+TEST_CASE("Sitemap benchmarks", "[.][benchmark]") {
+    std::vector<std::string> urls;
+    for (int i = 0; i < 50000; ++i) {
+        urls.push_back("http://example.com/products/" + std::to_string(i));
+    }
+    auto xml = urlset(urls);
+    auto compressed = gzip(xml);
+
+    BENCHMARK("parse 50000 URLs in 16 KiB chunks") {
+        return parse_in_chunks(xml, 16 * 1024).size();
+    };
+
+    BENCHMARK("inflate and parse 50000 URLs in 16 KiB chunks") {
+        std::size_t count = 0;
+        Scrapp::SitemapParser parser{
+            [&count](Scrapp::SitemapEntry&&) { ++count; },
+            [](Scrapp::SitemapEntry&&) {}};
+        Scrapp::GzipStream stream{
+            [&parser](std::string_view data) { parser.write(data); }};
+        for (std::size_t i = 0; i < compressed.size(); i += 16 * 1024) {
+            stream.write(std::string_view{compressed}.substr(i, 16 * 1024));
+        }
+        stream.finish();
+        parser.finish();
+        return count;
+    };
+}
@@ -142,7 +142,7 @@ TEST_CASE("Spider class") {
         mock_spider.start();
         mock_spider.wait();
         REQUIRE_NOTHROW(res.json());
-        auto js = res.json();
+        const auto& js = res.json();
         REQUIRE(js.at("url").get_string() == url);
     }
 
@@ -158,7 +158,7 @@ TEST_CASE("Spider class") {
         mock_spider.start();
         mock_spider.wait();
         REQUIRE_NOTHROW(res.json());
-        auto js = res.json();
+        const auto& js = res.json();
         REQUIRE(js.at("args").at("key").get_string() == "value");
     }
 
@@ -175,7 +175,7 @@ TEST_CASE("Spider class") {
         mock_spider.wait();
 
         REQUIRE_NOTHROW(res.json());
-        auto js = res.json();
+        const auto& js = res.json();
         REQUIRE(js.at("headers").at("Key") == "value");
     }
 
@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_TESTS_TEST_UTILS_H
+#define SCRAPP_TESTS_TEST_UTILS_H
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace Scrapp::Tests {
+    // A new empty directory under the system temporary directory. The name
+    // gets the process id and a counter appended, so test processes running
+    // side by side never share one.
+    inline std::filesystem::path temp_directory(const std::string& name) {
+        static std::atomic<unsigned> next{0};
+        auto path = std::filesystem::temp_directory_path() /
+                    (name + "_" + std::to_string(::getpid()) + "_" +
+                     std::to_string(next++));
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        return path;
+    }
+
+    inline std::string read_file(const std::filesystem::path& path) {
+        std::ifstream file{path, std::ios::binary};
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+} // namespace Scrapp::Tests
+
+#endif // SCRAPP_TESTS_TEST_UTILS_H
@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "utils.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+    // The ostringstream based implementations the SIMD kernels replaced,
+    // kept as the reference for correctness checks and benchmarks.
+    std::string reference_url_encode(const std::string& value) {
+        std::ostringstream escaped;
+        escaped.fill('0');
+        escaped << std::hex;
+        for (char c : value) {
+            if (isalnum(static_cast<unsigned char>(c)) || c == '-' ||
+                c == '_' || c == '.' || c == '~') {
+                escaped << c;
+                continue;
+            }
+            escaped << std::uppercase;
+            escaped << '%' << std::setw(2) << int((unsigned char)c);
+            escaped << std::nouppercase;
+        }
+        return escaped.str();
+    }
+
+    std::string reference_url_decode(const std::string& text) {
+        std::ostringstream escaped;
+        for (std::size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '%' && i + 2 < text.size()) {
+                escaped << char(
+                    Scrapp::from_hex(text[i + 1]) << 4 |
+                    Scrapp::from_hex(text[i + 2]));
+                i += 2;
+            } else if (text[i] == '+') {
+                escaped << ' ';
+            } else {
+                escaped << text[i];
+            }
+        }
+        return escaped.str();
+    }
+
+    std::string random_string(std::mt19937& rng, std::size_t length) {
+        static const std::string alphabet =
+            "abcXYZ019-_.~ %+&=/?\x80\xff";
+        std::string s;
+        for (std::size_t i = 0; i < length; i++) {
+            if (rng() % 3 == 0) {
+                s += static_cast<char>(rng() % 256);
+            } else {
+                s += alphabet[rng() % alphabet.size()];
+            }
+        }
+        return s;
+    }
+} // namespace
+
+TEST_CASE("url_encode") {
+    SECTION("matches the reference encoder across vector boundaries") {
+        std::mt19937 rng(42);
+        for (std::size_t length = 0; length < 200; length++) {
+            auto s = random_string(rng, length);
+            REQUIRE(Scrapp::url_encode(s) == reference_url_encode(s));
+        }
+    }
+
+    SECTION("url_encoded_size is exact") {
+        std::string s = "some key=some value&page=2";
+        REQUIRE(Scrapp::url_encoded_size(s) == Scrapp::url_encode(s).size());
+    }
+
+    SECTION("url_encode_to writes into a caller provided buffer") {
+        std::string s = "a b/c";
+        std::string out(Scrapp::url_encoded_size(s), '\0');
+        auto written = Scrapp::url_encode_to(s, out.data());
+        REQUIRE(written == out.size());
+        REQUIRE(out == "a%20b%2Fc");
+    }
+}
+
+TEST_CASE("url_decode") {
+    SECTION("reverses url_encode") {
+        std::mt19937 rng(7);
+        for (std::size_t length = 0; length < 200; length++) {
+            auto s = random_string(rng, length);
+            REQUIRE(Scrapp::url_decode(Scrapp::url_encode(s)) == s);
+        }
+    }
+
+    SECTION("decodes plus signs to spaces") {
+        REQUIRE(Scrapp::url_decode("some+key%3Dvalue") == "some key=value");
+    }
+
+    SECTION("copies malformed escapes verbatim") {
+        REQUIRE(Scrapp::url_decode("%zz%41%4") == "%zzA%4");
+    }
+}
+
+TEST_CASE("to_lower") {
+    SECTION("lowercases ASCII letters only") {
+        std::string s = "ABC-xyz_[\xC4]@Z";
+        REQUIRE(Scrapp::to_lower(s) == "abc-xyz_[\xC4]@z");
+    }
+
+    SECTION("handles inputs longer than a vector") {
+        std::string s(100, 'Q');
+        REQUIRE(Scrapp::to_lower(s) == std::string(100, 'q'));
+    }
+}
+
+TEST_CASE("trim and case-insensitive comparison") {
+    SECTION("trim removes the given bytes from both ends") {
+        REQUIRE(Scrapp::trim(" \t a b\r\n") == "a b");
+        REQUIRE(Scrapp::trim(" \r\n\t").empty());
+        REQUIRE(Scrapp::trim("\f a \f", " \f") == "a");
+        REQUIRE(Scrapp::trim("\f a \f") == "\f a \f");
+    }
+
+    SECTION("only ASCII letters ignore case") {
+        REQUIRE(Scrapp::equals_ignore_case("Content-Length", "content-LENGTH"));
+        REQUIRE_FALSE(Scrapp::equals_ignore_case("content", "content-length"));
+        REQUIRE_FALSE(Scrapp::equals_ignore_case("\xC4", "\xE4"));
+        REQUIRE_FALSE(Scrapp::equals_ignore_case("[", "{"));
+        REQUIRE(Scrapp::starts_with_ignore_case("SCRIPT>", "script"));
+        REQUIRE_FALSE(Scrapp::starts_with_ignore_case("scr", "script"));
+    }
+}
+
+TEST_CASE("resolve_url") {
+    const std::string base = "http://a/b/c/d;p?q";
+
+    SECTION("RFC 3986 normal examples") {
+        REQUIRE(Scrapp::resolve_url(base, "g:h") == "g:h");
+        REQUIRE(Scrapp::resolve_url(base, "g") == "http://a/b/c/g");
+        REQUIRE(Scrapp::resolve_url(base, "./g") == "http://a/b/c/g");
+        REQUIRE(Scrapp::resolve_url(base, "/g") == "http://a/g");
+        REQUIRE(Scrapp::resolve_url(base, "?y") == "http://a/b/c/d;p?y");
+        REQUIRE(Scrapp::resolve_url(base, "g?y") == "http://a/b/c/g?y");
+        REQUIRE(Scrapp::resolve_url(base, "") == base);
+        REQUIRE(Scrapp::resolve_url(base, "..") == "http://a/b/");
+        REQUIRE(Scrapp::resolve_url(base, "../../g") == "http://a/g");
+    }
+
+    SECTION("RFC 3986 abnormal examples") {
+        REQUIRE(Scrapp::resolve_url(base, "../../../g") == "http://a/g");
+        REQUIRE(Scrapp::resolve_url(base, "/./g") == "http://a/g");
+        REQUIRE(Scrapp::resolve_url(base, "g..") == "http://a/b/c/g..");
+        REQUIRE(Scrapp::resolve_url(base, "g;x=1/../y") == "http://a/b/c/y");
+    }
+
+    SECTION("fragments are dropped and whitespace is trimmed") {
+        REQUIRE(Scrapp::resolve_url(base, "g#s") == "http://a/b/c/g");
+        REQUIRE(Scrapp::resolve_url(base, "#s") == base);
+        REQUIRE(Scrapp::resolve_url(base, " \n/g ") == "http://a/g");
+    }
+
+    SECTION("network-path references keep the base scheme") {
+        REQUIRE(Scrapp::resolve_url("https://a/b", "//cdn/x") ==
+                "https://cdn/x");
+        REQUIRE(Scrapp::resolve_url("https://a", "x") == "https://a/x");
+    }
+}
+
+TEST_CASE("url_fingerprint") {
+    SECTION("ignores case of scheme and host, fragments and query order") {
+        REQUIRE(
+            Scrapp::url_fingerprint("HTTPS://Example.COM/A?b=2&a=1#top") ==
+            "https://example.com/A?a=1&b=2");
+        REQUIRE(
+            Scrapp::url_fingerprint("https://example.com") ==
+            Scrapp::url_fingerprint("https://example.com/"));
+    }
+
+    SECTION("keeps path case and repeated parameters") {
+        REQUIRE(
+            Scrapp::url_fingerprint("http://a/P?x=2&&x=1") ==
+            "http://a/P?x=1&x=2");
+    }
+}
+
+TEST_CASE("url_pattern") {
+    REQUIRE(
+        Scrapp::url_pattern("HTTPS://Shop.COM/item/12/reviews?p=2&sid=a&p=3") ==
+        "https://shop.com/item/#/reviews?p&sid");
+    REQUIRE(
+        Scrapp::url_pattern("https://a.com/s/3f2a9c1be0d44a7c9e1f/view") ==
+        "https://a.com/s/*/view");
+    REQUIRE(Scrapp::url_pattern("https://a.com/v2/a") == "https://a.com/v#/a");
+}
+
+TEST_CASE("url_origin and url_target") {
+    REQUIRE(
+        Scrapp::url_origin("HTTPS://Example.com:8443/a?b#c") ==
+        "https://example.com:8443");
+    REQUIRE(Scrapp::url_target("https://example.com/a?b#c") == "/a?b");
+    REQUIRE(Scrapp::url_target("https://example.com") == "/");
+}
+
+TEST_CASE("utils benchmarks", "[.][benchmark]") {
+    std::string query;
+    for (int i = 0; i < 16; i++) {
+        query += "q=running+shoes&category=sports/outdoor&page=12&";
+    }
+    auto encoded = Scrapp::url_encode(query);
+    std::string header = "Content-Type: Application/JSON; Charset=UTF-8";
+
+    BENCHMARK("url_encode (reference)") {
+        return reference_url_encode(query);
+    };
+    BENCHMARK("url_encode") { return Scrapp::url_encode(query); };
+    BENCHMARK("url_decode (reference)") {
+        return reference_url_decode(encoded);
+    };
+    BENCHMARK("url_decode") { return Scrapp::url_decode(encoded); };
+    BENCHMARK("to_lower (std::transform)") {
+        std::string s = header;
+        std::transform(s.begin(), s.end(), s.begin(), tolower);
+        return s;
+    };
+    BENCHMARK("to_lower") { return Scrapp::to_lower(header); };
+}
@@ -0,0 +1,217 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "exceptions.h"
+#include "test_utils.h"
+#include "warc.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+    using Scrapp::Tests::read_file;
+    using Scrapp::Tests::temp_directory;
+
+    // Decompresses the one gzip member at entry, checking that it spans the
+    // whole entry.
+    std::string read_record(
+        const std::vector<std::string>& segments,
+        const Scrapp::WarcIndexEntry& entry) {
+        auto data = read_file(segments.at(entry.segment));
+        REQUIRE(entry.offset + entry.length <= data.size());
+        z_stream stream{};
+        REQUIRE(inflateInit2(&stream, 15 + 16) == Z_OK);
+        std::string record(1 << 20, '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(data.data() + entry.offset);
+        stream.avail_in = static_cast<uInt>(entry.length);
+        stream.next_out = reinterpret_cast<Bytef*>(record.data());
+        stream.avail_out = static_cast<uInt>(record.size());
+        auto status = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        REQUIRE(status == Z_STREAM_END);
+        REQUIRE(stream.total_in == entry.length);
+        record.resize(stream.total_out);
+        return record;
+    }
+
+    Scrapp::Response make_response(const std::string& url) {
+        Scrapp::Response response;
+        response.url = Scrapp::Url{url};
+        response.status_code = 200;
+        response.raw_header = "HTTP/1.1 301 Moved\r\nLocation: /b\r\n\r\n"
+                              "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: text/html\r\n"
+                              "Content-Encoding: gzip\r\n"
+                              "Content-Length: 17\r\n"
+                              "Transfer-Encoding: chunked\r\n\r\n";
+        response.text = "<html>" + url + "</html>";
+        return response;
+    }
+} // namespace
+
+TEST_CASE("WarcWriter") {
+    auto directory = temp_directory("scrapp_warc");
+    Scrapp::WarcOptions options;
+    options.path = (directory / "capture").string();
+
+    SECTION("exchanges are written as response and request records") {
+        Scrapp::WarcWriter writer{options};
+        Scrapp::Request request{Scrapp::Url{"https://example.com/b"}};
+        request.add_header({"Accept", "text/html"});
+        request.add_parameter({"page", "2"});
+        auto id = writer.write(
+            request, make_response("https://example.com/b?page=2"));
+        writer.close();
+
+        auto segments = writer.segments();
+        REQUIRE(segments.size() == 1);
+        REQUIRE(segments[0] == options.path + "-00000.warc.gz");
+        auto index = writer.index();
+        REQUIRE(index.size() == 3);
+        REQUIRE(index[0].type == "warcinfo");
+        REQUIRE(index[1].record_id == id);
+
+        auto response = read_record(segments, index[1]);
+        REQUIRE(response.rfind("WARC/1.1\r\nWARC-Type: response\r\n", 0) == 0);
+        REQUIRE(
+            response.find(
+                "WARC-Target-URI: https://example.com/b?page=2\r\n") !=
+            std::string::npos);
+        std::string body = "<html>https://example.com/b?page=2</html>";
+        std::string block = "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: text/html\r\n"
+                            "Content-Length: " +
+                            std::to_string(body.size()) + "\r\n\r\n" + body;
+        REQUIRE(
+            response.find(
+                "Content-Length: " + std::to_string(block.size()) +
+                "\r\n\r\n" + block + "\r\n\r\n") != std::string::npos);
+
+        auto recorded = read_record(segments, index[2]);
+        REQUIRE(
+            recorded.find("WARC-Concurrent-To: " + id) != std::string::npos);
+        REQUIRE(
+            recorded.find("GET /b?page=2 HTTP/1.1\r\nHost: example.com\r\n"
+                          "Accept: text/html\r\n\r\n") != std::string::npos);
+    }
+
+    SECTION("segments rotate and the index finds every record") {
+        options.rotate_bytes = 4096;
+        options.max_pending_records = 4;
+        Scrapp::WarcWriter writer{options};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&writer, t] {
+                for (int i = 0; i < 50; ++i) {
+                    writer.write(Scrapp::WarcRecord{
+                        "resource",
+                        "https://example.com/" + std::to_string(t) + "/" +
+                            std::to_string(i),
+                        "text/plain", std::string(200, 'a')});
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        writer.flush();
+
+        auto segments = writer.segments();
+        REQUIRE(segments.size() > 1);
+        auto found = writer.find("https://example.com/3/49", "resource");
+        REQUIRE(found.has_value());
+        REQUIRE(
+            read_record(segments, *found).find(std::string(200, 'a')) !=
+            std::string::npos);
+        std::size_t resources = 0;
+        for (const auto& entry : writer.index()) {
+            resources += entry.type == "resource";
+        }
+        REQUIRE(resources == 200);
+
+        writer.close();
+        REQUIRE_THROWS_AS(
+            writer.write(Scrapp::WarcRecord{"resource"}),
+            Scrapp::warc_exception);
+    }
+
+#ifndef SCRAPP_WITH_ZSTD
+    SECTION("zstd needs SCRAPP_WITH_ZSTD") {
+        options.compression = Scrapp::WarcCompression::zstd;
+        REQUIRE_THROWS_AS(Scrapp::WarcWriter{options}, Scrapp::warc_exception);
+    }
+#endif
+
+    SECTION("unwritable paths throw right away") {
+        options.path = (directory / "missing" / "capture").string();
+        REQUIRE_THROWS_AS(Scrapp::WarcWriter{options}, Scrapp::warc_exception);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("WarcWriter benchmarks", "[.][benchmark]") {
+    auto directory = temp_directory("scrapp_warc_benchmarks");
+    Scrapp::Request request{Scrapp::Url{"https://example.com/"}};
+    auto response = make_response("https://example.com/");
+    for (int i = 0; i < 2000; ++i) {
+        response.text += "<p class=\"item\">item " + std::to_string(i) + "</p>";
+    }
+
+    auto run = [&](Scrapp::WarcCompression compression) {
+        Scrapp::WarcOptions options;
+        options.path = (directory / "capture").string();
+        options.compression = compression;
+        Scrapp::WarcWriter writer{options};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 250; ++i) {
+                    writer.write(request, response);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        writer.close();
+        return writer.index().size();
+    };
+
+    BENCHMARK("1000 exchanges, uncompressed") {
+        return run(Scrapp::WarcCompression::none);
+    };
+    BENCHMARK("1000 exchanges, gzip") {
+        return run(Scrapp::WarcCompression::gzip);
+    };
+#ifdef SCRAPP_WITH_ZSTD
+    BENCHMARK("1000 exchanges, zstd") {
+        return run(Scrapp::WarcCompression::zstd);
+    };
+#endif
+
+    std::filesystem::remove_all(directory);
+}
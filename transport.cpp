@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "transport.h"
+#include "exceptions.h"
+#include "json.h"
+#include <cpr/cpr.h>
+#include <memory>
+#include <utility>
+
+namespace Scrapp {
+    namespace {
+        cpr::Parameters cpr_parameters(const Request& request) {
+            auto params = cpr::Parameters{};
+            for (const auto& [key, value] : request.parameters()) {
+                params.Add({key, value});
+            }
+            return params;
+        }
+
+        cpr::Header cpr_header(const Request& request) {
+            auto headers = cpr::Header{};
+            for (const auto& [key, value] : request.headers()) {
+                headers[key] = value;
+            }
+            return headers;
+        }
+    } // namespace
+
+    Response Transport::fetch_stream(
+        const Request& request, const BodyCallback& on_body) {
+        auto response = this->fetch(request, FetchOptions{});
+        if (response.error.code == cpr::ErrorCode::OK) {
+            on_body(response.text);
+        }
+        response.text.clear();
+        return response;
+    }
+
+    Response
+    HttpTransport::fetch(const Request& request, const FetchOptions& options) {
+        auto params = cpr_parameters(request);
+        auto headers = cpr_header(request);
+        if (!request.stream_json()) {
+            auto c_res = cpr::Get(cpr::Url{request.url()}, params, headers);
+            return Response(c_res);
+        }
+        // Returning false from the write callback aborts the transfer, so
+        // an invalid document stops downloading early.
+        JsonStream stream;
+        std::string body;
+        auto keep_body = options.keep_body;
+        auto c_res = cpr::Get(
+            cpr::Url{request.url()}, params, headers,
+            cpr::WriteCallback{
+                [&stream, &body, keep_body](auto data, intptr_t) {
+                    if (keep_body) {
+                        body.append(data);
+                    }
+                    return stream.write(data);
+                }});
+        // A failed download leaves the document incomplete.
+        std::shared_ptr<const boost::json::value> json;
+        try {
+            json = std::make_shared<const boost::json::value>(stream.finish());
+        } catch (const invalid_json_exception&) {
+            // Response::json reports the error.
+        }
+        Response response(c_res, std::move(json), stream.error());
+        response.text = std::move(body);
+        return response;
+    }
+
+    Response HttpTransport::fetch_stream(
+        const Request& request, const BodyCallback& on_body) {
+        auto c_res = cpr::Get(
+            cpr::Url{request.url()}, cpr_parameters(request),
+            cpr_header(request),
+            cpr::WriteCallback{[&on_body](auto data, intptr_t) {
+                return on_body(std::string_view{data.data(), data.size()});
+            }});
+        return Response(c_res);
+    }
+} // namespace Scrapp
@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_TRANSPORT_H
+#define SCRAPP_TRANSPORT_H
+
+#include "request.h"
+#include "response.h"
+#include <functional>
+#include <string_view>
+
+namespace Scrapp {
+    struct FetchOptions {
+        // Keep Response::text of stream_json requests too, e.g. to archive
+        // it.
+        bool keep_body{false};
+    };
+
+    // Receives a body as it downloads. Returning false aborts the transfer.
+    using BodyCallback = std::function<bool(std::string_view)>;
+
+    // Where a Spider gets its responses from. fetch() is called from many
+    // threads at once.
+    class Transport {
+      public:
+        virtual ~Transport() = default;
+
+        virtual Response
+        fetch(const Request& request, const FetchOptions& options) = 0;
+        // Hands the body to on_body chunk by chunk instead of keeping it in
+        // Response::text, for bodies too large to hold. The default fetches
+        // the whole body and hands it over at once.
+        virtual Response
+        fetch_stream(const Request& request, const BodyCallback& on_body);
+    };
+
+    // Fetches requests over the network with cpr, the default transport.
+    class HttpTransport : public Transport {
+      public:
+        Response
+        fetch(const Request& request, const FetchOptions& options) override;
+        Response fetch_stream(
+            const Request& request, const BodyCallback& on_body) override;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_TRANSPORT_H
@@ -21,58 +21,684 @@
 // SOFTWARE.
 
 #include "utils.h"
-#include <iomanip>
-#include <memory>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
 #include <string>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SCRAPP_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
 namespace Scrapp {
-    std::string url_encode(const std::string& value) {
-        std::ostringstream escaped;
-        escaped.fill('0');
-        escaped << std::hex;
-
-        for (char c : value) {
-            // Keep alphanumeric and other accepted characters intact
-            if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
-                escaped << c;
-                continue;
+    namespace {
+        constexpr char hex_digits[] = "0123456789ABCDEF";
+
+        constexpr bool is_unreserved(unsigned char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                   (c >= 'A' && c <= 'Z') || c == '-' || c == '_' ||
+                   c == '.' || c == '~';
+        }
+
+        constexpr std::array<bool, 256> make_unreserved_table() {
+            std::array<bool, 256> table{};
+            for (int c = 0; c < 256; c++) {
+                table[c] = is_unreserved(static_cast<unsigned char>(c));
+            }
+            return table;
+        }
+
+        constexpr std::array<std::int8_t, 256> make_hex_table() {
+            std::array<std::int8_t, 256> table{};
+            for (int c = 0; c < 256; c++) {
+                table[c] = -1;
+            }
+            for (int c = '0'; c <= '9'; c++) {
+                table[c] = static_cast<std::int8_t>(c - '0');
+            }
+            for (int c = 'a'; c <= 'f'; c++) {
+                table[c] = static_cast<std::int8_t>(c - 'a' + 10);
+                table[c - 'a' + 'A'] = static_cast<std::int8_t>(c - 'a' + 10);
+            }
+            return table;
+        }
+
+        constexpr auto unreserved_table = make_unreserved_table();
+        constexpr auto hex_table = make_hex_table();
+
+        inline std::size_t encode_byte(unsigned char c, char* out) {
+            if (unreserved_table[c]) {
+                *out = static_cast<char>(c);
+                return 1;
+            }
+            out[0] = '%';
+            out[1] = hex_digits[c >> 4];
+            out[2] = hex_digits[c & 0x0F];
+            return 3;
+        }
+
+        // Decodes the escape or plus sign at in[i], advancing i past it.
+        // Malformed escapes are copied verbatim.
+        inline char decode_special(const char* in, std::size_t n,
+                                   std::size_t& i) {
+            if (in[i] == '+') {
+                i++;
+                return ' ';
+            }
+            if (i + 2 < n) {
+                auto hi = hex_table[static_cast<unsigned char>(in[i + 1])];
+                auto lo = hex_table[static_cast<unsigned char>(in[i + 2])];
+                if (hi >= 0 && lo >= 0) {
+                    i += 3;
+                    return static_cast<char>((hi << 4) | lo);
+                }
+            }
+            i++;
+            return '%';
+        }
+
+        std::size_t encoded_size_scalar(const char* in, std::size_t n) {
+            std::size_t size = n;
+            for (std::size_t i = 0; i < n; i++) {
+                if (!unreserved_table[static_cast<unsigned char>(in[i])]) {
+                    size += 2;
+                }
+            }
+            return size;
+        }
+
+        std::size_t encode_scalar(const char* in, std::size_t n, char* out) {
+            std::size_t o = 0;
+            for (std::size_t i = 0; i < n; i++) {
+                o += encode_byte(static_cast<unsigned char>(in[i]), out + o);
+            }
+            return o;
+        }
+
+        std::size_t decode_scalar(const char* in, std::size_t n, char* out) {
+            std::size_t o = 0;
+            for (std::size_t i = 0; i < n;) {
+                if (in[i] == '%' || in[i] == '+') {
+                    out[o++] = decode_special(in, n, i);
+                } else {
+                    out[o++] = in[i++];
+                }
+            }
+            return o;
+        }
+
+        void to_lower_scalar(char* data, std::size_t n) {
+            for (std::size_t i = 0; i < n; i++) {
+                if (data[i] >= 'A' && data[i] <= 'Z') {
+                    data[i] = static_cast<char>(data[i] + ('a' - 'A'));
+                }
+            }
+        }
+
+#ifdef SCRAPP_X86_SIMD
+        // SSE2 is part of the x86-64 baseline, so only the AVX2 kernels need
+        // a runtime check. Every kernel handles whole vectors and hands the
+        // tail to the scalar version.
+
+        inline __m128i in_range_sse2(__m128i x, char lo, char hi) {
+            auto above = _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(lo)), x);
+            auto below = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(hi)), x);
+            return _mm_and_si128(above, below);
+        }
+
+        inline unsigned unreserved_mask_sse2(__m128i x) {
+            auto folded = _mm_or_si128(x, _mm_set1_epi8(0x20));
+            auto m = _mm_or_si128(
+                in_range_sse2(folded, 'a', 'z'), in_range_sse2(x, '0', '9'));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('-')));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('.')));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('~')));
+            return static_cast<unsigned>(_mm_movemask_epi8(m));
+        }
+
+        std::size_t
+        encoded_size_sse2(const char* in, std::size_t n) {
+            std::size_t size = n, i = 0;
+            for (; i + 16 <= n; i += 16) {
+                auto x = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(in + i));
+                size += 2 * __builtin_popcount(~unreserved_mask_sse2(x) &
+                                               0xFFFFu);
+            }
+            return size + encoded_size_scalar(in + i, n - i) - (n - i);
+        }
+
+        std::size_t
+        encode_sse2(const char* in, std::size_t n, char* out) {
+            std::size_t i = 0, o = 0;
+            while (i + 16 <= n) {
+                auto x = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(in + i));
+                // The encoded form of the remaining input is at least as long
+                // as the input, so a full-width store always fits in out.
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), x);
+                auto reserved = ~unreserved_mask_sse2(x) & 0xFFFFu;
+                if (reserved == 0) {
+                    i += 16;
+                    o += 16;
+                    continue;
+                }
+                auto k = static_cast<std::size_t>(__builtin_ctz(reserved));
+                i += k;
+                o += k;
+                o += encode_byte(static_cast<unsigned char>(in[i++]), out + o);
+            }
+            return o + encode_scalar(in + i, n - i, out + o);
+        }
+
+        std::size_t
+        decode_sse2(const char* in, std::size_t n, char* out) {
+            std::size_t i = 0, o = 0;
+            const auto plus = _mm_set1_epi8('+');
+            const auto space = _mm_set1_epi8(' ');
+            const auto percent = _mm_set1_epi8('%');
+            while (i + 16 <= n) {
+                auto x = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(in + i));
+                auto is_plus = _mm_cmpeq_epi8(x, plus);
+                auto y = _mm_or_si128(
+                    _mm_andnot_si128(is_plus, x),
+                    _mm_and_si128(is_plus, space));
+                // Decoding never grows the output, so o <= i and the store
+                // stays inside the n bytes reserved for out.
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), y);
+                auto escapes = static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(x, percent)));
+                if (escapes == 0) {
+                    i += 16;
+                    o += 16;
+                    continue;
+                }
+                auto k = static_cast<std::size_t>(__builtin_ctz(escapes));
+                i += k;
+                o += k;
+                out[o++] = decode_special(in, n, i);
+            }
+            return o + decode_scalar(in + i, n - i, out + o);
+        }
+
+        void
+        to_lower_sse2(char* data, std::size_t n) {
+            std::size_t i = 0;
+            const auto delta = _mm_set1_epi8('a' - 'A');
+            for (; i + 16 <= n; i += 16) {
+                auto p = reinterpret_cast<__m128i*>(data + i);
+                auto x = _mm_loadu_si128(p);
+                auto upper = in_range_sse2(x, 'A', 'Z');
+                _mm_storeu_si128(
+                    p, _mm_add_epi8(x, _mm_and_si128(upper, delta)));
+            }
+            to_lower_scalar(data + i, n - i);
+        }
+
+        __attribute__((target("avx2"))) inline __m256i
+        in_range_avx2(__m256i x, char lo, char hi) {
+            auto above =
+                _mm256_cmpeq_epi8(_mm256_max_epu8(x, _mm256_set1_epi8(lo)), x);
+            auto below =
+                _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(hi)), x);
+            return _mm256_and_si256(above, below);
+        }
+
+        __attribute__((target("avx2"))) inline std::uint32_t
+        unreserved_mask_avx2(__m256i x) {
+            auto folded = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+            auto m = _mm256_or_si256(
+                in_range_avx2(folded, 'a', 'z'), in_range_avx2(x, '0', '9'));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('-')));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('.')));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('~')));
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+        }
+
+        __attribute__((target("avx2"))) std::size_t
+        encoded_size_avx2(const char* in, std::size_t n) {
+            std::size_t size = n, i = 0;
+            for (; i + 32 <= n; i += 32) {
+                auto x = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(in + i));
+                size += 2 * __builtin_popcount(~unreserved_mask_avx2(x));
+            }
+            return size + encoded_size_sse2(in + i, n - i) - (n - i);
+        }
+
+        __attribute__((target("avx2"))) std::size_t
+        encode_avx2(const char* in, std::size_t n, char* out) {
+            std::size_t i = 0, o = 0;
+            while (i + 32 <= n) {
+                auto x = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(in + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), x);
+                auto reserved = ~unreserved_mask_avx2(x);
+                if (reserved == 0) {
+                    i += 32;
+                    o += 32;
+                    continue;
+                }
+                auto k = static_cast<std::size_t>(__builtin_ctz(reserved));
+                i += k;
+                o += k;
+                o += encode_byte(static_cast<unsigned char>(in[i++]), out + o);
+            }
+            return o + encode_sse2(in + i, n - i, out + o);
+        }
+
+        __attribute__((target("avx2"))) std::size_t
+        decode_avx2(const char* in, std::size_t n, char* out) {
+            std::size_t i = 0, o = 0;
+            const auto plus = _mm256_set1_epi8('+');
+            const auto space = _mm256_set1_epi8(' ');
+            const auto percent = _mm256_set1_epi8('%');
+            while (i + 32 <= n) {
+                auto x = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(in + i));
+                auto is_plus = _mm256_cmpeq_epi8(x, plus);
+                auto y = _mm256_blendv_epi8(x, space, is_plus);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), y);
+                auto escapes = static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, percent)));
+                if (escapes == 0) {
+                    i += 32;
+                    o += 32;
+                    continue;
+                }
+                auto k = static_cast<std::size_t>(__builtin_ctz(escapes));
+                i += k;
+                o += k;
+                out[o++] = decode_special(in, n, i);
+            }
+            return o + decode_sse2(in + i, n - i, out + o);
+        }
+
+        __attribute__((target("avx2"))) void
+        to_lower_avx2(char* data, std::size_t n) {
+            std::size_t i = 0;
+            const auto delta = _mm256_set1_epi8('a' - 'A');
+            for (; i + 32 <= n; i += 32) {
+                auto p = reinterpret_cast<__m256i*>(data + i);
+                auto x = _mm256_loadu_si256(p);
+                auto upper = in_range_avx2(x, 'A', 'Z');
+                _mm256_storeu_si256(
+                    p, _mm256_add_epi8(x, _mm256_and_si256(upper, delta)));
             }
+            to_lower_sse2(data + i, n - i);
+        }
+#endif
+
+        struct Kernels {
+            const char* name;
+            std::size_t (*encoded_size)(const char*, std::size_t);
+            std::size_t (*encode)(const char*, std::size_t, char*);
+            std::size_t (*decode)(const char*, std::size_t, char*);
+            void (*to_lower)(char*, std::size_t);
+        };
+
+        Kernels select_kernels() {
+#ifdef SCRAPP_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return {
+                    "avx2", encoded_size_avx2, encode_avx2, decode_avx2,
+                    to_lower_avx2};
+            }
+            return {
+                "sse2", encoded_size_sse2, encode_sse2, decode_sse2,
+                to_lower_sse2};
+#else
+            return {
+                "scalar", encoded_size_scalar, encode_scalar, decode_scalar,
+                to_lower_scalar};
+#endif
+        }
+
+        const Kernels& kernels() noexcept {
+            static const Kernels selected = select_kernels();
+            return selected;
+        }
+    } // namespace
+
+    std::size_t url_encoded_size(std::string_view value) noexcept {
+        return kernels().encoded_size(value.data(), value.size());
+    }
+
+    std::size_t url_encode_to(std::string_view value, char* out) noexcept {
+        return kernels().encode(value.data(), value.size(), out);
+    }
+
+    std::size_t url_decode_to(std::string_view text, char* out) noexcept {
+        return kernels().decode(text.data(), text.size(), out);
+    }
+
+    void to_lower_ascii(char* data, std::size_t size) noexcept {
+        kernels().to_lower(data, size);
+    }
+
+    std::string_view trim(
+        std::string_view text, std::string_view chars) noexcept {
+        auto first = text.find_first_not_of(chars);
+        if (first == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(first, text.find_last_not_of(chars) - first + 1);
+    }
 
-            // Any other characters are percent-encoded
-            escaped << std::uppercase;
-            escaped << '%' << std::setw(2) << int((unsigned char)c);
-            escaped << std::nouppercase;
+    bool equals_ignore_case(std::string_view a, std::string_view b) noexcept {
+        return a.size() == b.size() && starts_with_ignore_case(a, b);
+    }
+
+    bool starts_with_ignore_case(
+        std::string_view text, std::string_view prefix) noexcept {
+        if (text.size() < prefix.size()) {
+            return false;
         }
+        auto lower = [](char c) {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+        };
+        for (std::size_t i = 0; i < prefix.size(); ++i) {
+            if (lower(text[i]) != lower(prefix[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
 
-        return escaped.str();
+    const char* simd_kernel_name() noexcept { return kernels().name; }
+
+    std::string url_encode(std::string_view value) {
+        std::string escaped(url_encoded_size(value), '\0');
+        url_encode_to(value, escaped.data());
+        return escaped;
     }
 
     char from_hex(char ch) {
         return isdigit(ch) ? ch - '0' : tolower(ch) - 'a' + 10;
     }
 
-    std::string url_decode(std::string text) {
-        char h;
-        std::ostringstream escaped;
-        escaped.fill('0');
+    std::string url_decode(std::string_view text) {
+        std::string decoded(text.size(), '\0');
+        decoded.resize(url_decode_to(text, decoded.data()));
+        return decoded;
+    }
+
+    std::string to_lower(const std::string& value) {
+        std::string s = value;
+        to_lower_ascii(s.data(), s.size());
+        return s;
+    }
+
+    namespace {
+        struct UrlParts {
+            std::string_view scheme;
+            std::optional<std::string_view> authority;
+            std::string_view path;
+            std::optional<std::string_view> query;
+        };
 
-        for (auto i = text.begin(), n = text.end(); i != n; ++i) {
-            std::string::value_type c = (*i);
+        UrlParts split_url(std::string_view url) {
+            UrlParts parts;
+            if (auto hash = url.find('#'); hash != std::string_view::npos) {
+                url = url.substr(0, hash);
+            }
+            auto colon = url.find(':');
+            if (colon != std::string_view::npos && colon > 0 &&
+                isalpha(static_cast<unsigned char>(url[0]))) {
+                auto scheme = url.substr(0, colon);
+                bool valid = std::all_of(
+                    scheme.begin(), scheme.end(), [](char c) {
+                        return isalnum(static_cast<unsigned char>(c)) ||
+                               c == '+' || c == '-' || c == '.';
+                    });
+                if (valid) {
+                    parts.scheme = scheme;
+                    url.remove_prefix(colon + 1);
+                }
+            }
+            if (url.substr(0, 2) == "//") {
+                auto end = url.find_first_of("/?", 2);
+                parts.authority = url.substr(2, end - 2);
+                url = end == std::string_view::npos ? std::string_view{}
+                                                    : url.substr(end);
+            }
+            auto question = url.find('?');
+            if (question != std::string_view::npos) {
+                parts.query = url.substr(question + 1);
+                url = url.substr(0, question);
+            }
+            parts.path = url;
+            return parts;
+        }
 
-            if (c == '%') {
-                if (i[1] && i[2]) {
-                    h = from_hex(i[1]) << 4 | from_hex(i[2]);
-                    escaped << h;
-                    i += 2;
+        // remove_dot_segments from RFC 3986 section 5.2.4.
+        std::string remove_dot_segments(std::string_view input) {
+            std::string output;
+            output.reserve(input.size());
+            while (!input.empty()) {
+                if (input.substr(0, 3) == "../") {
+                    input.remove_prefix(3);
+                } else if (input.substr(0, 2) == "./") {
+                    input.remove_prefix(2);
+                } else if (input.substr(0, 3) == "/./") {
+                    input.remove_prefix(2);
+                } else if (input == "/.") {
+                    input = "/";
+                } else if (
+                    input.substr(0, 4) == "/../" || input == "/..") {
+                    input = input.size() == 3 ? std::string_view{"/"}
+                                              : input.substr(3);
+                    auto slash = output.rfind('/');
+                    output.erase(slash == std::string::npos ? 0 : slash);
+                } else if (input == "." || input == "..") {
+                    input = {};
+                } else {
+                    auto end = input.find('/', input[0] == '/' ? 1 : 0);
+                    output.append(input.substr(0, end));
+                    input = end == std::string_view::npos
+                                ? std::string_view{}
+                                : input.substr(end);
                 }
-            } else if (c == '+') {
-                escaped << ' ';
+            }
+            return output;
+        }
+
+        std::string_view trim_url(std::string_view url) {
+            auto is_space = [](char c) {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                       c == '\f';
+            };
+            while (!url.empty() && is_space(url.front())) {
+                url.remove_prefix(1);
+            }
+            while (!url.empty() && is_space(url.back())) {
+                url.remove_suffix(1);
+            }
+            return url;
+        }
+    } // namespace
+
+    std::string resolve_url(std::string_view base, std::string_view reference) {
+        auto ref = split_url(trim_url(reference));
+        auto b = split_url(base);
+        UrlParts target;
+        std::string path;
+        if (!ref.scheme.empty()) {
+            target = ref;
+            path = remove_dot_segments(ref.path);
+        } else {
+            target.scheme = b.scheme;
+            if (ref.authority) {
+                target.authority = ref.authority;
+                target.query = ref.query;
+                path = remove_dot_segments(ref.path);
             } else {
-                escaped << c;
+                target.authority = b.authority;
+                if (ref.path.empty()) {
+                    path = std::string(b.path);
+                    target.query = ref.query ? ref.query : b.query;
+                } else {
+                    if (ref.path.front() == '/') {
+                        path = remove_dot_segments(ref.path);
+                    } else {
+                        std::string merged;
+                        if (b.authority && b.path.empty()) {
+                            merged = "/";
+                        } else {
+                            auto slash = b.path.rfind('/');
+                            if (slash != std::string_view::npos) {
+                                merged = b.path.substr(0, slash + 1);
+                            }
+                        }
+                        merged.append(ref.path);
+                        path = remove_dot_segments(merged);
+                    }
+                    target.query = ref.query;
+                }
+            }
+        }
+
+        std::string url;
+        url.reserve(base.size() + reference.size());
+        url.append(target.scheme);
+        url += ':';
+        if (target.authority) {
+            url += "//";
+            url.append(*target.authority);
+            if (path.empty() && !target.authority->empty()) {
+                path = "/";
             }
         }
+        url += path;
+        if (target.query) {
+            url += '?';
+            url.append(*target.query);
+        }
+        return url;
+    }
 
-        return escaped.str();
+    std::string url_fingerprint(std::string_view url) {
+        auto parts = split_url(trim_url(url));
+        std::string fingerprint;
+        fingerprint.reserve(url.size());
+        fingerprint.append(parts.scheme);
+        fingerprint += ':';
+        if (parts.authority) {
+            fingerprint += "//";
+            fingerprint.append(*parts.authority);
+        }
+        to_lower_ascii(fingerprint.data(), fingerprint.size());
+        if (parts.path.empty() && parts.authority) {
+            fingerprint += '/';
+        }
+        fingerprint.append(parts.path);
+        if (!parts.query) {
+            return fingerprint;
+        }
+        std::vector<std::string_view> pairs;
+        auto query = *parts.query;
+        while (!query.empty()) {
+            auto end = query.find('&');
+            if (end != 0) {
+                pairs.push_back(query.substr(0, end));
+            }
+            query = end == std::string_view::npos ? std::string_view{}
+                                                  : query.substr(end + 1);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        for (std::size_t i = 0; i < pairs.size(); ++i) {
+            fingerprint += i == 0 ? '?' : '&';
+            fingerprint.append(pairs[i]);
+        }
+        return fingerprint;
+    }
+
+    std::string url_pattern(std::string_view url) {
+        auto parts = split_url(trim_url(url));
+        std::string pattern;
+        pattern.reserve(url.size());
+        pattern.append(parts.scheme);
+        pattern += ':';
+        if (parts.authority) {
+            pattern += "//";
+            pattern.append(*parts.authority);
+        }
+        to_lower_ascii(pattern.data(), pattern.size());
+        auto path = parts.path;
+        while (!path.empty()) {
+            auto end = path.find('/', 1);
+            auto segment = path.substr(0, end);
+            path = end == std::string_view::npos ? std::string_view{}
+                                                 : path.substr(end);
+            // Long segments mixing letters and digits are ids or tokens.
+            auto digits = std::count_if(
+                segment.begin(), segment.end(),
+                [](char c) { return isdigit(static_cast<unsigned char>(c)); });
+            if (segment.size() > 16 && digits > 0 &&
+                static_cast<std::size_t>(digits) + 1 < segment.size()) {
+                pattern += segment[0] == '/' ? "/*" : "*";
+                continue;
+            }
+            for (std::size_t i = 0; i < segment.size(); ++i) {
+                if (!isdigit(static_cast<unsigned char>(segment[i]))) {
+                    pattern += segment[i];
+                } else if (
+                    i == 0 ||
+                    !isdigit(static_cast<unsigned char>(segment[i - 1]))) {
+                    pattern += '#';
+                }
+            }
+        }
+        if (!parts.query) {
+            return pattern;
+        }
+        std::vector<std::string_view> keys;
+        auto query = *parts.query;
+        while (!query.empty()) {
+            auto end = query.find('&');
+            auto pair = query.substr(0, end);
+            if (!pair.empty()) {
+                keys.push_back(pair.substr(0, pair.find('=')));
+            }
+            query = end == std::string_view::npos ? std::string_view{}
+                                                  : query.substr(end + 1);
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            pattern += i == 0 ? '?' : '&';
+            pattern.append(keys[i]);
+        }
+        return pattern;
+    }
+
+    std::string url_origin(std::string_view url) {
+        auto parts = split_url(trim_url(url));
+        std::string origin{parts.scheme};
+        origin += ':';
+        if (parts.authority) {
+            origin += "//";
+            origin.append(*parts.authority);
+        }
+        to_lower_ascii(origin.data(), origin.size());
+        return origin;
+    }
+
+    std::string url_target(std::string_view url) {
+        auto parts = split_url(trim_url(url));
+        std::string target = parts.path.empty() ? "/" : std::string{parts.path};
+        if (parts.query) {
+            target += '?';
+            target.append(*parts.query);
+        }
+        return target;
     }
-} // namespace Scrapp
\ No newline at end of file
+} // namespace Scrapp
@@ -24,8 +24,10 @@
 #define SCRAPP_UTILS_H
 
 #include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace Scrapp {
     // Copied from: https://stackoverflow.com/a/51274008/9105459
@@ -38,10 +40,51 @@ namespace Scrapp {
     using unique_ptr_with_deleter =
         std::unique_ptr<Type, deleter_from_fn<DeleterFunction, Arguments...>>;
 
-    std::string url_encode(const std::string& value);
-    std::string url_decode(std::string text);
+    std::string url_encode(std::string_view value);
+    std::string url_decode(std::string_view text);
     char from_hex(char ch);
 
+    // Exact number of bytes url_encode_to writes for value.
+    std::size_t url_encoded_size(std::string_view value) noexcept;
+    // Writes the percent-encoded form of value into out, which must hold at
+    // least url_encoded_size(value) bytes. Returns the number of bytes
+    // written.
+    std::size_t url_encode_to(std::string_view value, char* out) noexcept;
+    // Writes the decoded form of text into out, which must hold at least
+    // text.size() bytes. Returns the number of bytes written.
+    std::size_t url_decode_to(std::string_view text, char* out) noexcept;
+    // Lowercases ASCII letters in place, leaving every other byte untouched.
+    void to_lower_ascii(char* data, std::size_t size) noexcept;
+    // text without the leading and trailing bytes found in chars.
+    std::string_view trim(
+        std::string_view text, std::string_view chars = " \t\r\n") noexcept;
+    // Whether a and b are equal, comparing ASCII letters without case.
+    bool equals_ignore_case(std::string_view a, std::string_view b) noexcept;
+    // Whether text begins with prefix, comparing ASCII letters without case.
+    bool starts_with_ignore_case(
+        std::string_view text, std::string_view prefix) noexcept;
+
+    // Resolves reference against the absolute URL base as described in
+    // RFC 3986 section 5.2, dropping any fragment from the result.
+    std::string resolve_url(std::string_view base, std::string_view reference);
+    // Canonical form of url for telling whether two URLs fetch the same
+    // resource: lowercase scheme and host, no fragment and the query
+    // parameters sorted.
+    std::string url_fingerprint(std::string_view url);
+    // Shape of url shared by the pages of one template: lowercase scheme
+    // and host, runs of digits in the path as '#', path segments that look
+    // like ids or session tokens as '*' and only the sorted query keys.
+    std::string url_pattern(std::string_view url);
+    // Lowercase scheme and authority of url, "https://example.com".
+    std::string url_origin(std::string_view url);
+    // Path and query of url as in a request line, "/" for an empty path.
+    std::string url_target(std::string_view url);
+
+    // Name of the kernel set chosen at runtime ("avx2", "sse2" or "scalar").
+    const char* simd_kernel_name() noexcept;
+
+    std::string to_lower(const std::string& value);
+
     template<class T>
     std::basic_string<T> to_lower(const std::basic_string<T>& value) {
         std::basic_string<T> s = value;
@@ -0,0 +1,445 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "warc.h"
+#include "utils.h"
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <ctime>
+#include <utility>
+#include <zlib.h>
+#ifdef SCRAPP_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Scrapp {
+    namespace {
+        std::string record_id() {
+            thread_local boost::uuids::random_generator generate;
+            return "<urn:uuid:" + boost::uuids::to_string(generate()) + ">";
+        }
+
+        // With microseconds, which WARC/1.1 allows, so that replays can
+        // keep the original timing.
+        std::string warc_date() {
+            using namespace std::chrono;
+            auto now = system_clock::now();
+            auto seconds = time_point_cast<std::chrono::seconds>(now);
+            auto micros = duration_cast<microseconds>(now - seconds).count();
+            auto time_t = system_clock::to_time_t(seconds);
+            std::tm time{};
+            gmtime_r(&time_t, &time);
+            char date[sizeof("2000-01-01T00:00:00.000000Z")];
+            auto size = std::strftime(
+                date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &time);
+            std::snprintf(
+                date + size, sizeof(date) - size, ".%06dZ",
+                static_cast<int>(micros));
+            return date;
+        }
+
+        // The headers describing the body as sent, which cpr hands over
+        // de-chunked and decoded.
+        bool transfer_header(std::string_view line) {
+            return starts_with_ignore_case(line, "transfer-encoding:") ||
+                   starts_with_ignore_case(line, "content-encoding:") ||
+                   starts_with_ignore_case(line, "content-length:");
+        }
+
+        // The status line and headers of the final response, with the
+        // transfer headers replaced by the Content-Length of the body as
+        // stored, so that readers find the record's payload.
+        std::string http_header(const Response& response) {
+            std::string_view raw = response.raw_header;
+            auto end = raw.find_last_not_of("\r\n");
+            std::string header;
+            if (end == std::string_view::npos) {
+                header = response.status_line.empty()
+                             ? "HTTP/1.1 " +
+                                   std::to_string(response.status_code) +
+                                   " " + response.reason
+                             : response.status_line;
+                header += "\r\n";
+                for (const auto& [name, value] : response.headers) {
+                    if (!transfer_header(name + ":")) {
+                        header += name + ": " + value + "\r\n";
+                    }
+                }
+            } else {
+                // Redirects leave a header block per response.
+                raw = raw.substr(0, end + 1);
+                auto last = raw.rfind("\r\n\r\n");
+                if (last != std::string_view::npos) {
+                    raw.remove_prefix(last + 4);
+                }
+                while (!raw.empty()) {
+                    auto line_end = raw.find("\r\n");
+                    auto line = raw.substr(0, line_end);
+                    if (!transfer_header(line)) {
+                        header.append(line);
+                        header += "\r\n";
+                    }
+                    raw.remove_prefix(
+                        line_end == std::string_view::npos ? raw.size()
+                                                           : line_end + 2);
+                }
+            }
+            header += "Content-Length: " +
+                      std::to_string(response.text.size()) + "\r\n";
+            return header + "\r\n";
+        }
+
+        std::string http_request(const Request& request, std::string_view uri) {
+            std::string_view host;
+            std::string_view target = "/";
+            auto scheme = uri.find("://");
+            if (scheme != std::string_view::npos) {
+                auto authority = uri.substr(scheme + 3);
+                auto path = authority.find_first_of("/?#");
+                host = authority.substr(0, path);
+                if (path != std::string_view::npos && authority[path] != '#') {
+                    target = authority.substr(path);
+                    target = target.substr(0, target.find('#'));
+                }
+            }
+            std::string block = "GET ";
+            if (target.front() != '/') {
+                block += '/';
+            }
+            block.append(target);
+            block += " HTTP/1.1\r\nHost: ";
+            block.append(host);
+            block += "\r\n";
+            for (const auto& [name, value] : request.headers()) {
+                block += name + ": " + value + "\r\n";
+            }
+            return block + "\r\n";
+        }
+
+        // One gzip member. The deflate state is kept per thread, setting it
+        // up costs more than compressing a small record.
+        std::string gzip(std::string_view input, int level) {
+            struct Deflater {
+                z_stream stream{};
+                int level{INT_MIN};
+
+                ~Deflater() {
+                    if (this->level != INT_MIN) {
+                        deflateEnd(&this->stream);
+                    }
+                }
+            };
+            thread_local Deflater deflater;
+            if (level == 0) {
+                level = Z_DEFAULT_COMPRESSION;
+            }
+            if (deflater.level != level) {
+                if (deflater.level != INT_MIN) {
+                    deflateEnd(&deflater.stream);
+                    deflater.level = INT_MIN;
+                }
+                deflater.stream = z_stream{};
+                if (deflateInit2(
+                        &deflater.stream, level, Z_DEFLATED, 15 + 16, 8,
+                        Z_DEFAULT_STRATEGY) != Z_OK) {
+                    throw warc_exception("cannot initialize zlib");
+                }
+                deflater.level = level;
+            } else {
+                deflateReset(&deflater.stream);
+            }
+            if (input.size() > UINT_MAX) {
+                throw warc_exception("record too large for gzip");
+            }
+
+            auto& stream = deflater.stream;
+            std::string output(
+                deflateBound(&stream, static_cast<uLong>(input.size())), '\0');
+            stream.next_in =
+                reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+            stream.avail_in = static_cast<uInt>(input.size());
+            stream.next_out = reinterpret_cast<Bytef*>(output.data());
+            stream.avail_out = static_cast<uInt>(output.size());
+            if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+                throw warc_exception(
+                    std::string{"cannot compress record: "} +
+                    (stream.msg != nullptr ? stream.msg : "zlib error"));
+            }
+            output.resize(stream.total_out);
+            return output;
+        }
+
+#ifdef SCRAPP_WITH_ZSTD
+        // One zstd frame.
+        std::string zstd(std::string_view input, int level) {
+            thread_local unique_ptr_with_deleter<ZSTD_CCtx, ZSTD_freeCCtx>
+                context{ZSTD_createCCtx()};
+            if (context == nullptr) {
+                throw warc_exception("cannot initialize zstd");
+            }
+            std::string output(ZSTD_compressBound(input.size()), '\0');
+            auto size = ZSTD_compressCCtx(
+                context.get(), output.data(), output.size(), input.data(),
+                input.size(), level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+            if (ZSTD_isError(size)) {
+                throw warc_exception(
+                    std::string{"cannot compress record: "} +
+                    ZSTD_getErrorName(size));
+            }
+            output.resize(size);
+            return output;
+        }
+#endif
+    } // namespace
+
+    WarcWriter::WarcWriter(WarcOptions options)
+        : options_{std::move(options)},
+          writer_{
+              this->options_.max_pending_records,
+              std::chrono::milliseconds{0},
+              {[this](std::deque<Pending>& records) {
+                   this->write_records(records);
+               },
+               [this](bool closing) { this->flush_segment(closing); }}} {
+        switch (this->options_.compression) {
+        case WarcCompression::none:
+            this->extension_ = ".warc";
+            break;
+        case WarcCompression::gzip:
+            this->extension_ = ".warc.gz";
+            break;
+        case WarcCompression::zstd:
+#ifndef SCRAPP_WITH_ZSTD
+            throw warc_exception(
+                "zstd compression requires building with SCRAPP_WITH_ZSTD");
+#endif
+            this->extension_ = ".warc.zst";
+            break;
+        }
+        this->buffer_.reserve(this->options_.buffer_size);
+        std::vector<WarcIndexEntry> entries;
+        this->open_segment(entries);
+        this->add_to_index(entries);
+    }
+
+    WarcWriter::~WarcWriter() = default;
+
+    std::string
+    WarcWriter::write(const Request& request, const Response& response) {
+        auto uri = response.url.str();
+        if (uri.empty()) {
+            uri = request.url();
+        }
+        auto block = http_header(response);
+        block += response.text;
+        std::vector<Pending> records;
+        records.push_back(this->serialize(
+            {"response", uri, "application/http;msgtype=response",
+             std::move(block)}));
+        auto id = records.front().entry.record_id;
+        // The URL as requested, before redirects, so that replays find the
+        // exchange by the request.
+        auto requested = request.full_url();
+        records.push_back(this->serialize(
+            {"request",
+             requested,
+             "application/http;msgtype=request",
+             http_request(request, requested),
+             {{"WARC-Concurrent-To", id}}}));
+        this->submit(std::move(records));
+        return id;
+    }
+
+    std::string WarcWriter::write(WarcRecord record) {
+        std::vector<Pending> records;
+        records.push_back(this->serialize(std::move(record)));
+        auto id = records.front().entry.record_id;
+        this->submit(std::move(records));
+        return id;
+    }
+
+    void WarcWriter::flush() {
+        this->writer_.flush();
+    }
+
+    void WarcWriter::close() {
+        this->writer_.close();
+    }
+
+    std::vector<std::string> WarcWriter::segments() const {
+        std::lock_guard<std::mutex> lock{this->mutex_};
+        return this->segments_;
+    }
+
+    std::vector<WarcIndexEntry> WarcWriter::index() const {
+        std::lock_guard<std::mutex> lock{this->mutex_};
+        return this->index_;
+    }
+
+    std::optional<WarcIndexEntry> WarcWriter::find(
+        std::string_view target_uri, std::string_view type) const {
+        std::string key{type};
+        key += ' ';
+        key.append(target_uri);
+        std::lock_guard<std::mutex> lock{this->mutex_};
+        auto found = this->latest_.find(key);
+        if (found == this->latest_.end()) {
+            return std::nullopt;
+        }
+        return this->index_[found->second];
+    }
+
+    WarcWriter::Pending WarcWriter::serialize(WarcRecord record) const {
+        Pending pending;
+        pending.entry.type = std::move(record.type);
+        pending.entry.target_uri = std::move(record.target_uri);
+        pending.entry.record_id = record_id();
+
+        std::string header = "WARC/1.1\r\nWARC-Type: ";
+        header += pending.entry.type;
+        header += "\r\nWARC-Record-ID: ";
+        header += pending.entry.record_id;
+        header += "\r\nWARC-Date: ";
+        header += warc_date();
+        header += "\r\n";
+        if (!pending.entry.target_uri.empty()) {
+            header += "WARC-Target-URI: " + pending.entry.target_uri + "\r\n";
+        }
+        for (const auto& [name, value] : record.fields) {
+            header += name + ": " + value + "\r\n";
+        }
+        if (!record.content_type.empty()) {
+            header += "Content-Type: " + record.content_type + "\r\n";
+        }
+        header += "Content-Length: " + std::to_string(record.block.size()) +
+                  "\r\n\r\n";
+
+        auto& data = pending.data;
+        data.reserve(header.size() + record.block.size() + 4);
+        data += header;
+        data += record.block;
+        data += "\r\n\r\n";
+        switch (this->options_.compression) {
+        case WarcCompression::none:
+            break;
+        case WarcCompression::gzip:
+            data = gzip(data, this->options_.compression_level);
+            break;
+        case WarcCompression::zstd:
+#ifdef SCRAPP_WITH_ZSTD
+            data = zstd(data, this->options_.compression_level);
+#endif
+            break;
+        }
+        return pending;
+    }
+
+    void WarcWriter::submit(std::vector<Pending> records) {
+        if (!this->writer_.push_all(std::move(records))) {
+            throw warc_exception("warc writer is closed");
+        }
+    }
+
+    void WarcWriter::write_records(std::deque<Pending>& records) {
+        std::vector<WarcIndexEntry> entries;
+        for (auto& record : records) {
+            this->append(record, entries);
+        }
+        this->add_to_index(entries);
+    }
+
+    void WarcWriter::append(
+        Pending& record, std::vector<WarcIndexEntry>& entries) {
+        if (this->options_.rotate_bytes != 0 &&
+            this->segment_bytes_ >= this->options_.rotate_bytes) {
+            this->close_segment();
+            this->open_segment(entries);
+        }
+        record.entry.segment = this->segments_.size() - 1;
+        record.entry.offset = this->segment_bytes_;
+        record.entry.length = record.data.size();
+        this->buffer_ += record.data;
+        this->segment_bytes_ += record.data.size();
+        if (this->buffer_.size() >= this->options_.buffer_size) {
+            this->write_out();
+        }
+        entries.push_back(std::move(record.entry));
+    }
+
+    void WarcWriter::open_segment(std::vector<WarcIndexEntry>& entries) {
+        auto number = std::to_string(this->segments_.size());
+        number.insert(0, number.size() < 5 ? 5 - number.size() : 0, '0');
+        auto path = this->options_.path + "-" + number + this->extension_;
+        this->file_.open(path);
+        this->segment_bytes_ = 0;
+        auto name = path.substr(path.find_last_of('/') + 1);
+        {
+            std::lock_guard<std::mutex> lock{this->mutex_};
+            this->segments_.push_back(std::move(path));
+        }
+
+        auto info = this->serialize(
+            {"warcinfo",
+             "",
+             "application/warc-fields",
+             "software: " + this->options_.software +
+                 "\r\nformat: WARC File Format 1.1\r\n",
+             {{"WARC-Filename", name}}});
+        this->append(info, entries);
+    }
+
+    void WarcWriter::flush_segment(bool closing) {
+        if (closing) {
+            this->close_segment();
+            return;
+        }
+        this->write_out();
+        if (this->options_.fsync == FsyncPolicy::on_flush) {
+            this->file_.sync();
+        }
+    }
+
+    void WarcWriter::write_out() {
+        this->file_.write(this->buffer_);
+        this->buffer_.clear();
+    }
+
+    void WarcWriter::close_segment() {
+        if (!this->file_.is_open()) {
+            return;
+        }
+        this->write_out();
+        this->file_.close(this->options_.fsync != FsyncPolicy::never);
+    }
+
+    void WarcWriter::add_to_index(std::vector<WarcIndexEntry>& entries) {
+        std::lock_guard<std::mutex> lock{this->mutex_};
+        for (auto& entry : entries) {
+            this->latest_[entry.type + " " + entry.target_uri] =
+                this->index_.size();
+            this->index_.push_back(std::move(entry));
+        }
+    }
+} // namespace Scrapp
@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2022 Yunus Emre ÖRCÜN
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef SCRAPP_WARC_H
+#define SCRAPP_WARC_H
+
+#include "background_writer.h"
+#include "exceptions.h"
+#include "item_sinks.h"
+#include "output_file.h"
+#include "request.h"
+#include "response.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Scrapp {
+    enum class WarcCompression {
+        none,
+        // Every record is its own gzip member, as .warc.gz readers expect.
+        gzip,
+        // Every record is its own frame. Requires SCRAPP_WITH_ZSTD.
+        zstd,
+    };
+
+    struct WarcOptions {
+        // Segments are named path-00000.warc.gz, path-00001.warc.gz, ...
+        std::string path;
+        WarcCompression compression{WarcCompression::gzip};
+        // zlib or zstd level, 0 for the library's default.
+        int compression_level{0};
+        // Starts a new segment once this many bytes are written, 0 never
+        // does.
+        std::size_t rotate_bytes{std::size_t{1} << 30};
+        // Records waiting for the writer thread before write() blocks.
+        std::size_t max_pending_records{4096};
+        // Output is written in chunks of at least this size.
+        std::size_t buffer_size{1 << 20};
+        FsyncPolicy fsync{FsyncPolicy::on_close};
+        // Named in the warcinfo record that starts every segment.
+        std::string software{"scrapp"};
+    };
+
+    struct WarcRecord {
+        // "response", "request", "resource", "metadata", ...
+        std::string type{};
+        std::string target_uri{};
+        // Of the block, e.g. "application/http;msgtype=response".
+        std::string content_type{};
+        std::string block{};
+        // Extra named fields such as WARC-Concurrent-To.
+        std::vector<std::pair<std::string, std::string>> fields{};
+    };
+
+    // Where a record ended up. offset and length are those of the record as
+    // stored, compressed if the segment is.
+    struct WarcIndexEntry {
+        std::string type;
+        std::string target_uri;
+        std::string record_id;
+        std::size_t segment{};
+        std::uint64_t offset{};
+        std::uint64_t length{};
+    };
+
+    // Writes WARC/1.1 segments. Records are serialized and compressed on the
+    // calling threads, which may be many, and appended by a single writer
+    // thread. Throws warc_exception on errors, errors of the writer thread
+    // are rethrown by the next call.
+    class WarcWriter {
+      public:
+        // Opens the first segment right away, so that bad paths are
+        // reported before the crawl starts.
+        explicit WarcWriter(WarcOptions options);
+        WarcWriter(const WarcWriter&) = delete;
+        WarcWriter& operator=(const WarcWriter&) = delete;
+        // Closes the writer, errors are lost.
+        ~WarcWriter();
+
+        // Queues the response record of the exchange and the request record
+        // pointing to it. Thread safe. Returns the response's record id.
+        std::string write(const Request& request, const Response& response);
+        // Queues record. Thread safe. Returns its record id.
+        std::string write(WarcRecord record);
+        // Writes every queued record to the current segment.
+        void flush();
+        // Flushes, closes the segment and stops the writer thread.
+        void close();
+
+        // Every segment opened so far, in order.
+        [[nodiscard]] std::vector<std::string> segments() const;
+        // Every record written so far, in order.
+        [[nodiscard]] std::vector<WarcIndexEntry> index() const;
+        // The last record of type for target_uri written so far.
+        [[nodiscard]] std::optional<WarcIndexEntry>
+        find(std::string_view target_uri,
+             std::string_view type = "response") const;
+
+      private:
+        struct Pending {
+            std::string data;
+            WarcIndexEntry entry;
+        };
+
+        Pending serialize(WarcRecord record) const;
+        void submit(std::vector<Pending> records);
+        void write_records(std::deque<Pending>& records);
+        void append(Pending& record, std::vector<WarcIndexEntry>& entries);
+        void open_segment(std::vector<WarcIndexEntry>& entries);
+        void flush_segment(bool closing);
+        void write_out();
+        void close_segment();
+        void add_to_index(std::vector<WarcIndexEntry>& entries);
+
+        WarcOptions options_;
+        std::string extension_;
+
+        // Owned by the writer thread, or by the constructor and close()
+        // while it is not running.
+        std::string buffer_;
+        OutputFile<warc_exception> file_;
+        std::uint64_t segment_bytes_{0};
+
+        // Guarded by mutex_, only the writer thread changes segments_.
+        mutable std::mutex mutex_;
+        std::vector<std::string> segments_;
+        std::vector<WarcIndexEntry> index_;
+        std::unordered_map<std::string, std::size_t> latest_;
+
+        // Last, its thread uses the members above until it is joined.
+        BackgroundWriter<Pending> writer_;
+    };
+} // namespace Scrapp
+
+#endif // SCRAPP_WARC_H